@@ -0,0 +1,144 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm> // std::min
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint64_t
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/bandwidth.h>
+#include <libtransmission/net.h>
+#include <libtransmission/peer-io.h>
+#include <libtransmission/peer-socket.h>
+#include <libtransmission/session.h>
+
+#include "bench.h"
+
+using State = tr::bench::State;
+
+namespace
+{
+auto constexpr PeerCounts = std::array<size_t, 2>{ 1000U, 10000U };
+
+// How many peers each torrent has
+auto constexpr PeersPerTorrent = size_t{ 100U };
+
+// How often the session calls tr_bandwidth::allocate()
+auto constexpr PeriodMsec = uint64_t{ 500U };
+
+// A connected peer that has nothing to say, so that
+// only the cost of scheduling the bandwidth is measured
+class NullSocket final : public tr_peer_socket
+{
+public:
+    explicit NullSocket(tr_socket_address const& socket_address)
+        : tr_peer_socket{ socket_address }
+    {
+    }
+
+    void set_read_enabled(bool enabled) override
+    {
+        is_read_enabled_ = enabled;
+    }
+
+    void set_write_enabled(bool enabled) override
+    {
+        is_write_enabled_ = enabled;
+    }
+
+    [[nodiscard]] bool is_read_enabled() const override
+    {
+        return is_read_enabled_;
+    }
+
+    [[nodiscard]] bool is_write_enabled() const override
+    {
+        return is_write_enabled_;
+    }
+
+protected:
+    [[nodiscard]] constexpr Type type() const noexcept override
+    {
+        return Type::TCP;
+    }
+
+    [[nodiscard]] size_t try_read_impl(InBuf& /*buf*/, size_t /*n_bytes*/, tr_error* /*error*/) override
+    {
+        return {};
+    }
+
+    [[nodiscard]] size_t try_write_impl(OutBuf& buf, size_t n_bytes, tr_error* /*error*/) override
+    {
+        n_bytes = std::min(n_bytes, std::size(buf));
+        buf.drain(n_bytes);
+        return n_bytes;
+    }
+
+private:
+    bool is_read_enabled_ = false;
+    bool is_write_enabled_ = false;
+};
+
+// The same tree as a session has: a root, a bandwidth for each torrent, and one for each peer
+void bandwidth_allocate(State& state, size_t const peer_count)
+{
+    auto* const session = tr::bench::session();
+    auto const lock = session->unique_lock();
+
+    auto root = tr_bandwidth{};
+
+    auto torrents = std::vector<std::unique_ptr<tr_bandwidth>>{};
+    for (size_t i = 0; i < peer_count / PeersPerTorrent; ++i)
+    {
+        auto& tor = torrents.emplace_back(std::make_unique<tr_bandwidth>(&root));
+        tor->set_priority(static_cast<tr_priority_t>(TR_PRI_LOW + i % 3U));
+    }
+
+    auto peers = std::vector<std::shared_ptr<tr_peerIo>>{};
+    peers.reserve(peer_count);
+    for (size_t i = 0; i < peer_count; ++i)
+    {
+        // 10.0.0.1, 10.0.0.2, ...
+        auto const addr = std::array<uint8_t, 4>{
+            10U,
+            static_cast<uint8_t>(i >> 16U),
+            static_cast<uint8_t>(i >> 8U),
+            static_cast<uint8_t>(i + 1U),
+        };
+        auto const socket_address = tr_socket_address{
+            tr_address::from_compact_ipv4(reinterpret_cast<std::byte const*>(std::data(addr))).first,
+            tr_port::from_host(51413U),
+        };
+
+        auto* const parent = torrents[i / PeersPerTorrent].get();
+        peers.emplace_back(tr_peerIo::new_incoming(session, parent, std::make_shared<NullSocket>(socket_address)));
+    }
+
+    while (state.keep_running())
+    {
+        root.allocate(PeriodMsec);
+    }
+
+    state.set_items_processed(state.iterations() * peer_count);
+}
+
+bool const is_registered = []
+{
+    for (auto const peer_count : PeerCounts)
+    {
+        tr::bench::add(
+            fmt::format("bandwidth_allocate/{:d}_peers", peer_count),
+            [peer_count](State& state) { bandwidth_allocate(state, peer_count); });
+    }
+
+    return true;
+}();
+} // namespace
@@ -0,0 +1,625 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint> // uint64_t
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <numeric>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/error.h>
+#include <libtransmission/file.h>
+#include <libtransmission/file-utils.h>
+#include <libtransmission/log.h>
+#include <libtransmission/quark.h>
+#include <libtransmission/tr-getopt.h>
+#include <libtransmission/tr-strbuf.h>
+#include <libtransmission/utils.h>
+#include <libtransmission/variant.h>
+#include <libtransmission/version.h>
+
+#include "bench.h"
+
+using namespace std::literals;
+
+namespace
+{
+char constexpr MyName[] = "libtransmission-benchmark";
+char constexpr Usage[] = "Usage: libtransmission-benchmark [options]";
+
+using Arg = tr_option::Arg;
+auto constexpr Options = std::array<tr_option, 8>{ {
+    { 'f', "filter", "Only run the benchmarks whose names match this regular expression", "f", Arg::Required, "<regex>" },
+    { 'j', "json", "Print the results as JSON instead of a table", "j", Arg::None, nullptr },
+    { 'l', "list", "List the benchmarks and exit", "l", Arg::None, nullptr },
+    { 'o', "out", "Also save the results as JSON to this file", "o", Arg::Required, "<file>" },
+    { 'r', "repetitions", "Run each benchmark this many times (default: 1)", "r", Arg::Required, "<n>" },
+    { 't', "min-time", "Make each run last at least this long (default: 0.5)", "t", Arg::Required, "<seconds>" },
+    { 'V', "version", "Show version number and exit", "V", Arg::None, nullptr },
+    { 0, nullptr, nullptr, nullptr, Arg::None, nullptr },
+} };
+static_assert(Options[std::size(Options) - 2].val != 0);
+
+struct app_opts
+{
+    std::string filter = ".*";
+    std::string out_filename;
+    std::chrono::duration<double> min_time = 0.5s;
+    size_t repetitions = 1U;
+    bool json = false;
+    bool list = false;
+    bool show_version = false;
+};
+
+int parseCommandLine(app_opts& opts, int argc, char const* const* argv)
+{
+    int c;
+    char const* optarg;
+
+    while ((c = tr_getopt(Usage, argc, argv, std::data(Options), &optarg)) != TR_OPT_DONE)
+    {
+        switch (c)
+        {
+        case 'f':
+            opts.filter = optarg;
+            break;
+
+        case 'j':
+            opts.json = true;
+            break;
+
+        case 'l':
+            opts.list = true;
+            break;
+
+        case 'o':
+            opts.out_filename = optarg;
+            break;
+
+        case 'r':
+            if (auto const n = tr_num_parse<size_t>(optarg); n && *n > 0U)
+            {
+                opts.repetitions = *n;
+                break;
+            }
+            fmt::print(stderr, "Invalid repetitions: {:s}\n", optarg);
+            return 1;
+
+        case 't':
+            if (auto const secs = tr_num_parse<double>(optarg); secs && *secs >= 0.0)
+            {
+                opts.min_time = std::chrono::duration<double>{ *secs };
+                break;
+            }
+            fmt::print(stderr, "Invalid min-time: {:s}\n", optarg);
+            return 1;
+
+        case 'V':
+            opts.show_version = true;
+            break;
+
+        default:
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// ---
+
+struct Benchmark
+{
+    std::string name;
+    tr::bench::Function func;
+};
+
+[[nodiscard]] std::vector<Benchmark>& registry()
+{
+    // function-local so that it exists before the benchmarks' static initializers run
+    static auto& benchmarks{ *new std::vector<Benchmark>{} };
+    return benchmarks;
+}
+
+struct Result
+{
+    std::string name;
+    std::string error;
+    uint64_t iterations = {};
+    double real_ns = {}; // per iteration
+    double cpu_ns = {}; // per iteration
+    std::optional<double> bytes_per_second;
+    std::optional<double> items_per_second;
+};
+
+[[nodiscard]] Result to_result(std::string_view const name, tr::bench::State const& state)
+{
+    auto result = Result{};
+    result.name = name;
+    result.error = state.error();
+    result.iterations = state.iterations();
+
+    if (!std::empty(result.error))
+    {
+        return result;
+    }
+
+    if (result.iterations == 0U)
+    {
+        result.error = "the benchmark never called keep_running()";
+        return result;
+    }
+
+    auto const real_secs = std::chrono::duration<double>{ state.real_time() }.count();
+    auto const n = static_cast<double>(result.iterations);
+    result.real_ns = real_secs * 1e9 / n;
+    result.cpu_ns = state.cpu_time().count() * 1e9 / n;
+
+    if (real_secs > 0.0)
+    {
+        if (auto const bytes = state.bytes_processed(); bytes != 0U)
+        {
+            result.bytes_per_second = static_cast<double>(bytes) / real_secs;
+        }
+
+        if (auto const items = state.items_processed(); items != 0U)
+        {
+            result.items_per_second = static_cast<double>(items) / real_secs;
+        }
+    }
+
+    return result;
+}
+
+[[nodiscard]] Result run_once(Benchmark const& benchmark, uint64_t const iterations)
+{
+    auto state = tr::bench::State{ iterations };
+    benchmark.func(state);
+    return to_result(benchmark.name, state);
+}
+
+// Like Google Benchmark, keep growing the iteration count until a run is long enough
+[[nodiscard]] std::pair<Result, uint64_t> calibrate(Benchmark const& benchmark, std::chrono::duration<double> const min_time)
+{
+    static auto constexpr MaxIterations = uint64_t{ 1000000000U };
+
+    for (auto iterations = uint64_t{ 1U };;)
+    {
+        auto result = run_once(benchmark, iterations);
+        if (!std::empty(result.error))
+        {
+            return { std::move(result), iterations };
+        }
+
+        auto const elapsed = result.real_ns * static_cast<double>(result.iterations) / 1e9;
+        if (elapsed >= min_time.count() || iterations >= MaxIterations)
+        {
+            return { std::move(result), iterations };
+        }
+
+        // aim a little past min_time so that the next run is likely the last
+        auto const multiplier = elapsed / min_time.count() > 0.1 ? min_time.count() * 1.4 / elapsed : 10.0;
+        auto const next = static_cast<uint64_t>(std::ceil(static_cast<double>(iterations) * multiplier));
+        iterations = std::clamp(next, iterations + 1U, MaxIterations);
+    }
+}
+
+// ---
+
+struct Aggregate
+{
+    std::string_view name;
+    double (*func)(std::vector<double> values);
+};
+
+auto constexpr Aggregates = std::array<Aggregate, 3>{ {
+    { "mean"sv,
+      [](std::vector<double> values)
+      {
+          return std::accumulate(std::begin(values), std::end(values), 0.0) / static_cast<double>(std::size(values));
+      } },
+    { "median"sv,
+      [](std::vector<double> values)
+      {
+          auto const mid = std::begin(values) + static_cast<std::ptrdiff_t>(std::size(values) / 2U);
+          std::nth_element(std::begin(values), mid, std::end(values));
+          if (std::size(values) % 2U != 0U)
+          {
+              return *mid;
+          }
+          return (*mid + *std::max_element(std::begin(values), mid)) / 2.0;
+      } },
+    { "stddev"sv,
+      [](std::vector<double> values)
+      {
+          auto const n = static_cast<double>(std::size(values));
+          auto const mean = std::accumulate(std::begin(values), std::end(values), 0.0) / n;
+          auto const sum_sq = std::accumulate(
+              std::begin(values),
+              std::end(values),
+              0.0,
+              [mean](double sum, double val) { return sum + (val - mean) * (val - mean); });
+          return n > 1.0 ? std::sqrt(sum_sq / (n - 1.0)) : 0.0;
+      } },
+} };
+
+[[nodiscard]] Result aggregate(std::vector<Result> const& repetitions, Aggregate const& agg)
+{
+    auto const collect = [&repetitions](auto getter)
+    {
+        auto values = std::vector<double>{};
+        values.reserve(std::size(repetitions));
+        for (auto const& rep : repetitions)
+        {
+            values.emplace_back(getter(rep));
+        }
+        return values;
+    };
+
+    auto result = Result{};
+    result.name = fmt::format("{:s}_{:s}", repetitions.front().name, agg.name);
+    result.iterations = std::size(repetitions);
+    result.real_ns = agg.func(collect([](Result const& rep) { return rep.real_ns; }));
+    result.cpu_ns = agg.func(collect([](Result const& rep) { return rep.cpu_ns; }));
+
+    if (repetitions.front().bytes_per_second)
+    {
+        result.bytes_per_second = agg.func(collect([](Result const& rep) { return rep.bytes_per_second.value_or(0.0); }));
+    }
+
+    if (repetitions.front().items_per_second)
+    {
+        result.items_per_second = agg.func(collect([](Result const& rep) { return rep.items_per_second.value_or(0.0); }));
+    }
+
+    return result;
+}
+
+// ---
+
+[[nodiscard]] std::string format_time(double const ns)
+{
+    if (ns < 1e3)
+    {
+        return fmt::format("{:.1f} ns", ns);
+    }
+
+    if (ns < 1e6)
+    {
+        return fmt::format("{:.2f} us", ns / 1e3);
+    }
+
+    if (ns < 1e9)
+    {
+        return fmt::format("{:.2f} ms", ns / 1e6);
+    }
+
+    return fmt::format("{:.2f} s", ns / 1e9);
+}
+
+[[nodiscard]] std::string format_rate(double const per_second, std::string_view const unit)
+{
+    static auto constexpr Prefixes = std::array<std::string_view, 5>{ ""sv, "k"sv, "M"sv, "G"sv, "T"sv };
+
+    auto val = per_second;
+    auto prefix = std::begin(Prefixes);
+    while (val >= 1000.0 && std::next(prefix) != std::end(Prefixes))
+    {
+        val /= 1000.0;
+        ++prefix;
+    }
+
+    return fmt::format("{:.2f} {:s}{:s}/s", val, *prefix, unit);
+}
+
+void print_table_header()
+{
+    fmt::print("{:<52s} {:>12s} {:>12s} {:>12s}  {:s}\n", "Benchmark", "Time", "CPU", "Iterations", "Throughput");
+    fmt::print("{:-<110s}\n", "");
+}
+
+void print_table_row(Result const& result)
+{
+    if (!std::empty(result.error))
+    {
+        fmt::print("{:<52s} ERROR: {:s}\n", result.name, result.error);
+        return;
+    }
+
+    auto throughput = std::string{};
+    if (result.bytes_per_second)
+    {
+        throughput = format_rate(*result.bytes_per_second, "B");
+    }
+    if (result.items_per_second)
+    {
+        throughput += std::empty(throughput) ? "" : " ";
+        throughput += format_rate(*result.items_per_second, "items");
+    }
+
+    fmt::print(
+        "{:<52s} {:>12s} {:>12s} {:>12d}  {:s}\n",
+        result.name,
+        format_time(result.real_ns),
+        format_time(result.cpu_ns),
+        result.iterations,
+        throughput);
+}
+
+// ---
+
+struct Run
+{
+    Result result;
+    std::string run_name;
+    std::string_view aggregate_name; // empty for a single repetition
+    size_t family_index = {};
+    size_t repetitions = {};
+    size_t repetition_index = {};
+};
+
+[[nodiscard]] tr_variant to_json(std::vector<Run> const& runs, std::string_view const executable)
+{
+    auto const key = [](std::string_view const name)
+    {
+        return tr_quark_new(name);
+    };
+
+    auto context = tr_variant::Map{ 5U };
+    auto const now = std::time(nullptr);
+    context.try_emplace(key("date"sv), fmt::format("{:%FT%T%z}", *std::localtime(&now)));
+    context.try_emplace(key("executable"sv), executable);
+    context.try_emplace(key("num_cpus"sv), std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    context.try_emplace(key("library_build_type"sv), tr_variant::unmanaged_string("release"sv));
+#else
+    context.try_emplace(key("library_build_type"sv), tr_variant::unmanaged_string("debug"sv));
+#endif
+    context.try_emplace(key("transmission_version"sv), tr_variant::unmanaged_string(LONG_VERSION_STRING));
+
+    auto benchmarks = tr_variant::Vector{};
+    benchmarks.reserve(std::size(runs));
+    for (auto const& run : runs)
+    {
+        auto const& result = run.result;
+
+        auto map = tr_variant::Map{ 16U };
+        map.try_emplace(TR_KEY_name, result.name);
+        map.try_emplace(key("family_index"sv), run.family_index);
+        map.try_emplace(key("run_name"sv), run.run_name);
+        map.try_emplace(key("run_type"sv), std::empty(run.aggregate_name) ? "iteration"sv : "aggregate"sv);
+        map.try_emplace(key("repetitions"sv), run.repetitions);
+        map.try_emplace(key("threads"sv), 1);
+        if (std::empty(run.aggregate_name))
+        {
+            map.try_emplace(key("repetition_index"sv), run.repetition_index);
+        }
+        else
+        {
+            map.try_emplace(key("aggregate_name"sv), run.aggregate_name);
+            map.try_emplace(key("aggregate_unit"sv), tr_variant::unmanaged_string("time"sv));
+        }
+
+        if (!std::empty(result.error))
+        {
+            map.try_emplace(key("error_occurred"sv), true);
+            map.try_emplace(key("error_message"sv), result.error);
+        }
+
+        map.try_emplace(key("iterations"sv), result.iterations);
+        map.try_emplace(key("real_time"sv), result.real_ns);
+        map.try_emplace(key("cpu_time"sv), result.cpu_ns);
+        map.try_emplace(key("time_unit"sv), tr_variant::unmanaged_string("ns"sv));
+        if (result.bytes_per_second)
+        {
+            map.try_emplace(key("bytes_per_second"sv), *result.bytes_per_second);
+        }
+        if (result.items_per_second)
+        {
+            map.try_emplace(key("items_per_second"sv), *result.items_per_second);
+        }
+
+        benchmarks.emplace_back(std::move(map));
+    }
+
+    auto top = tr_variant::Map{ 2U };
+    top.try_emplace(key("context"sv), std::move(context));
+    top.try_emplace(key("benchmarks"sv), std::move(benchmarks));
+    return tr_variant{ std::move(top) };
+}
+
+// ---
+
+std::optional<std::string> sandbox_path;
+tr_session* shared_session = nullptr;
+
+void close_session()
+{
+    if (shared_session != nullptr)
+    {
+        static auto constexpr DeadlineSecs = 0.1;
+        tr_sessionClose(shared_session, DeadlineSecs);
+        shared_session = nullptr;
+    }
+
+    if (sandbox_path)
+    {
+        auto ec = std::error_code{};
+        std::filesystem::remove_all(*sandbox_path, ec);
+        sandbox_path.reset();
+    }
+}
+} // namespace
+
+bool tr::bench::add(std::string name, Function func)
+{
+    registry().push_back({ std::move(name), std::move(func) });
+    return true;
+}
+
+std::string_view tr::bench::assets_dir() noexcept
+{
+    return LIBTRANSMISSION_BENCHMARK_ASSETS_DIR;
+}
+
+std::string_view tr::bench::sandbox_dir()
+{
+    if (!sandbox_path)
+    {
+        auto path = tr_pathbuf{ std::filesystem::temp_directory_path().string(), "/transmission-bench-XXXXXX"sv };
+        tr_sys_dir_create_temp(std::data(path));
+        sandbox_path = path.sv();
+    }
+
+    return *sandbox_path;
+}
+
+tr_session* tr::bench::session()
+{
+    if (shared_session == nullptr)
+    {
+        auto const download_dir = tr_pathbuf{ sandbox_dir(), "/Downloads"sv };
+        tr_sys_dir_create(download_dir, TR_SYS_DIR_CREATE_PARENTS, 0700);
+
+        auto settings = tr_variant::Map{ 10U };
+        settings.try_emplace(TR_KEY_download_dir, download_dir.sv());
+        settings.try_emplace(TR_KEY_dht_enabled, false);
+        settings.try_emplace(TR_KEY_ip_endpoints_ipv4, tr_variant::Vector{});
+        settings.try_emplace(TR_KEY_ip_endpoints_ipv6, tr_variant::Vector{});
+        settings.try_emplace(TR_KEY_lpd_enabled, false);
+        settings.try_emplace(TR_KEY_message_level, TR_LOG_ERROR);
+        settings.try_emplace(TR_KEY_peer_port_random_on_start, true);
+        settings.try_emplace(TR_KEY_port_forwarding_enabled, false);
+        settings.try_emplace(TR_KEY_rpc_enabled, false);
+        settings.try_emplace(TR_KEY_utp_enabled, false);
+        shared_session = tr_sessionInit(sandbox_dir(), false, tr_variant{ std::move(settings) });
+    }
+
+    return shared_session;
+}
+
+int tr_main(int argc, char* argv[])
+{
+    tr_lib_init();
+
+    tr_logSetQueueEnabled(false);
+    tr_logSetLevel(TR_LOG_ERROR);
+
+    auto opts = app_opts{};
+    if (parseCommandLine(opts, argc, (char const* const*)argv) != 0)
+    {
+        tr_getopt_usage(MyName, Usage, std::data(Options));
+        return EXIT_FAILURE;
+    }
+
+    if (opts.show_version)
+    {
+        fmt::print(stderr, "{:s} {:s}\n", MyName, LONG_VERSION_STRING);
+        return EXIT_SUCCESS;
+    }
+
+    auto filter = std::regex{};
+    try
+    {
+        filter = std::regex{ opts.filter };
+    }
+    catch (std::regex_error const& err)
+    {
+        fmt::print(stderr, "Invalid filter '{:s}': {:s}\n", opts.filter, err.what());
+        return EXIT_FAILURE;
+    }
+
+    auto benchmarks = registry();
+    std::ranges::sort(benchmarks, {}, &Benchmark::name);
+    std::erase_if(benchmarks, [&filter](auto const& benchmark) { return !std::regex_search(benchmark.name, filter); });
+
+    if (opts.list)
+    {
+        for (auto const& benchmark : benchmarks)
+        {
+            fmt::print("{:s}\n", benchmark.name);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (!opts.json)
+    {
+        print_table_header();
+    }
+
+    auto runs = std::vector<Run>{};
+    for (size_t family_index = 0; family_index < std::size(benchmarks); ++family_index)
+    {
+        auto const& benchmark = benchmarks[family_index];
+
+        auto [first, iterations] = calibrate(benchmark, opts.min_time);
+        auto repetitions = std::vector<Result>{ std::move(first) };
+        while (std::size(repetitions) < opts.repetitions && std::empty(repetitions.front().error))
+        {
+            repetitions.emplace_back(run_once(benchmark, iterations));
+        }
+
+        for (size_t i = 0; i < std::size(repetitions); ++i)
+        {
+            if (!opts.json)
+            {
+                print_table_row(repetitions[i]);
+            }
+            runs.push_back({ repetitions[i], benchmark.name, {}, family_index, std::size(repetitions), i });
+        }
+
+        if (std::size(repetitions) > 1U)
+        {
+            for (auto const& agg : Aggregates)
+            {
+                auto result = aggregate(repetitions, agg);
+                if (!opts.json)
+                {
+                    print_table_row(result);
+                }
+                runs.push_back({ std::move(result), benchmark.name, agg.name, family_index, std::size(repetitions), 0U });
+            }
+        }
+    }
+
+    close_session();
+
+    auto const json = tr_variant_serde::json().to_string(to_json(runs, argv[0]));
+
+    if (opts.json)
+    {
+        fmt::print("{:s}\n", json);
+    }
+
+    if (!std::empty(opts.out_filename))
+    {
+        if (auto error = tr_error{}; !tr_file_save(opts.out_filename, json, &error))
+        {
+            fmt::print(stderr, "Couldn't save '{:s}': {:s} ({:d})\n", opts.out_filename, error.message(), error.code());
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto const failed = std::ranges::any_of(runs, [](auto const& run) { return !std::empty(run.result.error); });
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint> // uint64_t
+#include <ctime> // clock_t
+#include <functional>
+#include <string>
+#include <string_view>
+
+struct tr_session;
+
+/**
+ * A small benchmark harness for libtransmission's hot paths.
+ *
+ * Benchmarks register themselves with `TR_BENCHMARK()` or `tr::bench::add()`
+ * and loop on `State::keep_running()`. The runner picks an iteration count
+ * that makes each run last at least `--min-time` seconds, then reports the
+ * time per iteration as a table or, with `--json` or `--out`, as JSON in the
+ * same layout as Google Benchmark so that its `compare.py` can diff releases.
+ */
+namespace tr::bench
+{
+class State
+{
+public:
+    explicit State(uint64_t max_iterations) noexcept
+        : max_iterations_{ max_iterations }
+    {
+    }
+
+    [[nodiscard]] bool keep_running() noexcept
+    {
+        if (iterations_ == 0U)
+        {
+            resume_timing();
+        }
+
+        if (iterations_ < max_iterations_)
+        {
+            ++iterations_;
+            return true;
+        }
+
+        pause_timing();
+        return false;
+    }
+
+    // Use these to keep per-iteration setup out of the measurement
+    void pause_timing() noexcept
+    {
+        real_time_ += std::chrono::steady_clock::now() - real_begin_;
+        cpu_time_ += std::clock() - cpu_begin_;
+    }
+
+    void resume_timing() noexcept
+    {
+        real_begin_ = std::chrono::steady_clock::now();
+        cpu_begin_ = std::clock();
+    }
+
+    // If set, throughput is reported too
+    constexpr void set_bytes_processed(uint64_t const n_bytes) noexcept
+    {
+        bytes_processed_ = n_bytes;
+    }
+
+    constexpr void set_items_processed(uint64_t const n_items) noexcept
+    {
+        items_processed_ = n_items;
+    }
+
+    // Report that the benchmark could not run, e.g. because an asset is missing
+    void skip_with_error(std::string_view message)
+    {
+        error_ = message;
+        max_iterations_ = 0U;
+    }
+
+    [[nodiscard]] constexpr auto iterations() const noexcept
+    {
+        return iterations_;
+    }
+
+    [[nodiscard]] constexpr auto max_iterations() const noexcept
+    {
+        return max_iterations_;
+    }
+
+    [[nodiscard]] constexpr auto real_time() const noexcept
+    {
+        return real_time_;
+    }
+
+    [[nodiscard]] std::chrono::duration<double> cpu_time() const noexcept
+    {
+        return std::chrono::duration<double>{ static_cast<double>(cpu_time_) / CLOCKS_PER_SEC };
+    }
+
+    [[nodiscard]] constexpr auto bytes_processed() const noexcept
+    {
+        return bytes_processed_;
+    }
+
+    [[nodiscard]] constexpr auto items_processed() const noexcept
+    {
+        return items_processed_;
+    }
+
+    [[nodiscard]] constexpr auto const& error() const noexcept
+    {
+        return error_;
+    }
+
+private:
+    std::string error_;
+    std::chrono::steady_clock::time_point real_begin_;
+    std::chrono::steady_clock::duration real_time_ = {};
+    uint64_t max_iterations_;
+    uint64_t iterations_ = 0U;
+    uint64_t bytes_processed_ = 0U;
+    uint64_t items_processed_ = 0U;
+    std::clock_t cpu_begin_ = {};
+    std::clock_t cpu_time_ = {};
+};
+
+using Function = std::function<void(State&)>;
+
+// Always returns true, so that it can initialize a static variable
+bool add(std::string name, Function func);
+
+// Keeps the compiler from optimizing away a result that is never used
+template<typename T>
+void do_not_optimize(T const& value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static void const* volatile sink = nullptr;
+    sink = &value;
+#endif
+}
+
+// The test assets, e.g. real .torrent files
+[[nodiscard]] std::string_view assets_dir() noexcept;
+
+// A session and a scratch directory shared by the benchmarks that need them.
+// Both are created on first use and removed when the runner exits.
+[[nodiscard]] tr_session* session();
+[[nodiscard]] std::string_view sandbox_dir();
+} // namespace tr::bench
+
+#define TR_BENCHMARK(func) static bool const func##_is_registered = ::tr::bench::add(#func, func)
@@ -0,0 +1,178 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/bitfield.h>
+
+#include "bench.h"
+
+using State = tr::bench::State;
+
+namespace
+{
+// A 4 GiB torrent, counted in 256 KiB pieces and in 16 KiB blocks
+auto constexpr Sizes = std::array<size_t, 2>{ 16384U, 262144U };
+
+// Half of the bits are set, at random
+[[nodiscard]] tr_bitfield make_random_bitfield(size_t const bit_count, unsigned const seed)
+{
+    auto rng = std::mt19937{ seed };
+    auto raw = std::vector<uint8_t>((bit_count + 7U) / 8U);
+    std::ranges::generate(raw, [&rng]() { return static_cast<uint8_t>(rng()); });
+
+    auto bitfield = tr_bitfield{ bit_count };
+    bitfield.set_raw(std::data(raw), std::size(raw));
+    return bitfield;
+}
+
+[[nodiscard]] std::vector<size_t> make_random_indices(size_t const bit_count, size_t const n, unsigned const seed)
+{
+    auto rng = std::mt19937{ seed };
+    auto dist = std::uniform_int_distribution<size_t>{ 0U, bit_count - 1U };
+    auto indices = std::vector<size_t>(n);
+    std::ranges::generate(indices, [&]() { return dist(rng); });
+    return indices;
+}
+
+void bitfield_count_range(State& state, size_t const bit_count)
+{
+    auto const bitfield = make_random_bitfield(bit_count, 1U);
+    auto const begins = make_random_indices(bit_count / 2U, 1024U, 2U);
+
+    auto i = size_t{};
+    while (state.keep_running())
+    {
+        auto const begin = begins[i++ % std::size(begins)];
+        tr::bench::do_not_optimize(bitfield.count(begin, begin + bit_count / 2U));
+    }
+
+    state.set_items_processed(state.iterations());
+}
+
+void bitfield_set_and_unset(State& state, size_t const bit_count)
+{
+    auto bitfield = make_random_bitfield(bit_count, 1U);
+    auto const indices = make_random_indices(bit_count, 1024U, 2U);
+
+    while (state.keep_running())
+    {
+        for (auto const idx : indices)
+        {
+            bitfield.set(idx);
+        }
+
+        for (auto const idx : indices)
+        {
+            bitfield.unset(idx);
+        }
+
+        tr::bench::do_not_optimize(bitfield.count());
+    }
+
+    state.set_items_processed(state.iterations() * std::size(indices) * 2U);
+}
+
+void bitfield_set_span(State& state, size_t const bit_count)
+{
+    auto bitfield = tr_bitfield{ bit_count };
+    auto const begins = make_random_indices(bit_count - 64U, 1024U, 2U);
+
+    auto i = size_t{};
+    while (state.keep_running())
+    {
+        // a piece's worth of blocks
+        auto const begin = begins[i++ % std::size(begins)];
+        bitfield.set_span(begin, begin + 16U);
+        bitfield.unset_span(begin, begin + 16U);
+    }
+
+    tr::bench::do_not_optimize(bitfield.count());
+    state.set_items_processed(state.iterations() * 2U);
+}
+
+// e.g. handling a peer's Bitfield message
+void bitfield_set_raw(State& state, size_t const bit_count)
+{
+    auto const raw = make_random_bitfield(bit_count, 1U).raw();
+
+    auto bitfield = tr_bitfield{ bit_count };
+    while (state.keep_running())
+    {
+        bitfield.set_raw(std::data(raw), std::size(raw));
+        tr::bench::do_not_optimize(bitfield.count());
+    }
+
+    state.set_bytes_processed(state.iterations() * std::size(raw));
+}
+
+void bitfield_or(State& state, size_t const bit_count)
+{
+    auto const a = make_random_bitfield(bit_count, 1U);
+    auto const b = make_random_bitfield(bit_count, 2U);
+
+    auto tmp = tr_bitfield{ bit_count };
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        tmp = a;
+        state.resume_timing();
+
+        tmp |= b;
+        tr::bench::do_not_optimize(tmp.count());
+    }
+
+    state.set_bytes_processed(state.iterations() * bit_count / 8U);
+}
+
+// e.g. checking whether a peer has anything we want
+void bitfield_count_intersection(State& state, size_t const bit_count)
+{
+    auto const a = make_random_bitfield(bit_count, 1U);
+    auto const b = make_random_bitfield(bit_count, 2U);
+
+    while (state.keep_running())
+    {
+        tr::bench::do_not_optimize(a.count_intersection(b));
+    }
+
+    state.set_bytes_processed(state.iterations() * bit_count / 8U);
+}
+
+bool const is_registered = []
+{
+    using Func = void (*)(State&, size_t);
+    static auto constexpr Benchmarks = std::array<std::pair<char const*, Func>, 6>{ {
+        { "bitfield_count_range", bitfield_count_range },
+        { "bitfield_set_and_unset", bitfield_set_and_unset },
+        { "bitfield_set_span", bitfield_set_span },
+        { "bitfield_set_raw", bitfield_set_raw },
+        { "bitfield_or", bitfield_or },
+        { "bitfield_count_intersection", bitfield_count_intersection },
+    } };
+
+    for (auto const& [name, func] : Benchmarks)
+    {
+        for (auto const bit_count : Sizes)
+        {
+            tr::bench::add(
+                fmt::format("{:s}/{:d}", name, bit_count),
+                [func, bit_count](State& state) { func(state, bit_count); });
+        }
+    }
+
+    return true;
+}();
+} // namespace
@@ -0,0 +1,112 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <iterator> // std::back_inserter
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/blocklist.h>
+#include <libtransmission/file.h>
+#include <libtransmission/file-utils.h>
+#include <libtransmission/net.h>
+#include <libtransmission/tr-strbuf.h>
+
+#include "bench.h"
+
+using State = tr::bench::State;
+
+namespace
+{
+// About the size of the popular level1 list
+auto constexpr RangeCount = size_t{ 200000U };
+
+[[nodiscard]] std::string to_dotted_quad(uint32_t const addr)
+{
+    return fmt::format("{:d}.{:d}.{:d}.{:d}", (addr >> 24U) & 0xFFU, (addr >> 16U) & 0xFFU, (addr >> 8U) & 0xFFU, addr & 0xFFU);
+}
+
+// A PeerGuardian P2P list of sorted, disjoint ranges that are spread across the IPv4 space
+[[nodiscard]] std::string make_blocklist()
+{
+    // fixed seed, so that every run sees the same list
+    auto rng = std::mt19937{ 200000U };
+    auto gap = std::uniform_int_distribution<uint32_t>{ 1U, 20000U };
+    auto width = std::uniform_int_distribution<uint32_t>{ 0U, 1000U };
+
+    auto out = fmt::memory_buffer{};
+    auto begin = uint32_t{};
+    for (size_t i = 0; i < RangeCount; ++i)
+    {
+        begin += gap(rng);
+        auto const end = begin + width(rng);
+        fmt::format_to(std::back_inserter(out), "range {:d}:{:s}-{:s}\n", i, to_dotted_quad(begin), to_dotted_quad(end));
+        begin = end;
+    }
+
+    return fmt::to_string(out);
+}
+
+[[nodiscard]] tr::Blocklists const* get_blocklists()
+{
+    static auto blocklists = tr::Blocklists{};
+    static auto const is_loaded = []()
+    {
+        auto const folder = tr_pathbuf{ tr::bench::sandbox_dir(), "/blocklists" };
+        if (!tr_sys_dir_create(folder, TR_SYS_DIR_CREATE_PARENTS, 0777) ||
+            !tr_file_save(tr_pathbuf{ folder, "/level1" }, make_blocklist()))
+        {
+            return false;
+        }
+
+        blocklists.load(folder, true);
+        return blocklists.num_rules() > 0U;
+    }();
+
+    return is_loaded ? &blocklists : nullptr;
+}
+
+// e.g. checking every incoming connection and every address a tracker sends us
+void blocklists_contains(State& state)
+{
+    auto const* const blocklists = get_blocklists();
+    if (blocklists == nullptr)
+    {
+        state.skip_with_error("couldn't load the blocklist");
+        return;
+    }
+
+    auto rng = std::mt19937{ 1U };
+    auto addrs = std::vector<tr_address>{};
+    addrs.reserve(4096U);
+    while (std::size(addrs) < 4096U)
+    {
+        if (auto const addr = tr_address::from_string(to_dotted_quad(static_cast<uint32_t>(rng()))); addr)
+        {
+            addrs.emplace_back(*addr);
+        }
+    }
+
+    // the rules are read lazily, so don't count that
+    tr::bench::do_not_optimize(blocklists->contains(addrs.front()));
+
+    auto i = size_t{};
+    while (state.keep_running())
+    {
+        tr::bench::do_not_optimize(blocklists->contains(addrs[i++ % std::size(addrs)]));
+    }
+
+    state.set_items_processed(state.iterations());
+}
+
+TR_BENCHMARK(blocklists_contains);
+} // namespace
@@ -0,0 +1,80 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/crypto-utils.h>
+#include <libtransmission/tr-arc4.h>
+
+#include "bench.h"
+
+using State = tr::bench::State;
+
+namespace
+{
+// a block, and a typical piece
+auto constexpr Sizes = std::array<size_t, 2>{ 16384U, 1048576U };
+
+[[nodiscard]] std::vector<uint8_t> make_random_bytes(size_t const n_bytes)
+{
+    // fixed seed, so that every run sees the same data
+    auto rng = std::mt19937{ 1U };
+    auto bytes = std::vector<uint8_t>(n_bytes);
+    std::ranges::generate(bytes, [&rng]() { return static_cast<uint8_t>(rng()); });
+    return bytes;
+}
+
+// e.g. checking a piece
+void sha1(State& state, size_t const n_bytes)
+{
+    auto const data = make_random_bytes(n_bytes);
+
+    while (state.keep_running())
+    {
+        tr::bench::do_not_optimize(tr_sha1::digest(data));
+    }
+
+    state.set_bytes_processed(state.iterations() * n_bytes);
+}
+
+// e.g. encrypting a Piece message for a peer using MSE
+void arc4(State& state, size_t const n_bytes)
+{
+    auto const key = make_random_bytes(20U);
+    auto const data = make_random_bytes(n_bytes);
+    auto out = std::vector<uint8_t>(n_bytes);
+
+    auto cipher = tr_arc4{ std::data(key), std::size(key) };
+    cipher.discard(1024U);
+
+    while (state.keep_running())
+    {
+        cipher.process(std::data(data), std::size(data), std::data(out));
+        tr::bench::do_not_optimize(out);
+    }
+
+    state.set_bytes_processed(state.iterations() * n_bytes);
+}
+
+bool const is_registered = []
+{
+    for (auto const n_bytes : Sizes)
+    {
+        tr::bench::add(fmt::format("tr_sha1/{:d}", n_bytes), [n_bytes](State& state) { sha1(state, n_bytes); });
+        tr::bench::add(fmt::format("tr_arc4/{:d}", n_bytes), [n_bytes](State& state) { arc4(state, n_bytes); });
+    }
+
+    return true;
+}();
+} // namespace
@@ -0,0 +1,136 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <random>
+#include <span>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/block-info.h>
+#include <libtransmission/inout.h>
+#include <libtransmission/open-files.h>
+#include <libtransmission/torrent.h>
+#include <libtransmission/tr-strbuf.h>
+
+#include "bench.h"
+
+using namespace std::literals;
+using State = tr::bench::State;
+
+namespace
+{
+// Only touch the start of the torrent, so that its file stays small
+auto constexpr WorkingSetBlocks = tr_block_index_t{ 4096U }; // 64 MiB
+
+// A single-file torrent of a couple of GiB, added paused to the shared session.
+// Its data goes in the shared sandbox and is written sparsely, as needed.
+[[nodiscard]] tr_torrent* get_torrent()
+{
+    static auto* const tor = []() -> tr_torrent*
+    {
+        auto* const ctor = tr_ctorNew(tr::bench::session());
+        auto const filename = tr_pathbuf{ tr::bench::assets_dir(), "/ubuntu-20.04.4-desktop-amd64.iso.torrent"sv };
+        if (!tr_ctorSetMetainfoFromFile(ctor, filename))
+        {
+            tr_ctorFree(ctor);
+            return nullptr;
+        }
+
+        tr_ctorSetPaused(ctor, TR_FORCE, true);
+        auto* const ret = tr_torrentNew(ctor, nullptr);
+        tr_ctorFree(ctor);
+        return ret;
+    }();
+
+    return tor;
+}
+
+[[nodiscard]] std::vector<uint8_t> make_block(tr_torrent const& tor)
+{
+    // fixed seed, so that every run writes the same data
+    auto rng = std::mt19937{ 1U };
+    auto block = std::vector<uint8_t>(tor.block_size(0U));
+    std::ranges::generate(block, [&rng]() { return static_cast<uint8_t>(rng()); });
+    return block;
+}
+
+void tr_ioWrite_blocks(State& state)
+{
+    auto* const tor = get_torrent();
+    if (tor == nullptr)
+    {
+        state.skip_with_error("couldn't add the torrent");
+        return;
+    }
+
+    auto open_files = tr_open_files{};
+    auto const block = make_block(*tor);
+
+    auto next = tr_block_index_t{};
+    while (state.keep_running())
+    {
+        if (tr_ioWrite(*tor, open_files, tor->block_loc(next), block) != 0)
+        {
+            state.skip_with_error("tr_ioWrite() failed");
+            break;
+        }
+
+        next = (next + 1U) % WorkingSetBlocks;
+    }
+
+    state.set_bytes_processed(state.iterations() * std::size(block));
+}
+
+void tr_ioRead_blocks(State& state)
+{
+    auto* const tor = get_torrent();
+    if (tor == nullptr)
+    {
+        state.skip_with_error("couldn't add the torrent");
+        return;
+    }
+
+    auto open_files = tr_open_files{};
+    auto block = make_block(*tor);
+
+    // make sure that there is something to read
+    static auto is_prefilled = false;
+    for (tr_block_index_t i = 0; !is_prefilled && i < WorkingSetBlocks; ++i)
+    {
+        if (tr_ioWrite(*tor, open_files, tor->block_loc(i), block) != 0)
+        {
+            state.skip_with_error("tr_ioWrite() failed");
+            return;
+        }
+    }
+    is_prefilled = true;
+
+    // read in the random order that peers tend to ask for blocks
+    auto rng = std::mt19937{ 2U };
+    auto dist = std::uniform_int_distribution<tr_block_index_t>{ 0U, WorkingSetBlocks - 1U };
+
+    while (state.keep_running())
+    {
+        if (tr_ioRead(*tor, open_files, tor->block_loc(dist(rng)), block) != 0)
+        {
+            state.skip_with_error("tr_ioRead() failed");
+            break;
+        }
+
+        tr::bench::do_not_optimize(block);
+    }
+
+    state.set_bytes_processed(state.iterations() * std::size(block));
+}
+
+TR_BENCHMARK(tr_ioWrite_blocks);
+TR_BENCHMARK(tr_ioRead_blocks);
+} // namespace
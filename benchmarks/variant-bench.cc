@@ -0,0 +1,189 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <cstdint> // int64_t, uint64_t
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/crypto-utils.h>
+#include <libtransmission/file-utils.h>
+#include <libtransmission/quark.h>
+#include <libtransmission/tr-strbuf.h>
+#include <libtransmission/variant.h>
+
+#include "bench.h"
+
+using namespace std::literals;
+using State = tr::bench::State;
+
+namespace
+{
+[[nodiscard]] std::optional<std::string> load_asset(std::string_view const filename)
+{
+    auto contents = std::vector<char>{};
+    if (!tr_file_read(tr_pathbuf{ tr::bench::assets_dir(), '/', filename }, contents))
+    {
+        return {};
+    }
+
+    return std::string{ std::data(contents), std::size(contents) };
+}
+
+// A `torrent_get` response for a large library, like the web client polls for
+[[nodiscard]] std::string make_torrent_get_response()
+{
+    static auto constexpr NumTorrents = 2000;
+
+    // fixed seed, so that every run sees the same payload
+    auto rng = std::mt19937{ 2000U };
+    auto dist = std::uniform_int_distribution<int64_t>{ 0, 1000000000 };
+
+    auto torrents = tr_variant::Vector{};
+    torrents.reserve(NumTorrents);
+    for (int i = 0; i < NumTorrents; ++i)
+    {
+        auto const total_size = dist(rng) * 64;
+
+        auto labels = tr_variant::Vector{};
+        labels.emplace_back(fmt::format("label-{:d}", i % 7));
+
+        auto const name = fmt::format("Some.Linux.Distribution.{:d}.x86_64.iso", i);
+
+        auto torrent = tr_variant::Map{ 16U };
+        torrent.try_emplace(TR_KEY_id, i + 1);
+        torrent.try_emplace(TR_KEY_hash_string, tr_sha1_to_string(tr_sha1::digest(name)));
+        torrent.try_emplace(TR_KEY_name, name);
+        torrent.try_emplace(TR_KEY_status, i % 7);
+        torrent.try_emplace(TR_KEY_percent_done, static_cast<double>(dist(rng)) / 1e9);
+        torrent.try_emplace(TR_KEY_rate_download, dist(rng) % 5000000);
+        torrent.try_emplace(TR_KEY_rate_upload, dist(rng) % 1000000);
+        torrent.try_emplace(TR_KEY_eta, dist(rng) % 86400);
+        torrent.try_emplace(TR_KEY_peers_connected, dist(rng) % 50);
+        torrent.try_emplace(TR_KEY_size_when_done, total_size);
+        torrent.try_emplace(TR_KEY_total_size, total_size);
+        torrent.try_emplace(TR_KEY_upload_ratio, static_cast<double>(dist(rng)) / 1e8);
+        torrent.try_emplace(TR_KEY_error, 0);
+        torrent.try_emplace(TR_KEY_error_string, ""sv);
+        torrent.try_emplace(TR_KEY_download_dir, "/home/user/Downloads"sv);
+        torrent.try_emplace(TR_KEY_labels, std::move(labels));
+        torrents.emplace_back(std::move(torrent));
+    }
+
+    auto result = tr_variant::Map{ 1U };
+    result.try_emplace(TR_KEY_torrents, std::move(torrents));
+
+    auto response = tr_variant::Map{ 3U };
+    response.try_emplace(TR_KEY_jsonrpc, "2.0"sv);
+    response.try_emplace(TR_KEY_result, std::move(result));
+    response.try_emplace(TR_KEY_id, 1);
+    return tr_variant_serde::json().compact().to_string(tr_variant{ std::move(response) });
+}
+
+void parse(State& state, tr_variant_serde serde, std::string_view const payload)
+{
+    while (state.keep_running())
+    {
+        auto var = serde.parse(payload);
+        tr::bench::do_not_optimize(var);
+    }
+
+    state.set_bytes_processed(state.iterations() * std::size(payload));
+}
+
+void parse_inplace(State& state, tr_variant_serde serde, std::string_view const payload)
+{
+    // inplace parsing may modify its input, so give it a fresh copy each time
+    auto copy = std::string{};
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        copy = payload;
+        state.resume_timing();
+
+        auto var = serde.inplace().parse(copy);
+        tr::bench::do_not_optimize(var);
+    }
+
+    state.set_bytes_processed(state.iterations() * std::size(payload));
+}
+
+void serialize(State& state, tr_variant_serde serde, tr_variant const& var)
+{
+    auto n_bytes = uint64_t{};
+    while (state.keep_running())
+    {
+        auto const str = serde.to_string(var);
+        tr::bench::do_not_optimize(str);
+        n_bytes += std::size(str);
+    }
+
+    state.set_bytes_processed(n_bytes);
+}
+
+using Loader = std::optional<std::string> (*)(std::string_view name);
+
+void register_payload(std::string_view const name, Loader const load, bool const is_benc)
+{
+    auto const make_serde = [is_benc]()
+    {
+        return is_benc ? tr_variant_serde::benc() : tr_variant_serde::json();
+    };
+
+    // Runs `func` on the payload, or reports that it couldn't be loaded
+    auto const add = [&](std::string_view const operation, auto func)
+    {
+        tr::bench::add(
+            fmt::format("{:s}/{:s}", operation, name),
+            [name = std::string{ name }, load, make_serde, func](State& state)
+            {
+                if (auto const payload = load(name); payload)
+                {
+                    func(state, make_serde(), *payload);
+                }
+                else
+                {
+                    state.skip_with_error(fmt::format("couldn't load '{:s}'", name));
+                }
+            });
+    };
+
+    add(is_benc ? "variant_parse_benc"sv : "variant_parse_json"sv, parse);
+    add(is_benc ? "variant_parse_benc_inplace"sv : "variant_parse_json_inplace"sv, parse_inplace);
+
+    add("variant_serialize_benc"sv,
+        [](State& state, tr_variant_serde serde, std::string_view const payload)
+        { serialize(state, tr_variant_serde::benc(), serde.parse(payload).value_or(tr_variant{})); });
+
+    add("variant_serialize_json"sv,
+        [](State& state, tr_variant_serde serde, std::string_view const payload)
+        { serialize(state, tr_variant_serde::json().compact(), serde.parse(payload).value_or(tr_variant{})); });
+}
+
+bool const is_registered = []
+{
+    // a multi-file torrent, and a single-file one with a lot of pieces
+    register_payload("alice_in_wonderland_librivox_archive.torrent"sv, load_asset, true);
+    register_payload("ubuntu-20.04.4-desktop-amd64.iso.torrent"sv, load_asset, true);
+
+    register_payload(
+        "torrent_get_response"sv,
+        [](std::string_view /*name*/)
+        {
+            static auto const payload = make_torrent_get_response();
+            return std::optional<std::string>{ payload };
+        },
+        false);
+
+    return true;
+}();
+} // namespace
@@ -0,0 +1,195 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+#define LIBTRANSMISSION_PEER_MODULE
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/bitfield.h>
+#include <libtransmission/peer-mgr-wishlist.h>
+
+#include "bench.h"
+
+using State = tr::bench::State;
+
+namespace
+{
+// A 4 GiB torrent in 512 KiB pieces, a third of which we already have
+auto constexpr PieceCount = tr_piece_index_t{ 8192U };
+auto constexpr BlocksPerPiece = tr_block_index_t{ 32U };
+
+// How many blocks peer-mgr asks a peer for at once
+auto constexpr RequestBatchSize = size_t{ 64U };
+
+auto constexpr SwarmSizes = std::array<size_t, 2>{ 50U, 1000U };
+
+[[nodiscard]] tr_bitfield make_random_bitfield(std::mt19937& rng, size_t const bit_count, unsigned const percent_set)
+{
+    auto bitfield = tr_bitfield{ bit_count };
+    auto dist = std::uniform_int_distribution<unsigned>{ 0U, 99U };
+    for (size_t i = 0; i < bit_count; ++i)
+    {
+        if (dist(rng) < percent_set)
+        {
+            bitfield.set(i);
+        }
+    }
+    return bitfield;
+}
+
+class Swarm final : public Wishlist::Mediator
+{
+public:
+    explicit Swarm(size_t const peer_count)
+        : client_has_{ PieceCount }
+        , replication_(PieceCount)
+    {
+        // fixed seed, so that every run sees the same swarm
+        auto rng = std::mt19937{ 8192U };
+
+        client_has_ = make_random_bitfield(rng, PieceCount, 33U);
+
+        peers_.reserve(peer_count);
+        for (size_t i = 0; i < peer_count; ++i)
+        {
+            // a tenth of the swarm are seeds
+            auto& have = peers_.emplace_back(PieceCount);
+            if (i % 10U == 0U)
+            {
+                have.set_has_all();
+            }
+            else
+            {
+                have = make_random_bitfield(rng, PieceCount, 50U);
+            }
+
+            for (tr_piece_index_t piece = 0; piece < PieceCount; ++piece)
+            {
+                replication_[piece] += have.test(piece) ? 1U : 0U;
+            }
+        }
+    }
+
+    [[nodiscard]] constexpr auto const& peers() const noexcept
+    {
+        return peers_;
+    }
+
+    [[nodiscard]] bool client_has_block(tr_block_index_t const block) const override
+    {
+        return client_has_.test(block / BlocksPerPiece);
+    }
+
+    [[nodiscard]] bool client_has_piece(tr_piece_index_t const piece) const override
+    {
+        return client_has_.test(piece);
+    }
+
+    [[nodiscard]] bool client_wants_piece(tr_piece_index_t /*piece*/) const override
+    {
+        return true;
+    }
+
+    [[nodiscard]] bool is_sequential_download() const override
+    {
+        return false;
+    }
+
+    [[nodiscard]] tr_piece_index_t sequential_download_from_piece() const override
+    {
+        return 0U;
+    }
+
+    [[nodiscard]] size_t count_piece_replication(tr_piece_index_t const piece) const override
+    {
+        return replication_[piece];
+    }
+
+    [[nodiscard]] tr_block_span_t block_span(tr_piece_index_t const piece) const override
+    {
+        return { .begin = piece * BlocksPerPiece, .end = (piece + 1U) * BlocksPerPiece };
+    }
+
+    [[nodiscard]] tr_piece_index_t piece_count() const override
+    {
+        return PieceCount;
+    }
+
+    [[nodiscard]] tr_priority_t priority(tr_piece_index_t /*piece*/) const override
+    {
+        return TR_PRI_NORMAL;
+    }
+
+private:
+    tr_bitfield client_has_;
+    std::vector<size_t> replication_;
+    std::vector<tr_bitfield> peers_;
+};
+
+// One request pulse: ask for a batch of blocks for every peer in the swarm
+void wishlist_next(State& state, size_t const peer_count)
+{
+    auto swarm = Swarm{ peer_count };
+    auto wishlist = Wishlist{ swarm };
+
+    auto n_blocks = size_t{};
+    while (state.keep_running())
+    {
+        for (auto const& have : swarm.peers())
+        {
+            for (auto const& span : wishlist.next(RequestBatchSize, have))
+            {
+                n_blocks += span.end - span.begin;
+            }
+        }
+    }
+
+    tr::bench::do_not_optimize(n_blocks);
+    state.set_items_processed(state.iterations() * peer_count);
+}
+
+// Peers connecting and disconnecting, which changes the pieces' replication
+void wishlist_peer_churn(State& state, size_t const peer_count)
+{
+    auto swarm = Swarm{ peer_count };
+    auto wishlist = Wishlist{ swarm };
+    auto const no_requests = tr_bitfield{ PieceCount * BlocksPerPiece };
+
+    auto i = size_t{};
+    while (state.keep_running())
+    {
+        auto const& have = swarm.peers()[i++ % peer_count];
+        wishlist.on_peer_disconnect(have, no_requests);
+        wishlist.on_got_bitfield(have);
+    }
+
+    state.set_items_processed(state.iterations());
+}
+
+bool const is_registered = []
+{
+    for (auto const peer_count : SwarmSizes)
+    {
+        tr::bench::add(
+            fmt::format("wishlist_next/{:d}_peers", peer_count),
+            [peer_count](State& state) { wishlist_next(state, peer_count); });
+
+        tr::bench::add(
+            fmt::format("wishlist_peer_churn/{:d}_peers", peer_count),
+            [peer_count](State& state) { wishlist_peer_churn(state, peer_count); });
+    }
+
+    return true;
+}();
+} // namespace
@@ -42,20 +42,27 @@ void set_system_error(tr_error& error, DWORD code, char const* message)
     error.set(code, fmt::format("{:s} ({:#08x}): {:s})", message, code, system_message));
 }
 
-void do_log_system_error(char const* file, int line, tr_log_level level, DWORD code, char const* message)
+void do_log_system_error(
+    tr_log_repeats& repeats,
+    char const* file,
+    int line,
+    tr_log_level level,
+    DWORD code,
+    char const* message)
 {
     auto const system_message = tr_win32_format_message(code);
-    tr_logAddMessage(file, line, level, fmt::format("{} ({:#x}): {}", message, code, system_message), "tr_daemon");
+    tr_logAddMessage(repeats, file, line, level, fmt::format("{} ({:#x}): {}", message, code, system_message), "tr_daemon");
 }
 
 #define log_system_error(level, code, message) \
     do \
     { \
         DWORD const local_code = (code); \
+        static auto tr_log_call_site_repeats = tr_log_repeats{}; \
 \
-        if (tr_logLevelIsActive((level))) \
+        if (tr_logLevelIsActive((level)) && !tr_logIsMuted(tr_log_call_site_repeats)) \
         { \
-            do_log_system_error(__FILE__, __LINE__, (level), local_code, (message)); \
+            do_log_system_error(tr_log_call_site_repeats, __FILE__, __LINE__, (level), local_code, (message)); \
         } \
     } while (0)
 
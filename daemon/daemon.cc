@@ -3,15 +3,20 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
+#include <cstddef> // size_t
 #include <cstdint>
 #include <cstdio> /* printf */
 #include <iostream>
 #include <iterator> /* std::back_inserter */
 #include <memory>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #ifdef HAVE_SYSLOG
@@ -181,90 +186,141 @@ namespace
     return tr_getDefaultConfigDir(MyName);
 }
 
-auto onFileAdded(tr_session* session, std::string_view dirname, std::string_view basename)
+// Read a watchdir file's metainfo into `ctor`.
+// This doesn't touch the session, so it's safe to call from any thread.
+bool loadWatchdirFile(
+    tr_ctor* const ctor,
+    std::string_view const filename,
+    std::string_view const basename,
+    bool const is_torrent)
 {
-    auto const lowercase = tr_strlower(basename);
-    auto const is_torrent = tr_strv_ends_with(lowercase, ".torrent"sv);
-    auto const is_magnet = tr_strv_ends_with(lowercase, ".magnet"sv);
-
-    if (!is_torrent && !is_magnet)
+    if (is_torrent)
     {
-        return Watchdir::Action::Done;
+        return tr_ctorSetMetainfoFromFile(ctor, filename);
     }
 
-    auto const filename = tr_pathbuf{ dirname, '/', basename };
-    tr_ctor* const ctor = tr_ctorNew(session);
+    // is_magnet
+    auto content = std::vector<char>{};
+    auto error = tr_error{};
+    if (!tr_file_read(filename, content, &error))
+    {
+        tr_logAddWarn(
+            fmt::format(
+                fmt::runtime(_("Couldn't read '{path}': {error} ({error_code})")),
+                fmt::arg("path", basename),
+                fmt::arg("error", error.message()),
+                fmt::arg("error_code", error.code())));
+        return false;
+    }
 
-    bool retry = false;
+    auto const content_sv = std::string_view{ content.data(), content.size() };
+    return tr_ctorSetMetainfoFromMagnetLink(ctor, content_sv);
+}
 
-    if (is_torrent)
+void addWatchdirTorrent(tr_ctor* const ctor, std::string_view const filename, std::string_view const basename)
+{
+    if (tr_torrentNew(ctor, nullptr) == nullptr)
     {
-        if (!tr_ctorSetMetainfoFromFile(ctor, filename))
-        {
-            retry = true;
-        }
+        tr_logAddError(fmt::format(fmt::runtime(_("Couldn't add torrent file '{path}'")), fmt::arg("path", basename)));
+        return;
     }
-    else // is_magnet
+
+    bool trash = false;
+    bool const test = tr_ctorGetDeleteSource(ctor, &trash);
+
+    if (test && trash)
     {
-        auto content = std::vector<char>{};
-        auto error = tr_error{};
-        if (!tr_file_read(filename, content, &error))
+        tr_logAddInfo(fmt::format(fmt::runtime(_("Removing torrent file '{path}'")), fmt::arg("path", basename)));
+
+        if (auto error = tr_error{}; !tr_sys_path_remove(filename, &error))
         {
-            tr_logAddWarn(
+            tr_logAddError(
                 fmt::format(
-                    fmt::runtime(_("Couldn't read '{path}': {error} ({error_code})")),
+                    fmt::runtime(_("Couldn't remove '{path}': {error} ({error_code})")),
                     fmt::arg("path", basename),
                     fmt::arg("error", error.message()),
                     fmt::arg("error_code", error.code())));
-            retry = true;
         }
-        else
+    }
+    else
+    {
+        tr_sys_path_rename(filename, tr_pathbuf{ filename, ".added"sv });
+    }
+}
+
+// When many files show up at once, e.g. when thousands of torrents are
+// copied into the watchdir, parse their metainfo in parallel. Only
+// adding the parsed torrents to the session has to be done one by one.
+auto onFilesAdded(tr_session* session, std::string_view dirname, std::vector<std::string> const& basenames)
+{
+    struct Item
+    {
+        tr_pathbuf filename;
+        std::string_view basename;
+        tr_ctor* ctor = nullptr;
+        bool is_torrent = false;
+        bool loaded = false;
+        size_t action_index = {};
+    };
+
+    auto actions = std::vector<Watchdir::Action>(std::size(basenames), Watchdir::Action::Done);
+    auto items = std::vector<Item>{};
+
+    for (size_t i = 0, n = std::size(basenames); i < n; ++i)
+    {
+        auto const& basename = basenames[i];
+        auto const lowercase = tr_strlower(basename);
+        auto const is_torrent = tr_strv_ends_with(lowercase, ".torrent"sv);
+        auto const is_magnet = tr_strv_ends_with(lowercase, ".magnet"sv);
+
+        if (is_torrent || is_magnet)
         {
-            auto const content_sv = std::string_view{ content.data(), content.size() };
-            if (!tr_ctorSetMetainfoFromMagnetLink(ctor, content_sv))
-            {
-                retry = true;
-            }
+            auto& item = items.emplace_back();
+            item.filename = tr_pathbuf{ dirname, '/', basename };
+            item.basename = basename;
+            item.ctor = tr_ctorNew(session);
+            item.is_torrent = is_torrent;
+            item.action_index = i;
         }
     }
 
-    if (retry)
+    auto next = std::atomic<size_t>{};
+    auto const load_items = [&items, &next]()
     {
-        tr_ctorFree(ctor);
-        return Watchdir::Action::Retry;
-    }
+        for (auto i = next++; i < std::size(items); i = next++)
+        {
+            auto& item = items[i];
+            item.loaded = loadWatchdirFile(item.ctor, item.filename, item.basename, item.is_torrent);
+        }
+    };
 
-    if (tr_torrentNew(ctor, nullptr) == nullptr)
+    auto const n_threads = std::min(size_t{ std::thread::hardware_concurrency() }, std::size(items));
+    auto threads = std::vector<std::thread>{};
+    for (size_t i = 1; i < n_threads; ++i)
     {
-        tr_logAddError(fmt::format(fmt::runtime(_("Couldn't add torrent file '{path}'")), fmt::arg("path", basename)));
+        threads.emplace_back(load_items);
     }
-    else
+    load_items();
+    for (auto& thread : threads)
     {
-        bool trash = false;
-        bool const test = tr_ctorGetDeleteSource(ctor, &trash);
+        thread.join();
+    }
 
-        if (test && trash)
+    for (auto& item : items)
+    {
+        if (item.loaded)
         {
-            tr_logAddInfo(fmt::format(fmt::runtime(_("Removing torrent file '{path}'")), fmt::arg("path", basename)));
-
-            if (auto error = tr_error{}; !tr_sys_path_remove(filename, &error))
-            {
-                tr_logAddError(
-                    fmt::format(
-                        fmt::runtime(_("Couldn't remove '{path}': {error} ({error_code})")),
-                        fmt::arg("path", basename),
-                        fmt::arg("error", error.message()),
-                        fmt::arg("error_code", error.code())));
-            }
+            addWatchdirTorrent(item.ctor, item.filename, item.basename);
         }
         else
         {
-            tr_sys_path_rename(filename, tr_pathbuf{ filename, ".added"sv });
+            actions[item.action_index] = Watchdir::Action::Retry;
         }
+
+        tr_ctorFree(item.ctor);
     }
 
-    tr_ctorFree(ctor);
-    return Watchdir::Action::Done;
+    return actions;
 }
 
 [[nodiscard]] constexpr char const* levelName(tr_log_level level)
@@ -916,9 +972,9 @@ int tr_daemon::start([[maybe_unused]] bool foreground)
         {
             tr_logAddInfo(fmt::format(fmt::runtime(_("Watching '{path}' for new torrent files")), fmt::arg("path", dir)));
 
-            auto handler = [session](std::string_view dirname, std::string_view basename)
+            auto handler = [session](std::string_view dirname, std::vector<std::string> const& basenames)
             {
-                return onFileAdded(session, dirname, basename);
+                return onFilesAdded(session, dirname, basenames);
             };
 
             auto timer_maker = tr::EvTimerMaker{ ev_base_ };
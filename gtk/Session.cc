@@ -49,6 +49,7 @@
 #include <array>
 #include <cinttypes> // PRId64
 #include <cstring> // strstr
+#include <ctime>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -198,6 +199,16 @@ private:
     std::array<bool, NUM_PORT_TEST_IP_PROTOCOL> port_test_pending_ = {};
     guint inhibit_cookie_ = 0;
     gint busy_count_ = 0;
+
+    // Only the torrents that libtransmission says have changed since
+    // the last update get updated, except for a full update every
+    // FullUpdateInterval updates. Speeds take a couple of seconds to
+    // decay after a transfer stops, so overlap the changed-since windows.
+    static auto constexpr FullUpdateInterval = 10U;
+    static auto constexpr ChangedSinceOverlapSeconds = time_t{ 3 };
+    time_t last_update_time_ = {};
+    unsigned int updates_since_full_update_ = FullUpdateInterval;
+
     Glib::RefPtr<Gio::ListStore<Torrent>> raw_model_;
     Glib::RefPtr<SortListModel<Torrent>> sorted_model_;
     Glib::RefPtr<TorrentSorter> sorter_ = TorrentSorter::create();
@@ -537,7 +548,11 @@ Session::Impl::Impl(Session& core, tr_session* session)
     , session_{ session }
 {
     raw_model_ = Gio::ListStore<Torrent>::create();
+#if GTKMM_CHECK_VERSION(4, 0, 0)
+    // Gtk::SortListModel doesn't watch its items, so it needs to be told to re-sort.
+    // Gtk::TreeModelSort moves each row into place as it changes, so it doesn't.
     signal_torrents_changed_.connect(sigc::hide<0>(sigc::mem_fun(*sorter_, &TorrentSorter::update)));
+#endif
     sorted_model_ = SortListModel<Torrent>::create(gtr_ptr_static_cast<Gio::ListModel>(raw_model_), sorter_);
 
     /* init from prefs & listen to pref changes */
@@ -1007,17 +1022,41 @@ void Session::Impl::update()
     auto torrent_ids = std::unordered_set<tr_torrent_id_t>();
     auto changes = Torrent::ChangeFlags();
 
-    /* update the model */
-    for (auto i = 0U, count = raw_model_->get_n_items(); i < count; ++i)
+    auto const update_torrent = [&torrent_ids, &changes](Torrent& torrent)
     {
-        auto const torrent = raw_model_->get_item(i);
-        if (auto const torrent_changes = torrent->update(); torrent_changes.any())
+        if (auto const torrent_changes = torrent.update(); torrent_changes.any())
         {
-            torrent_ids.insert(torrent->get_id());
+            torrent_ids.insert(torrent.get_id());
             changes |= torrent_changes;
         }
+    };
+
+    /* update the model */
+    auto const now = tr_time();
+    if (++updates_since_full_update_ >= FullUpdateInterval)
+    {
+        // Not every stat change marks the torrent as changed, e.g. the
+        // passing of time in ETAs, so update all of them once in a while
+        updates_since_full_update_ = 0;
+
+        for (auto i = 0U, count = raw_model_->get_n_items(); i < count; ++i)
+        {
+            update_torrent(*raw_model_->get_item(i));
+        }
+    }
+    else
+    {
+        for (auto const id : tr_sessionGetTorrentsChangedSince(session_, last_update_time_ - ChangedSinceOverlapSeconds))
+        {
+            if (auto const& [torrent, position] = find_torrent_by_id(id); torrent)
+            {
+                update_torrent(*torrent);
+            }
+        }
     }
 
+    last_update_time_ = now;
+
     /* update hibernation */
     maybe_inhibit_hibernation();
 
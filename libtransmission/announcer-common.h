@@ -9,6 +9,7 @@
 #error only the libtransmission announcer module should #include this header.
 #endif
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <compare>
@@ -174,7 +175,9 @@ struct tr_announce_response
  * This is only an upper bound: if the tracker complains about
  * length, announcer will incrementally lower the batch size.
  */
-auto inline constexpr TrMultiscrapeMax = 60U;
+auto inline constexpr TrHttpMultiscrapeMax = 60U;
+auto inline constexpr TrUdpMultiscrapeMax = 74U;
+auto inline constexpr TrMultiscrapeMax = std::max(TrHttpMultiscrapeMax, TrUdpMultiscrapeMax);
 
 auto inline constexpr TrAnnounceTimeoutSec = std::chrono::seconds{ 45 };
 auto inline constexpr TrScrapeTimeoutSec = std::chrono::seconds{ 30 };
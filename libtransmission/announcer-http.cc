@@ -280,6 +280,7 @@ void tr_tracker_http_announce(
     announce_url_new(url, session, request);
     auto options = tr_web::FetchOptions{ url.sv(), onAnnounceDone, d };
     options.timeout_secs = TrAnnounceTimeoutSec;
+    options.priority = tr_web::FetchOptions::Priority::High;
     options.sndbuf = 4096;
     options.rcvbuf = 4096;
 
@@ -557,6 +558,7 @@ void tr_tracker_http_scrape(tr_session const* session, tr_scrape_request const&
     tr_logAddTrace(fmt::format("Sending scrape to libcurl: '{}'", scrape_url), request.log_name);
     auto options = tr_web::FetchOptions{ scrape_url, onScrapeDone, d };
     options.timeout_secs = TrScrapeTimeoutSec;
+    options.priority = tr_web::FetchOptions::Priority::High;
     options.sndbuf = 4096;
     options.rcvbuf = 4096;
     session->fetch(std::move(options));
@@ -18,7 +18,9 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #include <ws2tcpip.h>
@@ -37,14 +39,17 @@
 #include "libtransmission/announcer.h"
 #include "libtransmission/announcer-common.h"
 #include "libtransmission/crypto-utils.h" // for tr_rand_obj()
+#include "libtransmission/file.h" // for tr_sys_path_exists()
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-mgr.h" // for tr_pex::fromCompact4()
+#include "libtransmission/quark.h"
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/tr-buffer.h"
 #include "libtransmission/tr-strbuf.h"
 #include "libtransmission/utils.h"
+#include "libtransmission/variant.h"
 #include "libtransmission/web-utils.h"
 
 #define logwarn(name, msg) tr_logAddWarn(msg, name)
@@ -357,14 +362,110 @@ private:
     std::shared_ptr<tau_announce_data> data_;
 };
 
+// --- TRANSACTIONS
+
+struct tau_tracker;
+
+// transaction id -> the tracker that's waiting for its response
+using tau_transactions = std::unordered_map<tau_transaction_t, tau_tracker*>;
+
+// A tracker's pending requests, kept in the order they were made
+// and indexed by transaction id so that responses can be matched in O(1).
+template<typename T>
+class tau_request_queue
+{
+public:
+    using iterator = typename std::list<T>::iterator;
+
+    tau_request_queue(tau_transactions& transactions, tau_tracker* const tracker)
+        : transactions_{ transactions }
+        , tracker_{ tracker }
+    {
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        auto& req = list_.emplace_back(std::forward<Args>(args)...);
+        index_.insert_or_assign(req.transaction_id, std::prev(std::end(list_)));
+        transactions_.insert_or_assign(req.transaction_id, tracker_);
+        return req;
+    }
+
+    [[nodiscard]] iterator find(tau_transaction_t const transaction_id)
+    {
+        auto const it = index_.find(transaction_id);
+        return it != std::end(index_) ? it->second : std::end(list_);
+    }
+
+    iterator erase(iterator const it)
+    {
+        if (auto const idx = index_.find(it->transaction_id); idx != std::end(index_) && idx->second == it)
+        {
+            index_.erase(idx);
+
+            if (auto const txn = transactions_.find(it->transaction_id);
+                txn != std::end(transactions_) && txn->second == tracker_)
+            {
+                transactions_.erase(txn);
+            }
+        }
+
+        return list_.erase(it);
+    }
+
+    void clear()
+    {
+        for (auto it = std::begin(list_); it != std::end(list_);)
+        {
+            it = erase(it);
+        }
+    }
+
+    [[nodiscard]] auto begin() noexcept
+    {
+        return std::begin(list_);
+    }
+
+    [[nodiscard]] auto end() noexcept
+    {
+        return std::end(list_);
+    }
+
+    [[nodiscard]] auto empty() const noexcept
+    {
+        return std::empty(list_);
+    }
+
+private:
+    std::list<T> list_;
+    std::unordered_map<tau_transaction_t, iterator> index_;
+
+    tau_transactions& transactions_;
+    tau_tracker* const tracker_;
+};
+
 // --- TRACKER
 
+// What we remember about a tracker between sessions, per address type,
+// so that the first requests after a restart can skip DNS and `connect`.
+struct tau_tracker_state
+{
+    std::optional<tr_socket_address> address;
+    time_t address_expires_at = {};
+    tau_connection_t connection_id = {};
+    time_t connection_id_expires_at = {};
+};
+
+using tau_tracker_states = std::array<tau_tracker_state, NUM_TR_AF_INET_TYPES>;
+
 struct tau_tracker
 {
     using Mediator = tr_announcer_udp::Mediator;
 
     tau_tracker(
         Mediator& mediator,
+        tau_transactions& transactions,
         std::string_view const authority_in,
         std::string_view const host_in,
         std::string_view const host_lookup_in,
@@ -373,10 +474,61 @@ struct tau_tracker
         , host{ host_in }
         , host_lookup{ host_lookup_in }
         , port{ port_in }
+        , announces{ transactions, this }
+        , scrapes{ transactions, this }
         , mediator_{ mediator }
+        , transactions_{ transactions }
     {
     }
 
+    tau_tracker(tau_tracker const&) = delete;
+    tau_tracker(tau_tracker&&) = delete;
+    tau_tracker& operator=(tau_tracker const&) = delete;
+    tau_tracker& operator=(tau_tracker&&) = delete;
+    ~tau_tracker() = default;
+
+    [[nodiscard]] tau_tracker_states state() const
+    {
+        auto states = tau_tracker_states{};
+
+        for (ipp_t ipp = 0; ipp < NUM_TR_AF_INET_TYPES; ++ipp)
+        {
+            auto& state = states[ipp];
+
+            if (auto const& addr = addr_[ipp]; addr)
+            {
+                state.address = tr_socket_address::from_sockaddr(reinterpret_cast<sockaddr const*>(&addr->first));
+                state.address_expires_at = addr_expires_at_[ipp];
+            }
+
+            state.connection_id = connection_id[ipp];
+            state.connection_id_expires_at = connection_expiration_time[ipp];
+        }
+
+        return states;
+    }
+
+    void restore_state(tau_tracker_states const& states, time_t const now)
+    {
+        for (ipp_t ipp = 0; ipp < NUM_TR_AF_INET_TYPES; ++ipp)
+        {
+            auto const& state = states[ipp];
+
+            if (state.address && state.address->address().type == static_cast<tr_address_type>(ipp) &&
+                now < state.address_expires_at)
+            {
+                addr_[ipp] = state.address->to_sockaddr();
+                addr_expires_at_[ipp] = state.address_expires_at;
+
+                if (state.connection_id != tau_connection_t{} && now < state.connection_id_expires_at)
+                {
+                    connection_id[ipp] = state.connection_id;
+                    connection_expiration_time[ipp] = state.connection_id_expires_at;
+                }
+            }
+        }
+    }
+
     void sendto(tr_address_type ip_protocol, std::byte const* buf, size_t buflen)
     {
         TR_ASSERT(tr_address::is_valid(ip_protocol));
@@ -404,6 +556,12 @@ struct tau_tracker
             return;
         }
 
+        if (auto const it = transactions_.find(connection_transaction_id[ip_protocol]);
+            it != std::end(transactions_) && it->second == this)
+        {
+            transactions_.erase(it);
+        }
+
         connecting_at[ip_protocol] = 0;
         connection_transaction_id[ip_protocol] = 0;
 
@@ -486,6 +644,7 @@ struct tau_tracker
 
                 conn_at = now;
                 conn_transc_id = tau_transaction_new();
+                transactions_.insert_or_assign(conn_transc_id, this);
                 logtrace(
                     log_name(),
                     fmt::format("Trying to connect {}. Transaction ID is {}", tr_ip_protocol_to_sv(ipp_enum), conn_transc_id));
@@ -560,20 +719,15 @@ private:
     }
 
     template<typename T>
-    void timeout_requests(std::list<T>& requests, time_t now, std::string_view name)
+    void timeout_requests(tau_request_queue<T>& requests, time_t now, std::string_view name)
     {
-        for (auto it = std::begin(requests); it != std::end(requests);)
+        // Requests of a given type share a TTL and are queued in the
+        // order they were made, so the ones that expire first are in front.
+        for (auto it = std::begin(requests); it != std::end(requests) && it->expires_at() <= now;)
         {
-            if (auto& req = *it; req.expires_at() <= now)
-            {
-                logtrace(log_name(), fmt::format("timeout {} req {}", name, fmt::ptr(&req)));
-                req.fail(false, true, "");
-                it = requests.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
+            logtrace(log_name(), fmt::format("timeout {} req {}", name, fmt::ptr(&*it)));
+            it->fail(false, true, "");
+            it = requests.erase(it);
         }
     }
 
@@ -591,7 +745,7 @@ private:
     }
 
     template<typename T>
-    void maybe_send_requests(std::list<T>& reqs, time_t now)
+    void maybe_send_requests(tau_request_queue<T>& reqs, time_t now)
     {
         for (auto it = std::begin(reqs); it != std::end(reqs);)
         {
@@ -654,11 +808,12 @@ public:
     std::array<tau_connection_t, NUM_TR_AF_INET_TYPES> connection_id = {};
     std::array<tau_transaction_t, NUM_TR_AF_INET_TYPES> connection_transaction_id = {};
 
-    std::list<tau_announce_request> announces;
-    std::list<tau_scrape_request> scrapes;
+    tau_request_queue<tau_announce_request> announces;
+    tau_request_queue<tau_scrape_request> scrapes;
 
 private:
     Mediator& mediator_;
+    tau_transactions& transactions_;
 
     std::array<std::optional<std::future<std::optional<tr_socket_address>>>, NUM_TR_AF_INET_TYPES> addr_pending_dns_;
 
@@ -677,6 +832,24 @@ public:
     explicit tr_announcer_udp_impl(Mediator& mediator)
         : mediator_{ mediator }
     {
+        if (auto const config_dir = mediator_.config_dir(); !std::empty(config_dir))
+        {
+            state_filename_ = tr_pathbuf{ config_dir, "/udp-trackers.dat"sv };
+            load_state();
+        }
+    }
+
+    tr_announcer_udp_impl(tr_announcer_udp_impl const&) = delete;
+    tr_announcer_udp_impl(tr_announcer_udp_impl&&) = delete;
+    tr_announcer_udp_impl& operator=(tr_announcer_udp_impl const&) = delete;
+    tr_announcer_udp_impl& operator=(tr_announcer_udp_impl&&) = delete;
+
+    ~tr_announcer_udp_impl() override
+    {
+        if (!std::empty(state_filename_))
+        {
+            save_state();
+        }
     }
 
     void announce(tr_announce_request const& request, tr_announce_response_func on_response) override
@@ -709,7 +882,7 @@ public:
 
     void upkeep() override
     {
-        for (auto& tracker : trackers_)
+        for (auto& tracker : trackers_ | std::views::values)
         {
             tracker.upkeep();
         }
@@ -737,47 +910,46 @@ public:
         // extract the transaction_id and look for a match
         tau_transaction_t const transaction_id = buf.to_uint32();
 
+        auto const txn = transactions_.find(transaction_id);
+        if (txn == std::end(transactions_))
+        {
+            return false;
+        }
+
+        auto& tracker = *txn->second;
         auto const socket_address = tr_socket_address::from_sockaddr(from);
         auto const ip_protocol = socket_address ? socket_address->address().type : NUM_TR_AF_INET_TYPES;
-        for (auto& tracker : trackers_)
+
+        // is it a connection response?
+        if (tr_address::is_valid(ip_protocol) && tracker.connecting_at[ip_protocol] != 0 &&
+            transaction_id == tracker.connection_transaction_id[ip_protocol])
         {
-            // is it a connection response?
-            if (tr_address::is_valid(ip_protocol) && tracker.connecting_at[ip_protocol] != 0 &&
-                transaction_id == tracker.connection_transaction_id[ip_protocol])
-            {
-                logtrace(tracker.log_name(), fmt::format("{} is my connection request!", transaction_id));
-                tracker.on_connection_response(ip_protocol, action_id, buf);
-                return true;
-            }
+            logtrace(tracker.log_name(), fmt::format("{} is my connection request!", transaction_id));
+            tracker.on_connection_response(ip_protocol, action_id, buf);
+            return true;
+        }
 
-            // is it a response to one of this tracker's announces?
-            if (auto& reqs = tracker.announces; !std::empty(reqs))
+        // is it a response to one of this tracker's announces?
+        if (auto& reqs = tracker.announces; !std::empty(reqs))
+        {
+            if (auto it = reqs.find(transaction_id); it != std::end(reqs))
             {
-                if (auto it = std::ranges::find_if(
-                        reqs,
-                        [&transaction_id](auto const& req) { return req.transaction_id == transaction_id; });
-                    it != std::ranges::end(reqs))
-                {
-                    logtrace(tracker.log_name(), fmt::format("{} is an announce request!", transaction_id));
-                    it->on_response(ip_protocol, action_id, buf);
-                    reqs.erase(it);
-                    return true;
-                }
+                logtrace(tracker.log_name(), fmt::format("{} is an announce request!", transaction_id));
+                it->on_response(ip_protocol, action_id, buf);
+                reqs.erase(it);
+                return true;
             }
+        }
 
-            // is it a response to one of this tracker's scrapes?
-            if (auto& reqs = tracker.scrapes; !std::empty(reqs))
+        // is it a response to one of this tracker's scrapes?
+        if (auto& reqs = tracker.scrapes; !std::empty(reqs))
+        {
+            if (auto it = reqs.find(transaction_id); it != std::end(reqs))
             {
-                if (auto it = std::ranges::find_if(
-                        reqs,
-                        [&transaction_id](auto const& req) { return req.transaction_id == transaction_id; });
-                    it != std::ranges::end(reqs))
-                {
-                    logtrace(tracker.log_name(), fmt::format("{} is a scrape request!", transaction_id));
-                    it->on_response(action_id, buf);
-                    reqs.erase(it);
-                    return true;
-                }
+                logtrace(tracker.log_name(), fmt::format("{} is a scrape request!", transaction_id));
+                it->on_response(action_id, buf);
+                reqs.erase(it);
+                return true;
             }
         }
 
@@ -787,7 +959,7 @@ public:
 
     [[nodiscard]] bool is_idle() const noexcept override
     {
-        return std::ranges::all_of(trackers_, [](auto const& tracker) { return tracker.is_idle(); });
+        return std::ranges::all_of(trackers_ | std::views::values, [](auto const& tracker) { return tracker.is_idle(); });
     }
 
 private:
@@ -803,27 +975,137 @@ private:
             return nullptr;
         }
 
-        // see if we already have it
+        // see if we already have it.
+        // `authority` points into the interned announce URL, so it's safe to use as a key.
         auto const authority = parsed->authority;
-        for (auto& tracker : trackers_)
+        if (auto const it = trackers_.find(authority); it != std::end(trackers_))
         {
-            if (tracker.authority == authority)
-            {
-                return &tracker;
-            }
+            return &it->second;
         }
 
         // we don't have it -- build a new one
-        auto& tracker = trackers_.emplace_back(
+        auto const [it, is_new] = trackers_.try_emplace(
+            authority,
             mediator_,
+            transactions_,
             authority,
             parsed->host,
             parsed->host_wo_brackets,
             tr_port::from_host(parsed->port));
+        auto& tracker = it->second;
         logtrace(tracker.log_name(), "New tau_tracker created");
+
+        // pick up where the last session left off
+        if (auto const node = saved_states_.extract(std::string{ authority }); node)
+        {
+            tracker.restore_state(node.mapped(), tr_time());
+        }
+
         return &tracker;
     }
 
+    // ---
+
+    void load_state()
+    {
+        if (!tr_sys_path_exists(state_filename_))
+        {
+            return;
+        }
+
+        auto otop = tr_variant_serde::benc().parse_file(state_filename_);
+        if (!otop)
+        {
+            return;
+        }
+
+        auto const* const top_map = otop->get_if<tr_variant::Map>();
+        auto const* const entries = top_map != nullptr ? top_map->find_if<tr_variant::Vector>(TR_KEY_trackers) : nullptr;
+        if (entries == nullptr)
+        {
+            return;
+        }
+
+        for (auto const& entry : *entries)
+        {
+            auto const* const map = entry.get_if<tr_variant::Map>();
+            if (map == nullptr)
+            {
+                continue;
+            }
+
+            auto const authority = map->value_if<std::string_view>(TR_KEY_authority);
+            auto const ipp = map->value_if<int64_t>(TR_KEY_ip_protocol);
+            auto const compact = map->value_if<std::string_view>(TR_KEY_socket_address);
+            if (!authority || !ipp || !compact || !tr_address::is_valid(static_cast<tr_address_type>(*ipp)))
+            {
+                continue;
+            }
+
+            auto const ip_protocol = static_cast<tr_address_type>(*ipp);
+            if (std::size(*compact) != tr_socket_address::CompactSockAddrBytes[ip_protocol])
+            {
+                continue;
+            }
+
+            auto& state = saved_states_[std::string{ *authority }][ip_protocol];
+            auto const* const bytes = reinterpret_cast<std::byte const*>(std::data(*compact));
+            state.address = ip_protocol == TR_AF_INET ? tr_socket_address::from_compact_ipv4(bytes).first :
+                                                        tr_socket_address::from_compact_ipv6(bytes).first;
+            state.address_expires_at = map->value_if<int64_t>(TR_KEY_address_expires_at).value_or(0);
+            state.connection_id = static_cast<tau_connection_t>(map->value_if<int64_t>(TR_KEY_connection_id).value_or(0));
+            state.connection_id_expires_at = map->value_if<int64_t>(TR_KEY_connection_id_expires_at).value_or(0);
+        }
+    }
+
+    void save_state() const
+    {
+        auto const now = tr_time();
+        auto entries = tr_variant::Vector{};
+
+        auto const add_entries = [&entries, now](std::string_view const authority, tau_tracker_states const& states)
+        {
+            for (ipp_t ipp = 0; ipp < NUM_TR_AF_INET_TYPES; ++ipp)
+            {
+                auto const& state = states[ipp];
+                if (!state.address || state.address_expires_at <= now)
+                {
+                    continue;
+                }
+
+                auto compact = std::array<std::byte, tr_socket_address::CompactSockAddrMaxBytes>{};
+                auto const* const end = state.address->to_compact(std::data(compact));
+
+                auto map = tr_variant::Map{ 6U };
+                map.try_emplace(TR_KEY_authority, authority);
+                map.try_emplace(TR_KEY_ip_protocol, ipp);
+                map.try_emplace(TR_KEY_socket_address, tr_variant::make_raw(std::data(compact), end - std::data(compact)));
+                map.try_emplace(TR_KEY_address_expires_at, state.address_expires_at);
+                if (state.connection_id != tau_connection_t{} && now < state.connection_id_expires_at)
+                {
+                    map.try_emplace(TR_KEY_connection_id, static_cast<int64_t>(state.connection_id));
+                    map.try_emplace(TR_KEY_connection_id_expires_at, state.connection_id_expires_at);
+                }
+                entries.emplace_back(std::move(map));
+            }
+        };
+
+        for (auto const& [authority, tracker] : trackers_)
+        {
+            add_entries(authority, tracker.state());
+        }
+
+        // keep what we know about trackers that weren't used this session
+        for (auto const& [authority, states] : saved_states_)
+        {
+            add_entries(authority, states);
+        }
+
+        auto top = tr_variant::Map{ 1U };
+        top.try_emplace(TR_KEY_trackers, std::move(entries));
+        tr_variant_serde::benc().to_file(tr_variant{ std::move(top) }, state_filename_);
+    }
+
     [[nodiscard]] static constexpr bool is_response_message(tau_action_t action, size_t msglen) noexcept
     {
         if (action == TAU_ACTION_CONNECT)
@@ -849,7 +1131,16 @@ private:
         return false;
     }
 
-    std::list<tau_tracker> trackers_;
+    tau_transactions transactions_;
+
+    // depends-on: transactions_
+    // authority -> tracker
+    std::unordered_map<std::string_view, tau_tracker> trackers_;
+
+    // authority -> state from the last session, for trackers we haven't used yet
+    std::unordered_map<std::string, tau_tracker_states> saved_states_;
+
+    std::string state_filename_;
 
     Mediator& mediator_;
 };
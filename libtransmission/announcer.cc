@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <array>
 #include <chrono> // operator""ms
+#include <compare>
 #include <cstddef> // size_t
 #include <cstdint>
 #include <ctime>
@@ -32,8 +33,10 @@
 #include "libtransmission/crypto-utils.h" /* tr_rand_int() */
 #include "libtransmission/interned-string.h" // tr_interned_string
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/session.h"
 #include "libtransmission/string-utils.h"
+#include "libtransmission/timer-wheel.h"
 #include "libtransmission/timer.h"
 #include "libtransmission/torrent.h"
 #include "libtransmission/tr-assert.h"
@@ -58,7 +61,7 @@ auto constexpr Numwant = 80;
 
 /* how often to announce & scrape */
 auto constexpr MaxAnnouncesPerUpkeep = 20;
-auto constexpr MaxScrapesPerUpkeep = 20;
+auto constexpr MaxScrapesPerUpkeep = 20U; // per scrape URL
 
 /* how many infohashes to remove when we get a scrape-too-long error */
 auto constexpr TrMultiscrapeStep = 5U;
@@ -120,12 +123,21 @@ struct tr_scrape_info
 class tr_announcer_impl final : public tr_announcer
 {
 public:
+    struct TierKey
+    {
+        tr_torrent_id_t tor_id;
+        size_t tier_id;
+
+        [[nodiscard]] auto operator<=>(TierKey const&) const = default;
+    };
+
     explicit tr_announcer_impl(tr_session* session_in, tr_announcer_udp& announcer_udp)
         : session{ session_in }
         , announcer_udp_{ announcer_udp }
         , upkeep_timer_{ session_in->timerMaker().create() }
     {
         upkeep_timer_->set_callback([this]() { this->upkeep(); });
+        upkeep_timer_->set_name("announcer upkeep");
         upkeep_timer_->start_repeating(UpkeepInterval);
     }
 
@@ -153,6 +165,26 @@ public:
 
     void upkeep() override;
 
+    // Check on a tier at `when` to see if it needs to announce or scrape.
+    // A tier may be woken more than once; extra wakeups are harmless.
+    void wakeTierAt(tr_torrent_id_t tor_id, size_t tier_id, time_t when)
+    {
+        if (when != 0)
+        {
+            tier_wakeups_.add(when, TierKey{ tor_id, tier_id });
+        }
+    }
+
+    // @return the tiers that were due to be woken by `now`, without duplicates
+    [[nodiscard]] std::vector<TierKey> dueTiers(time_t now)
+    {
+        auto keys = tier_wakeups_.advance(now);
+        std::ranges::sort(keys);
+        auto const [first, last] = std::ranges::unique(keys);
+        keys.erase(first, last);
+        return keys;
+    }
+
     void onAnnounceDone(
         size_t tier_id,
         tr_announce_event event,
@@ -167,7 +199,8 @@ public:
             return nullptr;
         }
 
-        auto const [it, is_new] = scrape_info_.try_emplace(url, url, TrMultiscrapeMax);
+        auto const multiscrape_max = tr_strv_starts_with(url.sv(), "udp://"sv) ? TrUdpMultiscrapeMax : TrHttpMultiscrapeMax;
+        auto const [it, is_new] = scrape_info_.try_emplace(url, url, multiscrape_max);
         return &it->second;
     }
 
@@ -228,6 +261,9 @@ private:
 
     std::map<tr_interned_string, tr_scrape_info> scrape_info_;
 
+    // when to next check on each tier, so that upkeep() doesn't need to scan them all
+    tr_timer_wheel<TierKey> tier_wakeups_{ tr_time() };
+
     std::unique_ptr<tr::Timer> const upkeep_timer_;
 
     std::set<tr_announce_request, StopsCompare> stops_;
@@ -365,6 +401,7 @@ struct tr_tier
 {
     tr_tier(tr_announcer_impl* announcer, tr_torrent* tor_in, std::vector<tr_announce_list::tracker_info const*> const& infos)
         : tor{ tor_in }
+        , announcer_{ announcer }
     {
         trackers.reserve(std::size(infos));
         for (auto const* info : infos)
@@ -441,6 +478,9 @@ struct tr_tier
         lastAnnounceStartTime = 0;
         lastScrapeStartTime = 0;
 
+        // anything that was waiting on the old tracker can go now
+        wakeAt(tr_time());
+
         return currentTracker();
     }
 
@@ -483,6 +523,18 @@ struct tr_tier
     void scheduleNextScrape(time_t interval_secs)
     {
         this->scrapeAt = getNextScrapeTime(tor->session, this, interval_secs);
+        wakeAt(this->scrapeAt);
+    }
+
+    void scheduleAnnounce(time_t announce_at)
+    {
+        this->announceAt = announce_at;
+        wakeAt(announce_at);
+    }
+
+    void wakeAt(time_t when) const
+    {
+        announcer_->wakeTierAt(tor->id(), id, when);
     }
 
     std::deque<tr_announce_event> announce_events;
@@ -536,6 +588,8 @@ private:
     // unless the tracker says otherwise, this is the announce min_interval
     static auto constexpr DefaultAnnounceMinIntervalSec = time_t{ 60 * 2 };
 
+    tr_announcer_impl* const announcer_;
+
     [[nodiscard]] static time_t getNextScrapeTime(tr_session const* session, tr_tier const* tier, time_t interval_secs)
     {
         // Maybe don't scrape paused torrents
@@ -849,7 +903,7 @@ void tier_announce_event_push(tr_tier* tier, tr_announce_event e, time_t announc
 
     /* add it */
     events.push_back(e);
-    tier->announceAt = announce_at;
+    tier->scheduleAnnounce(announce_at);
     tier_update_announce_priority(tier);
 
     tr_logAddTrace_tier_announce_queue(tier);
@@ -946,6 +1000,16 @@ void on_announce_error(tr_tier* tier, std::string_view err, tr_announce_event e,
     };
 }
 
+// After a "started" event, pick a random point in the announce interval
+// for the first periodic reannounce. Otherwise torrents that start at the
+// same time, e.g. at startup, keep hitting their trackers in lockstep.
+[[nodiscard]] time_t first_reannounce_interval(tr_tier const* tier)
+{
+    auto const interval = tier->announceIntervalSec;
+    auto const earliest = std::min(std::max(interval / 2, tier->announceMinIntervalSec), interval);
+    return earliest + static_cast<time_t>(tr_rand_int(static_cast<uint64_t>(interval - earliest) + 1U));
+}
+
 [[nodiscard]] tr_tier* getTier(tr_announcer_impl* announcer, tr_sha1_digest_t const& info_hash, size_t tier_id)
 {
     if (announcer == nullptr)
@@ -984,6 +1048,9 @@ void tr_announcer_impl::onAnnounceDone(
     using namespace announce_helpers;
     using namespace publish_helpers;
 
+    auto const ok = response.did_connect && !response.did_timeout && std::empty(response.errmsg);
+    tr::metrics::add(ok ? tr::metrics::Counter::AnnouncesOk : tr::metrics::Counter::AnnouncesFailed);
+
     auto* const tier = getTier(this, response.info_hash, tier_id);
     if (tier == nullptr)
     {
@@ -1037,6 +1104,7 @@ void tr_announcer_impl::onAnnounceDone(
     tier->lastAnnounceSucceeded = false;
     tier->isAnnouncing = false;
     tier->manualAnnounceAllowedAt = now + tier->announceMinIntervalSec;
+    tier->wakeAt(now); // in case more events were queued while we were busy
 
     if (response.external_ip)
     {
@@ -1160,7 +1228,7 @@ void tr_announcer_impl::onAnnounceDone(
         if (!is_stopped && std::empty(tier->announce_events))
         {
             /* the queue is empty, so enqueue a periodic update */
-            auto const i = tier->announceIntervalSec;
+            auto const i = event == TR_ANNOUNCE_EVENT_STARTED ? first_reannounce_interval(tier) : tier->announceIntervalSec;
             tr_logAddTraceTier(tier, fmt::format("Sending periodic reannounce in {} seconds", i));
             tier_announce_event_push(tier, TR_ANNOUNCE_EVENT_NONE, now + i);
         }
@@ -1316,6 +1384,9 @@ void tr_announcer_impl::onScrapeDone(tr_scrape_response const& response)
     using namespace on_scrape_done_helpers;
     using namespace publish_helpers;
 
+    auto const ok = response.did_connect && !response.did_timeout && std::empty(response.errmsg);
+    tr::metrics::add(ok ? tr::metrics::Counter::ScrapesOk : tr::metrics::Counter::ScrapesFailed);
+
     auto const now = tr_time();
 
     for (size_t i = 0; i < response.row_count; ++i)
@@ -1358,6 +1429,7 @@ void tr_announcer_impl::onScrapeDone(tr_scrape_response const& response)
                 std::empty(response.errmsg) ? "none"sv : response.errmsg));
 
         tier->isScraping = false;
+        tier->wakeAt(now); // in case an announce was waiting on this scrape
         tier->lastScrapeTime = now;
         tier->lastScrapeSucceeded = false;
         tier->lastScrapeTimedOut = response.did_timeout;
@@ -1403,10 +1475,10 @@ namespace
 void multiscrape(tr_announcer_impl* announcer, std::vector<tr_tier*> const& tiers)
 {
     auto const now = tr_time();
-    auto requests = std::array<tr_scrape_request, MaxScrapesPerUpkeep>{};
-    auto request_count = size_t{};
 
-    // batch as many info_hashes into a request as we can
+    // Batch as many info_hashes into a request as the tracker allows,
+    // with up to MaxScrapesPerUpkeep requests per scrape URL.
+    auto requests = std::map<tr_interned_string, std::vector<tr_scrape_request>>{};
     for (auto* tier : tiers)
     {
         auto const* const current_tracker = tier->currentTracker();
@@ -1423,58 +1495,43 @@ void multiscrape(tr_announcer_impl* announcer, std::vector<tr_tier*> const& tier
             continue;
         }
 
-        bool found = false;
-
-        /* if there's a request with this scrape URL and a free slot, use it */
-        for (size_t j = 0; !found && j < request_count; ++j)
+        auto& url_requests = requests[scrape_info->scrape_url];
+        if (std::empty(url_requests) || url_requests.back().info_hash_count >= scrape_info->multiscrape_max)
         {
-            auto* const req = &requests[j];
-
-            if (req->info_hash_count >= scrape_info->multiscrape_max)
+            if (std::size(url_requests) >= MaxScrapesPerUpkeep)
             {
+                // no room this time; try again on the next upkeep
+                tier->wakeAt(now);
                 continue;
             }
 
-            if (scrape_info->scrape_url != req->scrape_url)
-            {
-                continue;
-            }
-
-            req->info_hash[req->info_hash_count] = tier->tor->info_hash();
-            ++req->info_hash_count;
-            tier->isScraping = true;
-            tier->lastScrapeStartTime = now;
-            found = true;
+            auto& req = url_requests.emplace_back();
+            req.scrape_url = scrape_info->scrape_url;
+            req.log_name = tier->buildLogName();
         }
 
-        /* otherwise, if there's room for another request, build a new one */
-        if (!found && request_count < MaxScrapesPerUpkeep)
-        {
-            auto* const req = &requests[request_count];
-            req->scrape_url = scrape_info->scrape_url;
-            req->log_name = tier->buildLogName();
-
-            req->info_hash[req->info_hash_count] = tier->tor->info_hash();
-            ++req->info_hash_count;
-            tier->isScraping = true;
-            tier->lastScrapeStartTime = now;
-
-            ++request_count;
-        }
+        auto& req = url_requests.back();
+        req.info_hash[req.info_hash_count] = tier->tor->info_hash();
+        ++req.info_hash_count;
+        tier->isScraping = true;
+        tier->lastScrapeStartTime = now;
     }
 
     /* send the requests we just built */
-    for (size_t i = 0; i < request_count; ++i)
+    for (auto const& [scrape_url, url_requests] : requests)
     {
-        announcer->scrape(
-            requests[i],
-            [session = announcer->session, announcer](tr_scrape_response const& response)
-            {
-                if (session->announcer_)
+        for (auto const& req : url_requests)
+        {
+            announcer->scrape(
+                req,
+                [session = announcer->session, announcer](tr_scrape_response const& response)
                 {
-                    announcer->onScrapeDone(response);
-                }
-            });
+                    if (session->announcer_)
+                    {
+                        announcer->onScrapeDone(response);
+                    }
+                });
+        }
     }
 }
 
@@ -1555,22 +1612,29 @@ void scrapeAndAnnounceMore(tr_announcer_impl* announcer)
 {
     auto const now = tr_time();
 
-    /* build a list of tiers that need to be announced */
+    /* build a list of the tiers whose time has come.
+     * Tiers that are busy now get woken again when they finish. */
     auto announce_me = std::vector<tr_tier*>{};
     auto scrape_me = std::vector<tr_tier*>{};
-    for (auto* const tor : announcer->session->torrents())
+    for (auto const& [tor_id, tier_id] : announcer->dueTiers(now))
     {
-        for (auto& tier : tor->torrent_announcer->tiers)
+        // the torrent or tier may have gone away since the wakeup was scheduled
+        auto* const tor = announcer->session->torrents().get(tor_id);
+        auto* const tier = tor != nullptr && tor->torrent_announcer != nullptr ? tor->torrent_announcer->getTier(tier_id) :
+                                                                                 nullptr;
+        if (tier == nullptr)
         {
-            if (tier.needsToAnnounce(now))
-            {
-                announce_me.push_back(&tier);
-            }
+            continue;
+        }
 
-            if (tier.needsToScrape(now))
-            {
-                scrape_me.push_back(&tier);
-            }
+        if (tier->needsToAnnounce(now))
+        {
+            announce_me.push_back(tier);
+        }
+
+        if (tier->needsToScrape(now))
+        {
+            scrape_me.push_back(tier);
         }
     }
 
@@ -1592,6 +1656,13 @@ void scrapeAndAnnounceMore(tr_announcer_impl* announcer)
             std::end(announce_me),
             [](auto const* a, auto const* b) { return compareAnnounceTiers(a, b) < 0; });
         // NOLINTEND(readability-redundant-casting)
+
+        // the rest will have to wait for the next upkeep
+        for (auto it = std::begin(announce_me) + MaxAnnouncesPerUpkeep; it != std::end(announce_me); ++it)
+        {
+            (*it)->wakeAt(now);
+        }
+
         announce_me.resize(MaxAnnouncesPerUpkeep);
     }
 
@@ -144,6 +144,13 @@ public:
             std::string_view name,
             uint16_t service,
             std::string_view log_name) const;
+
+        // Where to keep tracker addresses and connection IDs between sessions.
+        // Nothing is saved if this is empty.
+        [[nodiscard]] virtual std::string_view config_dir() const
+        {
+            return {};
+        }
     };
 
     virtual ~tr_announcer_udp() noexcept = default;
@@ -19,6 +19,7 @@
 #include "libtransmission/bandwidth.h"
 #include "libtransmission/crypto-utils.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/peer-io.h"
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/types.h"
@@ -216,6 +217,9 @@ void tr_bandwidth::phase_one(std::vector<tr_peerIo*>& peers, tr_direction dir)
 
 void tr_bandwidth::allocate(uint64_t period_msec)
 {
+    tr::metrics::add(tr::metrics::Counter::BandwidthAllocations);
+    auto const timer = tr::metrics::ScopedTimer{ tr::metrics::Histogram::BandwidthAllocationTime };
+
     // keep these peers alive for the scope of this function
     auto refs = std::vector<std::shared_ptr<tr_peerIo>>{};
 
@@ -7,6 +7,7 @@
 #include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring> // std::memcpy
 #include <vector> // std::vector
 
 #include "libtransmission/bitfield.h"
@@ -497,3 +498,43 @@ bool tr_bitfield::intersects(tr_bitfield const& that) const noexcept
 
     return false;
 }
+
+size_t tr_bitfield::count_intersection(tr_bitfield const& that) const noexcept
+{
+    if (has_none() || that.has_none())
+    {
+        return 0U;
+    }
+
+    if (has_all())
+    {
+        return that.count();
+    }
+
+    if (that.has_all())
+    {
+        return count();
+    }
+
+    auto ret = size_t{};
+    auto const n = std::min(std::size(flags_), std::size(that.flags_));
+    auto i = size_t{};
+
+    // compare a word at a time...
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        auto lhs = uint64_t{};
+        auto rhs = uint64_t{};
+        std::memcpy(&lhs, &flags_[i], sizeof(lhs));
+        std::memcpy(&rhs, &that.flags_[i], sizeof(rhs));
+        ret += std::popcount(lhs & rhs);
+    }
+
+    // ...then mop up the leftover bytes
+    for (; i < n; ++i)
+    {
+        ret += std::popcount(static_cast<uint8_t>(flags_[i] & that.flags_[i]));
+    }
+
+    return ret;
+}
@@ -9,6 +9,7 @@
 #include <array>
 #include <cstddef> // size_t
 #include <cstdint>
+#include <cstring> // memcpy
 #include <limits>
 #include <optional>
 #include <random> // for std::uniform_int_distribution<T>
@@ -182,6 +183,20 @@ using tr_sha1_string = tr_strbuf<char, (sizeof(tr_sha1_digest_t) * 2U) + 1U>;
  */
 [[nodiscard]] std::optional<tr_sha1_digest_t> tr_sha1_from_string(std::string_view hex);
 
+/**
+ * @brief Hash functor so that sha1 digests can be used as unordered container keys.
+ * The digest bytes are already uniformly distributed, so its prefix is used as-is.
+ */
+struct tr_sha1_digest_hash
+{
+    [[nodiscard]] std::size_t operator()(tr_sha1_digest_t const& digest) const noexcept
+    {
+        auto ret = std::size_t{};
+        std::memcpy(&ret, std::data(digest), sizeof(ret));
+        return ret;
+    }
+};
+
 using tr_sha256_string = tr_strbuf<char, (sizeof(tr_sha256_digest_t) * 2U) + 1U>;
 
 /**
@@ -48,6 +48,15 @@
 #define USE_COPY_FILE_RANGE
 #endif /* __linux__ */
 
+/* Copy-on-write clones (reflinks) on filesystems that support them, e.g. btrfs and xfs. */
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/fs.h> /* FICLONE */
+#ifdef FICLONE
+#define USE_FICLONE
+#endif
+#endif /* __linux__ */
+
 #include <fmt/format.h>
 
 #include "libtransmission/error.h"
@@ -216,7 +225,11 @@ bool tr_sys_path_rename(std::string_view const src_path, std::string_view const
 /* We try to do a fast (in-kernel) copy using a variety of non-portable system
  * calls. If the current implementation does not support in-kernel copying, we
  * use a user-space fallback instead. */
-bool tr_sys_path_copy(std::string_view const src_path, std::string_view const dst_path, tr_error* error)
+bool tr_sys_path_copy(
+    std::string_view const src_path,
+    std::string_view const dst_path,
+    tr_error* error,
+    tr_sys_path_copy_progress_func const& progress)
 {
     auto local_error = tr_error{};
     if (error == nullptr)
@@ -267,6 +280,37 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
     uint64_t file_size = info->size;
     int errno_cpy = 0; /* keep errno intact across copy attempts */
 
+#if defined(USE_COPY_FILE_RANGE) || defined(USE_SENDFILE64)
+    /* With a progress callback, copy in smaller chunks so that it gets called regularly. */
+    static auto constexpr ProgressChunkSize = uint64_t{ 64U * 1024U * 1024U };
+    uint64_t const max_chunk_size = progress ? ProgressChunkSize : uint64_t{ INT32_MAX };
+#endif
+
+    /* returns false if the caller canceled the copy */
+    auto const report_progress = [&]()
+    {
+        if (!progress || progress(info->size - file_size))
+        {
+            return true;
+        }
+
+        errno_cpy = ECANCELED; /* don't try any of the remaining fallbacks */
+        return false;
+    };
+
+#if defined(USE_FICLONE)
+
+    /* Clone the file. This is instant and doesn't use any more space. */
+    /* Fails with EXDEV between filesystems, or EOPNOTSUPP / EINVAL if the */
+    /* filesystem doesn't support it, so just fall through to a real copy. */
+    if (ioctl(out, FICLONE, in) == 0)
+    {
+        file_size = 0U;
+        report_progress();
+    }
+
+#endif /* USE_FICLONE */
+
 #if defined(USE_COPY_FILE_RANGE)
 
     /* Kernel copy by copy_file_range */
@@ -275,7 +319,7 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
 
     while (file_size > 0U)
     {
-        size_t const chunk_size = std::min({ file_size, uint64_t{ SSIZE_MAX }, uint64_t{ INT32_MAX } });
+        size_t const chunk_size = std::min({ file_size, uint64_t{ SSIZE_MAX }, max_chunk_size });
         auto const copied = copy_file_range(in, nullptr, out, nullptr, chunk_size, 0);
 
         TR_ASSERT(copied == -1 || copied >= 0); /* -1 for error; some non-negative value otherwise. */
@@ -297,6 +341,11 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
         TR_ASSERT(copied >= 0 && ((uint64_t)copied) <= file_size);
         TR_ASSERT(copied >= 0 && ((uint64_t)copied) <= chunk_size);
         file_size -= copied;
+
+        if (!report_progress())
+        {
+            break;
+        }
     } /* end file_size loop */
     /* at this point errno_cpy is either set or file_size is 0 due to while condition */
 
@@ -328,7 +377,7 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
         {
             while (file_size > 0U)
             {
-                size_t const chunk_size = std::min({ file_size, uint64_t{ SSIZE_MAX }, uint64_t{ INT32_MAX } });
+                size_t const chunk_size = std::min({ file_size, uint64_t{ SSIZE_MAX }, max_chunk_size });
                 auto const copied = sendfile64(out, in, nullptr, chunk_size);
                 TR_ASSERT(copied == -1 || copied >= 0); /* -1 for error; some non-negative value otherwise. */
 
@@ -350,6 +399,11 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
                 TR_ASSERT(copied >= 0 && ((uint64_t)copied) <= file_size);
                 TR_ASSERT(copied >= 0 && ((uint64_t)copied) <= chunk_size);
                 file_size -= copied;
+
+                if (!report_progress())
+                {
+                    break;
+                }
             } /* end file_size loop */
         } /* end lseek error */
     } /* end fallback check */
@@ -397,6 +451,11 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
                 TR_ASSERT(bytes_read == bytes_written);
                 TR_ASSERT(bytes_written <= file_size);
                 file_size -= bytes_written;
+
+                if (!report_progress())
+                {
+                    break;
+                }
             } /* end file_size loop */
         } /* end lseek error */
     } /* end fallback check */
@@ -407,6 +466,12 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
     tr_sys_file_close(out);
     tr_sys_file_close(in);
 
+    if (errno_cpy == ECANCELED)
+    {
+        error->set(ECANCELED, "Copy canceled"sv);
+        return false;
+    }
+
     if (file_size != 0)
     {
         error->prefix_message("Unable to read/write: ");
@@ -483,7 +483,29 @@ bool tr_sys_path_rename(std::string_view const src_path, std::string_view const
     return ret;
 }
 
-bool tr_sys_path_copy(std::string_view const src_path, std::string_view const dst_path, tr_error* error)
+namespace
+{
+DWORD CALLBACK on_copy_progress(
+    LARGE_INTEGER /*total_size*/,
+    LARGE_INTEGER total_transferred,
+    LARGE_INTEGER /*stream_size*/,
+    LARGE_INTEGER /*stream_transferred*/,
+    DWORD /*stream_number*/,
+    DWORD /*callback_reason*/,
+    HANDLE /*source_file*/,
+    HANDLE /*destination_file*/,
+    LPVOID vprogress)
+{
+    auto const& progress = *static_cast<tr_sys_path_copy_progress_func const*>(vprogress);
+    return progress(static_cast<uint64_t>(total_transferred.QuadPart)) ? PROGRESS_CONTINUE : PROGRESS_CANCEL;
+}
+} // namespace
+
+bool tr_sys_path_copy(
+    std::string_view const src_path,
+    std::string_view const dst_path,
+    tr_error* error,
+    tr_sys_path_copy_progress_func const& progress)
 {
     auto const wide_src_path = path_to_native_path(src_path);
     auto const wide_dst_path = path_to_native_path(dst_path);
@@ -495,7 +517,9 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
 
     auto cancel = BOOL{ FALSE };
     DWORD const flags = COPY_FILE_ALLOW_DECRYPTED_DESTINATION | COPY_FILE_FAIL_IF_EXISTS;
-    if (!to_bool(CopyFileExW(wide_src_path.c_str(), wide_dst_path.c_str(), nullptr, nullptr, &cancel, flags)))
+    auto* const routine = progress ? on_copy_progress : nullptr;
+    auto* const routine_data = progress ? const_cast<tr_sys_path_copy_progress_func*>(&progress) : nullptr;
+    if (!to_bool(CopyFileExW(wide_src_path.c_str(), wide_dst_path.c_str(), routine, routine_data, &cancel, flags)))
     {
         set_system_error(error, GetLastError());
         return false;
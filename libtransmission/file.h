@@ -20,6 +20,8 @@
 
 struct tr_error;
 
+using tr_sys_path_copy_progress_func = std::function<bool(uint64_t bytes_copied)>;
+
 /**
  * @addtogroup file_io File IO
  * @{
@@ -129,10 +131,16 @@ struct tr_sys_path_capacity
  * @param[in]  dst_path  Path to destination file.
  * @param[out] error     Pointer to error object. Optional, pass `nullptr` if
  *                       you are not interested in error details.
+ * @param[in]  progress  Optional. Called periodically with the number of bytes
+ *                       copied so far. Return `false` from it to cancel the copy.
  *
  * @return `True` on success, `false` otherwise (with `error` set accordingly).
  */
-bool tr_sys_path_copy(std::string_view src_path, std::string_view dst_path, tr_error* error = nullptr);
+bool tr_sys_path_copy(
+    std::string_view src_path,
+    std::string_view dst_path,
+    tr_error* error = nullptr,
+    tr_sys_path_copy_progress_func const& progress = {});
 
 /**
  * @brief Portability wrapper for `stat()`.
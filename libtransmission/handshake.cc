@@ -20,6 +20,7 @@
 #include "libtransmission/error.h"
 #include "libtransmission/handshake.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/peer-io.h"
 #include "libtransmission/peer-mse.h" // tr_message_stream_encryption::DH
 #include "libtransmission/timer.h"
@@ -805,6 +806,8 @@ bool tr_handshake::fire_done(bool is_connected)
         return false;
     }
 
+    tr::metrics::add(is_connected ? tr::metrics::Counter::HandshakesOk : tr::metrics::Counter::HandshakesFailed);
+
     // handshake could get destroyed inside on_done,
     // so handle all our housekeeping *before* calling it
 
@@ -822,6 +825,7 @@ bool tr_handshake::fire_done(bool is_connected)
 void tr_handshake::fire_timer()
 {
     tr_logAddTraceHand(this, "timer expired");
+    tr::metrics::add(tr::metrics::Counter::HandshakesTimedOut);
     fire_done(false);
 }
 
@@ -18,6 +18,7 @@
 #include "libtransmission/error.h"
 #include "libtransmission/file.h"
 #include "libtransmission/inout.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/session.h"
 #include "libtransmission/string-utils.h"
 #include "libtransmission/torrent-files.h"
@@ -144,7 +145,11 @@ void read_bytes(
         return;
     }
 
-    read_entire_buf(*fd, file_offset, buf, error);
+    if (auto const timer = tr::metrics::ScopedTimer{ tr::metrics::Histogram::DiskReadTime };
+        read_entire_buf(*fd, file_offset, buf, error))
+    {
+        tr::metrics::add(tr::metrics::Counter::DiskBytesRead, std::size(buf));
+    }
 
     if (error)
     {
@@ -182,7 +187,11 @@ void write_bytes(
         return;
     }
 
-    write_entire_buf(*fd, file_offset, buf, error);
+    if (auto const timer = tr::metrics::ScopedTimer{ tr::metrics::Histogram::DiskWriteTime };
+        write_entire_buf(*fd, file_offset, buf, error))
+    {
+        tr::metrics::add(tr::metrics::Counter::DiskBytesWritten, std::size(buf));
+    }
 
     if (error)
     {
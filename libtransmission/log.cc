@@ -4,15 +4,20 @@
 // License text can be found in the licenses/ folder.
 
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <cstdlib> // std::atexit()
 #include <deque>
 #include <iterator> // back_insert_iterator, empty
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 
 #ifdef _WIN32
@@ -26,8 +31,6 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 
-#include <small/map.hpp>
-
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
 #include "libtransmission/string-utils.h"
@@ -43,122 +46,263 @@ inline constexpr auto MaxQueueLength = 10000U;
 template<typename T>
 inline constexpr bool HasTmGmtoffV = requires(T t) { t.tm_gmtoff; };
 
-class tr_log_state
+// A bounded queue that any thread can push to without locking
+// and that one thread at a time can pop from.
+// See https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+class tr_log_ring
 {
 public:
-    [[nodiscard]] auto unique_lock()
+    static auto constexpr Capacity = size_t{ 4096U };
+
+    tr_log_ring()
+        : slots_{ std::make_unique<Slot[]>(Capacity) } // NOLINT(modernize-avoid-c-arrays)
     {
-        return std::unique_lock(message_mutex_);
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
     }
 
-    tr_log_level level = TR_LOG_ERROR;
+    // Returns false if the ring is full
+    [[nodiscard]] bool try_push(tr_log_message&& msg)
+    {
+        auto pos = tail_.load(std::memory_order_relaxed);
 
-    bool queue_enabled_ = false;
+        for (;;)
+        {
+            auto& slot = slots_[pos % Capacity];
+            auto const seq = slot.seq.load(std::memory_order_acquire);
+
+            if (seq == pos)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+                {
+                    slot.msg = std::move(msg);
+                    slot.seq.store(pos + 1U, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (seq < pos)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
 
-    tr_log_messages queue_;
+    // Only call this from one thread at a time
+    [[nodiscard]] std::optional<tr_log_message> try_pop()
+    {
+        auto& slot = slots_[head_ % Capacity];
+        if (slot.seq.load(std::memory_order_acquire) != head_ + 1U)
+        {
+            return {};
+        }
 
-    std::recursive_mutex message_mutex_;
-};
+        auto msg = std::move(slot.msg);
+        slot.seq.store(head_ + Capacity, std::memory_order_release);
+        ++head_;
+        return msg;
+    }
 
-auto log_state = tr_log_state{};
+private:
+    struct Slot
+    {
+        std::atomic<size_t> seq;
+        tr_log_message msg;
+    };
 
-// ---
+    std::unique_ptr<Slot[]> const slots_; // NOLINT(modernize-avoid-c-arrays)
+    std::atomic<size_t> tail_ = {};
+    size_t head_ = {};
+};
 
-void logAddImpl(
-    [[maybe_unused]] std::string_view file,
-    [[maybe_unused]] long line,
-    [[maybe_unused]] tr_log_level level,
-    std::string&& msg,
-    [[maybe_unused]] std::string_view name)
+class tr_log_state
 {
-    if (std::empty(msg))
+public:
+    void add(tr_log_message&& msg)
     {
-        return;
+        if (msg.level == TR_LOG_CRITICAL)
+        {
+            // write it now, e.g. in case we're about to crash
+            auto const lock = consumer_lock();
+            drain();
+            write(std::move(msg));
+            return;
+        }
+
+        start_sink();
+
+        if (!ring_.try_push(std::move(msg)))
+        {
+            ++dropped_;
+            ++dropped_total_;
+        }
+
+        wake_.fetch_add(1U, std::memory_order_release);
+        wake_.notify_one();
     }
 
-    auto const lock = log_state.unique_lock();
+    void flush()
+    {
+        auto const lock = consumer_lock();
+        drain();
+    }
 
-#if defined(__ANDROID__)
+    [[nodiscard]] tr_log_messages take_queue()
+    {
+        auto const lock = consumer_lock();
+        drain();
+        return std::exchange(queue_, {});
+    }
 
-    int prio;
+    [[nodiscard]] auto dropped_count() const noexcept
+    {
+        return dropped_total_.load();
+    }
 
-    switch (level)
+    std::atomic<bool> queue_enabled_ = false;
+
+private:
+    [[nodiscard]] std::unique_lock<std::mutex> consumer_lock()
     {
-    case TR_LOG_CRITICAL:
-        prio = ANDROID_LOG_FATAL;
-        break;
-    case TR_LOG_ERROR:
-        prio = ANDROID_LOG_ERROR;
-        break;
-    case TR_LOG_WARN:
-        prio = ANDROID_LOG_WARN;
-        break;
-    case TR_LOG_INFO:
-        prio = ANDROID_LOG_INFO;
-        break;
-    case TR_LOG_DEBUG:
-        prio = ANDROID_LOG_DEBUG;
-        break;
-    case TR_LOG_TRACE:
-        prio = ANDROID_LOG_VERBOSE;
+        return std::unique_lock{ consumer_mutex_ };
     }
 
-#ifdef NDEBUG
-    auto const szmsg = fmt::format("{:s}", msg);
-#else
-    auto const szmsg = fmt::format("[{:s}:{:d}] {:s}", file, line, msg);
-#endif
-    __android_log_write(prio, "transmission", szmsg.c_str());
+    void start_sink()
+    {
+        std::call_once(
+            sink_started_,
+            [this]()
+            {
+                std::thread{ &tr_log_state::sink_func, this }.detach();
+
+                // write whatever's still queued when the process exits
+                std::atexit([]() { tr_logFlush(); });
+            });
+    }
 
-#else
+    void sink_func()
+    {
+        for (;;)
+        {
+            auto const seen = wake_.load(std::memory_order_acquire);
+            flush();
+            wake_.wait(seen, std::memory_order_acquire);
+        }
+    }
 
-    if (log_state.queue_enabled_)
+    // Only call this while holding the consumer lock
+    void drain()
     {
-        auto& newmsg = log_state.queue_.emplace_back();
-        newmsg.level = level;
-        newmsg.when = std::chrono::system_clock::now();
-        newmsg.message = std::move(msg);
-        newmsg.file = file;
-        newmsg.line = line;
-        newmsg.name = name;
-
-        if (std::size(log_state.queue_) > MaxQueueLength)
+        while (auto msg = ring_.try_pop())
+        {
+            write(std::move(*msg));
+        }
+
+        if (auto const dropped = dropped_.exchange(0U); dropped > 0U)
         {
-            log_state.queue_.pop_front();
+            auto msg = tr_log_message{};
+            msg.level = TR_LOG_WARN;
+            msg.file = "log.cc"sv;
+            msg.when = std::chrono::system_clock::now();
+            msg.message = fmt::format("Dropped {:d} log messages", dropped);
+            write(std::move(msg));
         }
     }
-    else
+
+    // Only call this while holding the consumer lock
+    void write(tr_log_message&& msg)
     {
-        auto buf = std::array<char, 64U>{};
-        auto const timestr = tr_logGetTimeStr(std::data(buf), std::size(buf));
+        if (std::empty(msg.name))
+        {
+            msg.name = fmt::format("{:s}:{:d}", msg.file, msg.line);
+        }
+
+        writeImpl(std::move(msg));
+    }
+
+    void writeImpl(tr_log_message&& msg)
+    {
+#if defined(__ANDROID__)
+
+        int prio;
 
-        if (std::empty(name))
+        switch (msg.level)
         {
-            fmt::print(stderr, "[{:s}] {:s}\n", timestr, msg);
+        case TR_LOG_CRITICAL:
+            prio = ANDROID_LOG_FATAL;
+            break;
+        case TR_LOG_ERROR:
+            prio = ANDROID_LOG_ERROR;
+            break;
+        case TR_LOG_WARN:
+            prio = ANDROID_LOG_WARN;
+            break;
+        case TR_LOG_INFO:
+            prio = ANDROID_LOG_INFO;
+            break;
+        case TR_LOG_DEBUG:
+            prio = ANDROID_LOG_DEBUG;
+            break;
+        case TR_LOG_TRACE:
+            prio = ANDROID_LOG_VERBOSE;
+        }
+
+#ifdef NDEBUG
+        auto const szmsg = fmt::format("{:s}", msg.message);
+#else
+        auto const szmsg = fmt::format("[{:s}:{:d}] {:s}", msg.file, msg.line, msg.message);
+#endif
+        __android_log_write(prio, "transmission", szmsg.c_str());
+
+#else
+
+        if (queue_enabled_)
+        {
+            queue_.emplace_back(std::move(msg));
+
+            if (std::size(queue_) > MaxQueueLength)
+            {
+                queue_.pop_front();
+            }
         }
         else
         {
-            fmt::print("[{:s}] {:s}: {:s}\n", timestr, name, msg);
+            auto buf = std::array<char, 64U>{};
+            auto const timestr = tr_logGetTimeStr(msg.when, std::data(buf), std::size(buf));
+            fmt::print("[{:s}] {:s}: {:s}\n", timestr, msg.name, msg.message);
         }
-    }
 #endif
-}
+    }
 
-} // unnamed namespace
+    tr_log_ring ring_;
+    std::atomic<size_t> dropped_ = {};
+    std::atomic<size_t> dropped_total_ = {};
 
-tr_log_level tr_logGetLevel()
-{
-    return log_state.level;
-}
+    // bumped whenever there's something for the sink to do
+    std::atomic<uint32_t> wake_ = {};
 
-bool tr_logLevelIsActive(tr_log_level level)
-{
-    return tr_logGetLevel() >= level;
-}
+    std::once_flag sink_started_;
+
+    // only touched while holding the consumer lock
+    std::mutex consumer_mutex_;
+    tr_log_messages queue_;
+};
+
+// Leaked on purpose so that it outlives everything that might log
+auto& log_state = *new tr_log_state{};
+
+} // unnamed namespace
+
+std::atomic<tr_log_level> tr::detail::log::current_level = TR_LOG_ERROR;
 
 void tr_logSetLevel(tr_log_level level)
 {
-    log_state.level = level;
+    tr::detail::log::current_level.store(level, std::memory_order_relaxed);
 }
 
 void tr_logSetQueueEnabled(bool is_enabled)
@@ -168,9 +312,7 @@ void tr_logSetQueueEnabled(bool is_enabled)
 
 tr_log_messages tr_logGetQueue()
 {
-    auto const lock = log_state.unique_lock();
-
-    return std::exchange(log_state.queue_, {});
+    return log_state.take_queue();
 }
 
 void tr_logClearQueue()
@@ -178,6 +320,16 @@ void tr_logClearQueue()
     (void)tr_logGetQueue();
 }
 
+size_t tr_logGetDroppedCount() noexcept
+{
+    return log_state.dropped_count();
+}
+
+void tr_logFlush()
+{
+    log_state.flush();
+}
+
 // ---
 
 std::string_view tr_logGetTimeStr(std::chrono::system_clock::time_point const now, char* const buf, size_t const buflen)
@@ -215,60 +367,63 @@ std::string_view tr_logGetTimeStr(char* buf, size_t buflen)
     return tr_logGetTimeStr(a, buf, buflen);
 }
 
-void tr_logAddMessage(char const* file, long line, tr_log_level level, std::string&& msg, std::string_view name)
+void tr_logAddMessage(
+    char const* file,
+    long line,
+    tr_log_level level,
+    std::string&& msg,
+    std::string_view name,
+    tr_log_repeats* repeats)
 {
     TR_ASSERT(!std::empty(msg));
 
-    // strip source path to only include the filename
-    auto filename = tr_sys_path_basename(file);
-    if (std::empty(filename))
+    // skip unwanted messages
+    if (!tr_logLevelIsActive(level) || std::empty(msg))
     {
-        filename = "?"sv;
+        return;
     }
 
-    auto name_fallback = std::string{};
-    if (std::empty(name))
+    // don't log the same warning ad infinitum.
+    // at some point, it stops being useful.
+    auto last_one = false;
+    if (repeats != nullptr && level <= TR_LOG_WARN)
     {
-        name_fallback = fmt::format("{:s}:{:d}", filename, line);
-        name = name_fallback;
+        auto const count = repeats->fetch_add(1U, std::memory_order_relaxed) + 1U;
+        last_one = count == tr::detail::log::MaxRepeat;
+        if (count > tr::detail::log::MaxRepeat)
+        {
+            return;
+        }
     }
 
     // message logging shouldn't affect errno
     int const err = errno;
 
-    // skip unwanted messages
-    if (!tr_logLevelIsActive(level))
+    // strip source path to only include the filename
+    auto filename = tr_sys_path_basename(file);
+    if (std::empty(filename))
     {
-        errno = err;
-        return;
+        filename = "?"sv;
     }
 
-    auto const lock = log_state.unique_lock();
+    auto record = tr_log_message{};
+    record.level = level;
+    record.file = filename;
+    record.line = line;
+    record.when = std::chrono::system_clock::now();
+    record.name = name;
+    record.message = std::move(msg);
 
-    // don't log the same warning ad infinitum.
-    // at some point, it stops being useful.
-    bool last_one = false;
-    if (level == TR_LOG_CRITICAL || level == TR_LOG_ERROR || level == TR_LOG_WARN)
+    if (last_one)
     {
-        static auto constexpr MaxRepeat = size_t{ 30 };
-        static auto* const counts = new small::map<std::pair<std::string_view, long>, size_t>{};
-
-        auto& count = (*counts)[std::make_pair(filename, line)];
-        ++count;
-        last_one = count == MaxRepeat;
-        if (count > MaxRepeat)
-        {
-            errno = err;
-            return;
-        }
+        auto final_record = record;
+        final_record.message = _("Too many messages like this! I won't log this message anymore this session.");
+        log_state.add(std::move(record));
+        log_state.add(std::move(final_record));
     }
-
-    // log the messages
-    logAddImpl(filename, line, level, std::move(msg), name);
-    if (last_one)
+    else
     {
-        char const* final_msg = _("Too many messages like this! I won't log this message anymore this session.");
-        logAddImpl(filename, line, level, final_msg, name);
+        log_state.add(std::move(record));
     }
 
     errno = err;
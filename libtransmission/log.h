@@ -5,12 +5,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <cstddef> // size_t
 #include <deque>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility> // std::move
 
 #include "libtransmission/types.h"
 
@@ -48,27 +50,77 @@ void tr_logClearQueue();
 
 // ---
 
+namespace tr::detail::log
+{
+extern std::atomic<tr_log_level> current_level;
+
+// Warnings and errors from the same call site stop being logged after this many
+inline constexpr auto MaxRepeat = size_t{ 30U };
+} // namespace tr::detail::log
+
 void tr_logSetLevel(tr_log_level level);
 
-[[nodiscard]] tr_log_level tr_logGetLevel();
+[[nodiscard]] inline tr_log_level tr_logGetLevel() noexcept
+{
+    return tr::detail::log::current_level.load(std::memory_order_relaxed);
+}
+
+// Cheap enough to check before building a message, which the
+// tr_logAdd*() macros do so that disabled levels cost next to nothing
+[[nodiscard]] inline bool tr_logLevelIsActive(tr_log_level level) noexcept
+{
+    return tr_logGetLevel() >= level;
+}
+
+// The number of messages that were dropped because they were
+// logged faster than they could be written
+[[nodiscard]] size_t tr_logGetDroppedCount() noexcept;
 
-[[nodiscard]] bool tr_logLevelIsActive(tr_log_level level);
+// Wait for the messages that were already logged to be written
+void tr_logFlush();
 
 // ---
 
+// How many warnings and errors a call site has logged. The tr_logAdd*()
+// macros keep one per call site so that a chatty one is muted before
+// its messages are built or queued.
+using tr_log_repeats = std::atomic<size_t>;
+
+[[nodiscard]] inline bool tr_logIsMuted(tr_log_repeats const& repeats) noexcept
+{
+    return repeats.load(std::memory_order_relaxed) >= tr::detail::log::MaxRepeat;
+}
+
+// Messages are queued without blocking and are written or added to
+// tr_logGetQueue() by a background thread. If the queue is full,
+// the message is dropped. TR_LOG_CRITICAL messages are written
+// before this returns. Repeats are only capped if `repeats` is set.
 void tr_logAddMessage(
     char const* source_file,
     long source_line,
     tr_log_level level,
     std::string&& msg,
-    std::string_view module_name = {});
+    std::string_view module_name = {},
+    tr_log_repeats* repeats = nullptr);
+
+inline void tr_logAddMessage(
+    tr_log_repeats& repeats,
+    char const* source_file,
+    long source_line,
+    tr_log_level level,
+    std::string&& msg,
+    std::string_view module_name = {})
+{
+    tr_logAddMessage(source_file, source_line, level, std::move(msg), module_name, &repeats);
+}
 
 #define tr_logAddLevel(level, ...) \
     do \
     { \
-        if (tr_logLevelIsActive(level)) \
+        static auto tr_log_call_site_repeats = tr_log_repeats{}; \
+        if (tr_logLevelIsActive(level) && !tr_logIsMuted(tr_log_call_site_repeats)) \
         { \
-            tr_logAddMessage(__FILE__, __LINE__, level, __VA_ARGS__); \
+            tr_logAddMessage(tr_log_call_site_repeats, __FILE__, __LINE__, level, __VA_ARGS__); \
         } \
     } while (0)
 
@@ -0,0 +1,224 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <iterator> // std::back_inserter
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "libtransmission/metrics.h"
+
+using namespace std::literals;
+
+namespace
+{
+using namespace tr::metrics;
+
+struct Info
+{
+    std::string_view name;
+    std::string_view help;
+};
+
+auto constexpr CounterInfo = std::array<Info, CounterCount>{ {
+    { "announces_failed"sv, "Tracker announces that failed or timed out"sv },
+    { "announces_ok"sv, "Tracker announces that succeeded"sv },
+    { "bandwidth_allocations"sv, "Rounds of bandwidth allocation"sv },
+    { "dht_announce_lag_seconds"sv, "How late DHT announces were started, summed up"sv },
+    { "dht_announces"sv, "DHT announces that were started"sv },
+    { "disk_bytes_read"sv, "Bytes read from torrent files"sv },
+    { "disk_bytes_written"sv, "Bytes written to torrent files"sv },
+    { "endgame_requests"sv, "Duplicate block requests sent to peers in endgame mode"sv },
+    { "endgame_wasted_bytes"sv, "Piece data received for blocks that another peer had already sent"sv },
+    { "handshakes_failed"sv, "Peer handshakes that failed, including timeouts"sv },
+    { "handshakes_ok"sv, "Peer handshakes that succeeded"sv },
+    { "handshakes_timed_out"sv, "Peer handshakes that timed out"sv },
+    { "open_files_hits"sv, "Torrent file lookups that found the file already open"sv },
+    { "open_files_misses"sv, "Torrent file lookups that had to open the file"sv },
+    { "peer_bytes_read"sv, "Bytes read from peer sockets"sv },
+    { "peer_bytes_written"sv, "Bytes written to peer sockets"sv },
+    { "peer_message_allocations_bitfield"sv, "Heap allocations made building 'bitfield' peer messages"sv },
+    { "peer_message_allocations_cancel"sv, "Heap allocations made building 'cancel' peer messages"sv },
+    { "peer_message_allocations_choke"sv, "Heap allocations made building 'choke' peer messages"sv },
+    { "peer_message_allocations_dht_port"sv, "Heap allocations made building 'dht-port' peer messages"sv },
+    { "peer_message_allocations_fext_allowed_fast"sv, "Heap allocations made building 'fext-allowed-fast' peer messages"sv },
+    { "peer_message_allocations_fext_have_all"sv, "Heap allocations made building 'fext-have-all' peer messages"sv },
+    { "peer_message_allocations_fext_have_none"sv, "Heap allocations made building 'fext-have-none' peer messages"sv },
+    { "peer_message_allocations_fext_reject"sv, "Heap allocations made building 'fext-reject' peer messages"sv },
+    { "peer_message_allocations_fext_suggest"sv, "Heap allocations made building 'fext-suggest' peer messages"sv },
+    { "peer_message_allocations_have"sv, "Heap allocations made building 'have' peer messages"sv },
+    { "peer_message_allocations_interested"sv, "Heap allocations made building 'interested' peer messages"sv },
+    { "peer_message_allocations_ltep"sv, "Heap allocations made building 'ltep' peer messages"sv },
+    { "peer_message_allocations_not_interested"sv, "Heap allocations made building 'not-interested' peer messages"sv },
+    { "peer_message_allocations_piece"sv, "Heap allocations made building 'piece' peer messages"sv },
+    { "peer_message_allocations_request"sv, "Heap allocations made building 'request' peer messages"sv },
+    { "peer_message_allocations_unchoke"sv, "Heap allocations made building 'unchoke' peer messages"sv },
+    { "peer_messages_sent_bitfield"sv, "'bitfield' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_cancel"sv, "'cancel' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_choke"sv, "'choke' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_dht_port"sv, "'dht-port' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_fext_allowed_fast"sv, "'fext-allowed-fast' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_fext_have_all"sv, "'fext-have-all' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_fext_have_none"sv, "'fext-have-none' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_fext_reject"sv, "'fext-reject' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_fext_suggest"sv, "'fext-suggest' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_have"sv, "'have' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_interested"sv, "'interested' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_ltep"sv, "'ltep' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_not_interested"sv, "'not-interested' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_piece"sv, "'piece' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_request"sv, "'request' messages queued to be sent to peers"sv },
+    { "peer_messages_sent_unchoke"sv, "'unchoke' messages queued to be sent to peers"sv },
+    { "rpc_requests"sv, "RPC requests handled by the RPC server"sv },
+    { "scrapes_failed"sv, "Tracker scrapes that failed or timed out"sv },
+    { "scrapes_ok"sv, "Tracker scrapes that succeeded"sv },
+    { "session_thread_tasks"sv, "Tasks queued to and run by the session thread"sv },
+    { "utp_packets_in"sv, "UDP packets handled by µTP"sv },
+    { "utp_packets_out"sv, "UDP packets sent by µTP"sv },
+    { "utp_timer_wakeups"sv, "Times that the µTP timeout timer ran"sv },
+    { "verify_bytes"sv, "Bytes read while verifying local data"sv },
+    { "verify_pieces"sv, "Pieces checked while verifying local data"sv },
+} };
+
+auto constexpr HistogramInfo = std::array<Info, HistogramCount>{ {
+    { "bandwidth_allocation_seconds"sv, "Time spent allocating bandwidth and doing the resulting peer IO"sv },
+    { "disk_read_seconds"sv, "Latency of reads from torrent files"sv },
+    { "disk_write_seconds"sv, "Latency of writes to torrent files"sv },
+    { "rpc_request_seconds"sv, "Time from receiving an RPC request to sending its response"sv },
+    { "session_thread_lag_seconds"sv, "Time that queued tasks wait before the session thread runs them"sv },
+} };
+
+// ---
+
+// Each thread records to one shard. Shards are cache-line aligned so that
+// threads on different shards never contend on the same cache line.
+struct alignas(64) Shard
+{
+    struct HistogramShard
+    {
+        std::array<std::atomic<uint64_t>, BucketCount> buckets = {};
+        std::atomic<uint64_t> sum_usec = {};
+    };
+
+    std::array<std::atomic<uint64_t>, CounterCount> counters = {};
+    std::array<HistogramShard, HistogramCount> histograms = {};
+};
+
+// More shards than libtransmission has busy threads
+auto constexpr ShardCount = size_t{ 16U };
+
+std::array<Shard, ShardCount> shards;
+std::atomic<size_t> next_shard = 0U;
+
+[[nodiscard]] Shard& this_thread_shard() noexcept
+{
+    thread_local auto& shard = shards[next_shard.fetch_add(1U, std::memory_order_relaxed) % ShardCount];
+    return shard;
+}
+} // namespace
+
+void tr::metrics::add(Counter const counter, uint64_t const n) noexcept
+{
+    this_thread_shard().counters[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void tr::metrics::observe(Histogram const histogram, std::chrono::steady_clock::duration const duration) noexcept
+{
+    auto const usec = std::max(std::chrono::duration_cast<std::chrono::microseconds>(duration), std::chrono::microseconds{});
+    auto const bucket = static_cast<size_t>(std::ranges::lower_bound(BucketBounds, usec) - std::begin(BucketBounds));
+
+    auto& values = this_thread_shard().histograms[static_cast<size_t>(histogram)];
+    values.buckets[bucket].fetch_add(1U, std::memory_order_relaxed);
+    values.sum_usec.fetch_add(usec.count(), std::memory_order_relaxed);
+}
+
+tr::metrics::Snapshot tr::metrics::snapshot() noexcept
+{
+    auto ret = Snapshot{};
+
+    for (auto const& shard : shards)
+    {
+        for (size_t i = 0; i < CounterCount; ++i)
+        {
+            ret.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < HistogramCount; ++i)
+        {
+            auto const& from = shard.histograms[i];
+            auto& to = ret.histograms[i];
+
+            for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+            {
+                auto const n = from.buckets[bucket].load(std::memory_order_relaxed);
+                to.buckets[bucket] += n;
+                to.count += n;
+            }
+
+            to.sum += std::chrono::microseconds{ from.sum_usec.load(std::memory_order_relaxed) };
+        }
+    }
+
+    return ret;
+}
+
+std::string_view tr::metrics::name(Counter const counter) noexcept
+{
+    return CounterInfo[static_cast<size_t>(counter)].name;
+}
+
+std::string_view tr::metrics::name(Histogram const histogram) noexcept
+{
+    return HistogramInfo[static_cast<size_t>(histogram)].name;
+}
+
+std::string tr::metrics::to_prometheus(Snapshot const& snapshot)
+{
+    static auto constexpr Prefix = "transmission_"sv;
+    static auto constexpr ToSeconds = [](std::chrono::microseconds const usec)
+    {
+        return std::chrono::duration<double>{ usec }.count();
+    };
+
+    auto out = std::string{};
+    auto it = std::back_inserter(out);
+
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        auto const [name, help] = CounterInfo[i];
+        fmt::format_to(it, "# HELP {0:s}{1:s}_total {2:s}\n", Prefix, name, help);
+        fmt::format_to(it, "# TYPE {0:s}{1:s}_total counter\n", Prefix, name);
+        fmt::format_to(it, "{0:s}{1:s}_total {2:d}\n", Prefix, name, snapshot.counters[i]);
+    }
+
+    for (size_t i = 0; i < HistogramCount; ++i)
+    {
+        auto const [name, help] = HistogramInfo[i];
+        auto const& values = snapshot.histograms[i];
+        fmt::format_to(it, "# HELP {0:s}{1:s} {2:s}\n", Prefix, name, help);
+        fmt::format_to(it, "# TYPE {0:s}{1:s} histogram\n", Prefix, name);
+
+        // Prometheus' buckets are cumulative
+        auto n = uint64_t{};
+        for (size_t bucket = 0; bucket < std::size(BucketBounds); ++bucket)
+        {
+            n += values.buckets[bucket];
+            fmt::format_to(it, "{0:s}{1:s}_bucket{{le=\"{2}\"}} {3:d}\n", Prefix, name, ToSeconds(BucketBounds[bucket]), n);
+        }
+        fmt::format_to(it, "{0:s}{1:s}_bucket{{le=\"+Inf\"}} {2:d}\n", Prefix, name, values.count);
+
+        fmt::format_to(it, "{0:s}{1:s}_sum {2}\n", Prefix, name, ToSeconds(values.sum));
+        fmt::format_to(it, "{0:s}{1:s}_count {2:d}\n", Prefix, name, values.count);
+    }
+
+    return out;
+}
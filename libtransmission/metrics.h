@@ -0,0 +1,188 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <array>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint64_t
+#include <string>
+#include <string_view>
+
+/**
+ * Counters and latency histograms for libtransmission's internals.
+ *
+ * Recording is cheap and safe from any thread: each thread is assigned
+ * one of a fixed number of cache-line-sized shards and only does relaxed
+ * atomic adds on it. The shards are summed up when taking a snapshot.
+ *
+ * Snapshots are exposed by the `session_metrics` RPC method and, if
+ * `rpc_metrics_enabled` is set, in Prometheus' text format at
+ * `/transmission/metrics`.
+ */
+namespace tr::metrics
+{
+enum class Counter : uint8_t
+{
+    AnnouncesFailed,
+    AnnouncesOk,
+    BandwidthAllocations,
+    DhtAnnounceLagSeconds, // summed up, so that lag / announces is the average lag
+    DhtAnnounces,
+    DiskBytesRead,
+    DiskBytesWritten,
+    EndgameRequests, // duplicate block requests sent in endgame mode
+    EndgameWastedBytes, // piece data received for blocks that another peer sent first
+    HandshakesFailed,
+    HandshakesOk,
+    HandshakesTimedOut,
+    OpenFilesHits,
+    OpenFilesMisses,
+    PeerBytesRead,
+    PeerBytesWritten,
+    // heap allocations made while building outgoing peer messages, by message type
+    PeerMessageAllocationsBitfield,
+    PeerMessageAllocationsCancel,
+    PeerMessageAllocationsChoke,
+    PeerMessageAllocationsDhtPort,
+    PeerMessageAllocationsFextAllowedFast,
+    PeerMessageAllocationsFextHaveAll,
+    PeerMessageAllocationsFextHaveNone,
+    PeerMessageAllocationsFextReject,
+    PeerMessageAllocationsFextSuggest,
+    PeerMessageAllocationsHave,
+    PeerMessageAllocationsInterested,
+    PeerMessageAllocationsLtep,
+    PeerMessageAllocationsNotInterested,
+    PeerMessageAllocationsPiece,
+    PeerMessageAllocationsRequest,
+    PeerMessageAllocationsUnchoke,
+    // messages queued to be sent to peers, by message type
+    PeerMessagesSentBitfield,
+    PeerMessagesSentCancel,
+    PeerMessagesSentChoke,
+    PeerMessagesSentDhtPort,
+    PeerMessagesSentFextAllowedFast,
+    PeerMessagesSentFextHaveAll,
+    PeerMessagesSentFextHaveNone,
+    PeerMessagesSentFextReject,
+    PeerMessagesSentFextSuggest,
+    PeerMessagesSentHave,
+    PeerMessagesSentInterested,
+    PeerMessagesSentLtep,
+    PeerMessagesSentNotInterested,
+    PeerMessagesSentPiece,
+    PeerMessagesSentRequest,
+    PeerMessagesSentUnchoke,
+    RpcRequests,
+    ScrapesFailed,
+    ScrapesOk,
+    SessionThreadTasks,
+    UtpPacketsIn,
+    UtpPacketsOut,
+    UtpTimerWakeups,
+    VerifyBytes,
+    VerifyPieces,
+};
+
+inline auto constexpr CounterCount = size_t{ 57U };
+
+enum class Histogram : uint8_t
+{
+    BandwidthAllocationTime,
+    DiskReadTime,
+    DiskWriteTime,
+    RpcRequestTime,
+    SessionThreadLag, // how long queued tasks wait before the session thread runs them
+};
+
+inline auto constexpr HistogramCount = size_t{ 5U };
+
+// Upper bounds of the histogram buckets. Anything slower goes in a last, unbounded bucket.
+inline auto constexpr BucketBounds = std::array<std::chrono::microseconds, 14U>{ {
+    std::chrono::microseconds{ 10 },
+    std::chrono::microseconds{ 50 },
+    std::chrono::microseconds{ 100 },
+    std::chrono::microseconds{ 250 },
+    std::chrono::microseconds{ 500 },
+    std::chrono::microseconds{ 1000 },
+    std::chrono::microseconds{ 2500 },
+    std::chrono::microseconds{ 5000 },
+    std::chrono::microseconds{ 10000 },
+    std::chrono::microseconds{ 25000 },
+    std::chrono::microseconds{ 50000 },
+    std::chrono::microseconds{ 100000 },
+    std::chrono::microseconds{ 500000 },
+    std::chrono::microseconds{ 1000000 },
+} };
+
+inline auto constexpr BucketCount = std::size(BucketBounds) + 1U;
+
+struct Snapshot
+{
+    struct HistogramValues
+    {
+        // not cumulative: buckets[i] only counts values in (BucketBounds[i - 1], BucketBounds[i]]
+        std::array<uint64_t, BucketCount> buckets = {};
+        uint64_t count = {};
+        std::chrono::microseconds sum = {};
+    };
+
+    [[nodiscard]] constexpr auto operator[](Counter const counter) const noexcept
+    {
+        return counters[static_cast<size_t>(counter)];
+    }
+
+    [[nodiscard]] constexpr auto const& operator[](Histogram const histogram) const noexcept
+    {
+        return histograms[static_cast<size_t>(histogram)];
+    }
+
+    std::array<uint64_t, CounterCount> counters = {};
+    std::array<HistogramValues, HistogramCount> histograms = {};
+};
+
+void add(Counter counter, uint64_t n = 1U) noexcept;
+
+void observe(Histogram histogram, std::chrono::steady_clock::duration duration) noexcept;
+
+[[nodiscard]] Snapshot snapshot() noexcept;
+
+// e.g. "disk_bytes_read"
+[[nodiscard]] std::string_view name(Counter counter) noexcept;
+[[nodiscard]] std::string_view name(Histogram histogram) noexcept;
+
+// Render a snapshot in Prometheus' text exposition format
+[[nodiscard]] std::string to_prometheus(Snapshot const& snapshot);
+
+// Observes how long it lives in a histogram
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Histogram histogram) noexcept
+        : histogram_{ histogram }
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        observe(histogram_, std::chrono::steady_clock::now() - begin_);
+    }
+
+    ScopedTimer(ScopedTimer const&) = delete;
+    ScopedTimer(ScopedTimer&&) = delete;
+    ScopedTimer& operator=(ScopedTimer const&) = delete;
+    ScopedTimer& operator=(ScopedTimer&&) = delete;
+
+private:
+    std::chrono::steady_clock::time_point const begin_ = std::chrono::steady_clock::now();
+    Histogram const histogram_;
+};
+} // namespace tr::metrics
@@ -16,6 +16,7 @@
 #include "libtransmission/error.h"
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/open-files.h"
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/tr-strbuf.h"
@@ -129,12 +130,15 @@ std::optional<tr_sys_file_t> tr_open_files::get(tr_torrent_id_t tor_id, tr_file_
     {
         if (writable && !found->writable_)
         {
+            tr::metrics::add(tr::metrics::Counter::OpenFilesMisses);
             return {};
         }
 
+        tr::metrics::add(tr::metrics::Counter::OpenFilesHits);
         return found->fd_;
     }
 
+    tr::metrics::add(tr::metrics::Counter::OpenFilesMisses);
     return {};
 }
 
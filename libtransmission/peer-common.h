@@ -28,6 +28,7 @@
 class tr_swarm;
 struct tr_bandwidth;
 struct tr_peer;
+struct tr_torrent;
 
 // --- Peer Publish / Subscribe
 
@@ -49,6 +50,7 @@ public:
         // Unless otherwise specified, all events are for BT peers only
         ClientGotBlock, // applies to webseed too
         ClientGotChoke,
+        ClientGotDuplicateData, // piece data for a block we already have
         ClientGotPieceData, // applies to webseed too
         ClientGotAllowedFast,
         ClientGotSuggest,
@@ -69,7 +71,7 @@ public:
     tr_bitfield* bitfield = nullptr; // for GotBitfield
     uint32_t pieceIndex = 0; // for GotBlock, GotHave, Cancel, Allowed, Suggest
     uint32_t offset = 0; // for GotBlock
-    uint32_t length = 0; // for GotBlock, GotPieceData
+    uint32_t length = 0; // for GotBlock, GotPieceData, GotDuplicateData
     int err = 0; // errno for GotError
     tr_port port; // for GotPort
 
@@ -103,6 +105,14 @@ public:
         return event;
     }
 
+    [[nodiscard]] constexpr static auto GotDuplicateData(uint32_t length) noexcept
+    {
+        auto event = tr_peer_event{};
+        event.type = Type::ClientGotDuplicateData;
+        event.length = length;
+        return event;
+    }
+
     [[nodiscard]] constexpr static auto GotError(int err) noexcept
     {
         auto event = tr_peer_event{};
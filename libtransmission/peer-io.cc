@@ -20,6 +20,7 @@
 #include "libtransmission/block-info.h" // tr_block_info
 #include "libtransmission/error.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-io.h"
 #include "libtransmission/peer-socket-tcp.h"
@@ -28,6 +29,7 @@
 #include "libtransmission/session.h"
 #include "libtransmission/timer.h"
 #include "libtransmission/tr-assert.h"
+#include "libtransmission/tracer.h"
 #include "libtransmission/types.h"
 #include "libtransmission/utils.h" // for _()
 
@@ -341,6 +343,7 @@ size_t tr_peerIo::try_write(size_t max)
     }
     else if (n_written > 0U)
     {
+        tr::metrics::add(tr::metrics::Counter::PeerBytesWritten, n_written);
         did_write_wrapper(n_written);
     }
 
@@ -349,6 +352,8 @@ size_t tr_peerIo::try_write(size_t max)
 
 void tr_peerIo::write_cb()
 {
+    auto const span = tr::tracer::Span{ tr::tracer::Kind::PeerWrite, "peer write" };
+
     // Write as much as possible. Since the socket is non-blocking,
     // write() will return if it can't write any more without blocking
     auto const n_wrote = try_write(SIZE_MAX);
@@ -447,6 +452,7 @@ size_t tr_peerIo::try_read(size_t max)
     }
     else if (!std::empty(buf))
     {
+        tr::metrics::add(tr::metrics::Counter::PeerBytesRead, n_read);
         can_read_wrapper(n_read);
     }
 
@@ -457,6 +463,8 @@ void tr_peerIo::read_cb()
 {
     static auto constexpr MaxLen = RcvBuf;
 
+    auto const span = tr::tracer::Span{ tr::tracer::Kind::PeerRead, "peer read" };
+
     // if we don't have any bandwidth left, stop reading
     auto const n_used = read_buffer_size();
     auto const n_left = n_used >= MaxLen ? 0U : MaxLen - n_used;
@@ -517,12 +525,24 @@ void tr_peerIo::write_bytes(void const* bytes, size_t n_bytes, bool is_piece_dat
         return;
     }
 
-    outbuf_info_.emplace_back(n_bytes, is_piece_data);
-
     auto [resbuf, reslen] = outbuf_.reserve_space(n_bytes);
     filter_.encrypt(static_cast<std::byte const*>(bytes), n_bytes, resbuf);
     outbuf_.commit_space(n_bytes);
 
+    did_add_to_outbuf(n_bytes, is_piece_data);
+}
+
+void tr_peerIo::did_add_to_outbuf(size_t n_bytes, bool is_piece_data)
+{
+    if (!std::empty(outbuf_info_) && outbuf_info_.back().second == is_piece_data)
+    {
+        outbuf_info_.back().first += n_bytes;
+    }
+    else
+    {
+        outbuf_info_.emplace_back(n_bytes, is_piece_data);
+    }
+
     flush_outbuf_soon();
 }
 
@@ -22,6 +22,7 @@
 #include "libtransmission/bandwidth.h"
 #include "libtransmission/peer-mse.h"
 #include "libtransmission/peer-socket.h"
+#include "libtransmission/tr-assert.h"
 #include "libtransmission/tr-buffer.h"
 #include "libtransmission/types.h"
 
@@ -148,6 +149,29 @@ public:
         buf.drain(n_bytes);
     }
 
+    // Encode a message of `n_bytes` straight into the outbuf instead of
+    // building it elsewhere and copying it in with `write()`.
+    // `encode` gets a tr::BufferWriter<std::byte>& with room for exactly `n_bytes`.
+    // @return true if the outbuf had to grow to make room for the message
+    template<typename Encoder>
+    bool write_in_place(size_t n_bytes, bool is_piece_data, Encoder&& encode)
+    {
+        if (n_bytes == 0U)
+        {
+            return false;
+        }
+
+        auto const old_capacity = outbuf_.capacity();
+        auto [buf, buflen] = outbuf_.reserve_space(n_bytes);
+        auto writer = tr::SpanWriter<std::byte>{ buf, n_bytes };
+        encode(writer);
+        TR_ASSERT(std::size(writer) == n_bytes);
+        filter_.encrypt(buf, n_bytes, buf);
+        outbuf_.commit_space(n_bytes);
+        did_add_to_outbuf(n_bytes, is_piece_data);
+        return outbuf_.capacity() != old_capacity;
+    }
+
     size_t flush_outgoing_protocol_msgs();
 
     size_t flush(tr_direction dir, size_t byte_limit)
@@ -332,6 +356,7 @@ private:
     void read_cb();
     void write_cb();
     void flush_outbuf_soon();
+    void did_add_to_outbuf(size_t n_bytes, bool is_piece_data);
 
     void can_read_wrapper(size_t bytes_transferred);
     void did_write_wrapper(size_t bytes_transferred);
@@ -350,6 +375,8 @@ private:
     Filter filter_;
     std::optional<size_t> n_decrypt_remain_;
 
+    // Runs of bytes in `outbuf_`. Consecutive writes of the same kind share
+    // an entry, so a burst of protocol messages costs one entry per flush.
     std::deque<std::pair<size_t /*n_bytes*/, bool /*is_piece_data*/>> outbuf_info_;
 
     std::shared_ptr<tr_peer_socket> socket_;
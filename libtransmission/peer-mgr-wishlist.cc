@@ -15,6 +15,7 @@
 
 #define LIBTRANSMISSION_PEER_MODULE
 
+#include "libtransmission/bitfield.h"
 #include "libtransmission/crypto-utils.h" // for tr_salt_shaker
 #include "libtransmission/peer-mgr-wishlist.h"
 #include "libtransmission/tr-assert.h"
@@ -70,15 +71,22 @@ Wishlist::Candidate::Candidate(tr_piece_index_t piece_in, tr_piece_index_t salt_
 
 // ---
 
-std::vector<tr_block_span_t> Wishlist::next(
-    size_t const n_wanted_blocks,
-    std::function<bool(tr_piece_index_t)> const& peer_has_piece)
+std::vector<tr_block_span_t> Wishlist::next(size_t const n_wanted_blocks, tr_bitfield const& peer_has)
 {
     if (n_wanted_blocks == 0U)
     {
         return {};
     }
 
+    // How many of the peer's pieces still have blocks we could ask for?
+    // This is usually zero for peers that have nothing new to offer,
+    // so it lets us skip walking the candidate list entirely.
+    auto n_matching = peer_has.has_all() ? requestable_.count() : requestable_.count_intersection(peer_has);
+    if (n_matching == 0U)
+    {
+        return {};
+    }
+
     auto blocks = small::vector<tr_block_index_t>{};
     blocks.reserve(n_wanted_blocks);
     for (auto const& candidate : candidates_)
@@ -87,17 +95,25 @@ std::vector<tr_block_span_t> Wishlist::next(
         TR_ASSERT(n_added <= n_wanted_blocks);
 
         // do we have enough?
-        if (n_added >= n_wanted_blocks)
+        if (n_added >= n_wanted_blocks || n_matching == 0U)
+        {
+            break;
+        }
+
+        // the rest of the candidates have nothing left to request
+        if (std::empty(candidate.unrequested))
         {
             break;
         }
 
         // if the peer doesn't have this piece that we want...
-        if (candidate.replication == 0 || !peer_has_piece(candidate.piece))
+        if (candidate.replication == 0 || !peer_has.test(candidate.piece))
         {
             continue;
         }
 
+        --n_matching;
+
         // walk the blocks in this piece that we don't have or not requested
         auto const n_to_add = std::min(std::size(candidate.unrequested), n_wanted_blocks - n_added);
         std::copy_n(std::rbegin(candidate.unrequested), n_to_add, std::back_inserter(blocks));
@@ -109,6 +125,51 @@ std::vector<tr_block_span_t> Wishlist::next(
     return make_spans(blocks);
 }
 
+std::vector<tr_block_span_t> Wishlist::next_endgame(
+    size_t const n_wanted_blocks,
+    tr_bitfield const& peer_has,
+    tr_bitfield const& peer_requests)
+{
+    if (n_wanted_blocks == 0U || !is_endgame() || peer_has.has_none())
+    {
+        return {};
+    }
+
+    auto blocks = small::vector<tr_block_index_t>{};
+    blocks.reserve(n_wanted_blocks);
+    for (auto const& candidate : candidates_)
+    {
+        if (std::size(blocks) >= n_wanted_blocks)
+        {
+            break;
+        }
+
+        if (candidate.replication == 0 || !peer_has.test(candidate.piece))
+        {
+            continue;
+        }
+
+        // every block in the piece that we don't have yet is in flight
+        for (auto [block, end] = candidate.block_span; block < end && std::size(blocks) < n_wanted_blocks; ++block)
+        {
+            if (mediator_.client_has_block(block) || peer_requests.test(block))
+            {
+                continue;
+            }
+
+            // the count goes up in requested_block_span(), once the request is actually sent
+            if (auto const iter = endgame_dupes_.find(block);
+                iter == std::end(endgame_dupes_) || iter->second < MaxEndgameDuplicates)
+            {
+                blocks.push_back(block);
+            }
+        }
+    }
+
+    std::ranges::sort(blocks);
+    return make_spans(blocks);
+}
+
 void Wishlist::on_got_bad_piece(tr_piece_index_t const piece)
 {
     auto iter = find_by_piece(piece);
@@ -150,7 +211,7 @@ void Wishlist::on_got_bad_piece(tr_piece_index_t const piece)
         }
     }
 
-    std::ranges::sort(candidates_);
+    sort_candidates();
 }
 
 tr_piece_index_t Wishlist::get_salt(tr_piece_index_t const piece)
@@ -196,6 +257,11 @@ void Wishlist::candidate_list_upkeep()
     auto const n_pieces = mediator_.piece_count();
     candidates_.reserve(n_pieces);
 
+    if (std::size(requestable_) != n_pieces)
+    {
+        requestable_ = tr_bitfield{ n_pieces };
+    }
+
     std::ranges::sort(candidates_, [](auto const& lhs, auto const& rhs) { return lhs.piece < rhs.piece; });
 
     Candidate* prev = nullptr;
@@ -287,7 +353,24 @@ void Wishlist::candidate_list_upkeep()
         }
     }
 
+    sort_candidates();
+}
+
+void Wishlist::sort_candidates()
+{
     std::ranges::sort(candidates_);
+
+    requestable_.set_has_none();
+    for (auto const& candidate : candidates_)
+    {
+        if (std::empty(candidate.unrequested))
+        {
+            // sorted to the end, so none of the rest are requestable either
+            break;
+        }
+
+        requestable_.set(candidate.piece);
+    }
 }
 
 void Wishlist::recalculate_salt()
@@ -297,7 +380,7 @@ void Wishlist::recalculate_salt()
         candidate.salt = get_salt(candidate.piece);
     }
 
-    std::ranges::sort(candidates_);
+    sort_candidates();
 }
 
 void Wishlist::on_priority_changed()
@@ -307,5 +390,5 @@ void Wishlist::on_priority_changed()
         candidate.priority = mediator_.priority(candidate.piece);
     }
 
-    std::ranges::sort(candidates_);
+    sort_candidates();
 }
@@ -12,15 +12,16 @@
 #include <algorithm>
 #include <compare>
 #include <cstddef> // size_t
+#include <cstdint> // uint8_t
 #include <functional>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <small/set.hpp>
 
 #include "libtransmission/bitfield.h"
 #include "libtransmission/crypto-utils.h"
-#include "libtransmission/tr-macros.h"
 #include "libtransmission/types.h"
 
 /**
@@ -50,6 +51,13 @@ private:
 
         [[nodiscard]] constexpr auto operator<=>(Candidate const& that) const noexcept
         {
+            // keep candidates with nothing left to request at the end,
+            // so that next() can stop as soon as it reaches them.
+            if (auto const val = std::empty(unrequested) <=> std::empty(that.unrequested); val != 0)
+            {
+                return val;
+            }
+
             // prefer pieces closer to completion, skipped in sequential mode
             // where we want to prioritize pieces in order.
             if (!is_sequential)
@@ -109,6 +117,9 @@ private:
     using CandidateVec = std::vector<Candidate>;
 
 public:
+    // In endgame mode, the most extra copies of a block that may be in flight at once
+    static auto constexpr MaxEndgameDuplicates = uint8_t{ 2U };
+
     explicit Wishlist(Mediator& mediator_in)
         : mediator_{ mediator_in }
     {
@@ -122,26 +133,28 @@ public:
 
     void on_got_bad_piece(tr_piece_index_t piece);
 
-    constexpr void on_got_bitfield(tr_bitfield const& bitfield)
+    void on_got_bitfield(tr_bitfield const& bitfield)
     {
         inc_replication_bitfield(bitfield);
     }
 
-    constexpr void on_got_block(tr_block_index_t const block)
+    void on_got_block(tr_block_index_t const block)
     {
         if (auto const iter = find_by_block(block); iter != std::end(candidates_))
         {
             iter->unrequested.erase(block);
             resort_piece(iter);
         }
+
+        endgame_dupes_.erase(block);
     }
 
-    TR_CONSTEXPR_VEC void on_got_choke(tr_bitfield const& requests)
+    void on_got_choke(tr_bitfield const& requests)
     {
         reset_blocks_bitfield(requests);
     }
 
-    constexpr void on_got_have(tr_piece_index_t const piece)
+    void on_got_have(tr_piece_index_t const piece)
     {
         if (auto const iter = find_by_piece(piece); iter != std::end(candidates_))
         {
@@ -155,30 +168,30 @@ public:
         inc_replication();
     }
 
-    constexpr void on_got_reject(tr_block_index_t const block)
+    void on_got_reject(tr_block_index_t const block)
     {
         reset_block(block);
     }
 
-    TR_CONSTEXPR_VEC void on_peer_disconnect(tr_bitfield const& have, tr_bitfield const& requests)
+    void on_peer_disconnect(tr_bitfield const& have, tr_bitfield const& requests)
     {
         dec_replication_bitfield(have);
         reset_blocks_bitfield(requests);
     }
 
-    constexpr void on_piece_completed(tr_piece_index_t const piece)
+    void on_piece_completed(tr_piece_index_t const piece)
     {
         remove_piece(piece);
     }
 
     void on_priority_changed();
 
-    constexpr void on_sent_cancel(tr_block_index_t const block)
+    void on_sent_cancel(tr_block_index_t const block)
     {
         reset_block(block);
     }
 
-    constexpr void on_sent_request(tr_block_span_t const block_span)
+    void on_sent_request(tr_block_span_t const block_span)
     {
         requested_block_span(block_span);
     }
@@ -194,9 +207,22 @@ public:
     }
 
     // the next blocks that we should request from a peer
-    [[nodiscard]] std::vector<tr_block_span_t> next(
+    [[nodiscard]] std::vector<tr_block_span_t> next(size_t n_wanted_blocks, tr_bitfield const& peer_has);
+
+    // Endgame mode: every block we're missing has already been requested,
+    // so the download is waiting on whichever peers hold those requests.
+    [[nodiscard]] constexpr bool is_endgame() const noexcept
+    {
+        return !std::empty(candidates_) && requestable_.count() == 0U;
+    }
+
+    // In endgame mode, blocks that are in flight from other peers that we
+    // could also request from this peer. Each block is duplicated at most
+    // MaxEndgameDuplicates times; the first copy to arrive cancels the rest.
+    [[nodiscard]] std::vector<tr_block_span_t> next_endgame(
         size_t n_wanted_blocks,
-        std::function<bool(tr_piece_index_t)> const& peer_has_piece);
+        tr_bitfield const& peer_has,
+        tr_bitfield const& peer_requests);
 
 private:
     constexpr void dec_replication() noexcept
@@ -204,7 +230,7 @@ private:
         std::ranges::for_each(candidates_, [](Candidate& candidate) { --candidate.replication; });
     }
 
-    constexpr void dec_replication_bitfield(tr_bitfield const& bitfield)
+    void dec_replication_bitfield(tr_bitfield const& bitfield)
     {
         if (bitfield.has_none())
         {
@@ -225,7 +251,7 @@ private:
             }
         }
 
-        std::ranges::sort(candidates_);
+        sort_candidates();
     }
 
     constexpr void inc_replication() noexcept
@@ -233,7 +259,7 @@ private:
         std::ranges::for_each(candidates_, [](Candidate& candidate) { ++candidate.replication; });
     }
 
-    constexpr void inc_replication_bitfield(tr_bitfield const& bitfield)
+    void inc_replication_bitfield(tr_bitfield const& bitfield)
     {
         if (bitfield.has_none())
         {
@@ -254,12 +280,12 @@ private:
             }
         }
 
-        std::ranges::sort(candidates_);
+        sort_candidates();
     }
 
     // ---
 
-    constexpr void requested_block_span(tr_block_span_t const block_span)
+    void requested_block_span(tr_block_span_t const block_span)
     {
         for (auto block = block_span.begin; block < block_span.end;)
         {
@@ -270,24 +296,45 @@ private:
                 break;
             }
 
+            // a block that was already requested is an endgame duplicate
             auto& unreq = it_p->unrequested;
+            for (auto const end = std::min(block_span.end, it_p->block_span.end); block < end; ++block)
+            {
+                if (unreq.erase(block) == 0U)
+                {
+                    ++endgame_dupes_[block];
+                }
+            }
 
-            auto it_b_end = std::end(unreq);
-            it_b_end = *std::prev(it_b_end) >= block_span.begin ? it_b_end : unreq.upper_bound(block_span.begin);
-
-            auto it_b_begin = std::begin(unreq);
-            it_b_begin = *it_b_begin < block_span.end ? it_b_begin : unreq.upper_bound(block_span.end);
-
-            unreq.erase(it_b_begin, it_b_end);
+            resort_piece(it_p);
+        }
+    }
 
-            block = it_p->block_span.end;
+    // Returns true if another copy of `block` is still in flight,
+    // i.e. the request that's going away was an endgame duplicate.
+    bool release_duplicate(tr_block_index_t const block)
+    {
+        auto const iter = endgame_dupes_.find(block);
+        if (iter == std::end(endgame_dupes_))
+        {
+            return false;
+        }
 
-            resort_piece(it_p);
+        if (--iter->second == 0U)
+        {
+            endgame_dupes_.erase(iter);
         }
+
+        return true;
     }
 
-    constexpr void reset_block(tr_block_index_t block)
+    void reset_block(tr_block_index_t block)
     {
+        if (release_duplicate(block))
+        {
+            return;
+        }
+
         if (auto const it_p = find_by_block(block); it_p != std::end(candidates_))
         {
             it_p->unrequested.insert(block);
@@ -295,7 +342,7 @@ private:
         }
     }
 
-    TR_CONSTEXPR_VEC void reset_blocks_bitfield(tr_bitfield const& requests)
+    void reset_blocks_bitfield(tr_bitfield const& requests)
     {
         for (auto& candidate : candidates_)
         {
@@ -307,14 +354,14 @@ private:
 
             for (auto i = end; i > begin; --i)
             {
-                if (auto const block = i - 1U; requests.test(block))
+                if (auto const block = i - 1U; requests.test(block) && !release_duplicate(block))
                 {
                     candidate.unrequested.insert(block);
                 }
             }
         }
 
-        std::ranges::sort(candidates_);
+        sort_candidates();
     }
 
     // ---
@@ -337,11 +384,12 @@ private:
 
     // ---
 
-    constexpr void remove_piece(tr_piece_index_t const piece)
+    void remove_piece(tr_piece_index_t const piece)
     {
         if (auto const iter = find_by_piece(piece); iter != std::end(candidates_))
         {
             candidates_.erase(iter);
+            requestable_.unset(piece);
         }
     }
 
@@ -349,10 +397,14 @@ private:
 
     void recalculate_salt();
 
+    void sort_candidates();
+
     // ---
 
-    constexpr void resort_piece(CandidateVec::iterator const& pos_old)
+    void resort_piece(CandidateVec::iterator const& pos_old)
     {
+        requestable_.set(pos_old->piece, !std::empty(pos_old->unrequested));
+
         auto const pos_begin = std::begin(candidates_);
 
         // Candidate needs to be moved towards the front of the list
@@ -371,6 +423,14 @@ private:
 
     CandidateVec candidates_;
 
+    // Pieces that still have unrequested blocks. Intersecting this with a
+    // peer's `have` bitfield tells next() how many candidates are worth
+    // looking at before it walks the list.
+    tr_bitfield requestable_{ 0U };
+
+    // endgame mode: block -> number of extra requests in flight for it
+    std::unordered_map<tr_block_index_t, uint8_t> endgame_dupes_;
+
     tr_salt_shaker<tr_piece_index_t> salter_ = {};
 
     Mediator& mediator_;
@@ -35,6 +35,7 @@
 #include "libtransmission/handshake.h"
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-common.h"
 #include "libtransmission/peer-io.h"
@@ -408,9 +409,19 @@ public:
         {
         }
 
-        [[nodiscard]] auto next(size_t const n_wanted_blocks, std::function<bool(tr_piece_index_t)> const& peer_has_piece)
+        [[nodiscard]] auto next(size_t const n_wanted_blocks, tr_bitfield const& peer_has)
         {
-            return wishlist_.next(n_wanted_blocks, peer_has_piece);
+            return wishlist_.next(n_wanted_blocks, peer_has);
+        }
+
+        [[nodiscard]] auto next_endgame(size_t const n_wanted_blocks, tr_bitfield const& peer_has, tr_bitfield const& peer_requests)
+        {
+            return wishlist_.next_endgame(n_wanted_blocks, peer_has, peer_requests);
+        }
+
+        [[nodiscard]] bool is_endgame() const noexcept
+        {
+            return wishlist_.is_endgame();
         }
 
         [[nodiscard]] bool client_has_block(tr_block_index_t const block) const override
@@ -524,6 +535,37 @@ public:
         return std::size(peers);
     }
 
+    [[nodiscard]] bool is_webseed(tr_peer const* const peer) const noexcept
+    {
+        return std::ranges::any_of(webseeds, [peer](auto const& webseed) { return webseed.get() == peer; });
+    }
+
+    // Endgame duplicates are only worth sending to peers that are delivering
+    // at least as fast as the average of the peers that are sending to us.
+    [[nodiscard]] bool is_fast_peer(tr_peer const* const peer, uint64_t const now_msec) const
+    {
+        auto const peer_speed = peer->get_piece_speed(now_msec, tr_direction::PeerToClient).base_quantity();
+        if (peer_speed == 0U)
+        {
+            return false;
+        }
+
+        auto total = uint64_t{};
+        auto n_active = uint64_t{};
+        auto const add = [&](auto const& other)
+        {
+            if (auto const speed = other->get_piece_speed(now_msec, tr_direction::PeerToClient).base_quantity(); speed != 0U)
+            {
+                total += speed;
+                ++n_active;
+            }
+        };
+        std::ranges::for_each(peers, add);
+        std::ranges::for_each(webseeds, add);
+
+        return peer_speed * n_active >= total;
+    }
+
     void remove_peer(std::shared_ptr<tr_peerMsgs> const& peer)
     {
         auto const lock = unique_lock();
@@ -535,6 +577,7 @@ public:
 
         --stats.peer_count;
         --stats.peer_from_count[peer_info->from_first()];
+        tor->mark_changed();
 
         if (auto iter = std::ranges::find(peers, peer); iter != std::ranges::end(peers))
         {
@@ -644,6 +687,10 @@ public:
             on_client_got_piece_data(s->tor, event.length, tr_time());
             break;
 
+        case tr_peer_event::Type::ClientGotDuplicateData:
+            tr::metrics::add(tr::metrics::Counter::EndgameWastedBytes, event.length);
+            break;
+
         case tr_peer_event::Type::ClientGotHave:
             s->got_have(s->tor, event.pieceIndex);
             s->mark_all_upload_only_flag_dirty();
@@ -802,6 +849,12 @@ private:
         {
             maybe_send_cancel_request(peer.get(), block, no_notify);
         }
+
+        // a peer's endgame duplicate can beat a webseed's request
+        for (auto const& webseed : webseeds)
+        {
+            maybe_send_cancel_request(webseed.get(), block, no_notify);
+        }
     }
 
     void mark_all_upload_only_flag_dirty() noexcept
@@ -932,6 +985,14 @@ private:
                 auto const loc_begin = tor->piece_loc(event.pieceIndex, event.offset);
                 auto const loc_end = tor->piece_loc(event.pieceIndex, event.offset, event.length);
                 auto const span = tr_block_span_t{ .begin = loc_begin.block, .end = loc_end.block };
+
+                // Once in endgame, every request duplicates one that's already in flight.
+                // Check before `sent_request` because this request may be what starts it.
+                if (s->wishlist_controller && s->wishlist_controller->is_endgame())
+                {
+                    tr::metrics::add(tr::metrics::Counter::EndgameRequests, span.end - span.begin);
+                }
+
                 s->sent_request(tor, peer, span);
             }
             break;
@@ -1089,8 +1150,11 @@ public:
         , rechoke_timer_{ timer_maker.create([this]() { rechoke_pulse_marshall(); }) }
         , blocklists_tag_{ blocklist.observe_changes([this]() { on_blocklists_changed(); }) }
     {
+        bandwidth_timer_->set_name("peer-mgr bandwidth");
         bandwidth_timer_->start_repeating(BandwidthTimerPeriod);
+        peer_info_timer_->set_name("peer-mgr peer info");
         peer_info_timer_->start_repeating(PeerInfoPeriod);
+        rechoke_timer_->set_name("peer-mgr rechoke");
         rechoke_timer_->start_repeating(RechokePeriod);
     }
 
@@ -1210,18 +1274,37 @@ void tr_peerMgrFree(tr_peerMgr* manager)
  * 2. tr_swarm::wishlist, a class that tracks the pieces that we want to
  *    request. It's used to decide which blocks to return next when
  *    tr_peerMgrGetNextRequests() is called.
+ *
+ * Once every missing block has been requested, the wishlist is in endgame
+ * mode: fast peers are also asked for blocks that are already in flight
+ * elsewhere, and cancel_all_requests_for_block() cancels the other copies
+ * when the first one arrives.
  */
 
 std::vector<tr_block_span_t> tr_peerMgrGetNextRequests(tr_torrent* torrent, tr_peer const* peer, size_t numwant)
 {
     TR_ASSERT(!torrent->is_done());
 
-    if (auto& controller = torrent->swarm->wishlist_controller)
+    auto* const swarm = torrent->swarm;
+    auto& controller = swarm->wishlist_controller;
+    if (!controller)
+    {
+        return {};
+    }
+
+    if (!controller->is_endgame())
     {
-        return controller->next(numwant, [peer](tr_piece_index_t p) { return peer->has_piece(p); });
+        return controller->next(numwant, peer->has());
+    }
+
+    // Webseeds fetch large spans that can't be cancelled partway through,
+    // so leave the duplicates to peers.
+    if (swarm->is_webseed(peer) || !swarm->is_fast_peer(peer, tr_time_msec()))
+    {
+        return {};
     }
 
-    return {};
+    return controller->next_endgame(numwant, peer->has(), peer->active_requests);
 }
 
 namespace
@@ -1245,6 +1328,7 @@ void create_bit_torrent_peer(
 
     ++swarm->stats.peer_count;
     ++swarm->stats.peer_from_count[msgs->peer_info->from_first()];
+    tor.mark_changed();
 
     TR_ASSERT(swarm->stats.peer_count == swarm->peerCount());
     TR_ASSERT(swarm->stats.peer_from_count[msgs->peer_info->from_first()] <= swarm->stats.peer_count);
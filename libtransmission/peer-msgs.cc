@@ -20,6 +20,7 @@
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -28,6 +29,8 @@
 
 #include <small/vector.hpp>
 
+#define LIBTRANSMISSION_PEER_MODULE
+
 #include "libtransmission/bitfield.h"
 #include "libtransmission/block-info.h"
 #include "libtransmission/clients.h"
@@ -35,10 +38,12 @@
 #include "libtransmission/inout.h"
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/peer-common.h"
 #include "libtransmission/peer-io.h"
 #include "libtransmission/peer-mgr.h"
 #include "libtransmission/peer-msgs.h"
+#include "libtransmission/peer-request-pipeline.h"
 #include "libtransmission/quark.h"
 #include "libtransmission/session.h"
 #include "libtransmission/string-utils.h"
@@ -180,11 +185,6 @@ auto constexpr MetadataReqQ = size_t{ 64U };
 
 auto constexpr PeerReqQDefault = 500U;
 
-// when we're making requests from another peer,
-// batch them together to send enough requests to
-// meet our bandwidth goals for the next N seconds
-auto constexpr RequestBufSecs = time_t{ 10 };
-
 // ---
 
 auto constexpr MaxPexPeerCount = size_t{ 50U };
@@ -260,9 +260,11 @@ struct tr_incoming
 #define myLogMacro(msgs, level, text) \
     do \
     { \
-        if (tr_logLevelIsActive(level)) \
+        static auto tr_log_call_site_repeats = tr_log_repeats{}; \
+        if (tr_logLevelIsActive(level) && !tr_logIsMuted(tr_log_call_site_repeats)) \
         { \
             tr_logAddMessage( \
+                tr_log_call_site_repeats, \
                 __FILE__, \
                 __LINE__, \
                 (level), \
@@ -403,6 +405,7 @@ public:
     {
         cancels_sent_to_peer.add(tr_time(), 1);
         active_requests.unset(block);
+        pipeline_.on_request_cancelled(block);
         publish(tr_peer_event::SentCancel(tor_.block_info(), block));
         protocol_send_cancel(peer_request::from_block(tor_, block));
     }
@@ -475,6 +478,7 @@ public:
         TR_ASSERT(!client_is_choked());
 
         auto const timeout = tr_time() + RequestTimeoutSecs;
+        auto const now_msec = tr_time_msec();
         for (auto const *span = block_spans, *span_end = span + n_spans; span != span_end; ++span)
         {
             auto const [block_begin, block_end] = *span;
@@ -497,6 +501,7 @@ public:
                 }
 
                 request_timeouts_.emplace_back(block, timeout);
+                pipeline_.on_request_sent(block, now_msec);
             }
 
             active_requests.set_span(block_begin, block_end);
@@ -719,6 +724,9 @@ private:
 
     size_t desired_request_count_ = 0;
 
+    // sizes our request queue to the peer's bandwidth-delay product
+    RequestPipeline pipeline_;
+
     uint8_t ut_pex_id_ = 0;
     uint8_t ut_metadata_id_ = 0;
 
@@ -880,15 +888,76 @@ template<typename... Args>
 }
 
 template<typename... Args>
-size_t build_peer_message(MessageWriter& out, uint8_t type, Args const&... args)
+[[nodiscard]] size_t get_message_length(uint8_t type, Args const&... args)
 {
     auto msg_len = sizeof(type);
     ((msg_len += get_param_length(args)), ...);
+    return msg_len;
+}
+
+template<typename... Args>
+void build_peer_message(MessageWriter& out, size_t msg_len, uint8_t type, Args const&... args)
+{
     out.add_uint32(msg_len);
     out.add_uint8(type);
     (add_param(out, args), ...);
+}
 
-    return msg_len;
+// Params that the caller had to serialize into a std::string, e.g. LTEP's bencoded dicts
+template<typename... Args>
+[[nodiscard]] constexpr size_t count_allocated_params() noexcept
+{
+    return (size_t{ std::is_same_v<Args, std::string> } + ... + size_t{});
+}
+
+// Each type of message that we send has its own metrics
+struct MessageCounters
+{
+    tr::metrics::Counter sent;
+    tr::metrics::Counter allocations;
+};
+
+[[nodiscard]] constexpr std::optional<MessageCounters> message_counters(uint8_t type) noexcept
+{
+    using Counter = tr::metrics::Counter;
+
+    switch (type)
+    {
+    case BtPeerMsgs::Bitfield:
+        return MessageCounters{ Counter::PeerMessagesSentBitfield, Counter::PeerMessageAllocationsBitfield };
+    case BtPeerMsgs::Cancel:
+        return MessageCounters{ Counter::PeerMessagesSentCancel, Counter::PeerMessageAllocationsCancel };
+    case BtPeerMsgs::Choke:
+        return MessageCounters{ Counter::PeerMessagesSentChoke, Counter::PeerMessageAllocationsChoke };
+    case BtPeerMsgs::DhtPort:
+        return MessageCounters{ Counter::PeerMessagesSentDhtPort, Counter::PeerMessageAllocationsDhtPort };
+    case BtPeerMsgs::FextAllowedFast:
+        return MessageCounters{ Counter::PeerMessagesSentFextAllowedFast, Counter::PeerMessageAllocationsFextAllowedFast };
+    case BtPeerMsgs::FextHaveAll:
+        return MessageCounters{ Counter::PeerMessagesSentFextHaveAll, Counter::PeerMessageAllocationsFextHaveAll };
+    case BtPeerMsgs::FextHaveNone:
+        return MessageCounters{ Counter::PeerMessagesSentFextHaveNone, Counter::PeerMessageAllocationsFextHaveNone };
+    case BtPeerMsgs::FextReject:
+        return MessageCounters{ Counter::PeerMessagesSentFextReject, Counter::PeerMessageAllocationsFextReject };
+    case BtPeerMsgs::FextSuggest:
+        return MessageCounters{ Counter::PeerMessagesSentFextSuggest, Counter::PeerMessageAllocationsFextSuggest };
+    case BtPeerMsgs::Have:
+        return MessageCounters{ Counter::PeerMessagesSentHave, Counter::PeerMessageAllocationsHave };
+    case BtPeerMsgs::Interested:
+        return MessageCounters{ Counter::PeerMessagesSentInterested, Counter::PeerMessageAllocationsInterested };
+    case BtPeerMsgs::Ltep:
+        return MessageCounters{ Counter::PeerMessagesSentLtep, Counter::PeerMessageAllocationsLtep };
+    case BtPeerMsgs::NotInterested:
+        return MessageCounters{ Counter::PeerMessagesSentNotInterested, Counter::PeerMessageAllocationsNotInterested };
+    case BtPeerMsgs::Piece:
+        return MessageCounters{ Counter::PeerMessagesSentPiece, Counter::PeerMessageAllocationsPiece };
+    case BtPeerMsgs::Request:
+        return MessageCounters{ Counter::PeerMessagesSentRequest, Counter::PeerMessageAllocationsRequest };
+    case BtPeerMsgs::Unchoke:
+        return MessageCounters{ Counter::PeerMessagesSentUnchoke, Counter::PeerMessageAllocationsUnchoke };
+    default:
+        return {};
+    }
 }
 } // namespace protocol_send_message_helpers
 
@@ -899,11 +968,21 @@ size_t tr_peerMsgsImpl::protocol_send_message(uint8_t type, Args const&... args)
 
     logtrace(this, build_log_message(type, args...));
 
-    auto out = MessageBuffer{};
-    [[maybe_unused]] auto const msg_len = build_peer_message(out, type, args...);
+    auto const msg_len = get_message_length(type, args...);
     TR_ASSERT(is_message_length_correct(tor_, type, msg_len));
-    auto const n_bytes_added = std::size(out);
-    io_->write(out, type == BtPeerMsgs::Piece);
+    auto const n_bytes_added = sizeof(uint32_t) + msg_len;
+    auto const did_grow = io_->write_in_place(
+        n_bytes_added,
+        type == BtPeerMsgs::Piece,
+        [&](MessageWriter& out) { build_peer_message(out, msg_len, type, args...); });
+    if (auto const counters = message_counters(type); counters)
+    {
+        tr::metrics::add(counters->sent);
+        if (auto const n_allocs = count_allocated_params<Args...>() + (did_grow ? 1U : 0U); n_allocs != 0U)
+        {
+            tr::metrics::add(counters->allocations, n_allocs);
+        }
+    }
     return n_bytes_added;
 }
 
@@ -931,12 +1010,9 @@ size_t tr_peerMsgsImpl::protocol_send_keepalive() const
 {
     logtrace(this, "sending 'keepalive'");
 
-    auto out = MessageBuffer{};
-    out.add_uint32(0);
-
-    auto const n_bytes_added = std::size(out);
-    io_->write(out, false);
-    return n_bytes_added;
+    static auto constexpr NBytes = sizeof(uint32_t);
+    io_->write_in_place(NBytes, false, [](MessageWriter& out) { out.add_uint32(0); });
+    return NBytes;
 }
 
 // ---
@@ -1471,6 +1547,7 @@ ReadResult tr_peerMsgsImpl::process_peer_message(uint8_t id, MessageReader& payl
     case BtPeerMsgs::Choke:
         logtrace(this, "got Choke");
         set_client_choked(true);
+        pipeline_.on_choked();
 
         if (!fext)
         {
@@ -1681,6 +1758,7 @@ ReadResult tr_peerMsgsImpl::process_peer_message(uint8_t id, MessageReader& payl
                 if (auto const block = tor_.piece_loc(r.index, r.offset).block; active_requests.test(block))
                 {
                     active_requests.unset(block);
+                    pipeline_.on_request_failed(block);
 
                     // Make sure maybe_send_block_requests() is called before removing the request
                     // from the wishlist, so that it will choose a block other than the rejected block.
@@ -1732,8 +1810,11 @@ ReadResult tr_peerMsgsImpl::read_piece_data(MessageReader& payload)
 
     if (tor_.has_block(block))
     {
+        // Not an error: in endgame mode, we ask more than one peer for
+        // the same block and the cancels can cross paths with the data.
         logtrace(this, fmt::format("got completed block {:d} ({:d}:{:d}->{:d})", block, piece, offset, len));
-        return { ReadState::Err, len };
+        publish(tr_peer_event::GotDuplicateData(len));
+        return { ReadState::Now, len };
     }
 
     if (auto const block_loc = tor_.block_loc(block); !tor_.piece_is_wanted(block_loc.piece))
@@ -1800,6 +1881,7 @@ tr_error_code_t tr_peerMsgsImpl::client_got_block(std::span<uint8_t const> block
     }
 
     active_requests.unset(block);
+    pipeline_.on_block_received(block, tr_time_msec());
     publish(tr_peer_event::GotBlock(tor_.block_info(), block));
 
     return 0;
@@ -2001,6 +2083,7 @@ void tr_peerMsgsImpl::check_request_timeout(time_t const now)
         if (now >= timeout)
         {
             // request timed out, discard
+            pipeline_.on_request_failed(block);
             cancel_block_request(block);
             it = request_timeouts_.erase(it);
             continue;
@@ -2189,13 +2272,11 @@ size_t tr_peerMsgsImpl::max_available_reqs() const
         return 0;
     }
 
-    // Get the rate limit we should use.
-    // TODO: this needs to consider all the other peers as well...
-    uint64_t const now = tr_time_msec();
-    auto rate = get_piece_speed(now, tr_direction::PeerToClient);
+    // If we're capped by a speed limit, don't queue more than the limit can drain
+    auto rate_limit = std::optional<uint64_t>{};
     if (tor_.uses_speed_limit(tr_direction::PeerToClient))
     {
-        rate = std::min(rate, tor_.speed_limit(tr_direction::PeerToClient));
+        rate_limit = tor_.speed_limit(tr_direction::PeerToClient).base_quantity();
     }
 
     // honor the session limits, if enabled
@@ -2203,20 +2284,12 @@ size_t tr_peerMsgsImpl::max_available_reqs() const
     {
         if (auto const limit = session->active_speed_limit(tr_direction::PeerToClient))
         {
-            rate = std::min(rate, *limit);
+            rate_limit = std::min(rate_limit.value_or(limit->base_quantity()), limit->base_quantity());
         }
     }
 
-    // use this desired rate to figure out how
-    // many requests we should send to this peer
-    static auto constexpr Floor = size_t{ 32 };
-    static size_t constexpr Seconds = RequestBufSecs;
-    size_t const estimated_blocks_in_period = (rate.base_quantity() * Seconds) / tr_block_info::BlockSize;
-    auto const ceil = peer_reqq_.value_or(PeerReqQDefault);
-
-    // - Don't use std::clamp as `ceil` can be smaller than `Floor`
-    // - Peer-supplied ReqQ should take the highest priority
-    return std::min(ceil, std::max(estimated_blocks_in_period, Floor));
+    // Peer-supplied ReqQ takes the highest priority
+    return std::min(peer_reqq_.value_or(PeerReqQDefault), pipeline_.desired_requests(rate_limit));
 }
 
 } // namespace
@@ -0,0 +1,243 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef LIBTRANSMISSION_PEER_MODULE
+#error only the libtransmission peer module should #include this header.
+#endif
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <optional>
+#include <unordered_map>
+
+#include "libtransmission/block-info.h"
+#include "libtransmission/types.h"
+
+/**
+ * Decides how many block requests to keep outstanding with a peer.
+ *
+ * The goal is to keep the peer's send pipe full without queueing up
+ * more data than it can deliver in a round trip or two. The request
+ * queue is sized to the bandwidth-delay product: the peer's delivery
+ * rate times the shortest request->block latency we've seen.
+ *
+ * Until the delivery rate is known, the window grows each round trip,
+ * like TCP slow start. It stops growing once requests start waiting in
+ * the peer's queue or the rate stops climbing. Rejects and timeouts
+ * shrink the window, and later BDP estimates stay scaled down until
+ * the peer has gone a while without failures. A choke discards the
+ * in-flight samples.
+ */
+class RequestPipeline
+{
+public:
+    // Small enough to not bury a slow peer in requests on the first round trip.
+    // Fast peers get past this quickly since the window grows fast at startup.
+    static auto constexpr InitialWindow = size_t{ 16U };
+
+    // Keep a few requests outstanding so a single slow block doesn't stall us
+    static auto constexpr MinWindow = size_t{ 4U };
+
+    // Request enough to cover this many BDPs, to absorb rate jitter
+    static auto constexpr BdpGain = size_t{ 2U };
+
+    [[nodiscard]] constexpr auto window() const noexcept
+    {
+        return window_;
+    }
+
+    [[nodiscard]] constexpr auto is_ramping_up() const noexcept
+    {
+        return startup_;
+    }
+
+    [[nodiscard]] constexpr std::optional<uint64_t> min_rtt_msec() const noexcept
+    {
+        return min_rtt_msec_;
+    }
+
+    // estimated delivery rate, in bytes per second
+    [[nodiscard]] constexpr auto delivery_rate() const noexcept
+    {
+        return max_rate_;
+    }
+
+    // How many requests we want outstanding.
+    // `rate_limit` is the download speed limit in bytes per second, if any.
+    [[nodiscard]] size_t desired_requests(std::optional<uint64_t> const rate_limit = {}) const noexcept
+    {
+        if (rate_limit && min_rtt_msec_)
+        {
+            return std::min(window_, bdp_window(*rate_limit));
+        }
+
+        return window_;
+    }
+
+    void on_request_sent(tr_block_index_t const block, uint64_t const now_msec)
+    {
+        sent_at_.insert_or_assign(block, now_msec);
+    }
+
+    void on_block_received(tr_block_index_t const block, uint64_t const now_msec)
+    {
+        if (auto const iter = sent_at_.find(block); iter != std::end(sent_at_))
+        {
+            auto const rtt = now_msec >= iter->second ? now_msec - iter->second : 0U;
+            sent_at_.erase(iter);
+
+            if (!min_rtt_msec_)
+            {
+                round_start_msec_ = now_msec;
+                round_start_delivered_ = delivered_;
+            }
+
+            min_rtt_msec_ = std::min(min_rtt_msec_.value_or(rtt), rtt);
+
+            // If requests are taking much longer than the fastest one did,
+            // they're waiting in the peer's queue: we've filled the pipe.
+            if (startup_ && rtt > *min_rtt_msec_ * QueueingFactor)
+            {
+                end_startup();
+            }
+        }
+
+        ++delivered_;
+
+        if (startup_)
+        {
+            window_ += StartupGrowthPerBlock;
+        }
+
+        maybe_end_round(now_msec);
+    }
+
+    // A cancel we sent, e.g. because another peer delivered the block first
+    void on_request_cancelled(tr_block_index_t const block)
+    {
+        sent_at_.erase(block);
+    }
+
+    // The peer rejected the request or it timed out,
+    // so the peer has more queued than it can handle.
+    // Rejects for requests that a choke already discarded don't count.
+    void on_request_failed(tr_block_index_t const block)
+    {
+        if (sent_at_.erase(block) == 0U)
+        {
+            return;
+        }
+
+        startup_ = false;
+        window_ = std::max(MinWindow, window_ * 3U / 4U);
+        backoff_ = std::max(MinBackoff, backoff_ * 3U / 4U);
+        failed_this_round_ = true;
+    }
+
+    void on_choked()
+    {
+        sent_at_.clear();
+
+        // the pipe is empty now, so restart the round timer on the next sample
+        round_start_msec_ = {};
+        round_start_delivered_ = delivered_;
+    }
+
+private:
+    static auto constexpr MinRoundMsec = uint64_t{ 50U };
+
+    // Stop ramping up after this many round trips without a meaningful rate increase
+    static auto constexpr MaxPlateauRounds = 3U;
+
+    // While ramping up, grow the window by this much per block received.
+    // This multiplies the window by (1 + N) each round trip.
+    static auto constexpr StartupGrowthPerBlock = size_t{ 8U };
+
+    // A request->block latency this many times the minimum means queueing
+    static auto constexpr QueueingFactor = uint64_t{ 2U };
+
+    // `backoff_` is a fraction of this. Each failure takes off a quarter,
+    // and each round trip without one gives back BackoffRecovery.
+    static auto constexpr BackoffScale = size_t{ 1024U };
+    static auto constexpr MinBackoff = BackoffScale / 16U;
+    static auto constexpr BackoffRecovery = BackoffScale / 32U;
+
+    void end_startup()
+    {
+        startup_ = false;
+        window_ = std::max(MinWindow, bdp_window(max_rate_) * backoff_ / BackoffScale);
+    }
+
+    [[nodiscard]] constexpr size_t bdp_window(uint64_t const rate) const noexcept
+    {
+        auto const bdp_bytes = rate * min_rtt_msec_.value_or(0U) / 1000U;
+        auto const bdp_blocks = static_cast<size_t>((bdp_bytes + tr_block_info::BlockSize - 1U) / tr_block_info::BlockSize);
+        return std::max(MinWindow, bdp_blocks * BdpGain + 1U);
+    }
+
+    void maybe_end_round(uint64_t const now_msec)
+    {
+        if (!min_rtt_msec_ || round_start_msec_ == 0U)
+        {
+            if (min_rtt_msec_)
+            {
+                round_start_msec_ = now_msec;
+                round_start_delivered_ = delivered_;
+            }
+            return;
+        }
+
+        auto const elapsed = now_msec - round_start_msec_;
+        if (elapsed < std::max(*min_rtt_msec_, MinRoundMsec))
+        {
+            return;
+        }
+
+        auto const n_blocks = delivered_ - round_start_delivered_;
+        auto const rate = n_blocks * tr_block_info::BlockSize * 1000U / elapsed;
+        round_start_msec_ = now_msec;
+        round_start_delivered_ = delivered_;
+
+        if (!failed_this_round_)
+        {
+            backoff_ = std::min(BackoffScale, backoff_ + BackoffRecovery);
+        }
+        failed_this_round_ = false;
+
+        if (startup_)
+        {
+            // still climbing if we got at least 25% more than the best round so far
+            plateau_rounds_ = rate >= max_rate_ + max_rate_ / 4U ? 0U : plateau_rounds_ + 1U;
+        }
+
+        // windowed max that slowly forgets old peaks
+        max_rate_ = std::max(rate, max_rate_ - max_rate_ / 8U);
+
+        if (!startup_ || plateau_rounds_ >= MaxPlateauRounds)
+        {
+            end_startup();
+        }
+    }
+
+    // block -> when we requested it
+    std::unordered_map<tr_block_index_t, uint64_t> sent_at_;
+
+    std::optional<uint64_t> min_rtt_msec_;
+
+    uint64_t max_rate_ = {};
+
+    uint64_t delivered_ = {};
+    uint64_t round_start_msec_ = {};
+    uint64_t round_start_delivered_ = {};
+
+    size_t window_ = InitialWindow;
+    size_t backoff_ = BackoffScale;
+    unsigned int plateau_rounds_ = {};
+    bool failed_this_round_ = false;
+    bool startup_ = true;
+};
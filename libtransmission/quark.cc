@@ -7,7 +7,9 @@
 #include <array>
 #include <cstddef>
 #include <iterator> // for std::distance()
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <string_view>
 #include <vector>
 
@@ -35,6 +37,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "addedDate"sv, // rpc
     "added_date"sv, // .resume, rpc
     "address"sv, // rpc
+    "address_expires_at"sv, // udp tracker cache
     "alt-speed-down"sv, // gtk app, rpc, speed settings
     "alt-speed-enabled"sv, // gtk app, rpc, speed settings
     "alt-speed-time-begin"sv, // rpc, speed settings
@@ -61,7 +64,9 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "anti-brute-force-threshold"sv, // rpc server settings
     "anti_brute_force_enabled"sv, // rpc, rpc server settings
     "anti_brute_force_threshold"sv, // rpc server settings
+    "args"sv, // chrome trace
     "arguments"sv, // json-rpc
+    "authority"sv, // udp tracker cache
     "availability"sv, // rpc
     "bandwidth-priority"sv, // .resume
     "bandwidthPriority"sv, // rpc
@@ -85,12 +90,15 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "blocklist_updates_enabled"sv, // gtk app, qt app
     "blocklist_url"sv, // rpc, tr_session::Settings
     "blocks"sv, // .resume
+    "bucket_bounds"sv, // rpc
+    "buckets"sv, // rpc
     "bytesCompleted"sv, // rpc
     "bytes_completed"sv, // rpc
     "bytes_to_client"sv, // rpc
     "bytes_to_peer"sv, // rpc
     "cache-size-mb"sv, // rpc, tr_session::Settings
     "cache_size_mib"sv, // rpc, tr_session::Settings
+    "cat"sv, // chrome trace
     "clientIsChoked"sv, // rpc
     "clientIsInterested"sv, // rpc
     "clientName"sv, // rpc
@@ -104,10 +112,14 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "complete"sv, // BEP0048; BT protocol
     "config-dir"sv, // rpc
     "config_dir"sv, // rpc
+    "connection_id"sv, // udp tracker cache
+    "connection_id_expires_at"sv, // udp tracker cache
     "cookies"sv, // rpc
     "corrupt"sv, // .resume
     "corruptEver"sv, // rpc
     "corrupt_ever"sv, // rpc
+    "count"sv, // rpc
+    "counters"sv, // rpc
     "created by"sv, // .torrent
     "creation date"sv, // .torrent
     "creator"sv, // rpc
@@ -164,9 +176,12 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "downloading_time_seconds"sv, // .resume
     "dropped"sv, // BEP0011; BT protocol
     "dropped6"sv, // BEP0011; BT protocol
+    "dur"sv, // chrome trace
+    "duration_us"sv, // rpc
     "e"sv, // BT protocol
     "editDate"sv, // rpc
     "edit_date"sv, // rpc
+    "enabled"sv, // rpc
     "encoding"sv, // .torrent
     "encryption"sv, // daemon, rpc, tr_session::Settings
     "end_piece"sv, // rpc
@@ -176,6 +191,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "eta"sv, // rpc
     "etaIdle"sv, // rpc
     "eta_idle"sv, // rpc
+    "events"sv, // rpc
     "fields"sv, // rpc
     "file-count"sv, // rpc
     "fileStats"sv, // rpc
@@ -231,6 +247,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "haveValid"sv, // rpc
     "have_unchecked"sv, // rpc
     "have_valid"sv, // rpc
+    "histograms"sv, // rpc
     "honorsSessionLimits"sv, // rpc
     "honors_session_limits"sv, // rpc
     "host"sv, // rpc
@@ -278,7 +295,9 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "is_uploading_to"sv, // rpc
     "is_utp"sv, // rpc
     "jsonrpc"sv, // json-rpc
+    "kind"sv, // rpc
     "labels"sv, // .resume, rpc
+    "lag_us"sv, // rpc
     "lastAnnouncePeerCount"sv, // rpc
     "lastAnnounceResult"sv, // rpc
     "lastAnnounceStartTime"sv, // rpc
@@ -401,6 +420,8 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "percent_done"sv, // rpc
     "pex-enabled"sv, // rpc, tr_session::Settings
     "pex_enabled"sv, // rpc, tr_session::Settings
+    "ph"sv, // chrome trace
+    "pid"sv, // chrome trace
     "pidfile"sv, // daemon
     "piece"sv, // BT protocol
     "piece length"sv, // .torrent
@@ -467,6 +488,9 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "recently_active"sv, // rpc
     "recheckProgress"sv, // rpc
     "recheck_progress"sv, // rpc
+    "relocation_bytes_done"sv, // rpc
+    "relocation_bytes_total"sv, // rpc
+    "relocation_target"sv, // .resume
     "remote-session-enabled"sv, // qt app
     "remote-session-host"sv, // qt app
     "remote-session-https"sv, // qt app
@@ -507,6 +531,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "rpc_enabled"sv, // daemon, rpc server settings
     "rpc_host_whitelist"sv, // rpc, rpc server settings
     "rpc_host_whitelist_enabled"sv, // rpc, rpc server settings
+    "rpc_metrics_enabled"sv, // daemon, rpc server settings
     "rpc_password"sv, // daemon, rpc server settings
     "rpc_port"sv, // daemon, gtk app, rpc server settings
     "rpc_socket_mode"sv, // rpc server settings
@@ -517,6 +542,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "rpc_version_semver"sv, // rpc
     "rpc_whitelist"sv, // daemon, gtk app, rpc server settings
     "rpc_whitelist_enabled"sv, // daemon, rpc server settings
+    "save"sv, // rpc
     "scrape"sv, // rpc
     "scrape-paused-torrents-enabled"sv, // tr_session::Settings
     "scrapeState"sv, // rpc
@@ -572,8 +598,10 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "session_count"sv, // rpc, stats.json
     "session_get"sv, // rpc
     "session_id"sv, // rpc
+    "session_metrics"sv, // rpc
     "session_set"sv, // rpc
     "session_stats"sv, // rpc
+    "session_trace"sv, // rpc
     "show-backup-trackers"sv, // gtk app, qt app
     "show-extra-peer-details"sv, // gtk app
     "show-filterbar"sv, // gtk app, qt app
@@ -627,12 +655,16 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "start_date"sv, // rpc
     "start_minimized"sv, // qt app
     "start_paused"sv, // daemon
+    "start_us"sv, // rpc
     "status"sv, // rpc
     "statusbar-stats"sv, // gtk app, qt app
     "statusbar_stats"sv, // gtk app, qt app
+    "sum"sv, // rpc
     "tag"sv, // rpc
     "tcp-enabled"sv, // rpc, tr_session::Settings
     "tcp_enabled"sv, // rpc, tr_session::Settings
+    "threshold_ms"sv, // rpc
+    "tid"sv, // chrome trace
     "tier"sv, // rpc
     "time-checked"sv, // .resume
     "time_checked"sv, // .resume
@@ -680,6 +712,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "torrents"sv, // rpc
     "totalSize"sv, // rpc
     "total_size"sv, // BT protocol, rpc
+    "traceEvents"sv, // chrome trace
     "trackerAdd"sv, // rpc
     "trackerList"sv, // rpc
     "trackerRemove"sv, // rpc
@@ -695,6 +728,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "trash-original-torrent-files"sv, // gtk app, rpc, tr_session::Settings
     "trash_can_enabled"sv, // gtk app
     "trash_original_torrent_files"sv, // gtk app, rpc, tr_session::Settings
+    "ts"sv, // chrome trace
     "umask"sv, // tr_session::Settings
     "units"sv, // rpc
     "upload-slots-per-torrent"sv, // tr_session::Settings
@@ -734,6 +768,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "watch_dir"sv, // daemon, gtk app, qt app
     "watch_dir_enabled"sv, // daemon, gtk app, qt app
     "watch_dir_force_generic"sv, // daemon
+    "web_worker_count"sv, // tr_session::Settings
     "webseeds"sv, // rpc
     "webseedsSendingToUs"sv, // rpc
     "webseeds_ex"sv, // rpc
@@ -757,7 +792,21 @@ bool constexpr quarks_are_sorted()
 static_assert(quarks_are_sorted(), "Predefined quarks must be sorted by their string value");
 static_assert(std::size(MyStatic) == TR_N_KEYS);
 
+// Runtime quarks can be added from any thread, e.g. when parsing metainfo
 auto& my_runtime{ *new std::vector<std::string_view>{} };
+auto& my_runtime_mutex{ *new std::shared_mutex{} };
+
+[[nodiscard]] std::optional<tr_quark> lookup_runtime(std::string_view key)
+{
+    auto const rbegin = std::begin(my_runtime);
+    auto const rend = std::end(my_runtime);
+    if (auto const rit = std::find(rbegin, rend, key); rit != rend)
+    {
+        return TR_N_KEYS + std::distance(rbegin, rit);
+    }
+
+    return {};
+}
 
 } // namespace
 
@@ -773,14 +822,8 @@ std::optional<tr_quark> tr_quark_lookup(std::string_view key)
     }
 
     /* was it added during runtime? */
-    auto const rbegin = std::begin(my_runtime);
-    auto const rend = std::end(my_runtime);
-    if (auto const rit = std::find(rbegin, rend, key); rit != rend)
-    {
-        return TR_N_KEYS + std::distance(rbegin, rit);
-    }
-
-    return {};
+    auto const lock = std::shared_lock{ my_runtime_mutex };
+    return lookup_runtime(key);
 }
 
 tr_quark tr_quark_new(std::string_view str)
@@ -791,6 +834,13 @@ tr_quark tr_quark_new(std::string_view str)
         return *prior;
     }
 
+    // check again in case another thread added it in the meantime
+    auto const lock = std::unique_lock{ my_runtime_mutex };
+    if (auto const prior = lookup_runtime(utf8); prior)
+    {
+        return *prior;
+    }
+
     auto const ret = TR_N_KEYS + std::size(my_runtime);
     auto const len = std::size(utf8);
     auto* perma = new char[len + 1];
@@ -802,6 +852,12 @@ tr_quark tr_quark_new(std::string_view str)
 
 std::string_view tr_quark_get_string_view(tr_quark q)
 {
+    if (q < TR_N_KEYS)
+    {
+        return MyStatic[q];
+    }
+
+    auto const lock = std::shared_lock{ my_runtime_mutex };
     TR_ASSERT(q < TR_N_KEYS + std::size(my_runtime));
-    return q < TR_N_KEYS ? MyStatic[q] : my_runtime[q - TR_N_KEYS];
+    return my_runtime[q - TR_N_KEYS];
 }
@@ -46,6 +46,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_added_date_camel_APICOMPAT,
     TR_KEY_added_date, /* rpc, resume file */
     TR_KEY_address, /* rpc */
+    TR_KEY_address_expires_at, /* udp tracker cache */
     TR_KEY_alt_speed_down_kebab_APICOMPAT,
     TR_KEY_alt_speed_enabled_kebab_APICOMPAT,
     TR_KEY_alt_speed_time_begin_kebab_APICOMPAT,
@@ -72,7 +73,9 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_anti_brute_force_threshold_kebab_APICOMPAT,
     TR_KEY_anti_brute_force_enabled, /* rpc, settings */
     TR_KEY_anti_brute_force_threshold, /* rpc, settings */
+    TR_KEY_args,
     TR_KEY_arguments, /* rpc */
+    TR_KEY_authority, /* udp tracker cache */
     TR_KEY_availability, // rpc
     TR_KEY_bandwidth_priority_kebab_APICOMPAT,
     TR_KEY_bandwidth_priority_camel_APICOMPAT,
@@ -96,12 +99,15 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_blocklist_updates_enabled,
     TR_KEY_blocklist_url,
     TR_KEY_blocks,
+    TR_KEY_bucket_bounds,
+    TR_KEY_buckets,
     TR_KEY_bytes_completed_camel_APICOMPAT,
     TR_KEY_bytes_completed,
     TR_KEY_bytes_to_client,
     TR_KEY_bytes_to_peer,
     TR_KEY_cache_size_mb_kebab_APICOMPAT,
     TR_KEY_cache_size_mib,
+    TR_KEY_cat,
     TR_KEY_client_is_choked_camel_APICOMPAT,
     TR_KEY_client_is_interested_camel_APICOMPAT,
     TR_KEY_client_name_camel_APICOMPAT,
@@ -115,10 +121,14 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_complete,
     TR_KEY_config_dir_kebab_APICOMPAT,
     TR_KEY_config_dir,
+    TR_KEY_connection_id, /* udp tracker cache */
+    TR_KEY_connection_id_expires_at, /* udp tracker cache */
     TR_KEY_cookies,
     TR_KEY_corrupt,
     TR_KEY_corrupt_ever_camel_APICOMPAT,
     TR_KEY_corrupt_ever,
+    TR_KEY_count,
+    TR_KEY_counters,
     TR_KEY_created_by,
     TR_KEY_creation_date,
     TR_KEY_creator,
@@ -175,9 +185,12 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_downloading_time_seconds,
     TR_KEY_dropped,
     TR_KEY_dropped6,
+    TR_KEY_dur,
+    TR_KEY_duration_us,
     TR_KEY_e,
     TR_KEY_edit_date_camel_APICOMPAT,
     TR_KEY_edit_date,
+    TR_KEY_enabled,
     TR_KEY_encoding,
     TR_KEY_encryption,
     TR_KEY_end_piece,
@@ -187,6 +200,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_eta,
     TR_KEY_eta_idle_camel_APICOMPAT,
     TR_KEY_eta_idle,
+    TR_KEY_events,
     TR_KEY_fields,
     TR_KEY_file_count_kebab_APICOMPAT,
     TR_KEY_file_stats_camel_APICOMPAT,
@@ -242,6 +256,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_have_valid_camel_APICOMPAT,
     TR_KEY_have_unchecked,
     TR_KEY_have_valid,
+    TR_KEY_histograms,
     TR_KEY_honors_session_limits_camel_APICOMPAT,
     TR_KEY_honors_session_limits,
     TR_KEY_host,
@@ -289,7 +304,9 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_is_uploading_to,
     TR_KEY_is_utp,
     TR_KEY_jsonrpc,
+    TR_KEY_kind,
     TR_KEY_labels,
+    TR_KEY_lag_us,
     TR_KEY_last_announce_peer_count_camel_APICOMPAT,
     TR_KEY_last_announce_result_camel_APICOMPAT,
     TR_KEY_last_announce_start_time_camel_APICOMPAT,
@@ -412,6 +429,8 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_percent_done,
     TR_KEY_pex_enabled_kebab_APICOMPAT,
     TR_KEY_pex_enabled,
+    TR_KEY_ph,
+    TR_KEY_pid,
     TR_KEY_pidfile,
     TR_KEY_piece,
     TR_KEY_piece_length,
@@ -478,6 +497,9 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_recently_active,
     TR_KEY_recheck_progress_camel_APICOMPAT,
     TR_KEY_recheck_progress,
+    TR_KEY_relocation_bytes_done,
+    TR_KEY_relocation_bytes_total,
+    TR_KEY_relocation_target,
     TR_KEY_remote_session_enabled_kebab_APICOMPAT,
     TR_KEY_remote_session_host_kebab_APICOMPAT,
     TR_KEY_remote_session_https_kebab_APICOMPAT,
@@ -518,6 +540,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_rpc_enabled,
     TR_KEY_rpc_host_whitelist,
     TR_KEY_rpc_host_whitelist_enabled,
+    TR_KEY_rpc_metrics_enabled,
     TR_KEY_rpc_password,
     TR_KEY_rpc_port,
     TR_KEY_rpc_socket_mode,
@@ -528,6 +551,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_rpc_version_semver,
     TR_KEY_rpc_whitelist,
     TR_KEY_rpc_whitelist_enabled,
+    TR_KEY_save,
     TR_KEY_scrape,
     TR_KEY_scrape_paused_torrents_enabled_kebab_APICOMPAT,
     TR_KEY_scrape_state_camel_APICOMPAT,
@@ -583,8 +607,10 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_session_count,
     TR_KEY_session_get,
     TR_KEY_session_id,
+    TR_KEY_session_metrics,
     TR_KEY_session_set,
     TR_KEY_session_stats,
+    TR_KEY_session_trace,
     TR_KEY_show_backup_trackers_kebab_APICOMPAT,
     TR_KEY_show_extra_peer_details_kebab_APICOMPAT,
     TR_KEY_show_filterbar_kebab_APICOMPAT,
@@ -638,12 +664,16 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_start_date,
     TR_KEY_start_minimized,
     TR_KEY_start_paused,
+    TR_KEY_start_us,
     TR_KEY_status,
     TR_KEY_statusbar_stats_kebab_APICOMPAT,
     TR_KEY_statusbar_stats,
+    TR_KEY_sum,
     TR_KEY_tag,
     TR_KEY_tcp_enabled_kebab_APICOMPAT,
     TR_KEY_tcp_enabled,
+    TR_KEY_threshold_ms,
+    TR_KEY_tid,
     TR_KEY_tier,
     TR_KEY_time_checked_kebab_APICOMPAT,
     TR_KEY_time_checked,
@@ -691,6 +721,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_torrents,
     TR_KEY_total_size_camel_APICOMPAT,
     TR_KEY_total_size,
+    TR_KEY_trace_events_camel,
     TR_KEY_tracker_add_camel_APICOMPAT,
     TR_KEY_tracker_list_camel_APICOMPAT,
     TR_KEY_tracker_remove_camel_APICOMPAT,
@@ -706,6 +737,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_trash_original_torrent_files_kebab_APICOMPAT,
     TR_KEY_trash_can_enabled,
     TR_KEY_trash_original_torrent_files,
+    TR_KEY_ts,
     TR_KEY_umask,
     TR_KEY_units,
     TR_KEY_upload_slots_per_torrent_kebab_APICOMPAT,
@@ -745,6 +777,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_watch_dir,
     TR_KEY_watch_dir_enabled,
     TR_KEY_watch_dir_force_generic,
+    TR_KEY_web_worker_count,
     TR_KEY_webseeds,
     TR_KEY_webseeds_sending_to_us_camel_APICOMPAT,
     TR_KEY_webseeds_ex,
@@ -0,0 +1,275 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstdint> // uint64_t
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string_view>
+#include <thread>
+#include <utility> // for std::move()
+
+#include <fmt/format.h>
+
+#include "libtransmission/error.h"
+#include "libtransmission/file.h"
+#include "libtransmission/log.h"
+#include "libtransmission/relocate.h"
+#include "libtransmission/tr-strbuf.h"
+#include "libtransmission/utils.h" // for _()
+
+using namespace std::literals;
+
+namespace
+{
+// Renaming only works within a filesystem,
+// so try to rename a scratch file from one directory to the other.
+[[nodiscard]] bool is_same_filesystem(std::string_view const old_parent, std::string_view const new_parent)
+{
+    auto probe = tr_pathbuf{ new_parent, "/.trmove-XXXXXX"sv };
+    auto const fd = tr_sys_file_open_temp(std::data(probe));
+    if (fd == TR_BAD_SYS_FILE)
+    {
+        return false;
+    }
+    tr_sys_file_close(fd);
+
+    if (auto const moved = tr_pathbuf{ old_parent, '/', tr_sys_path_basename(probe) }; tr_sys_path_rename(probe, moved))
+    {
+        tr_sys_path_remove(moved);
+        return true;
+    }
+
+    tr_sys_path_remove(probe);
+    return false;
+}
+
+// Remove `filename`, then any directories that it leaves empty below `top`.
+// If the file was renamed instead of copied, only the directories are left.
+void remove_file_and_empty_parents(std::string_view const filename, std::string_view const top)
+{
+    if (auto error = tr_error{}; tr_sys_path_exists(filename) && !tr_sys_path_remove(filename, &error))
+    {
+        tr_logAddWarn(
+            fmt::format(
+                fmt::runtime(_("Couldn't remove '{path}': {error} ({error_code})")),
+                fmt::arg("path", filename),
+                fmt::arg("error", error.message()),
+                fmt::arg("error_code", error.code())));
+        return;
+    }
+
+    // removing a directory fails if it isn't empty
+    for (auto dir = tr_sys_path_dirname(filename); std::size(dir) > std::size(top) && dir.starts_with(top);
+         dir = tr_sys_path_dirname(dir))
+    {
+        if (!tr_sys_path_remove(dir))
+        {
+            break;
+        }
+    }
+}
+
+void remove_temp_copies(tr_relocate_worker::Job const& job)
+{
+    for (auto const& file : job.files)
+    {
+        if (auto const temp = tr_pathbuf{ file.new_path, tr_relocate_worker::TempSuffix }; tr_sys_path_exists(temp))
+        {
+            remove_file_and_empty_parents(temp, job.new_parent);
+        }
+    }
+}
+} // namespace
+
+void tr_relocate_worker::copy_files(Node& node)
+{
+    auto& job = node.job_;
+    auto error = tr_error{};
+
+    if (!tr_sys_dir_create(job.new_parent, TR_SYS_DIR_CREATE_PARENTS, 0777, &error))
+    {
+        node.mediator_->on_copied(std::move(job), error);
+        return;
+    }
+
+    job.same_filesystem = !always_copy_ && is_same_filesystem(job.old_parent, job.new_parent);
+    if (job.same_filesystem)
+    {
+        tr_logAddTrace(fmt::format("'{}' and '{}' are on the same filesystem", job.old_parent, job.new_parent));
+        node.mediator_->on_copied(std::move(job), error);
+        return;
+    }
+
+    auto bytes_total = uint64_t{};
+    for (auto& file : job.files)
+    {
+        if (auto const info = tr_sys_path_get_info(file.old_path); info)
+        {
+            file.size = info->size;
+            file.mtime = info->last_modified_at;
+            bytes_total += file.size;
+        }
+    }
+
+    auto bytes_done = uint64_t{};
+    node.mediator_->on_progress(bytes_done, bytes_total);
+
+    for (auto& file : job.files)
+    {
+        auto const info = tr_sys_path_get_info(file.old_path, 0, &error);
+        if (!info)
+        {
+            break;
+        }
+        file.size = info->size;
+        file.mtime = info->last_modified_at;
+
+        // The temp copy might be left over from before a restart.
+        // Keep it if it's complete and the source hasn't changed since.
+        auto const temp = tr_pathbuf{ file.new_path, TempSuffix };
+        if (auto const temp_info = tr_sys_path_get_info(temp);
+            temp_info && temp_info->size == file.size && temp_info->last_modified_at >= file.mtime)
+        {
+            tr_logAddTrace(fmt::format("Reusing '{}'", temp));
+        }
+        else
+        {
+            tr_sys_path_remove(temp);
+
+            auto const on_progress = [this, &node, bytes_done, bytes_total](uint64_t const bytes_copied)
+            {
+                node.mediator_->on_progress(bytes_done + bytes_copied, bytes_total);
+                return !cancel_current_;
+            };
+
+            if (!tr_sys_dir_create(tr_sys_path_dirname(temp), TR_SYS_DIR_CREATE_PARENTS, 0777, &error) ||
+                !tr_sys_path_copy(file.old_path, temp, &error, on_progress))
+            {
+                break;
+            }
+        }
+
+        bytes_done += file.size;
+        node.mediator_->on_progress(bytes_done, bytes_total);
+
+        if (cancel_current_)
+        {
+            break;
+        }
+    }
+
+    if (cancel_current_)
+    {
+        // Keep the copies if we're shutting down, so that the move can pick up
+        // where it left off. Otherwise the move was cancelled; clean up.
+        if (!stopping_)
+        {
+            remove_temp_copies(job);
+        }
+        return;
+    }
+
+    if (error)
+    {
+        remove_temp_copies(job);
+    }
+
+    node.mediator_->on_copied(std::move(job), error);
+}
+
+void tr_relocate_worker::thread_func()
+{
+    for (;;)
+    {
+        {
+            auto lock = std::unique_lock{ mutex_ };
+            current_.reset();
+            current_done_cv_.notify_all();
+
+            todo_cv_.wait(lock, [this]() { return stopping_ || !std::empty(todo_); });
+            if (std::empty(todo_))
+            {
+                return;
+            }
+
+            current_ = std::move(todo_.front());
+            todo_.pop_front();
+            cancel_current_ = false;
+        }
+
+        if (current_->mediator_)
+        {
+            copy_files(*current_);
+        }
+        else
+        {
+            for (auto const& file : current_->job_.files)
+            {
+                remove_file_and_empty_parents(file.old_path, current_->job_.old_parent);
+            }
+        }
+    }
+}
+
+void tr_relocate_worker::enqueue(Node&& node)
+{
+    auto const lock = std::scoped_lock{ mutex_ };
+
+    todo_.emplace_back(std::move(node));
+    todo_cv_.notify_one();
+
+    if (!thread_.joinable())
+    {
+        thread_ = std::thread{ &tr_relocate_worker::thread_func, this };
+    }
+}
+
+void tr_relocate_worker::add(std::unique_ptr<Mediator> mediator, Job job)
+{
+    enqueue(Node{ std::move(mediator), std::move(job) });
+}
+
+void tr_relocate_worker::remove_old_files(Job job)
+{
+    enqueue(Node{ nullptr, std::move(job) });
+}
+
+void tr_relocate_worker::remove(tr_sha1_digest_t const& info_hash)
+{
+    auto lock = std::unique_lock{ mutex_ };
+
+    if (current_ && current_->matches(info_hash))
+    {
+        cancel_current_ = true;
+        current_done_cv_.wait(lock, [this, &info_hash]() { return !current_ || !current_->matches(info_hash); });
+    }
+    else if (auto const iter = std::ranges::find_if(todo_, [&info_hash](auto const& node) { return node.matches(info_hash); });
+             iter != std::ranges::end(todo_))
+    {
+        remove_temp_copies(iter->job_);
+        todo_.erase(iter);
+    }
+}
+
+tr_relocate_worker::~tr_relocate_worker()
+{
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+        stopping_ = true;
+        cancel_current_ = true;
+
+        // Pending moves will be restarted when the session is,
+        // but finish deleting the originals of moves that already cut over.
+        std::erase_if(todo_, [](auto const& node) { return node.mediator_ != nullptr; });
+        todo_cv_.notify_one();
+    }
+
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
@@ -0,0 +1,135 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "libtransmission/env.h"
+#include "libtransmission/error.h"
+#include "libtransmission/types.h"
+
+/**
+ * Moves torrents' files to a new location on a background thread,
+ * so that copying between filesystems doesn't stall the session.
+ *
+ * Each file is copied next to its destination under a temporary name
+ * while the torrent keeps using the original. When all the copies are
+ * done, the mediator cuts over by renaming them into place. If the old
+ * and new locations are on the same filesystem, nothing gets copied and
+ * the cut-over just renames the originals.
+ *
+ * Copies that finished before an interruption, e.g. a restart, are kept
+ * and reused when the move is started again.
+ */
+class tr_relocate_worker
+{
+public:
+    static auto constexpr TempSuffix = std::string_view{ ".trmove" };
+
+    struct File
+    {
+        std::string old_path;
+        std::string new_path;
+
+        // The source's size and mtime when it was copied,
+        // so that the cut-over can tell if it changed afterwards
+        uint64_t size = {};
+        time_t mtime = {};
+    };
+
+    struct Job
+    {
+        std::vector<File> files;
+        std::string old_parent;
+        std::string new_parent;
+        bool same_filesystem = false;
+    };
+
+    class Mediator
+    {
+    public:
+        virtual ~Mediator() = default;
+
+        [[nodiscard]] virtual tr_sha1_digest_t const& info_hash() const = 0;
+
+        // Called from the worker thread as the copy makes progress
+        virtual void on_progress(uint64_t bytes_done, uint64_t bytes_total) = 0;
+
+        // Called from the worker thread when the files are ready to be
+        // cut over, or with `error` set if the copy failed.
+        // Not called if the move was cancelled.
+        virtual void on_copied(Job job, tr_error const& error) = 0;
+    };
+
+    tr_relocate_worker() = default;
+    ~tr_relocate_worker();
+
+    tr_relocate_worker(tr_relocate_worker const&) = delete;
+    tr_relocate_worker(tr_relocate_worker&&) = delete;
+    tr_relocate_worker& operator=(tr_relocate_worker const&) = delete;
+    tr_relocate_worker& operator=(tr_relocate_worker&&) = delete;
+
+    void add(std::unique_ptr<Mediator> mediator, Job job);
+
+    // Cancel a torrent's move and delete its partial copies.
+    // If the move is in progress, this waits for the worker to stop it.
+    void remove(tr_sha1_digest_t const& info_hash);
+
+    // Delete the originals of a job that was cut over
+    void remove_old_files(Job job);
+
+private:
+    struct Node
+    {
+        [[nodiscard]] bool matches(tr_sha1_digest_t const& info_hash) const noexcept
+        {
+            return mediator_ && mediator_->info_hash() == info_hash;
+        }
+
+        // nullptr for jobs that delete old files
+        std::unique_ptr<Mediator> mediator_;
+        Job job_;
+    };
+
+    void copy_files(Node& node);
+
+    void thread_func();
+
+    void enqueue(Node&& node);
+
+    std::mutex mutex_;
+    std::condition_variable todo_cv_;
+    std::condition_variable current_done_cv_;
+
+    std::deque<Node> todo_;
+    std::optional<Node> current_;
+
+    // set to abort `current_`'s copy
+    std::atomic<bool> cancel_current_ = false;
+
+    // set when the session is shutting down
+    std::atomic<bool> stopping_ = false;
+
+    // copy even when a rename would do, to test the copying on a single filesystem
+    bool const always_copy_ = tr_env_key_exists("TR_RELOCATE_ALWAYS_COPY");
+
+    std::thread thread_;
+};
@@ -792,6 +792,15 @@ tr_resume::fields_t load_from_file(tr_torrent* tor, tr_torrent::ResumeHelper& he
         }
     }
 
+    if ((fields_to_load & tr_resume::Relocation) != 0)
+    {
+        if (auto sv = map.value_if<std::string_view>(TR_KEY_relocation_target); sv && !std::empty(*sv))
+        {
+            helper.load_relocation_target(*sv);
+            fields_loaded |= tr_resume::Relocation;
+        }
+    }
+
     if ((fields_to_load & tr_resume::Peers) != 0)
     {
         fields_loaded |= load_peers(map, tor);
@@ -976,6 +985,12 @@ void save(tr_torrent* const tor, tr_torrent::ResumeHelper const& helper)
     map.try_emplace(TR_KEY_paused, !helper.start_when_stable());
     map.try_emplace(TR_KEY_sequential_download, tor->is_sequential_download());
     map.try_emplace(TR_KEY_sequential_download_from_piece, tor->sequential_download_from_piece());
+
+    if (auto const target = helper.relocation_target(); target)
+    {
+        map.try_emplace(TR_KEY_relocation_target, tr_variant::unmanaged_string(*target));
+    }
+
     save_peers(map, tor);
 
     if (tor->has_metainfo())
@@ -38,6 +38,7 @@
 #include "libtransmission/error.h"
 #include "libtransmission/file-utils.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/platform.h" /* tr_getWebClientDir() */
 #include "libtransmission/quark.h"
@@ -372,12 +373,16 @@ void handle_web_client(struct evhttp_request* req, tr_rpc_server const* server)
 
 void handle_rpc_from_json(struct evhttp_request* req, tr_rpc_server* server, std::string_view json)
 {
+    tr::metrics::add(tr::metrics::Counter::RpcRequests);
+
     tr_rpc_request_exec(
         server->session,
         json,
         // NOLINTNEXTLINE(cppcoreguidelines-rvalue-reference-param-not-moved)
-        [req, server](tr_variant&& content)
+        [req, server, begin = std::chrono::steady_clock::now()](tr_variant&& content)
         {
+            tr::metrics::observe(tr::metrics::Histogram::RpcRequestTime, std::chrono::steady_clock::now() - begin);
+
             if (!content.has_value())
             {
                 evhttp_send_reply(req, HTTP_NOCONTENT, "OK", nullptr);
@@ -392,6 +397,21 @@ void handle_rpc_from_json(struct evhttp_request* req, tr_rpc_server* server, std
         });
 }
 
+void handle_metrics(struct evhttp_request* req, tr_rpc_server const* server)
+{
+    if (auto const cmd = evhttp_request_get_command(req); cmd != EVHTTP_REQ_GET)
+    {
+        send_simple_response(req, HTTP_BADMETHOD);
+        return;
+    }
+
+    auto* const output_headers = evhttp_request_get_output_headers(req);
+    auto* const response = make_response(req, server, tr::metrics::to_prometheus(tr::metrics::snapshot()));
+    evhttp_add_header(output_headers, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    evhttp_send_reply(req, HTTP_OK, "OK", response);
+    evbuffer_free(response);
+}
+
 void handle_rpc(struct evhttp_request* req, tr_rpc_server* server)
 {
     if (auto const cmd = evhttp_request_get_command(req); cmd == EVHTTP_REQ_POST)
@@ -597,6 +617,7 @@ void handle_request(struct evhttp_request* req, void* arg)
     auto const& base_path = server->url();
     auto const web_base_path = tr_urlbuf{ base_path, TrHttpServerWebRelativePath };
     auto const rpc_base_path = tr_urlbuf{ base_path, TrHttpServerRpcRelativePath };
+    auto const metrics_path = tr_urlbuf{ base_path, TrHttpServerMetricsRelativePath };
     auto const deprecated_web_path = tr_urlbuf{ base_path, "web" /*no trailing slash*/ };
 
     auto const uri = std::string_view{ evhttp_request_get_uri(req) };
@@ -627,6 +648,11 @@ void handle_request(struct evhttp_request* req, void* arg)
             fmt::format(fmt::runtime(_("Rejected request from {host} (Host not whitelisted)")), fmt::arg("host", remote_host)));
         send_simple_response(req, 421, Body);
     }
+    else if (server->settings().is_metrics_enabled && uri == metrics_path.sv())
+    {
+        // read-only, so no session id needed. This lets Prometheus scrape it.
+        handle_metrics(req, server);
+    }
     else if (
         !uri.starts_with(rpc_base_path.sv()) ||
         (uri.size() != rpc_base_path.size() && uri.substr(rpc_base_path.size()) != "/"sv))
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <array>
 #include <cerrno>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <filesystem>
@@ -34,6 +35,7 @@
 #include "libtransmission/file-utils.h"
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-mgr.h"
 #include "libtransmission/api-compat.h"
@@ -45,6 +47,7 @@
 #include "libtransmission/torrent.h"
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/tr-strbuf.h"
+#include "libtransmission/tracer.h"
 #include "libtransmission/types.h"
 #include "libtransmission/utils.h"
 #include "libtransmission/values.h"
@@ -764,6 +767,8 @@ namespace make_torrent_field_helpers
     case TR_KEY_rate_download:
     case TR_KEY_rate_upload:
     case TR_KEY_recheck_progress:
+    case TR_KEY_relocation_bytes_done:
+    case TR_KEY_relocation_bytes_total:
     case TR_KEY_seconds_downloading:
     case TR_KEY_seconds_seeding:
     case TR_KEY_seed_idle_limit:
@@ -916,6 +921,10 @@ namespace make_torrent_field_helpers
         return st.piece_upload_speed.base_quantity();
     case TR_KEY_recheck_progress:
         return st.recheck_progress;
+    case TR_KEY_relocation_bytes_done:
+        return st.relocation_bytes_done;
+    case TR_KEY_relocation_bytes_total:
+        return st.relocation_bytes_total;
     case TR_KEY_seconds_downloading:
         return st.seconds_downloading;
     case TR_KEY_seconds_seeding:
@@ -1653,12 +1662,13 @@ void onBlocklistFetched(tr_web::FetchResponse const& web_response)
 
 void blocklistUpdate(tr_session* session, tr_variant::Map const& /*args_in*/, struct tr_rpc_idle_data* idle_data)
 {
-    session->fetch(
-        {
-            session->blocklistUrl(),
-            [](tr_web::FetchResponse const& r) { onBlocklistFetched(r); },
-            idle_data,
-        });
+    auto options = tr_web::FetchOptions{
+        session->blocklistUrl(),
+        [](tr_web::FetchResponse const& r) { onBlocklistFetched(r); },
+        idle_data,
+    };
+    options.priority = tr_web::FetchOptions::Priority::Bulk;
+    session->fetch(std::move(options));
 }
 
 // ---
@@ -2036,6 +2046,133 @@ void add_strings_from_var(std::set<std::string_view>& strings, tr_variant const&
     return { JsonRpc::Error::SUCCESS, std::string{} };
 }
 
+[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> sessionMetrics(
+    tr_session* /*session*/,
+    tr_variant::Map const& /*args_in*/,
+    tr_variant::Map& args_out)
+{
+    using namespace tr::metrics;
+
+    static auto constexpr ToSeconds = [](std::chrono::microseconds const usec)
+    {
+        return std::chrono::duration<double>{ usec }.count();
+    };
+
+    auto const snap = snapshot();
+
+    auto bucket_bounds = tr_variant::Vector{};
+    bucket_bounds.reserve(std::size(BucketBounds));
+    for (auto const bound : BucketBounds)
+    {
+        bucket_bounds.emplace_back(ToSeconds(bound));
+    }
+
+    auto counters = tr_variant::Map{ CounterCount };
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        auto const counter = static_cast<Counter>(i);
+        counters.try_emplace(tr_quark_new(name(counter)), snap[counter]);
+    }
+
+    auto histograms = tr_variant::Map{ HistogramCount };
+    for (size_t i = 0; i < HistogramCount; ++i)
+    {
+        auto const histogram = static_cast<Histogram>(i);
+        auto const& values = snap[histogram];
+
+        auto buckets = tr_variant::Vector{};
+        buckets.reserve(std::size(values.buckets));
+        for (auto const n : values.buckets)
+        {
+            buckets.emplace_back(n);
+        }
+
+        auto histogram_map = tr_variant::Map{ 3U };
+        histogram_map.try_emplace(TR_KEY_buckets, std::move(buckets));
+        histogram_map.try_emplace(TR_KEY_count, values.count);
+        histogram_map.try_emplace(TR_KEY_sum, ToSeconds(values.sum));
+        histograms.try_emplace(tr_quark_new(name(histogram)), std::move(histogram_map));
+    }
+
+    args_out.reserve(std::size(args_out) + 3U);
+    args_out.try_emplace(TR_KEY_bucket_bounds, std::move(bucket_bounds));
+    args_out.try_emplace(TR_KEY_counters, std::move(counters));
+    args_out.try_emplace(TR_KEY_histograms, std::move(histograms));
+
+    return { JsonRpc::Error::SUCCESS, std::string{} };
+}
+
+[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> sessionTrace(
+    tr_session* session,
+    tr_variant::Map const& args_in,
+    tr_variant::Map& args_out)
+{
+    using namespace JsonRpc;
+    using namespace tr::tracer;
+
+    if (auto const val = args_in.value_if<int64_t>(TR_KEY_threshold_ms); val)
+    {
+        if (*val < 0)
+        {
+            return { Error::INVALID_PARAMS, "threshold_ms must not be negative"s };
+        }
+
+        // larger values would overflow when converted to microseconds
+        static auto constexpr MaxThresholdMsec = int64_t{ 60000 };
+        set_threshold(std::chrono::milliseconds{ std::min(*val, MaxThresholdMsec) });
+    }
+
+    if (auto const val = args_in.value_if<bool>(TR_KEY_enabled); val)
+    {
+        set_enabled(*val);
+    }
+
+    auto const events = tr::tracer::events();
+
+    // Always the same file, so that a client can't pick what gets overwritten
+    auto const filename = tr_pathbuf{ session->configDir(), "/trace.json"sv };
+    auto const save = args_in.value_if<bool>(TR_KEY_save).value_or(false);
+    if (save)
+    {
+        auto const content = tr_variant_serde::json().compact().to_string(to_chrome_trace(events));
+        if (auto error = tr_error{}; !tr_file_save(filename, content, &error))
+        {
+            return { Error::SYSTEM_ERROR,
+                     fmt::format(
+                         fmt::runtime(_("Couldn't save '{path}': {error} ({error_code})")),
+                         fmt::arg("path", filename),
+                         fmt::arg("error", error.message()),
+                         fmt::arg("error_code", error.code())) };
+        }
+    }
+
+    auto events_vec = tr_variant::Vector{};
+    events_vec.reserve(std::size(events));
+    for (auto const& event : events)
+    {
+        auto event_map = tr_variant::Map{ 5U };
+        event_map.try_emplace(TR_KEY_kind, tr_variant::unmanaged_string(kind_name(event.kind)));
+        event_map.try_emplace(TR_KEY_name, event.name);
+        event_map.try_emplace(
+            TR_KEY_start_us,
+            std::chrono::duration_cast<std::chrono::microseconds>(event.begin.time_since_epoch()).count());
+        event_map.try_emplace(TR_KEY_duration_us, event.duration.count());
+        event_map.try_emplace(TR_KEY_lag_us, event.lag.count());
+        events_vec.emplace_back(std::move(event_map));
+    }
+
+    args_out.reserve(std::size(args_out) + 4U);
+    if (save)
+    {
+        args_out.try_emplace(TR_KEY_filename, filename.sv());
+    }
+    args_out.try_emplace(TR_KEY_enabled, is_enabled());
+    args_out.try_emplace(TR_KEY_threshold_ms, std::chrono::duration_cast<std::chrono::milliseconds>(threshold()).count());
+    args_out.try_emplace(TR_KEY_events, std::move(events_vec));
+
+    return { Error::SUCCESS, std::string{} };
+}
+
 [[nodiscard]] auto values_get_units()
 {
     using namespace tr::Values;
@@ -2804,7 +2941,7 @@ using SessionAccessors = std::pair<SessionGetter, SessionSetter>;
 
 using SyncHandler = std::pair<JsonRpc::Error::Code, std::string> (*)(tr_session*, tr_variant::Map const&, tr_variant::Map&);
 
-auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler, bool /*has_side_effects*/>, 20U>{ {
+auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler, bool /*has_side_effects*/>, 22U>{ {
     { TR_KEY_free_space, { freeSpace, false } },
     { TR_KEY_group_get, { groupGet, false } },
     { TR_KEY_group_set, { groupSet, true } },
@@ -2814,8 +2951,10 @@ auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler,
     { TR_KEY_queue_move_up, { queueMoveUp, true } },
     { TR_KEY_session_close, { sessionClose, true } },
     { TR_KEY_session_get, { sessionGet, false } },
+    { TR_KEY_session_metrics, { sessionMetrics, false } },
     { TR_KEY_session_set, { sessionSet, true } },
     { TR_KEY_session_stats, { sessionStats, false } },
+    { TR_KEY_session_trace, { sessionTrace, true } },
     { TR_KEY_torrent_get, { torrentGet, false } },
     { TR_KEY_torrent_reannounce, { torrentReannounce, true } },
     { TR_KEY_torrent_remove, { torrentRemove, true } },
@@ -2925,6 +3064,7 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
             return;
         }
 
+        auto const span = tr::tracer::Span{ tr::tracer::Kind::Rpc, method_name };
         func(session, *params, data);
         return;
     }
@@ -2938,6 +3078,7 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
             return;
         }
 
+        auto const span = tr::tracer::Span{ tr::tracer::Kind::Rpc, method_name };
         auto const [err, errmsg] = func(session, *params, data->args_out);
         tr_rpc_idle_done(data, err, errmsg);
         return;
@@ -117,6 +117,7 @@ public:
     size_t speed_limit_down = 100U;
     size_t speed_limit_up = 100U;
     size_t upload_slots_per_torrent = 8U;
+    size_t web_worker_count = 2U;
     small::max_size_vector<tr_preferred_transport, PreferredTransportCount> preferred_transports = {
         tr_preferred_transport::UTP,
         tr_preferred_transport::TCP,
@@ -217,7 +218,8 @@ public:
         Field<&SessionSettings::should_delete_source_torrents>{ TR_KEY_trash_original_torrent_files },
         Field<&SessionSettings::umask>{ TR_KEY_umask },
         Field<&SessionSettings::upload_slots_per_torrent>{ TR_KEY_upload_slots_per_torrent },
-        Field<&SessionSettings::utp_enabled>{ TR_KEY_utp_enabled });
+        Field<&SessionSettings::utp_enabled>{ TR_KEY_utp_enabled },
+        Field<&SessionSettings::web_worker_count>{ TR_KEY_web_worker_count });
 };
 
 struct SessionAltSpeedSettings final
@@ -297,6 +299,7 @@ public:
     bool is_anti_brute_force_enabled = false;
     bool is_enabled = false;
     bool is_host_whitelist_enabled = true;
+    bool is_metrics_enabled = false;
     bool is_whitelist_enabled = true;
     size_t anti_brute_force_limit = 100U;
     std::string bind_address_str = "0.0.0.0";
@@ -321,6 +324,7 @@ public:
         Field<&RpcServerSettings::is_enabled>{ TR_KEY_rpc_enabled },
         Field<&RpcServerSettings::host_whitelist_str>{ TR_KEY_rpc_host_whitelist },
         Field<&RpcServerSettings::is_host_whitelist_enabled>{ TR_KEY_rpc_host_whitelist_enabled },
+        Field<&RpcServerSettings::is_metrics_enabled>{ TR_KEY_rpc_metrics_enabled },
         Field<&RpcServerSettings::port>{ TR_KEY_rpc_port },
         Field<&RpcServerSettings::salted_password>{ TR_KEY_rpc_password },
         Field<&RpcServerSettings::socket_mode>{ TR_KEY_rpc_socket_mode },
@@ -3,15 +3,19 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm> // for std::max()
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef> // for size_t
+#include <cstdint> // for intptr_t, int64_t, uint64_t
 #include <functional>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <string_view>
 #include <thread>
 #include <utility> // for std::move(), std::swap()
+#include <vector>
 
 #include <csignal>
 
@@ -22,8 +26,10 @@
 #include <event2/event.h>
 #include <event2/thread.h>
 
+#include "libtransmission/metrics.h"
 #include "libtransmission/session-thread.h"
 #include "libtransmission/tr-assert.h"
+#include "libtransmission/tracer.h"
 #include "libtransmission/utils-ev.h"
 
 using namespace std::literals;
@@ -154,10 +160,24 @@ void tr_session_thread::tr_evthread_init()
     std::call_once(evthread_flag, init_evthreads_once);
 }
 
+namespace
+{
+// What tr_session_thread_impl calls after a producer claims a slot in the ring.
+// Only tests do anything there, so the default compiles away to nothing.
+struct NoSlotHook
+{
+    constexpr void operator()() const noexcept
+    {
+    }
+};
+} // namespace
+
+template<typename SlotHook = NoSlotHook>
 class tr_session_thread_impl final : public tr_session_thread
 {
 public:
-    explicit tr_session_thread_impl()
+    explicit tr_session_thread_impl(SlotHook on_slot_claimed = {})
+        : on_slot_claimed_{ std::move(on_slot_claimed) }
     {
         auto lock = std::unique_lock(is_looping_mutex_);
 
@@ -202,16 +222,27 @@ public:
         return thread_id_ == std::this_thread::get_id();
     }
 
-    void queue(callback_t&& func) override
+    void queue_named(callback_t&& func, std::string_view const name) override
     {
-        work_queue_mutex_.lock();
-        work_queue_.emplace_back(std::move(func));
-        work_queue_mutex_.unlock();
+        auto const now = std::chrono::steady_clock::now();
+
+        // Once anything has spilled into the overflow list, keep using it
+        // until the session thread drains it so that tasks stay in order.
+        if (overflowed_.load(std::memory_order_acquire) || !work_ring_.try_push(func, name, now, on_slot_claimed_))
+        {
+            auto const lock = std::lock_guard{ overflow_mutex_ };
+            overflow_.emplace_back(std::move(func), name, now);
+            overflowed_.store(true, std::memory_order_release);
+        }
 
-        event_active(work_queue_event_.get(), 0, {});
+        // only wake the session thread if it doesn't already have a wakeup pending
+        if (!wakeup_pending_.exchange(true))
+        {
+            event_active(work_queue_event_.get(), 0, {});
+        }
     }
 
-    void run(callback_t&& func) override
+    void run_named(callback_t&& func, std::string_view const name) override
     {
         if (am_in_session_thread())
         {
@@ -219,12 +250,41 @@ public:
         }
         else
         {
-            queue(std::move(func));
+            queue_named(std::move(func), name);
         }
     }
 
+    [[nodiscard]] QueueStats queue_stats() const noexcept override
+    {
+        auto stats = QueueStats{};
+        stats.n_tasks = n_tasks_.load(std::memory_order_relaxed);
+        stats.max_depth = max_depth_.load(std::memory_order_relaxed);
+        stats.max_latency = std::chrono::microseconds{ max_latency_us_.load(std::memory_order_relaxed) };
+        stats.total_latency = std::chrono::microseconds{ total_latency_us_.load(std::memory_order_relaxed) };
+        return stats;
+    }
+
 private:
-    using work_queue_t = std::list<callback_t>;
+    struct Task
+    {
+        Task() = default;
+
+        Task(callback_t&& func_in, std::string_view name_in, std::chrono::steady_clock::time_point queued_at_in)
+            : func{ std::move(func_in) }
+            , name{ name_in }
+            , queued_at{ queued_at_in }
+        {
+        }
+
+        callback_t func;
+        std::string_view name;
+        std::chrono::steady_clock::time_point queued_at;
+    };
+
+    using work_queue_t = std::vector<Task>;
+
+    // Upper bound on how many tasks to run before yielding to other events
+    static constexpr size_t MaxTasksPerWakeup = 1024U;
 
     void session_thread_func(struct event_base* evbase)
     {
@@ -264,21 +324,179 @@ private:
     {
         static_cast<tr_session_thread_impl*>(vself)->on_work_available();
     }
+
     void on_work_available()
     {
         TR_ASSERT(am_in_session_thread());
 
-        // steal the work queue
-        auto work_queue_lock = std::unique_lock(work_queue_mutex_);
-        auto work_queue = work_queue_t{};
-        std::swap(work_queue, work_queue_);
-        work_queue_lock.unlock();
+        // Clear the flag before draining: any task queued after this
+        // point will schedule another wakeup if we miss it here.
+        wakeup_pending_.store(false);
 
-        // process the work queue
-        for (auto const& func : work_queue)
+        auto depth = work_ring_.size();
+        if (overflowed_.load(std::memory_order_acquire))
         {
-            func();
+            auto const lock = std::lock_guard{ overflow_mutex_ };
+            depth += std::size(overflow_);
+        }
+        max_depth_.store(std::max(max_depth_.load(std::memory_order_relaxed), depth), std::memory_order_relaxed);
+
+        // process a bounded batch from the ring so that a flood of tasks
+        // can't starve socket and timer events...
+        auto task = Task{};
+        auto n_run = size_t{};
+        for (; n_run < MaxTasksPerWakeup && work_ring_.try_pop(task); ++n_run)
+        {
+            run_task(task);
+        }
+
+        // ...and come back for the rest on the next loop iteration.
+        if (n_run == MaxTasksPerWakeup)
+        {
+            wakeup_pending_.store(true);
+            event_active(work_queue_event_.get(), 0, {});
+            return;
+        }
+
+        // Overflowed tasks were queued after the ones still in the ring,
+        // so they have to wait until the ring is empty. If it isn't, the
+        // next slot was claimed by a producer that hasn't published its
+        // task yet. Don't spin on it: once that producer publishes, its
+        // queue() sees `wakeup_pending_` is false and wakes us up again.
+        if (overflowed_.load(std::memory_order_acquire) && work_ring_.size() != 0U)
+        {
+            return;
+        }
+
+        // steal the overflow list
+        if (overflowed_.load(std::memory_order_acquire))
+        {
+            auto overflow = work_queue_t{};
+            {
+                auto const lock = std::lock_guard{ overflow_mutex_ };
+                std::swap(overflow, overflow_);
+                overflowed_.store(false, std::memory_order_release);
+            }
+
+            for (auto& item : overflow)
+            {
+                run_task(item);
+            }
+        }
+    }
+
+    // A fixed-capacity, lock-free multi-producer single-consumer queue.
+    // Based on Dmitry Vyukov's bounded MPMC queue, simplified for one consumer.
+    class WorkRing
+    {
+    public:
+        WorkRing()
+            : slots_(Capacity)
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+            {
+                slots_[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Returns false without touching `func` if the ring is full.
+        [[nodiscard]] bool try_push(
+            callback_t& func,
+            std::string_view const name,
+            std::chrono::steady_clock::time_point const queued_at,
+            SlotHook const& on_slot_claimed)
+        {
+            auto pos = push_pos_.load(std::memory_order_relaxed);
+
+            for (;;)
+            {
+                auto& slot = slots_[pos & Mask];
+                auto const seq = slot.seq.load(std::memory_order_acquire);
+                auto const diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+                if (diff == 0)
+                {
+                    if (push_pos_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+                    {
+                        on_slot_claimed();
+
+                        slot.task.func = std::move(func);
+                        slot.task.name = name;
+                        slot.task.queued_at = queued_at;
+                        slot.seq.store(pos + 1U, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // full
+                }
+                else
+                {
+                    pos = push_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Only call this from the consumer thread.
+        [[nodiscard]] bool try_pop(Task& setme)
+        {
+            auto& slot = slots_[pop_pos_ & Mask];
+            auto const seq = slot.seq.load(std::memory_order_acquire);
+
+            if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pop_pos_ + 1U) < 0)
+            {
+                return false; // empty
+            }
+
+            setme = std::move(slot.task);
+            slot.task = {};
+            slot.seq.store(pop_pos_ + Capacity, std::memory_order_release);
+            ++pop_pos_;
+            return true;
+        }
+
+        // Only call this from the consumer thread.
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return push_pos_.load(std::memory_order_relaxed) - pop_pos_;
+        }
+
+    private:
+        static constexpr size_t Capacity = 4096U; // must be a power of two
+        static constexpr size_t Mask = Capacity - 1U;
+
+        struct Slot
+        {
+            std::atomic<size_t> seq;
+            Task task;
+        };
+
+        std::vector<Slot> slots_;
+
+        // keep the producers' and consumer's positions on separate cache lines
+        alignas(64) std::atomic<size_t> push_pos_ = 0U;
+        alignas(64) size_t pop_pos_ = 0U;
+    };
+
+    void run_task(Task& task)
+    {
+        auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - task.queued_at);
+        n_tasks_.fetch_add(1U, std::memory_order_relaxed);
+        total_latency_us_.fetch_add(latency.count(), std::memory_order_relaxed);
+        if (latency.count() > max_latency_us_.load(std::memory_order_relaxed))
+        {
+            max_latency_us_.store(latency.count(), std::memory_order_relaxed);
         }
+        tr::metrics::add(tr::metrics::Counter::SessionThreadTasks);
+        tr::metrics::observe(tr::metrics::Histogram::SessionThreadLag, latency);
+
+        {
+            auto const span = tr::tracer::Span{ tr::tracer::Kind::Task, task.name, latency };
+            task.func();
+        }
+        task = {};
     }
 
     tr::evhelpers::evbase_unique_ptr const evbase_{ make_event_base() };
@@ -286,8 +504,21 @@ private:
         tr::evhelpers::event_new_pri2(evbase_.get(), -1, 0, on_work_available_static, this)
     };
 
-    work_queue_t work_queue_;
-    std::mutex work_queue_mutex_;
+    [[no_unique_address]] SlotHook const on_slot_claimed_;
+
+    WorkRing work_ring_;
+    std::atomic<bool> wakeup_pending_ = false;
+
+    // Used when the ring is full. This keeps queue() from ever blocking
+    // or dropping tasks, at the cost of taking a lock.
+    work_queue_t overflow_;
+    std::mutex overflow_mutex_;
+    std::atomic<bool> overflowed_ = false;
+
+    std::atomic<uint64_t> n_tasks_ = 0U;
+    std::atomic<size_t> max_depth_ = 0U;
+    std::atomic<int64_t> max_latency_us_ = 0;
+    std::atomic<int64_t> total_latency_us_ = 0;
 
     std::thread thread_;
     std::thread::id thread_id_;
@@ -302,5 +533,10 @@ private:
 
 std::unique_ptr<tr_session_thread> tr_session_thread::create()
 {
-    return std::make_unique<tr_session_thread_impl>();
+    return std::make_unique<tr_session_thread_impl<>>();
+}
+
+std::unique_ptr<tr_session_thread> tr_session_thread::create_with_slot_hook(std::function<void()> on_slot_claimed)
+{
+    return std::make_unique<tr_session_thread_impl<std::function<void()>>>(std::move(on_slot_claimed));
 }
@@ -9,40 +9,108 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <chrono>
+#include <concepts> // std::invocable
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
 #include <functional>
 #include <memory>
+#include <source_location>
+#include <string_view>
+#include <typeinfo>
 #include <utility>
 
+#include "libtransmission/tracer.h"
+
 struct event_base;
 
+namespace tr::test
+{
+
+class SessionThreadTest;
+
+} // namespace tr::test
+
 class tr_session_thread
 {
 protected:
     using callback_t = std::function<void()>;
 
 public:
+    struct QueueStats
+    {
+        // number of queued tasks that have been run
+        uint64_t n_tasks = {};
+
+        // the most tasks that were waiting to run at once
+        size_t max_depth = {};
+
+        // time between a task being queued and being run
+        std::chrono::microseconds max_latency = {};
+        std::chrono::microseconds total_latency = {};
+    };
+
     static void tr_evthread_init();
 
     static std::unique_ptr<tr_session_thread> create();
+
     virtual ~tr_session_thread() = default;
 
     [[nodiscard]] virtual struct event_base* event_base() noexcept = 0;
 
     [[nodiscard]] virtual bool am_in_session_thread() const noexcept = 0;
 
-    virtual void queue(callback_t&& func) = 0;
+    // `name` labels the task in traces. It must outlive the task.
+    virtual void queue_named(callback_t&& func, std::string_view name) = 0;
+
+    virtual void run_named(callback_t&& func, std::string_view name) = 0;
 
-    virtual void run(callback_t&& func) = 0;
+    [[nodiscard]] virtual QueueStats queue_stats() const noexcept = 0;
 
-    template<typename Func, typename... Args>
-    void queue(Func&& func, Args&&... args)
+    // Traces name these tasks after the function that queued them...
+    template<typename Func>
+    void queue(Func&& func, std::source_location const where = std::source_location::current())
     {
-        queue(callback_t{ std::bind_front(std::forward<Func>(func), std::forward<Args>(args)...) });
+        queue_named(callback_t{ std::forward<Func>(func) }, where.function_name());
     }
 
-    template<typename Func, typename... Args>
-    void run(Func&& func, Args&&... args)
+    template<typename Func>
+    void run(Func&& func, std::source_location const where = std::source_location::current())
     {
-        run(callback_t{ std::bind_front(std::forward<Func>(func), std::forward<Args>(args)...) });
+        run_named(callback_t{ std::forward<Func>(func) }, where.function_name());
     }
+
+    // ...and these after the function that they call
+    template<typename Func, typename Arg, typename... Args>
+        requires std::invocable<Func, Arg, Args...>
+    void queue(Func&& func, Arg&& arg, Args&&... args)
+    {
+        queue_named(
+            callback_t{ std::bind_front(std::forward<Func>(func), std::forward<Arg>(arg), std::forward<Args>(args)...) },
+            trace_name<Func>());
+    }
+
+    template<typename Func, typename Arg, typename... Args>
+        requires std::invocable<Func, Arg, Args...>
+    void run(Func&& func, Arg&& arg, Args&&... args)
+    {
+        run_named(
+            callback_t{ std::bind_front(std::forward<Func>(func), std::forward<Arg>(arg), std::forward<Args>(args)...) },
+            trace_name<Func>());
+    }
+
+private:
+    friend class tr::test::SessionThreadTest;
+
+    // Only worth looking up when someone is going to read it
+    template<typename Func>
+    [[nodiscard]] static std::string_view trace_name()
+    {
+        return tr::tracer::is_enabled() ? tr::tracer::type_name(typeid(Func)) : std::string_view{};
+    }
+
+    // Like create(), but calls `on_slot_claimed` inside queue() after a task's
+    // slot in the lock-free queue has been claimed and before the task is
+    // published in it. This lets tests stall a producer at that point.
+    static std::unique_ptr<tr_session_thread> create_with_slot_hook(std::function<void()> on_slot_claimed);
 };
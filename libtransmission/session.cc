@@ -369,6 +369,11 @@ std::chrono::steady_clock::time_point tr_session::WebMediator::now() const
     return std::chrono::steady_clock::now();
 }
 
+size_t tr_session::WebMediator::worker_count() const
+{
+    return session_->settings().web_worker_count;
+}
+
 void tr_sessionFetch(tr_session* session, tr_web::FetchOptions&& options)
 {
     session->fetch(std::move(options));
@@ -636,30 +641,6 @@ void tr_session::on_now_timer()
     now_timer_->set_interval(std::chrono::duration_cast<std::chrono::milliseconds>(target_interval));
 }
 
-namespace
-{
-namespace queue_helpers
-{
-std::vector<tr_torrent*> get_next_queued_torrents(tr_torrents const& torrents, tr_direction dir, size_t num_wanted)
-{
-    auto candidates = torrents.get_matching([dir](auto const* const tor) { return tor->is_queued(dir); });
-
-    // find the best n candidates
-    num_wanted = std::min(num_wanted, std::size(candidates));
-    if (num_wanted < candidates.size())
-    {
-        std::ranges::partial_sort(
-            candidates,
-            std::begin(candidates) + static_cast<decltype(candidates)::difference_type>(num_wanted),
-            tr_torrent::CompareQueuePosition);
-        candidates.resize(num_wanted);
-    }
-
-    return candidates;
-}
-} // namespace queue_helpers
-} // namespace
-
 size_t tr_session::count_queue_free_slots(tr_direction dir) const noexcept
 {
     if (!queueEnabled(dir))
@@ -675,8 +656,12 @@ size_t tr_session::count_queue_free_slots(tr_direction dir) const noexcept
     auto const stalled_enabled = queueStalledEnabled();
     auto const stalled_if_idle_for_n_seconds = static_cast<time_t>(queueStalledMinutes() * 60);
     auto const now = tr_time();
-    for (auto const* const tor : torrents())
+
+    // only running torrents can be seeding or downloading
+    for (auto const id : torrents().running())
     {
+        auto const* const tor = torrents().get(id);
+
         // is it the right activity?
         if (activity != tor->activity())
         {
@@ -707,8 +692,6 @@ size_t tr_session::count_queue_free_slots(tr_direction dir) const noexcept
 
 void tr_session::on_queue_timer()
 {
-    using namespace queue_helpers;
-
     for (auto const dir : { tr_direction::Up, tr_direction::Down })
     {
         if (!queueEnabled(dir))
@@ -718,8 +701,14 @@ void tr_session::on_queue_timer()
 
         auto const n_wanted = count_queue_free_slots(dir);
 
-        for (auto* tor : get_next_queued_torrents(torrents(), dir, n_wanted))
+        for (auto const id : torrent_queue().get_queued(dir, n_wanted))
         {
+            auto* const tor = torrents().get(id);
+            if (tor == nullptr || !tor->is_queued(dir))
+            {
+                continue;
+            }
+
             tr_torrentStartNow(tor);
 
             if (queue_start_callback_)
@@ -904,6 +893,11 @@ void tr_session::setSettings(tr_session::Settings&& settings_in, bool force)
         verifier_->set_sleep_per_seconds_during_verify(val);
     }
 
+    if (auto const& val = new_settings.web_worker_count; force || val != old_settings.web_worker_count)
+    {
+        web_->set_worker_count(val);
+    }
+
     // We need to update bandwidth if speed settings changed.
     // It's a harmless call, so just call it instead of checking for settings changes
     update_bandwidth(tr_direction::Up);
@@ -1399,6 +1393,7 @@ void tr_session::closeImplPart1(std::promise<void>* closed_promise, std::chrono:
     // close the low-hanging fruit that can be closed immediately w/o consequences
     utp_timer.reset();
     verifier_.reset();
+    relocator_.reset();
     save_timer_.reset();
     queue_timer_.reset();
     now_timer_.reset();
@@ -1596,6 +1591,22 @@ size_t tr_sessionGetAllTorrents(tr_session* session, tr_torrent** buf, size_t bu
     return n;
 }
 
+std::vector<tr_torrent_id_t> tr_sessionGetTorrentsChangedSince(tr_session* session, time_t const since)
+{
+    auto const lock = session->unique_lock();
+
+    auto ids = std::vector<tr_torrent_id_t>{};
+    for (auto const* const tor : session->torrents())
+    {
+        if (tor->has_changed_since(since))
+        {
+            ids.push_back(tor->id());
+        }
+    }
+
+    return ids;
+}
+
 // ---
 
 void tr_sessionSetPexEnabled(tr_session* session, bool enabled)
@@ -2070,6 +2081,30 @@ void tr_session::verify_add(tr_torrent* const tor)
     }
 }
 
+void tr_session::relocate_add(tr_torrent* const tor, tr_relocate_worker::Job job)
+{
+    if (relocator_)
+    {
+        relocator_->add(std::make_unique<tr_torrent::RelocateMediator>(tor), std::move(job));
+    }
+}
+
+void tr_session::relocate_remove(tr_torrent const* const tor)
+{
+    if (relocator_)
+    {
+        relocator_->remove(tor->info_hash());
+    }
+}
+
+void tr_session::relocate_remove_old_files(tr_relocate_worker::Job job)
+{
+    if (relocator_)
+    {
+        relocator_->remove_old_files(std::move(job));
+    }
+}
+
 // ---
 
 void tr_session::close_torrent_files(tr_torrent_id_t const tor_id) noexcept
@@ -2177,8 +2212,11 @@ tr_session::tr_session(std::string_view config_dir, tr_variant const& settings_d
     , queue_timer_{ timer_maker_->create([this]() { on_queue_timer(); }) }
     , save_timer_{ timer_maker_->create([this]() { on_save_timer(); }) }
 {
+    now_timer_->set_name("session now");
     now_timer_->start_repeating(1s);
+    queue_timer_->set_name("session queue");
     queue_timer_->start_repeating(QueueInterval);
+    save_timer_->set_name("session save");
     save_timer_->start_repeating(SaveInterval);
 }
 
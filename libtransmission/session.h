@@ -14,6 +14,7 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <concepts> // std::invocable
 #include <cstddef> // size_t
 #include <cstdint> // uintX_t
 #include <ctime> // time_t
@@ -21,6 +22,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <source_location>
 #include <span>
 #include <string>
 #include <string_view>
@@ -50,6 +52,7 @@
 #include "libtransmission/platform.h"
 #include "libtransmission/port-forwarding.h"
 #include "libtransmission/quark.h"
+#include "libtransmission/relocate.h"
 #include "libtransmission/rpc-server.h"
 #include "libtransmission/session-alt-speeds.h"
 #include "libtransmission/session-id.h"
@@ -157,6 +160,11 @@ private:
             return tr_address::from_string(session_.announceIP());
         }
 
+        [[nodiscard]] std::string_view config_dir() const override
+        {
+            return session_.config_dir_;
+        }
+
     private:
         tr_session& session_;
     };
@@ -266,6 +274,7 @@ private:
         [[nodiscard]] size_t clamp(int torrent_id, size_t byte_count) const override;
         [[nodiscard]] std::optional<std::string> proxyUrl() const override;
         [[nodiscard]] std::chrono::steady_clock::time_point now() const override;
+        [[nodiscard]] size_t worker_count() const override;
         // runs the tr_web::fetch response callback in the libtransmission thread
         void run(tr_web::FetchDoneFunc&& func, tr_web::FetchResponse&& response) const override;
 
@@ -373,7 +382,12 @@ private:
         tr_udp_core& operator=(tr_udp_core const&) = delete;
         tr_udp_core& operator=(tr_udp_core&&) = delete;
 
-        void sendto(void const* buf, size_t buflen, struct sockaddr const* to, socklen_t tolen) const;
+        // On platforms with sendmmsg(), datagrams are queued and sent
+        // in batches at the end of the current event loop iteration.
+        void sendto(void const* buf, size_t buflen, struct sockaddr const* to, socklen_t tolen);
+
+        // Sends any datagrams that are still queued.
+        void flush();
 
         [[nodiscard]] constexpr auto socket4() const noexcept
         {
@@ -386,12 +400,29 @@ private:
         }
 
     private:
+        struct RecvBatch;
+        struct SendQueue;
+
+        static void on_readable(evutil_socket_t s, short type, void* vself);
+        static void on_deferred(evutil_socket_t fd, short type, void* vself);
+        void read_datagrams(tr_socket_t sock);
+        [[nodiscard]] bool handle_datagram(unsigned char* buf, size_t buflen, struct sockaddr* from, socklen_t fromlen);
+        void sendto_now(tr_socket_t sock, void const* buf, size_t buflen, struct sockaddr const* to, socklen_t tolen) const;
+
         tr_port const udp_port_;
         tr_session& session_;
         tr_socket_t udp4_socket_ = TR_BAD_SOCKET;
         tr_socket_t udp6_socket_ = TR_BAD_SOCKET;
         tr::evhelpers::event_unique_ptr udp4_event_;
         tr::evhelpers::event_unique_ptr udp6_event_;
+
+        // runs once at the end of an event loop iteration to
+        // send deferred µTP ACKs and flush the send queue
+        tr::evhelpers::event_unique_ptr deferred_event_;
+        bool utp_acks_pending_ = false;
+
+        std::unique_ptr<RecvBatch> recv_batch_;
+        std::unique_ptr<SendQueue> send_queue_;
     };
 
 public:
@@ -414,16 +445,30 @@ public:
         return session_thread_->am_in_session_thread();
     }
 
-    template<typename Func, typename... Args>
-    void queue_session_thread(Func&& func, Args&&... args)
+    template<typename Func>
+    void queue_session_thread(Func&& func, std::source_location const where = std::source_location::current())
+    {
+        session_thread_->queue(std::forward<Func>(func), where);
+    }
+
+    template<typename Func, typename Arg, typename... Args>
+        requires std::invocable<Func, Arg, Args...>
+    void queue_session_thread(Func&& func, Arg&& arg, Args&&... args)
+    {
+        session_thread_->queue(std::forward<Func>(func), std::forward<Arg>(arg), std::forward<Args>(args)...);
+    }
+
+    template<typename Func>
+    void run_in_session_thread(Func&& func, std::source_location const where = std::source_location::current())
     {
-        session_thread_->queue(std::forward<Func>(func), std::forward<Args>(args)...);
+        session_thread_->run(std::forward<Func>(func), where);
     }
 
-    template<typename Func, typename... Args>
-    void run_in_session_thread(Func&& func, Args&&... args)
+    template<typename Func, typename Arg, typename... Args>
+        requires std::invocable<Func, Arg, Args...>
+    void run_in_session_thread(Func&& func, Arg&& arg, Args&&... args)
     {
-        session_thread_->run(std::forward<Func>(func), std::forward<Args>(args)...);
+        session_thread_->run(std::forward<Func>(func), std::forward<Arg>(arg), std::forward<Args>(args)...);
     }
 
     [[nodiscard]] auto* event_base() noexcept
@@ -875,6 +920,28 @@ public:
 
     [[nodiscard]] bool allowsUTP() const noexcept;
 
+    // When the last µTP packet was sent or received.
+    // The µTP timer goes to sleep when this gets too old.
+    [[nodiscard]] constexpr auto utp_last_activity() const noexcept
+    {
+        return utp_last_activity_;
+    }
+
+    constexpr void set_utp_last_activity(time_t const now) noexcept
+    {
+        utp_last_activity_ = now;
+    }
+
+    [[nodiscard]] constexpr auto is_utp_timer_sleeping() const noexcept
+    {
+        return utp_timer_sleeping_;
+    }
+
+    constexpr void set_utp_timer_sleeping(bool const sleeping) noexcept
+    {
+        utp_timer_sleeping_ = sleeping;
+    }
+
     [[nodiscard]] constexpr auto const& preferred_transports() const noexcept
     {
         return settings().preferred_transports;
@@ -1014,6 +1081,10 @@ public:
     void verify_add(tr_torrent* tor);
     void verify_remove(tr_torrent const* tor);
 
+    void relocate_add(tr_torrent* tor, tr_relocate_worker::Job job);
+    void relocate_remove(tr_torrent const* tor);
+    void relocate_remove_old_files(tr_relocate_worker::Job job);
+
     void fetch(tr_web::FetchOptions&& options) const
     {
         if (web_)
@@ -1349,6 +1420,12 @@ private:
 
     std::unique_ptr<tr_verify_worker> verifier_ = std::make_unique<tr_verify_worker>();
 
+    std::unique_ptr<tr_relocate_worker> relocator_ = std::make_unique<tr_relocate_worker>();
+
 public:
     std::unique_ptr<tr::Timer> utp_timer;
+
+private:
+    time_t utp_last_activity_ = 0;
+    bool utp_timer_sleeping_ = false;
 };
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <string_view>
 #include <utility>
 
 #ifdef _WIN32
@@ -19,6 +20,7 @@
 #include "libtransmission/timer.h"
 #include "libtransmission/timer-ev.h"
 #include "libtransmission/tr-assert.h"
+#include "libtransmission/tracer.h"
 #include "libtransmission/utils-ev.h"
 
 using namespace std::literals;
@@ -68,6 +70,7 @@ public:
         evtimer_add(evtimer_.get(), &tv);
 
         is_running_ = true;
+        due_at_ = tracer::is_enabled() ? steady_clock::now() + interval_ : steady_clock::time_point{};
     }
 
     void set_callback(std::function<void()> callback) override
@@ -146,18 +149,49 @@ private:
 
     void handleTimer()
     {
+        using namespace std::chrono;
+
         is_running_ = is_repeating_;
 
+        auto lag = steady_clock::duration{};
+        if (tracer::is_enabled())
+        {
+            auto const now = steady_clock::now();
+            if (due_at_ != steady_clock::time_point{})
+            {
+                lag = now - due_at_;
+            }
+
+            // libevent reschedules repeating timers from when they were due,
+            // unless that has already passed
+            auto const next = due_at_ + interval_;
+            due_at_ = !is_repeating_ ? steady_clock::time_point{} : next < now ? now + interval_ : next;
+        }
+
         TR_ASSERT(callback_);
+        auto const span = tracer::Span{ tracer::Kind::Timer, traceName(), lag };
         callback_();
     }
 
+    [[nodiscard]] std::string_view traceName() const noexcept
+    {
+        if (auto const timer_name = name(); !std::empty(timer_name))
+        {
+            return timer_name;
+        }
+
+        // fall back to the callback's type, e.g. the function that a lambda was written in.
+        // That takes a lock, so don't bother unless the span is going to be recorded.
+        return tracer::is_enabled() ? tracer::type_name(callback_.target_type()) : std::string_view{};
+    }
+
     [[nodiscard]] constexpr bool isRunning() const noexcept
     {
         return is_running_;
     }
 
     std::chrono::milliseconds interval_ = 100ms;
+    std::chrono::steady_clock::time_point due_at_; // only tracked while tracing
     bool is_repeating_ = false;
     bool is_running_ = false;
     std::function<void()> callback_;
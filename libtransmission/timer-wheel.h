@@ -0,0 +1,203 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/**
+ * A hierarchical timer wheel with one-second resolution.
+ *
+ * Keys are added with the time they come due and are handed back by
+ * `advance()` once that time arrives. Adding is O(1), and advancing
+ * costs O(due keys) plus a few slot lookups per elapsed second, no
+ * matter how many keys are waiting further out.
+ *
+ * Level 0 has one slot per second; each level above it has slots that
+ * are `SlotsPerLevel` times wider. Keys in a higher level are moved down a
+ * level when their slot comes around.
+ *
+ * There is no removal: callers that reschedule a key should add it
+ * again and ignore stale wakeups.
+ */
+template<typename Key>
+class tr_timer_wheel
+{
+public:
+    explicit tr_timer_wheel(time_t now = {})
+        : now_{ to_secs(now) }
+    {
+    }
+
+    [[nodiscard]] constexpr auto size() const noexcept
+    {
+        return size_;
+    }
+
+    [[nodiscard]] constexpr auto empty() const noexcept
+    {
+        return size_ == 0U;
+    }
+
+    // Schedule `key` to come due at `when`.
+    // Keys scheduled in the past come due on the next `advance()`.
+    void add(time_t const when, Key key)
+    {
+        ++size_;
+        insert({ to_secs(when), std::move(key) });
+    }
+
+    // @return the keys that came due since the last call, in no particular order
+    [[nodiscard]] std::vector<Key> advance(time_t const now_in)
+    {
+        auto const now = to_secs(now_in);
+
+        if (now > now_ && now - now_ > SlotsPerLevel * SlotsPerLevel)
+        {
+            // jumped far ahead, e.g. after the computer was asleep.
+            // Cheaper to re-bucket everything than to step through.
+            rebuild(now);
+        }
+
+        while (now_ < now)
+        {
+            step();
+        }
+
+        auto ret = std::vector<Key>{};
+        ret.reserve(std::size(due_));
+        for (auto& entry : due_)
+        {
+            ret.emplace_back(std::move(entry.key));
+        }
+
+        size_ -= std::size(due_);
+        due_.clear();
+        return ret;
+    }
+
+private:
+    static auto constexpr Levels = size_t{ 4U };
+    static auto constexpr SlotBits = uint64_t{ 6U };
+    static auto constexpr SlotsPerLevel = uint64_t{ 1U } << SlotBits;
+    static auto constexpr SlotMask = SlotsPerLevel - 1U;
+
+    struct Entry
+    {
+        uint64_t when;
+        Key key;
+    };
+
+    using Slot = std::vector<Entry>;
+
+    [[nodiscard]] static constexpr uint64_t to_secs(time_t const t) noexcept
+    {
+        return t > 0 ? static_cast<uint64_t>(t) : 0U;
+    }
+
+    [[nodiscard]] static constexpr uint64_t slot_index(uint64_t const when, size_t const level) noexcept
+    {
+        return (when >> (SlotBits * level)) & SlotMask;
+    }
+
+    void insert(Entry&& entry)
+    {
+        if (entry.when <= now_)
+        {
+            due_.emplace_back(std::move(entry));
+            return;
+        }
+
+        // Use the lowest level where `when` and `now_` share a parent slot.
+        for (size_t level = 0; level < Levels; ++level)
+        {
+            auto const shift = SlotBits * (level + 1U);
+            if ((entry.when >> shift) == (now_ >> shift))
+            {
+                wheel_[level][slot_index(entry.when, level)].emplace_back(std::move(entry));
+                return;
+            }
+        }
+
+        far_.emplace_back(std::move(entry));
+    }
+
+    void cascade(Slot& slot)
+    {
+        auto entries = Slot{};
+        std::swap(entries, slot);
+        for (auto& entry : entries)
+        {
+            insert(std::move(entry));
+        }
+    }
+
+    void step()
+    {
+        ++now_;
+
+        // When a level wraps around, move the next slot of the level above it down.
+        // Go top-down so that keys can fall more than one level.
+        auto n_wrapped = size_t{};
+        while (n_wrapped < Levels && slot_index(now_, n_wrapped) == 0U)
+        {
+            ++n_wrapped;
+        }
+
+        if (n_wrapped == Levels)
+        {
+            cascade(far_);
+        }
+
+        for (auto level = std::min(n_wrapped, Levels - 1U); level > 0U; --level)
+        {
+            cascade(wheel_[level][slot_index(now_, level)]);
+        }
+
+        cascade(wheel_[0][slot_index(now_, 0U)]);
+    }
+
+    void rebuild(uint64_t const now)
+    {
+        auto entries = Slot{};
+        std::swap(entries, far_);
+        for (auto& level : wheel_)
+        {
+            for (auto& slot : level)
+            {
+                std::move(std::begin(slot), std::end(slot), std::back_inserter(entries));
+                slot.clear();
+            }
+        }
+
+        now_ = now;
+        for (auto& entry : entries)
+        {
+            insert(std::move(entry));
+        }
+    }
+
+    std::array<std::array<Slot, SlotsPerLevel>, Levels> wheel_;
+
+    // keys too far out to fit in the wheel
+    Slot far_;
+
+    // keys whose time has come
+    Slot due_;
+
+    uint64_t now_ = {};
+    size_t size_ = {};
+};
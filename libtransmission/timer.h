@@ -8,6 +8,7 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <string_view>
 #include <utility>
 
 namespace tr
@@ -56,6 +57,20 @@ public:
     {
         set_callback([user_data, callback]() { callback(user_data); });
     }
+
+    // A label for the tracer, e.g. "rechoke". Must outlive the timer.
+    constexpr void set_name(std::string_view name) noexcept
+    {
+        name_ = name;
+    }
+
+    [[nodiscard]] constexpr std::string_view name() const noexcept
+    {
+        return name_;
+    }
+
+private:
+    std::string_view name_;
 };
 
 class TimerMaker
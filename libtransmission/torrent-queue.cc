@@ -4,11 +4,15 @@
 // License text can be found in the licenses/ folder.
 
 #include <algorithm>
-#include <ranges>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "libtransmission/crypto-utils.h" // tr_rand_obj()
 #include "libtransmission/torrent-queue.h"
 #include "libtransmission/tr-strbuf.h"
 #include "libtransmission/variant.h"
@@ -23,53 +27,236 @@ using namespace std::literals;
 }
 } // namespace
 
-size_t tr_torrent_queue::add(tr_torrent_id_t const id)
+// --- tree helpers
+
+bool tr_torrent_queue::contains(tr_torrent_id_t const id) const noexcept
 {
-    queue_.push_back(id);
-    set_dirty();
-    return std::size(queue_) - 1U;
+    return id != Nil && std::cmp_less(id, std::size(nodes_)) && nodes_[id].size_ != 0U;
 }
 
-void tr_torrent_queue::remove(tr_torrent_id_t const id)
+void tr_torrent_queue::update(index_t const idx) noexcept
+{
+    auto& node = nodes_[idx];
+    auto const& left = nodes_[node.left];
+    auto const& right = nodes_[node.right];
+
+    node.size_ = 1U + left.size_ + right.size_;
+    for (auto const dir : { tr_direction::Up, tr_direction::Down })
+    {
+        auto const i = static_cast<size_t>(dir);
+        node.n_queued[i] = left.n_queued[i] + right.n_queued[i] + (node.queued == dir ? 1U : 0U);
+    }
+}
+
+void tr_torrent_queue::update_to_root(index_t idx) noexcept
+{
+    for (; idx != Nil; idx = nodes_[idx].parent)
+    {
+        update(idx);
+    }
+}
+
+tr_torrent_queue::index_t tr_torrent_queue::merge(index_t const lhs, index_t const rhs) noexcept
 {
-    auto const pos = std::cmp_less(id, std::size(pos_cache_)) ? pos_cache_[id] : 0U;
-    if (pos < std::size(queue_) && queue_[pos] == id)
+    if (lhs == Nil || rhs == Nil)
     {
-        using diff_type = decltype(queue_)::difference_type;
-        queue_.erase(std::begin(queue_) + static_cast<diff_type>(pos));
+        return lhs != Nil ? lhs : rhs;
+    }
+
+    if (nodes_[lhs].priority > nodes_[rhs].priority)
+    {
+        auto const child = merge(nodes_[lhs].right, rhs);
+        nodes_[lhs].right = child;
+        nodes_[child].parent = lhs;
+        update(lhs);
+        return lhs;
+    }
+
+    auto const child = merge(lhs, nodes_[rhs].left);
+    nodes_[rhs].left = child;
+    nodes_[child].parent = rhs;
+    update(rhs);
+    return rhs;
+}
+
+// Splits the subtree at `idx` into its first `n_left` nodes and the rest.
+// The roots of both halves have no parent.
+std::pair<tr_torrent_queue::index_t, tr_torrent_queue::index_t> tr_torrent_queue::split(
+    index_t const idx,
+    size_t const n_left) noexcept
+{
+    if (idx == Nil)
+    {
+        return { Nil, Nil };
+    }
+
+    auto& node = nodes_[idx];
+    node.parent = Nil;
+
+    if (auto const n_left_of_node = nodes_[node.left].size_; n_left <= n_left_of_node)
+    {
+        auto const [lhs, rhs] = split(node.left, n_left);
+        node.left = rhs;
+        nodes_[rhs].parent = idx;
+        update(idx);
+        return { lhs, idx };
     }
     else
     {
-        std::erase(queue_, id);
+        auto const [lhs, rhs] = split(node.right, n_left - n_left_of_node - 1U);
+        node.right = lhs;
+        nodes_[lhs].parent = idx;
+        update(idx);
+        return { idx, rhs };
     }
-    set_dirty();
 }
 
-size_t tr_torrent_queue::get_pos(tr_torrent_id_t const id)
+tr_torrent_queue::index_t tr_torrent_queue::at(size_t pos) const noexcept
 {
-    auto const uid = static_cast<size_t>(id);
-    if (auto n_cache = std::size(pos_cache_);
-        uid >= n_cache || pos_cache_[uid] >= std::size(queue_) || id != queue_[pos_cache_[uid]])
+    for (auto idx = root_; idx != Nil;)
+    {
+        auto const& node = nodes_[idx];
+        auto const n_left = nodes_[node.left].size_;
+        if (pos < n_left)
+        {
+            idx = node.left;
+        }
+        else if (pos == n_left)
+        {
+            return idx;
+        }
+        else
+        {
+            pos -= n_left + 1U;
+            idx = node.right;
+        }
+    }
+
+    return Nil;
+}
+
+// in-order successor
+tr_torrent_queue::index_t tr_torrent_queue::next(index_t idx) const noexcept
+{
+    if (auto child = nodes_[idx].right; child != Nil)
     {
-        auto it = std::ranges::find(queue_, id);
-        if (it == std::ranges::cend(queue_))
+        while (nodes_[child].left != Nil)
         {
-            return MaxQueuePosition;
+            child = nodes_[child].left;
         }
+        return child;
+    }
 
-        pos_cache_.resize(std::max(uid + 1U, n_cache));
-        pos_cache_[uid] = std::ranges::distance(std::ranges::cbegin(queue_), it);
+    for (auto parent = nodes_[idx].parent; parent != Nil; idx = parent, parent = nodes_[parent].parent)
+    {
+        if (nodes_[parent].left == idx)
+        {
+            return parent;
+        }
+    }
+
+    return Nil;
+}
+
+void tr_torrent_queue::insert_at(index_t const idx, size_t const pos) noexcept
+{
+    auto& node = nodes_[idx];
+    node.left = Nil;
+    node.right = Nil;
+    node.parent = Nil;
+    update(idx);
+
+    auto const [lhs, rhs] = split(root_, pos);
+    root_ = merge(merge(lhs, idx), rhs);
+    nodes_[root_].parent = Nil;
+}
+
+void tr_torrent_queue::erase(index_t const idx) noexcept
+{
+    auto& node = nodes_[idx];
+    auto const parent = node.parent;
+    auto const child = merge(node.left, node.right);
+
+    nodes_[child].parent = parent;
+    if (parent == Nil)
+    {
+        root_ = child;
+    }
+    else if (nodes_[parent].left == idx)
+    {
+        nodes_[parent].left = child;
+    }
+    else
+    {
+        nodes_[parent].right = child;
     }
+    update_to_root(parent);
 
-    return pos_cache_[uid];
+    node.left = Nil;
+    node.right = Nil;
+    node.parent = Nil;
+    node.size_ = 0U;
+    node.n_queued = {};
+}
+
+// ---
+
+size_t tr_torrent_queue::add(tr_torrent_id_t const id)
+{
+    auto const uid = static_cast<size_t>(id);
+    if (uid >= std::size(nodes_))
+    {
+        nodes_.resize(uid + 1U);
+    }
+
+    if (!contains(id))
+    {
+        nodes_[id].priority = tr_rand_obj<uint32_t>();
+        insert_at(id, size());
+        set_dirty();
+    }
+
+    return get_pos(id);
+}
+
+void tr_torrent_queue::remove(tr_torrent_id_t const id)
+{
+    if (!contains(id))
+    {
+        return;
+    }
+
+    erase(id);
+    nodes_[id].queued.reset();
+    set_dirty();
+}
+
+size_t tr_torrent_queue::get_pos(tr_torrent_id_t const id) const noexcept
+{
+    if (!contains(id))
+    {
+        return MaxQueuePosition;
+    }
+
+    auto idx = index_t{ id };
+    auto pos = nodes_[nodes_[idx].left].size_;
+    for (auto parent = nodes_[idx].parent; parent != Nil; idx = parent, parent = nodes_[parent].parent)
+    {
+        if (nodes_[parent].right == idx)
+        {
+            pos += nodes_[nodes_[parent].left].size_ + 1U;
+        }
+    }
+
+    return pos;
 }
 
 // returns the list of torrent IDs whose queue position changed
 std::vector<tr_torrent_id_t> tr_torrent_queue::set_pos(tr_torrent_id_t const id, size_t new_pos)
 {
     auto const old_pos = get_pos(id);
-    auto const n_queue = std::size(queue_);
-    if (old_pos >= n_queue || queue_[old_pos] != id)
+    auto const n_queue = size();
+    if (old_pos >= n_queue)
     {
         return {};
     }
@@ -81,26 +268,75 @@ std::vector<tr_torrent_id_t> tr_torrent_queue::set_pos(tr_torrent_id_t const id,
         return {};
     }
 
+    erase(id);
+    insert_at(id, new_pos);
+    set_dirty();
+
+    // Everything between the old and new positions shifted by one,
+    // so this is proportional to how far the torrent moved.
+    auto const [lo, hi] = std::minmax(old_pos, new_pos);
     auto ret = std::vector<tr_torrent_id_t>{};
+    ret.reserve(hi - lo + 1U);
+    for (auto idx = at(lo); idx != Nil && std::size(ret) <= hi - lo; idx = next(idx))
+    {
+        ret.push_back(idx);
+    }
 
-    using diff_type = decltype(queue_)::difference_type;
-    auto const begin = std::begin(queue_);
-    auto const old_it = std::next(begin, static_cast<diff_type>(old_pos));
-    auto const old_next_it = std::next(old_it);
-    auto const new_it = std::next(begin, static_cast<diff_type>(new_pos));
-    if (old_pos > new_pos)
+    return ret;
+}
+
+void tr_torrent_queue::set_queued(tr_torrent_id_t const id, std::optional<tr_direction> const dir)
+{
+    if (id == Nil)
     {
-        ret.assign(new_it, old_next_it);
-        std::rotate(new_it, old_it, old_next_it);
+        return;
     }
-    else
+
+    if (auto const uid = static_cast<size_t>(id); uid >= std::size(nodes_))
     {
-        auto const new_next_it = std::next(new_it);
-        ret.assign(old_it, new_next_it);
-        std::rotate(old_it, old_next_it, new_next_it);
+        nodes_.resize(uid + 1U);
     }
 
-    set_dirty();
+    if (nodes_[id].queued == dir)
+    {
+        return;
+    }
+
+    nodes_[id].queued = dir;
+    if (contains(id))
+    {
+        update_to_root(id);
+    }
+}
+
+// in-order walk that skips subtrees with nothing queued in `dir`
+void tr_torrent_queue::collect_queued(
+    index_t const idx,
+    tr_direction const dir,
+    size_t const n_wanted,
+    std::vector<tr_torrent_id_t>& setme) const
+{
+    auto const& node = nodes_[idx];
+    if (std::size(setme) >= n_wanted || node.n_queued[static_cast<size_t>(dir)] == 0U)
+    {
+        return;
+    }
+
+    collect_queued(node.left, dir, n_wanted, setme);
+
+    if (std::size(setme) < n_wanted && node.queued == dir)
+    {
+        setme.push_back(idx);
+    }
+
+    collect_queued(node.right, dir, n_wanted, setme);
+}
+
+std::vector<tr_torrent_id_t> tr_torrent_queue::get_queued(tr_direction const dir, size_t const n_wanted) const
+{
+    auto ret = std::vector<tr_torrent_id_t>{};
+    ret.reserve(std::min(n_wanted, nodes_[root_].n_queued[static_cast<size_t>(dir)]));
+    collect_queued(root_, dir, n_wanted, ret);
     return ret;
 }
 
@@ -113,10 +349,10 @@ bool tr_torrent_queue::to_file()
     set_dirty(false);
 
     auto vec = tr_variant::Vector{};
-    vec.reserve(std::size(queue_));
-    for (auto const id : queue_)
+    vec.reserve(size());
+    for (auto idx = at(0U); idx != Nil; idx = next(idx))
     {
-        vec.emplace_back(mediator_.store_filename(id));
+        vec.emplace_back(mediator_.store_filename(idx));
     }
 
     return tr_variant_serde::json().to_file(std::move(vec), get_file_path(mediator_.config_dir()));
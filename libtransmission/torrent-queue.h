@@ -9,13 +9,26 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <array>
 #include <cstddef>
+#include <cstdint> // uint32_t
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "libtransmission/tr-macros.h"
 #include "libtransmission/types.h"
 
+/**
+ * The order in which torrents get started when a queue slot opens up.
+ *
+ * The queue is kept in a balanced tree (a treap ordered by queue position)
+ * so that adding, removing, moving, and looking up a torrent's position are
+ * all O(log n). Each subtree also counts how many of its torrents are waiting
+ * in the upload and download queues, so the next torrents to start can be
+ * found without scanning the ones that aren't waiting.
+ */
 class tr_torrent_queue
 {
 public:
@@ -40,12 +53,18 @@ public:
     size_t add(tr_torrent_id_t id);
     void remove(tr_torrent_id_t id);
 
-    [[nodiscard]] size_t get_pos(tr_torrent_id_t id);
+    [[nodiscard]] size_t get_pos(tr_torrent_id_t id) const noexcept;
     [[nodiscard]] std::vector<tr_torrent_id_t> set_pos(tr_torrent_id_t id, size_t new_pos);
 
+    // Mark a torrent as waiting in `dir`'s queue, or as not waiting if `dir` is empty
+    void set_queued(tr_torrent_id_t id, std::optional<tr_direction> dir);
+
+    // The first `n_wanted` torrents waiting in `dir`'s queue, in queue order
+    [[nodiscard]] std::vector<tr_torrent_id_t> get_queued(tr_direction dir, size_t n_wanted) const;
+
     [[nodiscard]] TR_CONSTEXPR_VEC auto size() const noexcept
     {
-        return queue_.size();
+        return nodes_[root_].size_;
     }
 
     bool to_file(); // NOLINT(modernize-use-nodiscard)
@@ -65,8 +84,43 @@ private:
         is_dirty_ = is_dirty;
     }
 
-    std::vector<tr_torrent_id_t> queue_;
-    std::vector<size_t> pos_cache_;
+    // Torrent IDs are small and dense, so nodes are stored by ID.
+    // Index 0 isn't a valid torrent ID, so it's used as the null node.
+    using index_t = tr_torrent_id_t;
+    static auto constexpr Nil = index_t{};
+
+    struct Node
+    {
+        index_t left = Nil;
+        index_t right = Nil;
+        index_t parent = Nil;
+
+        // heap order; random so that the tree stays balanced
+        uint32_t priority = 0U;
+
+        // number of nodes in this subtree, or 0 if this ID isn't in the queue
+        size_t size_ = 0U;
+
+        // number of nodes in this subtree that are waiting in each direction's queue
+        std::array<size_t, 2> n_queued = {};
+
+        std::optional<tr_direction> queued;
+    };
+
+    [[nodiscard]] bool contains(tr_torrent_id_t id) const noexcept;
+    void update(index_t idx) noexcept;
+    void update_to_root(index_t idx) noexcept;
+    [[nodiscard]] index_t merge(index_t lhs, index_t rhs) noexcept;
+    [[nodiscard]] std::pair<index_t, index_t> split(index_t idx, size_t n_left) noexcept;
+    [[nodiscard]] index_t at(size_t pos) const noexcept;
+    [[nodiscard]] index_t next(index_t idx) const noexcept;
+    void insert_at(index_t idx, size_t pos) noexcept;
+    void erase(index_t idx) noexcept;
+    void collect_queued(index_t idx, tr_direction dir, size_t n_wanted, std::vector<tr_torrent_id_t>& setme) const;
+
+    // nodes_[Nil] is a sentinel whose size_ is 0
+    std::vector<Node> nodes_ = std::vector<Node>(1U);
+    index_t root_ = Nil;
 
     bool is_dirty_ = false;
 
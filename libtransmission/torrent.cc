@@ -654,6 +654,7 @@ void tr_torrent::start(bool bypass_queue, std::optional<bool> has_any_local_data
     }
 
     is_running_ = true;
+    session->torrents().set_running(id(), true);
     set_dirty();
     session->run_in_session_thread([this]() { start_in_session_thread(); });
 }
@@ -675,6 +676,7 @@ void tr_torrent::start_in_session_thread()
     time_t const now = tr_time();
 
     is_running_ = true;
+    session->torrents().set_running(id(), true);
     date_started_ = now;
     mark_changed();
     error().clear();
@@ -700,6 +702,7 @@ void tr_torrent::stop_now()
     seconds_seeding_before_current_start_ = seconds_seeding(now);
 
     is_running_ = false;
+    session->torrents().set_running(id(), false);
     is_stopping_ = false;
     mark_changed();
 
@@ -797,6 +800,7 @@ void tr_torrentFreeInSessionThread(tr_torrent* tor)
 
     tor->set_dirty(!tor->is_deleting_);
     tor->stop_now();
+    tor->cancel_relocation();
 
     if (tor->is_deleting_)
     {
@@ -853,7 +857,6 @@ bool tr_torrent::is_new_torrent_a_seed()
 void tr_torrent::on_metainfo_updated()
 {
     completion_ = tr_completion{ this, &block_info() };
-    obfuscated_hash_ = tr_sha1::digest("req2"sv, info_hash());
     fpm_ = tr_file_piece_map{ metainfo_ };
     file_mtimes_.resize(file_count());
     file_priorities_ = tr_file_priorities{ &fpm_ };
@@ -1037,6 +1040,15 @@ void tr_torrent::init(tr_ctor const& ctor)
     {
         date_done_ = now_sec;
     }
+
+    // pick up a move that was interrupted by a restart.
+    // Files that were already copied are reused.
+    if (relocation_)
+    {
+        auto const target = std::move(relocation_->target);
+        relocation_.reset();
+        set_location(target, true, nullptr);
+    }
 }
 
 void tr_torrent::set_metainfo(tr_torrent_metainfo tm)
@@ -1090,48 +1102,201 @@ void tr_torrent::set_location_in_session_thread(std::string_view const path, boo
 {
     TR_ASSERT(session->am_in_session_thread());
 
-    auto ok = true;
-    if (move_from_old_path)
+    // a new location replaces any move that's still in progress
+    auto const restart_when_done = relocation_ && relocation_->restart_when_done;
+    cancel_relocation();
+
+    if (!move_from_old_path)
     {
+        // tell the torrent where the files are
+        set_download_dir(path);
+
+        if (restart_when_done)
+        {
+            tr_torrentStart(this);
+        }
+
         if (setme_state != nullptr)
         {
-            *setme_state = TR_LOC_MOVING;
+            *setme_state = TR_LOC_DONE;
+        }
+
+        return;
+    }
+
+    if (setme_state != nullptr)
+    {
+        *setme_state = TR_LOC_MOVING;
+    }
+
+    session->verify_remove(this);
+
+    auto job = tr_relocate_worker::Job{};
+    job.old_parent = current_dir().sv();
+    job.new_parent = path;
+    if (!tr_sys_path_is_same(job.old_parent, job.new_parent))
+    {
+        auto const paths = std::array<std::string_view, 1>{ job.old_parent };
+        for (tr_file_index_t i = 0, n = file_count(); i < n; ++i)
+        {
+            auto const found = files().find(i, std::data(paths), std::size(paths));
+            if (!found)
+            {
+                continue;
+            }
+
+            if (auto new_path = tr_pathbuf{ path, '/', found->subpath() }; !tr_sys_path_is_same(found->filename(), new_path))
+            {
+                job.files.push_back({ std::string{ found->filename() }, std::string{ new_path } });
+            }
+        }
+    }
+
+    relocation_ = Relocation{ std::string{ path }, setme_state, restart_when_done };
+    relocation_bytes_done_ = 0U;
+    relocation_bytes_total_ = 0U;
+    set_dirty();
+    mark_changed();
+
+    if (std::empty(job.files))
+    {
+        finish_relocation(std::move(job), {});
+        return;
+    }
+
+    // A download would keep writing to the files while they're being copied,
+    // so pause it until the move is done. Seeds keep seeding from the old
+    // location until the copies are ready.
+    if (is_running() && !is_done())
+    {
+        relocation_->restart_when_done = true;
+        tr_torrentStop(this);
+    }
+
+    tr_logAddTraceTor(this, fmt::format("Moving files from '{:s}' to '{:s}'", job.old_parent, job.new_parent));
+    session->relocate_add(this, std::move(job));
+}
+
+void tr_torrent::cancel_relocation()
+{
+    if (!relocation_)
+    {
+        return;
+    }
+
+    session->relocate_remove(this);
+
+    if (auto* const setme_state = relocation_->setme_state; setme_state != nullptr)
+    {
+        *setme_state = TR_LOC_ERROR;
+    }
+
+    relocation_.reset();
+    relocation_bytes_done_ = 0U;
+    relocation_bytes_total_ = 0U;
+    set_dirty();
+    mark_changed();
+}
+
+void tr_torrent::finish_relocation(tr_relocate_worker::Job job, tr_error const& copy_error)
+{
+    TR_ASSERT(session->am_in_session_thread());
+
+    // skip moves that were cancelled or replaced after the copy finished
+    if (!relocation_ || relocation_->target != job.new_parent)
+    {
+        // nothing will cut over to the copies, so delete them
+        if (!job.same_filesystem && !std::empty(job.files))
+        {
+            for (auto& file : job.files)
+            {
+                file.old_path = tr_pathbuf{ file.new_path, tr_relocate_worker::TempSuffix };
+            }
+            job.old_parent = job.new_parent;
+            session->relocate_remove_old_files(std::move(job));
         }
+        return;
+    }
 
+    auto error = copy_error;
+    if (!error)
+    {
         // ensure the files are all closed and idle before moving
         session->close_torrent_files(id());
-        session->verify_remove(this);
 
-        auto error = tr_error{};
-        ok = files().move(current_dir(), path, name(), &error);
-        if (error)
+        // If a file changed after it was copied, the copy is stale.
+        // Pause the torrent and copy again; unchanged files are reused.
+        auto const is_stale = [](tr_relocate_worker::File const& file)
         {
-            this->error().set_local_error(
-                fmt::format(
-                    fmt::runtime(_("Couldn't move '{old_path}' to '{path}': {error} ({error_code})")),
-                    fmt::arg("old_path", current_dir()),
-                    fmt::arg("path", path),
-                    fmt::arg("error", error.message()),
-                    fmt::arg("error_code", error.code())));
-            tr_torrentStop(this);
+            auto const info = tr_sys_path_get_info(file.old_path);
+            return info && (info->size != file.size || info->last_modified_at != file.mtime);
+        };
+        if (!job.same_filesystem && std::ranges::any_of(job.files, is_stale))
+        {
+            tr_logAddDebugTor(this, "Files changed while they were being moved; copying them again");
+
+            if (is_running())
+            {
+                relocation_->restart_when_done = true;
+                tr_torrentStop(this);
+            }
+
+            session->relocate_add(this, std::move(job));
+            return;
+        }
+
+        for (auto const& file : job.files)
+        {
+            auto const from = job.same_filesystem ? tr_pathbuf{ file.old_path } :
+                                                    tr_pathbuf{ file.new_path, tr_relocate_worker::TempSuffix };
+            if (!tr_file_move(from, file.new_path, false, &error))
+            {
+                break;
+            }
         }
     }
 
-    // tell the torrent where the files are
-    if (ok)
+    auto const relocation = *relocation_;
+    relocation_.reset();
+    relocation_bytes_done_ = 0U;
+    relocation_bytes_total_ = 0U;
+
+    if (error)
     {
-        set_download_dir(path);
+        this->error().set_local_error(
+            fmt::format(
+                fmt::runtime(_("Couldn't move '{old_path}' to '{path}': {error} ({error_code})")),
+                fmt::arg("old_path", job.old_parent),
+                fmt::arg("path", job.new_parent),
+                fmt::arg("error", error.message()),
+                fmt::arg("error_code", error.code())));
+        tr_torrentStop(this);
+    }
+    else
+    {
+        // tell the torrent where the files are
+        set_download_dir(relocation.target);
+        incomplete_dir_.clear();
+        current_dir_ = download_dir();
+
+        // delete the originals and any directories they leave empty
+        if (!std::empty(job.files))
+        {
+            session->relocate_remove_old_files(std::move(job));
+        }
 
-        if (move_from_old_path)
+        if (relocation.restart_when_done)
         {
-            incomplete_dir_.clear();
-            current_dir_ = download_dir();
+            tr_torrentStart(this);
         }
     }
 
-    if (setme_state != nullptr)
+    set_dirty();
+    mark_changed();
+
+    if (relocation.setme_state != nullptr)
     {
-        *setme_state = ok ? TR_LOC_DONE : TR_LOC_ERROR;
+        *relocation.setme_state = error ? TR_LOC_ERROR : TR_LOC_DONE;
     }
 }
 
@@ -1316,6 +1481,8 @@ tr_stat tr_torrent::stats() const
 
     auto const verify_progress = this->verify_progress();
     stats.recheck_progress = verify_progress.value_or(0.0);
+    stats.relocation_bytes_done = relocation_bytes_done_;
+    stats.relocation_bytes_total = relocation_bytes_total_;
     stats.activity_date = this->date_active_;
     stats.added_date = this->date_added_;
     stats.done_date = this->date_done_;
@@ -1748,6 +1915,34 @@ void tr_torrent::VerifyMediator::on_verify_done(bool const aborted)
 
 // ---
 
+tr_sha1_digest_t const& tr_torrent::RelocateMediator::info_hash() const
+{
+    return tor_->info_hash();
+}
+
+// (called from tr_relocate_worker's thread)
+void tr_torrent::RelocateMediator::on_progress(uint64_t const bytes_done, uint64_t const bytes_total)
+{
+    tor_->relocation_bytes_done_ = bytes_done;
+    tor_->relocation_bytes_total_ = bytes_total;
+}
+
+// (called from tr_relocate_worker's thread)
+void tr_torrent::RelocateMediator::on_copied(tr_relocate_worker::Job job, tr_error const& error)
+{
+    tor_->session->run_in_session_thread(
+        // Do not capture the torrent pointer directly; it may be freed before this runs.
+        [tor_id = tor_->id(), session = tor_->session, job = std::move(job), error]() mutable
+        {
+            if (auto* const tor = session->torrents().get(tor_id); tor != nullptr && !tor->is_deleting_)
+            {
+                tor->finish_relocation(std::move(job), error);
+            }
+        });
+}
+
+// ---
+
 void tr_torrent::save_resume_file()
 {
     if (!is_dirty())
@@ -1850,6 +2045,7 @@ void tr_torrent::recheck_completeness()
                 get_completion_string(new_completeness)));
 
         completeness_ = new_completeness;
+        update_queue_index();
 
         if (is_done())
         {
@@ -2108,14 +2304,17 @@ void tr_torrent::on_tracker_response(tr_tracker_event const* event)
                 fmt::arg("warning", event->text),
                 fmt::arg("url", tr_urlTrackerLogName(event->announce_url))));
         error_.set_tracker_warning(event->announce_url, event->text);
+        mark_changed();
         break;
 
     case tr_tracker_event::Type::Error:
         error_.set_tracker_error(event->announce_url, event->text);
+        mark_changed();
         break;
 
     case tr_tracker_event::Type::ErrorClear:
         error_.clear_if_tracker();
+        mark_changed();
         break;
     }
 }
@@ -2693,6 +2892,23 @@ void tr_torrent::ResumeHelper::load_incomplete_dir(std::string_view const dir) n
 
 // ---
 
+void tr_torrent::ResumeHelper::load_relocation_target(std::string_view const dir)
+{
+    tor_.relocation_ = Relocation{ std::string{ dir } };
+}
+
+std::optional<std::string_view> tr_torrent::ResumeHelper::relocation_target() const noexcept
+{
+    if (tor_.relocation_)
+    {
+        return tor_.relocation_->target;
+    }
+
+    return {};
+}
+
+// ---
+
 void tr_torrent::ResumeHelper::load_start_when_stable(bool const val) noexcept
 {
     tor_.start_when_stable_ = val;
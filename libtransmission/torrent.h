@@ -9,6 +9,7 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <atomic>
 #include <cstddef> // size_t
 #include <cstdint> // uint64_t, uint16_t
 #include <ctime>
@@ -32,6 +33,7 @@
 #include "libtransmission/file-piece-map.h"
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
+#include "libtransmission/relocate.h"
 #include "libtransmission/session.h"
 #include "libtransmission/torrent-files.h"
 #include "libtransmission/torrent-magnet.h"
@@ -77,6 +79,7 @@ struct tr_torrent
         void load_date_done(time_t when) noexcept;
         void load_download_dir(std::string_view dir) noexcept;
         void load_incomplete_dir(std::string_view dir) noexcept;
+        void load_relocation_target(std::string_view dir);
         void load_seconds_downloading_before_current_start(time_t when) noexcept;
         void load_seconds_seeding_before_current_start(time_t when) noexcept;
         void load_start_when_stable(bool val) noexcept;
@@ -87,6 +90,7 @@ struct tr_torrent
         [[nodiscard]] time_t date_active() const noexcept;
         [[nodiscard]] time_t date_added() const noexcept;
         [[nodiscard]] time_t date_done() const noexcept;
+        [[nodiscard]] std::optional<std::string_view> relocation_target() const noexcept;
         [[nodiscard]] time_t seconds_downloading(time_t now) const noexcept;
         [[nodiscard]] time_t seconds_seeding(time_t now) const noexcept;
         [[nodiscard]] bool start_when_stable() const noexcept;
@@ -171,11 +175,31 @@ struct tr_torrent
         std::optional<time_t> time_started_;
     };
 
+    class RelocateMediator : public tr_relocate_worker::Mediator
+    {
+    public:
+        explicit RelocateMediator(tr_torrent* const tor)
+            : tor_{ tor }
+        {
+        }
+
+        ~RelocateMediator() override = default;
+
+        [[nodiscard]] tr_sha1_digest_t const& info_hash() const override;
+
+        void on_progress(uint64_t bytes_done, uint64_t bytes_total) override;
+        void on_copied(tr_relocate_worker::Job job, tr_error const& error) override;
+
+    private:
+        tr_torrent* const tor_;
+    };
+
     // ---
 
     explicit tr_torrent(tr_torrent_metainfo&& tm)
         : metainfo_{ std::move(tm) }
         , completion_{ this, &metainfo_.block_info() }
+        , obfuscated_hash_{ tr_sha1::digest(std::string_view{ "req2" }, metainfo_.info_hash()) }
     {
     }
 
@@ -661,6 +685,7 @@ struct tr_torrent
         if (is_queued_ != queued)
         {
             is_queued_ = queued;
+            update_queue_index();
             mark_changed();
             set_dirty();
         }
@@ -810,6 +835,9 @@ struct tr_torrent
         return date_changed_ > when;
     }
 
+    // Flag a change to the torrent's stats, e.g. for tr_sessionGetTorrentsChangedSince()
+    void mark_changed();
+
     void set_bandwidth_group(std::string_view group_name) noexcept;
 
     [[nodiscard]] constexpr auto get_priority() const noexcept
@@ -972,9 +1000,10 @@ struct tr_torrent
 
     void stop_if_seed_limit_reached();
 
-    [[nodiscard]] constexpr auto obfuscated_hash_equals(tr_sha1_digest_t const& test) const noexcept
+    // Peers doing an MSE handshake send this instead of the info hash
+    [[nodiscard]] constexpr auto const& obfuscated_hash() const noexcept
     {
-        return obfuscated_hash_ == test;
+        return obfuscated_hash_;
     }
 
     // --- queue position
@@ -1296,8 +1325,6 @@ private:
         date_changed_ = std::max(date_changed_, when);
     }
 
-    void mark_changed();
-
     constexpr void bump_date_edited(time_t when)
     {
         date_edited_ = std::max(date_edited_, when);
@@ -1332,7 +1359,15 @@ private:
 
     void update_file_path(tr_file_index_t file, std::optional<bool> has_file) const;
 
+    // keep the session's index of queued torrents in sync with is_queued()
+    void update_queue_index()
+    {
+        session->torrent_queue().set_queued(id(), is_queued_ ? std::optional{ queue_direction() } : std::nullopt);
+    }
+
     void set_location_in_session_thread(std::string_view path, bool move_from_old_path, int volatile* setme_state);
+    void finish_relocation(tr_relocate_worker::Job job, tr_error const& error);
+    void cancel_relocation();
 
     void rename_path_in_session_thread(
         std::string_view oldpath,
@@ -1387,7 +1422,8 @@ private:
     // Will equal either download_dir or incomplete_dir
     tr_interned_string current_dir_;
 
-    tr_sha1_digest_t obfuscated_hash_ = {};
+    // the info hash never changes, so neither does this
+    tr_sha1_digest_t const obfuscated_hash_;
 
     mutable SimpleSmoothedSpeed eta_speed_;
 
@@ -1416,6 +1452,23 @@ private:
     float verify_progress_ = -1.0F;
     double seed_ratio_ = 0.0;
 
+    // A move to a new location that is copying files in the background.
+    // The torrent keeps using current_dir() until the copies are done.
+    struct Relocation
+    {
+        std::string target;
+        int volatile* setme_state = nullptr;
+
+        // incomplete torrents are paused while their files are copied
+        bool restart_when_done = false;
+    };
+
+    std::optional<Relocation> relocation_;
+
+    // updated by tr_relocate_worker's thread
+    std::atomic<uint64_t> relocation_bytes_done_ = {};
+    std::atomic<uint64_t> relocation_bytes_total_ = {};
+
     tr_announce_key_t announce_key_ = tr_rand_obj<tr_announce_key_t>();
 
     tr_torrent_id_t unique_id_ = 0;
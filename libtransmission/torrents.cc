@@ -14,34 +14,6 @@
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/types.h"
 
-namespace
-{
-
-constexpr struct
-{
-    bool operator()(tr_sha1_digest_t const& a, tr_sha1_digest_t const& b) const
-    {
-        return a < b;
-    }
-
-    bool operator()(tr_torrent const* a, tr_torrent const* b) const
-    {
-        return (*this)(a->info_hash(), b->info_hash());
-    }
-
-    bool operator()(tr_torrent const* a, tr_sha1_digest_t const& b) const
-    {
-        return (*this)(a->info_hash(), b);
-    }
-
-    bool operator()(tr_sha1_digest_t const& a, tr_torrent const* b) const
-    {
-        return (*this)(a, b->info_hash());
-    }
-} CompareTorrentByHash{};
-
-} // namespace
-
 tr_torrent* tr_torrents::get(std::string_view magnet_link) const
 {
     auto magnet = tr_magnet_metainfo{};
@@ -50,28 +22,26 @@ tr_torrent* tr_torrents::get(std::string_view magnet_link) const
 
 tr_torrent* tr_torrents::get(tr_sha1_digest_t const& hash) const
 {
-    auto const range = std::ranges::equal_range(by_hash_, hash, CompareTorrentByHash);
-    return range.empty() ? nullptr : range.front();
+    auto const iter = by_hash_.find(hash);
+    return iter == std::end(by_hash_) ? nullptr : torrents_[iter->second];
 }
 
 tr_torrent* tr_torrents::find_from_obfuscated_hash(tr_sha1_digest_t const& obfuscated_hash) const
 {
-    for (auto* const tor : *this)
-    {
-        if (tor->obfuscated_hash_equals(obfuscated_hash))
-        {
-            return tor;
-        }
-    }
-
-    return nullptr;
+    auto const iter = by_obfuscated_hash_.find(obfuscated_hash);
+    return iter == std::end(by_obfuscated_hash_) ? nullptr : iter->second;
 }
 
 tr_torrent_id_t tr_torrents::add(tr_torrent* tor)
 {
+    TR_ASSERT(tor != nullptr);
+    TR_ASSERT(!contains(tor->info_hash()));
+
     auto const id = static_cast<tr_torrent_id_t>(std::size(by_id_));
     by_id_.push_back(tor);
-    by_hash_.insert(std::ranges::lower_bound(by_hash_, tor, CompareTorrentByHash), tor);
+    by_hash_.try_emplace(tor->info_hash(), std::size(torrents_));
+    by_obfuscated_hash_.try_emplace(tor->obfuscated_hash(), tor);
+    torrents_.push_back(tor);
     return id;
 }
 
@@ -81,8 +51,24 @@ void tr_torrents::remove(tr_torrent const* tor, time_t current_time)
     TR_ASSERT(get(tor->id()) == tor);
 
     by_id_[tor->id()] = nullptr;
-    auto const [begin, end] = std::ranges::equal_range(by_hash_, tor, CompareTorrentByHash);
-    by_hash_.erase(begin, end);
+    by_obfuscated_hash_.erase(tor->obfuscated_hash());
+    running_.erase(tor->id());
+
+    if (auto const iter = by_hash_.find(tor->info_hash()); iter != std::end(by_hash_))
+    {
+        // swap-and-pop to keep removal O(1)
+        auto const pos = iter->second;
+        by_hash_.erase(iter);
+
+        if (auto* const last = torrents_.back(); last != tor)
+        {
+            torrents_[pos] = last;
+            by_hash_[last->info_hash()] = pos;
+        }
+
+        torrents_.pop_back();
+    }
+
     removed_.emplace_back(tor->id(), current_time);
 }
 
@@ -14,10 +14,13 @@
 #include <ctime>
 #include <functional>
 #include <iterator>
+#include <set>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "libtransmission/crypto-utils.h" // tr_sha1_digest_hash
 #include "libtransmission/torrent-metainfo.h"
 
 struct tr_torrent;
@@ -38,7 +41,7 @@ public:
         return uid >= std::size(by_id_) ? nullptr : by_id_.at(uid);
     }
 
-    // O(log n)
+    // O(1)
     [[nodiscard]] tr_torrent* get(tr_sha1_digest_t const& hash) const;
 
     [[nodiscard]] tr_torrent* get(tr_torrent_metainfo const& metainfo) const
@@ -46,7 +49,7 @@ public:
         return get(metainfo.info_hash());
     }
 
-    // O(n)}
+    // O(1)
     [[nodiscard]] tr_torrent* find_from_obfuscated_hash(tr_sha1_digest_t const& obfuscated_hash) const;
 
     // These convenience functions use get(tr_sha1_digest_t const&)
@@ -62,9 +65,28 @@ public:
 
     [[nodiscard]] std::vector<tr_torrent_id_t> removedSince(time_t timestamp) const;
 
+    void set_running(tr_torrent_id_t id, bool is_running)
+    {
+        if (is_running)
+        {
+            running_.insert(id);
+        }
+        else
+        {
+            running_.erase(id);
+        }
+    }
+
+    // IDs of the torrents that are running, so that callers which only
+    // care about those (e.g. counting free queue slots) needn't visit all.
+    [[nodiscard]] constexpr auto const& running() const noexcept
+    {
+        return running_;
+    }
+
     [[nodiscard]] constexpr auto cbegin() const noexcept
     {
-        return std::cbegin(by_hash_);
+        return std::cbegin(torrents_);
     }
     [[nodiscard]] constexpr auto begin() const noexcept
     {
@@ -72,12 +94,12 @@ public:
     }
     [[nodiscard]] constexpr auto begin() noexcept
     {
-        return std::begin(by_hash_);
+        return std::begin(torrents_);
     }
 
     [[nodiscard]] constexpr auto cend() const noexcept
     {
-        return std::cend(by_hash_);
+        return std::cend(torrents_);
     }
 
     [[nodiscard]] constexpr auto end() const noexcept
@@ -87,17 +109,17 @@ public:
 
     [[nodiscard]] constexpr auto end() noexcept
     {
-        return std::end(by_hash_);
+        return std::end(torrents_);
     }
 
     [[nodiscard]] constexpr auto size() const noexcept
     {
-        return std::size(by_hash_);
+        return std::size(torrents_);
     }
 
     [[nodiscard]] constexpr auto empty() const noexcept
     {
-        return std::empty(by_hash_);
+        return std::empty(torrents_);
     }
 
     [[nodiscard]] auto get_matching(std::function<bool(tr_torrent const*)> pred_in) const
@@ -119,7 +141,16 @@ public:
     }
 
 private:
-    std::vector<tr_torrent*> by_hash_;
+    // All the torrents, in no particular order.
+    // Removal swaps the last torrent into the removed one's slot.
+    std::vector<tr_torrent*> torrents_;
+
+    // info hash -> index in torrents_
+    std::unordered_map<tr_sha1_digest_t, size_t, tr_sha1_digest_hash> by_hash_;
+
+    // Incoming encrypted handshakes only tell us SHA1("req2", info_hash),
+    // so keep a second index to look torrents up from that.
+    std::unordered_map<tr_sha1_digest_t, tr_torrent*, tr_sha1_digest_hash> by_obfuscated_hash_;
 
     // This is a lookup table where by_id_[id]->id() == id.
     // There is a small tradeoff here -- lookup is O(1) at the cost
@@ -136,4 +167,6 @@ private:
     std::vector<tr_torrent*> by_id_{ nullptr };
 
     std::vector<std::pair<tr_torrent_id_t, time_t>> removed_;
+
+    std::set<tr_torrent_id_t> running_;
 };
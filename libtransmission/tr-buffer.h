@@ -271,10 +271,50 @@ public:
         end_pos_ += n_bytes;
     }
 
+    // how many bytes the buffer can hold before it has to grow
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+        return buf_.capacity();
+    }
+
 private:
     small::vector<value_type, N, std::allocator<value_type>, std::true_type, size_t, GrowthFactor> buf_ = {};
     size_t begin_pos_ = {};
     size_t end_pos_ = {};
 };
 
+// Writes into a fixed-size span that's owned by someone else,
+// e.g. space that was reserved in another buffer.
+template<typename value_type = std::byte>
+class SpanWriter final : public BufferWriter<value_type>
+{
+public:
+    SpanWriter(value_type* begin, size_t len) noexcept
+        : begin_{ begin }
+        , len_{ len }
+    {
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept
+    {
+        return pos_;
+    }
+
+    std::pair<value_type*, size_t> reserve_space(size_t n_bytes) override
+    {
+        TR_ASSERT(pos_ + n_bytes <= len_);
+        return { begin_ + pos_, n_bytes };
+    }
+
+    void commit_space(size_t n_bytes) override
+    {
+        pos_ += n_bytes;
+    }
+
+private:
+    value_type* const begin_;
+    size_t const len_;
+    size_t pos_ = {};
+};
+
 } // namespace tr
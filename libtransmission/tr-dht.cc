@@ -6,13 +6,15 @@
 #include <array>
 #include <chrono>
 #include <cstddef>
-#include <cstdint> // uint16_t
+#include <cstdint> // uint16_t, uint64_t
 #include <cstring> // memcpy()
 #include <ctime>
 #include <deque>
+#include <functional> // std::greater
 #include <fstream>
 #include <map>
 #include <memory>
+#include <queue>
 #include <ranges>
 #include <sstream>
 #include <string>
@@ -36,6 +38,7 @@
 #include "libtransmission/crypto-utils.h"
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-mgr.h" // for tr_peerMgrCompactToPex()
 #include "libtransmission/quark.h"
@@ -127,6 +130,15 @@ private:
     using Nodes = std::deque<Node>;
     using Id = std::array<unsigned char, 20>;
 
+    // Upper bound on how many DHT searches are started per announce tick.
+    // With 20k torrents announcing on both IPv4 and IPv6 every ~27 minutes,
+    // the steady state is ~25 searches per second, so this leaves room
+    // for catching up without flooding the DHT after startup.
+    static auto constexpr MaxSearchesPerTick = size_t{ 64U };
+
+    // How often to ask the session which torrents allow DHT
+    static auto constexpr ScheduleRefreshIntervalSecs = time_t{ 10 };
+
     enum class SwarmStatus : uint8_t
     {
         Stopped,
@@ -337,30 +349,87 @@ private:
         return announce_again_in_n_secs;
     }
 
+    void refresh_announce_schedule(time_t const now)
+    {
+        auto ids = mediator_.torrents_allowing_dht();
+        std::ranges::sort(ids);
+
+        // forget torrents that have stopped or no longer allow DHT.
+        // their stale entries in `announce_queue_` are skipped when popped.
+        std::erase_if(
+            announce_times_,
+            [&ids](auto const& item) { return !std::ranges::binary_search(ids, item.first); });
+
+        for (auto const id : ids)
+        {
+            if (auto const [iter, added] = announce_times_.try_emplace(id, AnnounceInfo{ now, now }); added)
+            {
+                announce_queue_.push({ now, id, AF_INET });
+                announce_queue_.push({ now, id, AF_INET6 });
+            }
+        }
+
+        schedule_refreshed_at_ = now;
+    }
+
     void on_announce_timer()
     {
+        auto const now = tr_time();
+
+        if (schedule_refreshed_at_ + ScheduleRefreshIntervalSecs <= now)
+        {
+            refresh_announce_schedule(now);
+        }
+
         // don't announce if the swarm isn't ready
         if (swarm_status(AF_INET) < SwarmStatus::Poor && swarm_status(AF_INET6) < SwarmStatus::Poor)
         {
             return;
         }
 
-        auto const now = tr_time();
-        for (auto const id : mediator_.torrents_allowing_dht())
+        // Pop only the announces that are due, and no more than
+        // MaxSearchesPerTick of them, so that a big batch of torrents
+        // becoming due at once is spread out over several ticks.
+        auto n_searches = size_t{};
+        auto max_lag = time_t{};
+        while (!std::empty(announce_queue_) && announce_queue_.top().announce_after <= now &&
+               n_searches < MaxSearchesPerTick)
         {
-            auto& times = announce_times_[id];
+            auto const [scheduled_at, id, af] = announce_queue_.top();
+            announce_queue_.pop();
 
-            if (auto& announce_after = times.ipv4_announce_after; announce_after < now)
+            auto const iter = announce_times_.find(id);
+            if (iter == std::end(announce_times_))
             {
-                auto const announce_again_in_n_secs = announce_torrent(mediator_.torrent_info_hash(id), AF_INET, peer_port_);
-                announce_after = now + std::chrono::seconds{ announce_again_in_n_secs }.count();
+                continue;
             }
 
-            if (auto& announce_after = times.ipv6_announce_after; announce_after < now)
+            auto& times = iter->second;
+            auto& announce_after = af == AF_INET ? times.ipv4_announce_after : times.ipv6_announce_after;
+            if (announce_after != scheduled_at) // stale entry
             {
-                auto const announce_again_in_n_secs = announce_torrent(mediator_.torrent_info_hash(id), AF_INET6, peer_port_);
-                announce_after = now + std::chrono::seconds{ announce_again_in_n_secs }.count();
+                continue;
             }
+
+            auto const lag = now - announce_after;
+            tr::metrics::add(tr::metrics::Counter::DhtAnnounces);
+            tr::metrics::add(tr::metrics::Counter::DhtAnnounceLagSeconds, static_cast<uint64_t>(lag));
+            max_lag = std::max(max_lag, lag);
+            tr_logAddTrace(fmt::format("DHT announce for torrent {} (af {}) is {}s late", id, af, lag));
+
+            auto const announce_again_in_n_secs = announce_torrent(mediator_.torrent_info_hash(id), af, peer_port_);
+            announce_after = now + announce_again_in_n_secs.count();
+            announce_queue_.push({ announce_after, id, af });
+            ++n_searches;
+        }
+
+        if (n_searches == MaxSearchesPerTick)
+        {
+            tr_logAddDebug(
+                fmt::format(
+                    "DHT announce backlog: {} searches started this tick, oldest was {}s late",
+                    n_searches,
+                    max_lag));
         }
     }
 
@@ -633,7 +702,20 @@ private:
         time_t ipv6_announce_after = 0;
     };
 
+    struct ScheduledAnnounce
+    {
+        time_t announce_after = 0;
+        tr_torrent_id_t id = {};
+        int af = {};
+
+        [[nodiscard]] constexpr auto operator<=>(ScheduledAnnounce const&) const noexcept = default;
+    };
+
     std::map<tr_torrent_id_t, AnnounceInfo> announce_times_;
+
+    // min-heap of upcoming announces, ordered by time
+    std::priority_queue<ScheduledAnnounce, std::vector<ScheduledAnnounce>, std::greater<>> announce_queue_;
+    time_t schedule_refreshed_at_ = 0;
 };
 
 [[nodiscard]] std::unique_ptr<tr_dht> tr_dht::create(
@@ -5,12 +5,17 @@
 #include <array>
 #include <cerrno>
 #include <cstddef>
+#include <cstring> // std::memcpy()
+#include <memory>
 #include <string>
+#include <utility> // std::exchange()
+#include <vector>
 
 #ifdef _WIN32
 #include <ws2tcpip.h>
 #else
-#include <sys/socket.h> // setsockopt, SOL_SOCKET, bind
+#include <sys/socket.h> // setsockopt, SOL_SOCKET, bind, recvmmsg, sendmmsg
+#include <sys/uio.h> // iovec
 #endif
 
 #include <event2/event.h>
@@ -84,90 +89,266 @@ void set_socket_buffers(tr_socket_t fd, bool large)
     }
 }
 
-void event_callback(evutil_socket_t s, [[maybe_unused]] short type, void* vsession)
-{
-    TR_ASSERT(vsession != nullptr);
-    TR_ASSERT(type == EV_READ);
+// Large enough for any µTP, DHT, or UDP tracker datagram we expect to see.
+// One byte is kept in reserve for libdht's zero terminator.
+auto constexpr MaxDatagramSize = size_t{ 8192U };
 
-    auto buf = std::array<unsigned char, 8192>{};
-    auto from = sockaddr_storage{};
-    auto fromlen = socklen_t{ sizeof(from) };
-    auto* const from_sa = reinterpret_cast<sockaddr*>(&from);
-    auto* const session = static_cast<tr_session*>(vsession);
-    auto got_utp_packet = false;
+#ifdef HAVE_RECVMMSG
+// How many datagrams to read per recvmmsg() call
+auto constexpr RecvBatchSize = size_t{ 32U };
+#endif
 
-    auto const from_str = [from_sa]
+#ifdef HAVE_SENDMMSG
+// How many datagrams to queue per socket before flushing with sendmmsg().
+// Datagrams larger than MaxQueuedDatagramSize bypass the queue.
+auto constexpr SendBatchSize = size_t{ 64U };
+auto constexpr MaxQueuedDatagramSize = size_t{ 1500U };
+#endif
+} // namespace
+
+// ---
+
+struct tr_session::tr_udp_core::RecvBatch
+{
+#ifdef HAVE_RECVMMSG
+    std::array<std::array<unsigned char, MaxDatagramSize>, RecvBatchSize> bufs = {};
+    std::array<sockaddr_storage, RecvBatchSize> froms = {};
+    std::array<iovec, RecvBatchSize> iovs = {};
+    std::array<mmsghdr, RecvBatchSize> msgs = {};
+#endif
+};
+
+struct tr_session::tr_udp_core::SendQueue
+{
+#ifdef HAVE_SENDMMSG
+    struct Datagram
     {
-        return tr_socket_address::from_sockaddr(from_sa).value_or(tr_socket_address{}).display_name();
+        sockaddr_storage to = {};
+        socklen_t tolen = {};
+        size_t len = {};
+        std::array<char, MaxQueuedDatagramSize> buf = {};
     };
 
-    for (;;)
+    SendQueue()
     {
-        auto const n_read = recvfrom(s, reinterpret_cast<char*>(std::data(buf)), std::size(buf) - 1, 0, from_sa, &fromlen);
-        if (n_read <= 0)
+        queue4.reserve(SendBatchSize);
+        queue6.reserve(SendBatchSize);
+    }
+
+    [[nodiscard]] auto& queue(tr_socket_t sock, tr_udp_core const& core) noexcept
+    {
+        return sock == core.udp4_socket_ ? queue4 : queue6;
+    }
+
+    void flush(tr_socket_t sock, std::vector<Datagram>& datagrams) const
+    {
+        auto msgs = std::array<mmsghdr, SendBatchSize>{};
+        auto iovs = std::array<iovec, SendBatchSize>{};
+        auto const n_msgs = std::size(datagrams);
+        for (size_t i = 0; i < n_msgs; ++i)
         {
-            if (got_utp_packet)
-            {
-                // To reduce protocol overhead, we wait until we've read all UDP packets
-                // we can, then send one ACK for each µTP socket that received packet(s).
-                tr_utp_issue_deferred_acks(session);
-            }
-            return;
+            auto& datagram = datagrams[i];
+            iovs[i].iov_base = std::data(datagram.buf);
+            iovs[i].iov_len = datagram.len;
+            msgs[i].msg_hdr.msg_name = &datagram.to;
+            msgs[i].msg_hdr.msg_namelen = datagram.tolen;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
         }
 
-        // Since most packets we receive here are µTP, make quick inline
-        // checks for the other protocols. The logic is as follows:
-        // - all DHT packets start with 'd' (100)
-        // - all UDP tracker packets start with a 32-bit (!) "action", which
-        //   is between 0 and 3
-        // - the above cannot be µTP packets, since these start with a 4-bit
-        //   "type" between 0 and 4, followed by a 4-bit version number (1)
-        if (buf[0] == 'd')
+        for (size_t i = 0; i < n_msgs;)
         {
-            if (session->dht_)
+            auto const n_sent = sendmmsg(sock, &msgs[i], static_cast<unsigned int>(n_msgs - i), 0);
+            if (n_sent > 0)
             {
-                buf[n_read] = '\0'; // libdht requires zero-terminated messages
-                session->dht_->handle_message(std::data(buf), n_read, from_sa, fromlen);
+                i += static_cast<size_t>(n_sent);
+                continue;
             }
+
+            // sendmmsg() reports the error for the first unsent datagram;
+            // log it and move on to the next one.
+            auto const error_code = errno;
+            tr_logAddWarn(
+                fmt::format(
+                    "Couldn't send to {address}: {errno} ({error})",
+                    fmt::arg(
+                        "address",
+                        tr_socket_address::from_sockaddr(reinterpret_cast<sockaddr const*>(&datagrams[i].to))
+                            .value_or(tr_socket_address{})
+                            .display_name()),
+                    fmt::arg("errno", error_code),
+                    fmt::arg("error", tr_strerror(error_code))));
+            ++i;
+        }
+
+        datagrams.clear();
+    }
+
+    std::vector<Datagram> queue4;
+    std::vector<Datagram> queue6;
+#endif
+};
+
+// ---
+
+void tr_session::tr_udp_core::on_readable(evutil_socket_t s, [[maybe_unused]] short type, void* vself)
+{
+    TR_ASSERT(vself != nullptr);
+    TR_ASSERT(type == EV_READ);
+
+    static_cast<tr_udp_core*>(vself)->read_datagrams(static_cast<tr_socket_t>(s));
+}
+
+void tr_session::tr_udp_core::read_datagrams(tr_socket_t const sock)
+{
+    auto got_utp_packet = false;
+
+#ifdef HAVE_RECVMMSG
+    // Drain the socket in batches so that a busy µTP swarm
+    // costs one syscall per RecvBatchSize packets instead of one per packet.
+    auto& batch = *recv_batch_;
+    for (;;)
+    {
+        for (size_t i = 0; i < RecvBatchSize; ++i)
+        {
+            batch.iovs[i].iov_base = std::data(batch.bufs[i]);
+            batch.iovs[i].iov_len = MaxDatagramSize - 1U;
+            batch.msgs[i].msg_hdr.msg_name = &batch.froms[i];
+            batch.msgs[i].msg_hdr.msg_namelen = sizeof(batch.froms[i]);
+            batch.msgs[i].msg_hdr.msg_iov = &batch.iovs[i];
+            batch.msgs[i].msg_hdr.msg_iovlen = 1;
+            batch.msgs[i].msg_len = 0;
         }
-        else if (n_read >= 8 && buf[0] == 0 && buf[1] == 0 && buf[2] == 0 && buf[3] <= 3)
+
+        auto const n_msgs = recvmmsg(sock, std::data(batch.msgs), RecvBatchSize, 0, nullptr);
+        if (n_msgs <= 0)
         {
-            if (!session->announcer_udp_->handle_message(std::data(buf), n_read, from_sa, fromlen))
-            {
-                tr_logAddTrace(fmt::format("{} Couldn't parse UDP tracker packet.", from_str()));
-            }
+            break;
         }
-        else if (session->allowsUTP() && session->utp_context != nullptr)
+
+        for (size_t i = 0, n = static_cast<size_t>(n_msgs); i < n; ++i)
         {
-            if (tr_utp_packet(std::data(buf), n_read, from_sa, fromlen, session))
+            auto const& hdr = batch.msgs[i].msg_hdr;
+            if (auto const n_read = batch.msgs[i].msg_len; n_read > 0U)
             {
-                got_utp_packet = true;
-            }
-            else
-            {
-                tr_logAddTrace(
-                    fmt::format(
-                        "{} Unexpected UDP packet... len {} [{}]",
-                        from_str(),
-                        n_read,
-                        tr_base64_encode({ reinterpret_cast<char const*>(std::data(buf)), static_cast<size_t>(n_read) })));
+                auto* const from_sa = static_cast<sockaddr*>(hdr.msg_name);
+                got_utp_packet |= handle_datagram(std::data(batch.bufs[i]), n_read, from_sa, hdr.msg_namelen);
             }
         }
+
+        if (static_cast<size_t>(n_msgs) < RecvBatchSize)
+        {
+            break;
+        }
+    }
+#else
+    auto buf = std::array<unsigned char, MaxDatagramSize>{};
+    for (;;)
+    {
+        auto from = sockaddr_storage{};
+        auto fromlen = socklen_t{ sizeof(from) };
+        auto* const from_sa = reinterpret_cast<sockaddr*>(&from);
+        auto const n_read = recvfrom(sock, reinterpret_cast<char*>(std::data(buf)), std::size(buf) - 1, 0, from_sa, &fromlen);
+        if (n_read <= 0)
+        {
+            break;
+        }
+
+        got_utp_packet |= handle_datagram(std::data(buf), static_cast<size_t>(n_read), from_sa, fromlen);
+    }
+#endif
+
+    if (got_utp_packet)
+    {
+        // To reduce protocol overhead, we wait until we've read all UDP packets
+        // we can from both sockets, then send one ACK for each µTP socket that
+        // received packet(s) at the end of this event loop iteration.
+        utp_acks_pending_ = true;
+        event_active(deferred_event_.get(), 0, 0);
+    }
+}
+
+void tr_session::tr_udp_core::on_deferred(evutil_socket_t /*fd*/, short /*type*/, void* vself)
+{
+    auto* const self = static_cast<tr_udp_core*>(vself);
+
+    if (std::exchange(self->utp_acks_pending_, false))
+    {
+        tr_utp_issue_deferred_acks(&self->session_);
+    }
+
+    self->flush();
+}
+
+// Returns true if `buf` was a µTP packet.
+// `buf` must have room for one more byte past `n_read`.
+bool tr_session::tr_udp_core::handle_datagram(unsigned char* buf, size_t n_read, sockaddr* from_sa, socklen_t fromlen)
+{
+    auto const from_str = [from_sa]
+    {
+        return tr_socket_address::from_sockaddr(from_sa).value_or(tr_socket_address{}).display_name();
+    };
+
+    // Since most packets we receive here are µTP, make quick inline
+    // checks for the other protocols. The logic is as follows:
+    // - all DHT packets start with 'd' (100)
+    // - all UDP tracker packets start with a 32-bit (!) "action", which
+    //   is between 0 and 3
+    // - the above cannot be µTP packets, since these start with a 4-bit
+    //   "type" between 0 and 4, followed by a 4-bit version number (1)
+    if (buf[0] == 'd')
+    {
+        if (session_.dht_)
+        {
+            buf[n_read] = '\0'; // libdht requires zero-terminated messages
+            session_.dht_->handle_message(buf, n_read, from_sa, fromlen);
+        }
+    }
+    else if (n_read >= 8 && buf[0] == 0 && buf[1] == 0 && buf[2] == 0 && buf[3] <= 3)
+    {
+        if (!session_.announcer_udp_->handle_message(buf, n_read, from_sa, fromlen))
+        {
+            tr_logAddTrace(fmt::format("{} Couldn't parse UDP tracker packet.", from_str()));
+        }
+    }
+    else if (session_.allowsUTP() && session_.utp_context != nullptr)
+    {
+        if (tr_utp_packet(buf, n_read, from_sa, fromlen, &session_))
+        {
+            return true;
+        }
+
+        tr_logAddTrace(
+            fmt::format(
+                "{} Unexpected UDP packet... len {} [{}]",
+                from_str(),
+                n_read,
+                tr_base64_encode({ reinterpret_cast<char const*>(buf), n_read })));
     }
+
+    return false;
 }
-} // namespace
+
+// ---
 
 // BEP-32 explains why we need to bind to one IPv6 address
 
 tr_session::tr_udp_core::tr_udp_core(tr_session& session, tr_port udp_port)
     : udp_port_{ udp_port }
     , session_{ session }
+    , recv_batch_{ std::make_unique<RecvBatch>() }
 {
     if (std::empty(udp_port_))
     {
         return;
     }
 
+    deferred_event_.reset(tr::evhelpers::event_new_pri2(session_.event_base(), -1, 0, on_deferred, this));
+
+#ifdef HAVE_SENDMMSG
+    send_queue_ = std::make_unique<SendQueue>();
+#endif
+
     if (!session.has_ip_protocol(TR_AF_INET))
     {
         // no IPv4; do nothing
@@ -214,8 +395,8 @@ tr_session::tr_udp_core::tr_udp_core(tr_session& session, tr_port udp_port)
                     session_.event_base(),
                     static_cast<evutil_socket_t>(udp4_socket_),
                     EV_READ | EV_PERSIST,
-                    event_callback,
-                    &session_));
+                    on_readable,
+                    this));
             event_add(udp4_event_.get(), nullptr);
         }
     }
@@ -267,8 +448,8 @@ tr_session::tr_udp_core::tr_udp_core(tr_session& session, tr_port udp_port)
                     session_.event_base(),
                     static_cast<evutil_socket_t>(udp6_socket_),
                     EV_READ | EV_PERSIST,
-                    event_callback,
-                    &session_));
+                    on_readable,
+                    this));
             event_add(udp6_event_.get(), nullptr);
         }
     }
@@ -281,6 +462,10 @@ tr_session::tr_udp_core::tr_udp_core(tr_session& session, tr_port udp_port)
 
 tr_session::tr_udp_core::~tr_udp_core()
 {
+    deferred_event_.reset();
+    flush();
+    send_queue_.reset();
+
     udp6_event_.reset();
 
     if (is_valid_socket(udp6_socket_))
@@ -298,33 +483,98 @@ tr_session::tr_udp_core::~tr_udp_core()
     }
 }
 
-void tr_session::tr_udp_core::sendto(void const* buf, size_t buflen, struct sockaddr const* to, socklen_t const tolen) const
+void tr_session::tr_udp_core::sendto(void const* buf, size_t buflen, struct sockaddr const* to, socklen_t const tolen)
 {
     auto const addrport = tr_socket_address::from_sockaddr(to);
     if (to->sa_family != AF_INET && to->sa_family != AF_INET6)
     {
         errno = EAFNOSUPPORT;
+        tr_logAddWarn(
+            fmt::format(
+                "Couldn't send to {address}: {errno} ({error})",
+                fmt::arg("address", addrport ? addrport->display_name() : std::string{}),
+                fmt::arg("errno", errno),
+                fmt::arg("error", tr_strerror(errno))));
+        return;
     }
-    else if (auto const sock = to->sa_family == AF_INET ? udp4_socket_ : udp6_socket_; !is_valid_socket(sock))
+
+    auto const sock = to->sa_family == AF_INET ? udp4_socket_ : udp6_socket_;
+    if (!is_valid_socket(sock))
     {
         // don't warn on bad sockets; the system may not support IPv6
         return;
     }
-    else if (
-        addrport && !addrport->address().is_ipv4_loopback() && !addrport->address().is_ipv6_loopback() &&
+
+    if (addrport && !addrport->address().is_ipv4_loopback() && !addrport->address().is_ipv6_loopback() &&
         !session_.source_address(tr_af_to_ip_protocol(to->sa_family)))
     {
         // don't try to send if we don't have a route in this IP protocol
         return;
     }
+
+#ifdef HAVE_SENDMMSG
+    if (send_queue_ && buflen <= MaxQueuedDatagramSize && static_cast<size_t>(tolen) <= sizeof(sockaddr_storage))
+    {
+        auto& queue = send_queue_->queue(sock, *this);
+        if (std::size(queue) == SendBatchSize)
+        {
+            send_queue_->flush(sock, queue);
+        }
+
+        auto& datagram = queue.emplace_back();
+        std::memcpy(&datagram.to, to, tolen);
+        datagram.tolen = tolen;
+        datagram.len = buflen;
+        std::memcpy(std::data(datagram.buf), buf, buflen);
+
+        // flush at the end of this event loop iteration
+        event_active(deferred_event_.get(), 0, 0);
+        return;
+    }
+
+    // keep datagrams in order if this one can't be queued
+    flush();
+#endif
+
+    sendto_now(sock, buf, buflen, to, tolen);
+}
+
+void tr_session::tr_udp_core::flush()
+{
+#ifdef HAVE_SENDMMSG
+    if (!send_queue_)
+    {
+        return;
+    }
+
+    if (!std::empty(send_queue_->queue4))
+    {
+        send_queue_->flush(udp4_socket_, send_queue_->queue4);
+    }
+
+    if (!std::empty(send_queue_->queue6))
+    {
+        send_queue_->flush(udp6_socket_, send_queue_->queue6);
+    }
+#endif
+}
+
+void tr_session::tr_udp_core::sendto_now(
+    tr_socket_t const sock,
+    void const* buf,
+    size_t buflen,
+    struct sockaddr const* to,
+    socklen_t const tolen) const
+{
     // NOLINTNEXTLINE(readability-redundant-casting)
-    else if (::sendto(sock, static_cast<char const*>(buf), static_cast<TR_IF_WIN32(int, size_t)>(buflen), 0, to, tolen) != -1)
+    if (::sendto(sock, static_cast<char const*>(buf), static_cast<TR_IF_WIN32(int, size_t)>(buflen), 0, to, tolen) != -1)
     {
         return;
     }
 
+    auto const error_code = errno;
     auto display_name = std::string{};
-    if (addrport)
+    if (auto const addrport = tr_socket_address::from_sockaddr(to); addrport)
     {
         display_name = addrport->display_name();
     }
@@ -333,6 +583,6 @@ void tr_session::tr_udp_core::sendto(void const* buf, size_t buflen, struct sock
         fmt::format(
             "Couldn't send to {address}: {errno} ({error})",
             fmt::arg("address", display_name),
-            fmt::arg("errno", errno),
-            fmt::arg("error", tr_strerror(errno))));
+            fmt::arg("errno", error_code),
+            fmt::arg("error", tr_strerror(error_code))));
 }
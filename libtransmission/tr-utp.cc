@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <ctime>
 
 #include <fmt/format.h> // fmt::ptr
 
@@ -14,6 +15,7 @@
 
 #include "libtransmission/crypto-utils.h" // tr_rand_int()
 #include "libtransmission/log.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-socket-utp.h"
 #include "libtransmission/peer-socket.h"
@@ -55,6 +57,67 @@ namespace
 /* Greg says 50ms works for them. */
 auto constexpr UtpInterval = 50ms;
 
+// If no µTP packets have been sent or received for this long, every
+// socket has either been closed or timed out, so stop the timer until
+// the next packet comes or goes.
+auto constexpr UtpIdleSecs = time_t{ 60 };
+
+void restart_timer(tr_session* session)
+{
+    auto interval = std::chrono::milliseconds{};
+    auto const random_percent = tr_rand_int(1000U) / 1000.0;
+
+    if (session->allowsUTP())
+    {
+        static auto constexpr MinInterval = UtpInterval * 0.5;
+        static auto constexpr MaxInterval = UtpInterval * 1.5;
+        auto const target = MinInterval + random_percent * (MaxInterval - MinInterval);
+        interval = std::chrono::duration_cast<std::chrono::milliseconds>(target);
+    }
+    else
+    {
+        // If somebody has disabled µTP, then we still want to run
+        // utp_check_timeouts, in order to let closed sockets finish
+        // gracefully and so on.  However, since we're not particularly
+        // interested in that happening in a timely manner, we might as
+        // well use a large timeout.
+        static auto constexpr MinInterval = 2s;
+        static auto constexpr MaxInterval = 3s;
+        auto const target = MinInterval + random_percent * (MaxInterval - MinInterval);
+        interval = std::chrono::duration_cast<std::chrono::milliseconds>(target);
+    }
+
+    session->utp_timer->start_single_shot(interval);
+}
+
+void timer_callback(void* vsession)
+{
+    auto* session = static_cast<tr_session*>(vsession);
+
+    tr::metrics::add(tr::metrics::Counter::UtpTimerWakeups);
+    utp_check_timeouts(session->utp_context);
+
+    if (session->utp_last_activity() + UtpIdleSecs < tr_time())
+    {
+        tr_logAddTrace("No recent µTP activity; putting the µTP timer to sleep");
+        session->set_utp_timer_sleeping(true);
+        return;
+    }
+
+    restart_timer(session);
+}
+
+void wake_timer(tr_session* session)
+{
+    session->set_utp_last_activity(tr_time());
+
+    if (session->is_utp_timer_sleeping() && session->utp_timer)
+    {
+        session->set_utp_timer_sleeping(false);
+        restart_timer(session);
+    }
+}
+
 void utp_on_accept(tr_session* const session, UTPSocket* const utp_sock)
 {
     auto from_storage = sockaddr_storage{};
@@ -81,12 +144,14 @@ void utp_on_accept(tr_session* const session, UTPSocket* const utp_sock)
 }
 
 void utp_send_to(
-    tr_session const* const ss,
+    tr_session* const ss,
     uint8_t const* const buf,
     size_t const buflen,
     struct sockaddr const* const to,
     socklen_t const tolen)
 {
+    tr::metrics::add(tr::metrics::Counter::UtpPacketsOut);
+    wake_timer(ss);
     ss->udp_core_->sendto(buf, buflen, to, tolen);
 }
 
@@ -119,42 +184,6 @@ uint64 utp_callback(utp_callback_arguments* args)
 
     return 0;
 }
-
-void restart_timer(tr_session* session)
-{
-    auto interval = std::chrono::milliseconds{};
-    auto const random_percent = tr_rand_int(1000U) / 1000.0;
-
-    if (session->allowsUTP())
-    {
-        static auto constexpr MinInterval = UtpInterval * 0.5;
-        static auto constexpr MaxInterval = UtpInterval * 1.5;
-        auto const target = MinInterval + random_percent * (MaxInterval - MinInterval);
-        interval = std::chrono::duration_cast<std::chrono::milliseconds>(target);
-    }
-    else
-    {
-        // If somebody has disabled µTP, then we still want to run
-        // utp_check_timeouts, in order to let closed sockets finish
-        // gracefully and so on.  However, since we're not particularly
-        // interested in that happening in a timely manner, we might as
-        // well use a large timeout.
-        static auto constexpr MinInterval = 2s;
-        static auto constexpr MaxInterval = 3s;
-        auto const target = MinInterval + random_percent * (MaxInterval - MinInterval);
-        interval = std::chrono::duration_cast<std::chrono::milliseconds>(target);
-    }
-
-    session->utp_timer->start_single_shot(interval);
-}
-
-void timer_callback(void* vsession)
-{
-    auto* session = static_cast<tr_session*>(vsession);
-
-    utp_check_timeouts(session->utp_context);
-    restart_timer(session);
-}
 } // namespace
 
 void tr_utp_init(tr_session* session)
@@ -185,6 +214,9 @@ void tr_utp_init(tr_session* session)
 
     session->utp_context = ctx;
     session->utp_timer = session->timerMaker().create(timer_callback, session);
+    session->utp_timer->set_name("utp");
+    session->set_utp_last_activity(tr_time());
+    session->set_utp_timer_sleeping(false);
     restart_timer(session);
 }
 
@@ -192,6 +224,12 @@ bool tr_utp_packet(unsigned char const* buf, size_t buflen, struct sockaddr cons
 {
     auto const ret = utp_process_udp(ss->utp_context, buf, buflen, from, fromlen);
 
+    if (ret != 0)
+    {
+        tr::metrics::add(tr::metrics::Counter::UtpPacketsIn);
+        wake_timer(ss);
+    }
+
     return ret != 0;
 }
 
@@ -0,0 +1,218 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // int64_t
+#include <cstdlib> // free()
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+#include "libtransmission/quark.h"
+#include "libtransmission/tracer.h"
+#include "libtransmission/variant.h"
+
+using namespace std::literals;
+
+std::atomic<bool> tr::detail::tracer::enabled = false;
+
+namespace
+{
+using namespace tr::tracer;
+
+std::atomic<int64_t> threshold_usec = std::chrono::microseconds{ 10ms }.count();
+
+// The last `Capacity` slow events. Only slow events get here, so a lock is fine.
+class EventRing
+{
+public:
+    void push(Event&& event)
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+
+        if (std::size(events_) < Capacity)
+        {
+            events_.emplace_back(std::move(event));
+        }
+        else
+        {
+            events_[next_] = std::move(event);
+        }
+
+        next_ = (next_ + 1U) % Capacity;
+    }
+
+    [[nodiscard]] std::vector<Event> events() const
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+
+        auto ret = events_;
+        if (std::size(ret) == Capacity)
+        {
+            std::ranges::rotate(ret, std::begin(ret) + next_);
+        }
+        return ret;
+    }
+
+    void clear()
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+        events_.clear();
+        next_ = 0U;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Event> events_;
+    size_t next_ = 0U;
+};
+
+auto& event_ring{ *new EventRing{} };
+
+[[nodiscard]] std::string demangle(char const* const name)
+{
+#if __has_include(<cxxabi.h>)
+    auto status = int{};
+    auto const demangled = std::unique_ptr<char, void (*)(void*)>{ abi::__cxa_demangle(name, nullptr, nullptr, &status),
+                                                                   std::free };
+    if (status == 0 && demangled)
+    {
+        return demangled.get();
+    }
+#endif
+
+    // MSVC's names are already readable
+    return name;
+}
+} // namespace
+
+void tr::tracer::set_enabled(bool const enabled) noexcept
+{
+    tr::detail::tracer::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds tr::tracer::threshold() noexcept
+{
+    return std::chrono::microseconds{ threshold_usec.load(std::memory_order_relaxed) };
+}
+
+void tr::tracer::set_threshold(std::chrono::microseconds const threshold) noexcept
+{
+    threshold_usec.store(threshold.count(), std::memory_order_relaxed);
+}
+
+void tr::tracer::record(
+    Kind const kind,
+    std::string_view const name,
+    std::chrono::steady_clock::time_point const begin,
+    std::chrono::steady_clock::time_point const end,
+    std::chrono::steady_clock::duration const lag)
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+
+    auto const duration = std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
+    auto const lag_usec = std::max(std::chrono::duration_cast<std::chrono::microseconds>(lag), std::chrono::microseconds{});
+    if (auto const limit = threshold(); duration < limit && lag_usec < limit)
+    {
+        return;
+    }
+
+    auto event = Event{};
+    event.name = name;
+    event.begin = begin;
+    event.duration = duration;
+    event.lag = lag_usec;
+    event.kind = kind;
+    event_ring.push(std::move(event));
+}
+
+std::vector<tr::tracer::Event> tr::tracer::events()
+{
+    return event_ring.events();
+}
+
+void tr::tracer::clear()
+{
+    event_ring.clear();
+}
+
+std::string_view tr::tracer::kind_name(Kind const kind) noexcept
+{
+    switch (kind)
+    {
+    case Kind::Timer:
+        return "timer"sv;
+    case Kind::Task:
+        return "task"sv;
+    case Kind::PeerRead:
+        return "peer_read"sv;
+    case Kind::PeerWrite:
+        return "peer_write"sv;
+    case Kind::Rpc:
+        return "rpc"sv;
+    }
+
+    return "unknown"sv;
+}
+
+std::string_view tr::tracer::type_name(std::type_info const& type)
+{
+    static auto mutex = std::mutex{};
+    static auto& names = *new std::unordered_map<std::type_index, std::string>{};
+
+    auto const lock = std::scoped_lock{ mutex };
+    auto const [iter, added] = names.try_emplace(std::type_index{ type });
+    if (added)
+    {
+        iter->second = demangle(type.name());
+    }
+
+    return iter->second;
+}
+
+tr_variant tr::tracer::to_chrome_trace(std::vector<Event> const& events)
+{
+    auto trace_events = tr_variant::Vector{};
+    trace_events.reserve(std::size(events));
+    for (auto const& event : events)
+    {
+        auto args = tr_variant::Map{ 1U };
+        args.try_emplace(TR_KEY_lag_us, event.lag.count());
+
+        // a "complete" event, i.e. one with a duration
+        auto trace_event = tr_variant::Map{ 8U };
+        trace_event.try_emplace(TR_KEY_name, event.name);
+        trace_event.try_emplace(TR_KEY_cat, tr_variant::unmanaged_string(kind_name(event.kind)));
+        trace_event.try_emplace(TR_KEY_ph, tr_variant::unmanaged_string("X"sv));
+        trace_event.try_emplace(
+            TR_KEY_ts,
+            std::chrono::duration_cast<std::chrono::microseconds>(event.begin.time_since_epoch()).count());
+        trace_event.try_emplace(TR_KEY_dur, event.duration.count());
+        trace_event.try_emplace(TR_KEY_pid, 1);
+        trace_event.try_emplace(TR_KEY_tid, 1);
+        trace_event.try_emplace(TR_KEY_args, std::move(args));
+        trace_events.emplace_back(std::move(trace_event));
+    }
+
+    auto top = tr_variant::Map{ 1U };
+    top.try_emplace(TR_KEY_trace_events_camel, std::move(trace_events));
+    return tr_variant{ std::move(top) };
+}
@@ -0,0 +1,129 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+struct tr_variant;
+
+/**
+ * An opt-in tracer for finding out what blocks the session thread.
+ *
+ * When enabled, timer callbacks, queued tasks, peer IO callbacks and RPC
+ * methods are timestamped. The ones that ran longer than a threshold, or
+ * that started later than that after they were due, are kept in a ring
+ * buffer. That can be read with the `session_trace` RPC method or saved as
+ * a Chrome trace-event file, which chrome://tracing and Perfetto can open.
+ *
+ * When disabled, tracing a callback costs one relaxed atomic load.
+ */
+namespace tr::detail::tracer
+{
+extern std::atomic<bool> enabled;
+} // namespace tr::detail::tracer
+
+namespace tr::tracer
+{
+enum class Kind : uint8_t
+{
+    Timer,
+    Task,
+    PeerRead,
+    PeerWrite,
+    Rpc,
+};
+
+struct Event
+{
+    std::string name;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::microseconds duration = {};
+    std::chrono::microseconds lag = {}; // how long after it was due that it started
+    Kind kind = {};
+};
+
+// How many of the most recent slow events are kept
+inline auto constexpr Capacity = size_t{ 1024U };
+
+[[nodiscard]] inline bool is_enabled() noexcept
+{
+    return tr::detail::tracer::enabled.load(std::memory_order_relaxed);
+}
+
+void set_enabled(bool enabled) noexcept;
+
+[[nodiscard]] std::chrono::microseconds threshold() noexcept;
+void set_threshold(std::chrono::microseconds threshold) noexcept;
+
+// Keep an event if it was slow or late. No-op if tracing is disabled.
+void record(
+    Kind kind,
+    std::string_view name,
+    std::chrono::steady_clock::time_point begin,
+    std::chrono::steady_clock::time_point end,
+    std::chrono::steady_clock::duration lag = {});
+
+// The kept events, oldest first
+[[nodiscard]] std::vector<Event> events();
+
+void clear();
+
+[[nodiscard]] std::string_view kind_name(Kind kind) noexcept;
+
+// A readable name for a callable's type, e.g. the function that a lambda
+// was written in. The returned string lives as long as the program.
+[[nodiscard]] std::string_view type_name(std::type_info const& type);
+
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+[[nodiscard]] tr_variant to_chrome_trace(std::vector<Event> const& events);
+
+// Records the callback that runs during its lifetime.
+// `name` must outlive the span.
+class Span
+{
+public:
+    Span(Kind kind, std::string_view name, std::chrono::steady_clock::duration lag = {}) noexcept
+        : name_{ name }
+        , lag_{ lag }
+        , kind_{ kind }
+    {
+        if (is_enabled())
+        {
+            begin_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~Span()
+    {
+        if (begin_ != std::chrono::steady_clock::time_point{})
+        {
+            record(kind_, name_, begin_, std::chrono::steady_clock::now(), lag_);
+        }
+    }
+
+    Span(Span const&) = delete;
+    Span(Span&&) = delete;
+    Span& operator=(Span const&) = delete;
+    Span& operator=(Span&&) = delete;
+
+private:
+    std::string_view const name_;
+    std::chrono::steady_clock::time_point begin_;
+    std::chrono::steady_clock::duration const lag_;
+    Kind const kind_;
+};
+} // namespace tr::tracer
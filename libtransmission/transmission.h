@@ -488,6 +488,20 @@ size_t tr_sessionLoadTorrents(tr_session* session, tr_ctor* ctor);
  */
 size_t tr_sessionGetAllTorrents(tr_session* session, tr_torrent** buf, size_t buflen);
 
+/**
+ * Get the ids of the torrents whose stats may have changed since `since`.
+ *
+ * A torrent is marked as changed when its state, progress, peers, errors
+ * or settings change, and while it's transferring data. This lets clients
+ * refresh only those torrents instead of polling all of them.
+ *
+ * Speeds decay for a couple of seconds after a transfer stops, so clients
+ * should overlap the windows they ask about by a few seconds.
+ *
+ * @param since a time from `tr_time()`. Torrents changed after it are returned.
+ */
+[[nodiscard]] std::vector<tr_torrent_id_t> tr_sessionGetTorrentsChangedSince(tr_session* session, time_t since);
+
 // ---
 
 [[nodiscard]] std::string tr_sessionGetScript(tr_session const* session, TrScript type);
@@ -564,6 +564,13 @@ struct tr_stat
     // @see `tr_stat.activity`
     float recheck_progress = {};
 
+    // When the torrent's files are being moved to a new location,
+    // how many bytes have been copied so far and how many there are
+    // in total. Both are 0 when no move is in progress, or when
+    // the move is a rename that doesn't need to copy anything.
+    uint64_t relocation_bytes_done = {};
+    uint64_t relocation_bytes_total = {};
+
     // How much has been downloaded of the entire torrent.
     // Range is [0..1]
     float percent_complete = {};
@@ -17,6 +17,7 @@
 
 #include "libtransmission/crypto-utils.h"
 #include "libtransmission/file.h"
+#include "libtransmission/metrics.h"
 #include "libtransmission/types.h"
 #include "libtransmission/verify.h"
 
@@ -74,6 +75,7 @@ void tr_verify_worker::verify_torrent(
             {
                 bytes_this_pass = num_read;
                 sha.add(std::data(buffer), bytes_this_pass);
+                tr::metrics::add(tr::metrics::Counter::VerifyBytes, bytes_this_pass);
             }
         }
 
@@ -88,6 +90,7 @@ void tr_verify_worker::verify_torrent(
         {
             auto const has_piece = sha.finish() == metainfo.piece_hash(piece);
             verify_mediator.on_piece_checked(piece, has_piece);
+            tr::metrics::add(tr::metrics::Counter::VerifyPieces);
 
             if (sleep_per_seconds_during_verify > std::chrono::milliseconds::zero())
             {
@@ -19,6 +19,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "libtransmission/timer.h"
 #include "libtransmission/watchdir.h"
@@ -29,7 +30,7 @@ namespace tr::impl
 class BaseWatchdir : public Watchdir
 {
 public:
-    BaseWatchdir(std::string_view dirname, Callback callback, TimerMaker& timer_maker)
+    BaseWatchdir(std::string_view dirname, BatchCallback callback, TimerMaker& timer_maker)
         : dirname_{ dirname }
         , callback_{ std::move(callback) }
         , retry_timer_{ timer_maker.create() }
@@ -72,11 +73,32 @@ public:
         {
             setNextKickTime(info);
         }
+
+        retry_timer_at_.reset();
+        restartTimerIfPending();
+    }
+
+    [[nodiscard]] auto handledCount() const noexcept
+    {
+        return std::size(handled_);
+    }
+
+    [[nodiscard]] auto pendingCount() const noexcept
+    {
+        return std::size(pending_);
     }
 
 protected:
+    // List the whole directory and process any new files in it.
+    // Files that are gone from the directory are forgotten.
     void scan();
-    void processFile(std::string_view basename);
+
+    // Process files that may be new, e.g. from filesystem events
+    void processFiles(std::vector<std::string> basenames);
+
+    // Forget a file that was removed or renamed away,
+    // so that a new file with the same name gets processed
+    void forgetFile(std::string_view basename);
 
 private:
     using Timestamp = std::chrono::time_point<std::chrono::steady_clock>;
@@ -111,12 +133,20 @@ private:
 
     void restartTimerIfPending()
     {
+        // New retries are due no sooner than the ones already pending,
+        // so an already-started timer doesn't need to be moved up
+        if (retry_timer_at_)
+        {
+            return;
+        }
+
         if (auto next_kick_time = nextKickTime(); next_kick_time)
         {
             using namespace std::chrono;
             auto const now = steady_clock::now();
             auto duration = duration_cast<milliseconds>(*next_kick_time - now);
-            retry_timer_->start_single_shot(duration);
+            retry_timer_->start_single_shot(std::max(duration, milliseconds{}));
+            retry_timer_at_ = *next_kick_time;
         }
     }
 
@@ -124,27 +154,25 @@ private:
     {
         using namespace std::chrono;
         auto const now = steady_clock::now();
+        retry_timer_at_.reset();
 
-        auto tmp = decltype(pending_){};
-        std::swap(tmp, pending_);
-        for (auto const& [basename, info] : tmp)
+        auto due = std::vector<std::string>{};
+        for (auto const& [basename, info] : pending_)
         {
             if (info.next_kick_at <= now)
             {
-                processFile(basename);
-            }
-            else
-            {
-                pending_.try_emplace(basename, info);
+                due.emplace_back(basename);
             }
         }
 
+        processFiles(std::move(due));
         restartTimerIfPending();
     }
 
     std::string const dirname_;
-    Callback const callback_;
+    BatchCallback const callback_;
     std::unique_ptr<Timer> const retry_timer_;
+    std::optional<Timestamp> retry_timer_at_;
 
     std::map<std::string, Pending, std::less<>> pending_;
     std::set<std::string, std::less<>> handled_;
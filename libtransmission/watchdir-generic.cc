@@ -23,7 +23,7 @@ class GenericWatchdir final : public impl::BaseWatchdir
 public:
     GenericWatchdir(
         std::string_view dirname,
-        Callback callback,
+        BatchCallback callback,
         tr::TimerMaker& timer_maker,
         std::chrono::milliseconds rescan_interval)
         : BaseWatchdir{ dirname, std::move(callback), timer_maker }
@@ -42,7 +42,7 @@ private:
 
 std::unique_ptr<Watchdir> Watchdir::create_generic(
     std::string_view dirname,
-    Callback callback,
+    BatchCallback callback,
     tr::TimerMaker& timer_maker,
     std::chrono::milliseconds rescan_interval)
 {
@@ -53,7 +53,7 @@ std::unique_ptr<Watchdir> Watchdir::create_generic(
 // no native impl, so use generic
 std::unique_ptr<Watchdir> Watchdir::create(
     std::string_view dirname,
-    Callback callback,
+    BatchCallback callback,
     tr::TimerMaker& timer_maker,
     struct event_base* /*evbase*/)
 {
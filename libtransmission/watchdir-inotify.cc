@@ -10,6 +10,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <unistd.h> /* close() */
 
@@ -42,10 +43,14 @@ namespace
 class INotifyWatchdir final : public impl::BaseWatchdir
 {
 private:
-    static auto constexpr InotifyWatchMask = uint32_t{ IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE };
+    // Wait for new files to be closed instead of handling them on IN_CREATE,
+    // since they're probably still being written then
+    static auto constexpr InotifyAddedMask = uint32_t{ IN_CLOSE_WRITE | IN_MOVED_TO };
+    static auto constexpr InotifyRemovedMask = uint32_t{ IN_DELETE | IN_MOVED_FROM };
+    static auto constexpr InotifyWatchMask = uint32_t{ InotifyAddedMask | InotifyRemovedMask };
 
 public:
-    INotifyWatchdir(std::string_view dirname, Callback callback, TimerMaker& timer_maker, event_base* evbase)
+    INotifyWatchdir(std::string_view dirname, BatchCallback callback, TimerMaker& timer_maker, event_base* evbase)
         : BaseWatchdir{ dirname, std::move(callback), timer_maker }
     {
         init(evbase);
@@ -133,6 +138,7 @@ private:
     {
         auto ev = inotify_event{};
         auto name = std::string{};
+        auto added = std::vector<std::string>{};
 
         // Read the size of the struct excluding name into buf.
         // Guaranteed to have at least sizeof(ev) available.
@@ -149,6 +155,15 @@ private:
                 break;
             }
 
+            // events were dropped, so look for new files the hard way
+            if ((ev.mask & IN_Q_OVERFLOW) != 0)
+            {
+                tr_logAddDebug(fmt::format("inotify queue overflowed; rescanning '{:s}'", dirname()));
+                added.clear();
+                scan();
+                continue;
+            }
+
             TR_ASSERT(ev.wd == inwd_);
             TR_ASSERT((ev.mask & InotifyWatchMask) != 0);
             TR_ASSERT(ev.len > 0);
@@ -168,9 +183,21 @@ private:
             }
 
             // NB: `name` may have extra trailing zeroes from inotify;
-            // pass the c_str() so that processFile gets the right strlen
-            processFile(std::data(name));
+            // use the c_str() so that we get the right strlen
+            auto const basename = std::string_view{ std::data(name) };
+            if ((ev.mask & InotifyRemovedMask) != 0)
+            {
+                std::erase(added, basename);
+                forgetFile(basename);
+            }
+            else
+            {
+                added.emplace_back(basename);
+            }
         }
+
+        // handle everything that arrived together as one batch
+        processFiles(std::move(added));
     }
 
     int infd_ = -1;
@@ -182,7 +209,7 @@ private:
 
 std::unique_ptr<Watchdir> Watchdir::create(
     std::string_view dirname,
-    Callback callback,
+    BatchCallback callback,
     tr::TimerMaker& timer_maker,
     event_base* evbase)
 {
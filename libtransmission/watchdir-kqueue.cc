@@ -36,7 +36,7 @@ namespace
 class KQueueWatchdir final : public impl::BaseWatchdir
 {
 public:
-    KQueueWatchdir(std::string_view dirname, Callback callback, tr::TimerMaker& timer_maker, event_base* evbase)
+    KQueueWatchdir(std::string_view dirname, BatchCallback callback, tr::TimerMaker& timer_maker, event_base* evbase)
         : BaseWatchdir{ dirname, std::move(callback), timer_maker }
     {
         init(evbase);
@@ -166,7 +166,7 @@ private:
 
 std::unique_ptr<Watchdir> Watchdir::create(
     std::string_view dirname,
-    Callback callback,
+    BatchCallback callback,
     TimerMaker& timer_maker,
     event_base* evbase)
 {
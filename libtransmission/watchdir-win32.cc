@@ -7,7 +7,9 @@
 #include <cerrno>
 #include <cstddef> // for offsetof
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <process.h> // for _beginthreadex()
 
@@ -82,7 +84,7 @@ BOOL tr_get_overlapped_result_ex(
 class Win32Watchdir final : public impl::BaseWatchdir
 {
 public:
-    Win32Watchdir(std::string_view dirname, Callback callback, tr::TimerMaker& timer_maker, struct event_base* event_base)
+    Win32Watchdir(std::string_view dirname, BatchCallback callback, tr::TimerMaker& timer_maker, struct event_base* event_base)
         : BaseWatchdir{ dirname, std::move(callback), timer_maker }
     {
         init(event_base);
@@ -274,6 +276,8 @@ private:
 
         size_t const header_size = offsetof(FILE_NOTIFY_INFORMATION, FileName);
 
+        auto added = std::vector<std::string>{};
+
         // Read the size of the struct excluding name into buf.
         // Guaranteed to have at least sizeof(*ev) available
         for (;;)
@@ -319,16 +323,26 @@ private:
                 break;
             }
 
+            auto const name = tr_win32_native_to_utf8({ ev->FileName, ev->FileNameLength / sizeof(WCHAR) });
+            if (std::empty(name))
+            {
+                continue;
+            }
+
             if (ev->Action == FILE_ACTION_ADDED || ev->Action == FILE_ACTION_MODIFIED ||
                 ev->Action == FILE_ACTION_RENAMED_NEW_NAME)
             {
-                if (auto const name = tr_win32_native_to_utf8({ ev->FileName, ev->FileNameLength / sizeof(WCHAR) });
-                    !std::empty(name))
-                {
-                    processFile(name);
-                }
+                added.emplace_back(name);
+            }
+            else if (ev->Action == FILE_ACTION_REMOVED || ev->Action == FILE_ACTION_RENAMED_OLD_NAME)
+            {
+                std::erase(added, name);
+                forgetFile(name);
             }
         }
+
+        // handle everything that arrived together as one batch
+        processFiles(std::move(added));
     }
 
     HANDLE fd_ = INVALID_HANDLE_VALUE;
@@ -343,7 +357,7 @@ private:
 
 std::unique_ptr<Watchdir> Watchdir::create(
     std::string_view dirname,
-    Callback callback,
+    BatchCallback callback,
     TimerMaker& timer_maker,
     struct event_base* evbase)
 {
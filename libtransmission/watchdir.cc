@@ -3,9 +3,13 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef> // size_t
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -15,6 +19,7 @@
 #include "libtransmission/error.h"
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
+#include "libtransmission/tr-assert.h"
 #include "libtransmission/tr-strbuf.h"
 #include "libtransmission/utils.h" // for _()
 #include "libtransmission/watchdir-base.h"
@@ -64,54 +69,92 @@ namespace
 namespace impl
 {
 
-void BaseWatchdir::processFile(std::string_view basename)
+void BaseWatchdir::processFiles(std::vector<std::string> basenames)
 {
-    if (!isRegularFile(dirname_, basename) || handled_.contains(basename))
+    std::ranges::sort(basenames);
+    auto const [first, last] = std::ranges::unique(basenames);
+    basenames.erase(first, last);
+
+    // Skip files that were already added or aren't torrent candidates anymore,
+    // and stop retrying them so that their retry times don't keep the timer busy
+    std::erase_if(
+        basenames,
+        [this](auto const& basename)
+        {
+            if (handled_.contains(basename) || !isRegularFile(dirname_, basename))
+            {
+                pending_.erase(basename);
+                return true;
+            }
+
+            return false;
+        });
+
+    if (std::empty(basenames))
     {
         return;
     }
 
-    auto const action = callback_(dirname_, basename);
-    tr_logAddDebug(fmt::format("Callback decided to {:s} file '{:s}'", actionToString(action), basename));
-    if (action == Action::Retry)
-    {
-        auto const [iter, added] = pending_.try_emplace(std::string{ basename });
-
-        auto const now = std::chrono::steady_clock::now();
-        auto& info = iter->second;
-        ++info.strikes;
-        info.last_kick_at = now;
+    auto const actions = callback_(dirname_, basenames);
+    TR_ASSERT(std::size(actions) == std::size(basenames));
 
-        if (info.first_kick_at == Timestamp{})
-        {
-            info.first_kick_at = now;
-        }
+    auto const now = std::chrono::steady_clock::now();
+    for (size_t i = 0, n = std::min(std::size(actions), std::size(basenames)); i < n; ++i)
+    {
+        auto const& basename = basenames[i];
+        auto const action = actions[i];
+        tr_logAddDebug(fmt::format("Callback decided to {:s} file '{:s}'", actionToString(action), basename));
 
-        if (now - info.first_kick_at > timeoutDuration())
+        if (action == Action::Retry)
         {
-            tr_logAddWarn(fmt::format(fmt::runtime(_("Couldn't add torrent file '{path}'")), fmt::arg("path", basename)));
-            pending_.erase(iter);
+            auto const [iter, added] = pending_.try_emplace(basename);
+
+            auto& info = iter->second;
+            ++info.strikes;
+            info.last_kick_at = now;
+
+            if (info.first_kick_at == Timestamp{})
+            {
+                info.first_kick_at = now;
+            }
+
+            if (now - info.first_kick_at > timeoutDuration())
+            {
+                tr_logAddWarn(fmt::format(fmt::runtime(_("Couldn't add torrent file '{path}'")), fmt::arg("path", basename)));
+                pending_.erase(iter);
+            }
+            else
+            {
+                setNextKickTime(info);
+            }
         }
-        else
+        else if (action == Action::Done)
         {
-            setNextKickTime(info);
-            restartTimerIfPending();
+            pending_.erase(basename);
+            handled_.emplace(basename);
         }
     }
-    else if (action == Action::Done)
+
+    restartTimerIfPending();
+}
+
+void BaseWatchdir::forgetFile(std::string_view basename)
+{
+    if (auto const iter = handled_.find(basename); iter != std::end(handled_))
+    {
+        handled_.erase(iter);
+    }
+
+    if (auto const iter = pending_.find(basename); iter != std::end(pending_))
     {
-        handled_.emplace(basename);
+        pending_.erase(iter);
     }
 }
 
 void BaseWatchdir::scan()
 {
     auto error = tr_error{};
-
-    for (auto const& file : tr_sys_dir_get_files(dirname_, tr_basename_is_not_dotfile, &error))
-    {
-        processFile(file);
-    }
+    auto basenames = tr_sys_dir_get_files(dirname_, tr_basename_is_not_dotfile, &error);
 
     if (error)
     {
@@ -121,7 +164,19 @@ void BaseWatchdir::scan()
                 fmt::arg("path", dirname()),
                 fmt::arg("error", error.message()),
                 fmt::arg("error_code", error.code())));
+        return;
     }
+
+    // forget the files that aren't there anymore
+    std::ranges::sort(basenames);
+    auto const is_gone = [&basenames](auto const& basename)
+    {
+        return !std::ranges::binary_search(basenames, basename);
+    };
+    std::erase_if(handled_, is_gone);
+    std::erase_if(pending_, [&is_gone](auto const& item) { return is_gone(item.first); });
+
+    processFiles(std::move(basenames));
 }
 
 } // namespace impl
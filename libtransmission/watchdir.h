@@ -8,7 +8,10 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 struct event_base;
 
@@ -28,6 +31,12 @@ public:
 
     using Callback = std::function<Action(std::string_view dirname, std::string_view basename)>;
 
+    // Called with all the new files that were found together, e.g. by a scan or
+    // by one burst of filesystem events, so that they can be handled in bulk.
+    // Returns an Action for each of the files.
+    using BatchCallback = std::function<
+        std::vector<Action>(std::string_view dirname, std::vector<std::string> const& basenames)>;
+
     Watchdir() = default;
     virtual ~Watchdir() = default;
     Watchdir(Watchdir&&) = delete;
@@ -49,17 +58,49 @@ public:
 
     [[nodiscard]] static std::unique_ptr<Watchdir> create(
         std::string_view dirname,
-        Callback callback,
+        BatchCallback callback,
         tr::TimerMaker& timer_maker,
         struct event_base* evbase);
 
-    [[nodiscard]] static std::unique_ptr<Watchdir> create_generic(
+    [[nodiscard]] static std::unique_ptr<Watchdir> create(
         std::string_view dirname,
         Callback callback,
         tr::TimerMaker& timer_maker,
+        struct event_base* evbase)
+    {
+        return create(dirname, to_batch_callback(std::move(callback)), timer_maker, evbase);
+    }
+
+    [[nodiscard]] static std::unique_ptr<Watchdir> create_generic(
+        std::string_view dirname,
+        BatchCallback callback,
+        tr::TimerMaker& timer_maker,
         std::chrono::milliseconds rescan_interval = generic_rescan_interval_);
 
+    [[nodiscard]] static std::unique_ptr<Watchdir> create_generic(
+        std::string_view dirname,
+        Callback callback,
+        tr::TimerMaker& timer_maker,
+        std::chrono::milliseconds rescan_interval = generic_rescan_interval_)
+    {
+        return create_generic(dirname, to_batch_callback(std::move(callback)), timer_maker, rescan_interval);
+    }
+
 private:
+    [[nodiscard]] static BatchCallback to_batch_callback(Callback callback)
+    {
+        return [callback = std::move(callback)](std::string_view dirname, std::vector<std::string> const& basenames)
+        {
+            auto actions = std::vector<Action>{};
+            actions.reserve(std::size(basenames));
+            for (auto const& basename : basenames)
+            {
+                actions.emplace_back(callback(dirname, basename));
+            }
+            return actions;
+        };
+    }
+
     // NOLINTNEXTLINE(readability-identifier-naming)
     static inline auto generic_rescan_interval_ = std::chrono::milliseconds{ 1000 };
 };
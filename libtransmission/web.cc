@@ -23,6 +23,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -217,8 +218,7 @@ public:
             this->user_agent = *ua;
         }
 
-        auto const lock = std::unique_lock{ tasks_mutex_ };
-        curl_thread = std::make_unique<std::thread>(&Impl::curlThreadFunc, this);
+        set_worker_count(mediator.worker_count());
     }
 
     Impl(Impl&&) = delete;
@@ -229,14 +229,20 @@ public:
     ~Impl()
     {
         deadline_ns_ = to_ns(mediator.now());
-        queued_tasks_cv_.notify_one();
-        curl_thread->join();
+
+        // join the worker threads before tearing down the share handle they use
+        workers_.clear();
     }
 
     void startShutdown(std::chrono::milliseconds deadline)
     {
         deadline_ns_ = to_ns(mediator.now() + deadline);
-        queued_tasks_cv_.notify_one();
+
+        auto const lock = std::scoped_lock{ workers_mutex_ };
+        for (auto& worker : workers_)
+        {
+            worker->notify();
+        }
     }
 
     void fetch(FetchOptions&& options)
@@ -246,25 +252,49 @@ public:
             return;
         }
 
-        auto const lock = std::unique_lock{ tasks_mutex_ };
-        queued_tasks_.emplace_back(*this, std::move(options));
-        queued_tasks_cv_.notify_one();
+        auto const lock = std::scoped_lock{ workers_mutex_ };
+        worker_for(options.priority).fetch(std::move(options));
     }
 
     [[nodiscard]] bool is_idle() const noexcept
     {
-        return std::empty(queued_tasks_) && std::empty(running_tasks_);
+        auto const lock = std::scoped_lock{ workers_mutex_ };
+        return std::ranges::all_of(workers_, [](auto const& worker) { return worker->is_idle(); });
+    }
+
+    // Workers that aren't needed anymore are kept until shutdown,
+    // so that their transfers can finish, and reused if the count goes back up.
+    void set_worker_count(size_t n_workers)
+    {
+        n_workers = std::clamp(n_workers, size_t{ 1U }, MaxWorkers);
+
+        auto const lock = std::scoped_lock{ workers_mutex_ };
+        while (std::size(workers_) < n_workers)
+        {
+            workers_.emplace_back(std::make_unique<Worker>(*this));
+        }
+        n_workers_ = n_workers;
     }
 
+    [[nodiscard]] size_t worker_count() const
+    {
+        auto const lock = std::scoped_lock{ workers_mutex_ };
+        return n_workers_;
+    }
+
+    class Worker;
+
     class Task
     {
     public:
-        Task(tr_web::Impl& impl_in, tr_web::FetchOptions&& options_in)
-            : impl{ impl_in }
+        Task(Worker& worker_in, tr_web::FetchOptions&& options_in)
+            : impl{ worker_in.impl }
+            , worker{ worker_in }
             , options_{ std::move(options_in) }
         {
             auto const parsed = tr_urlParse(options_.url);
-            easy_ = parsed ? impl.get_easy(parsed->host) : nullptr;
+            host_ = parsed ? parsed->host : ""sv;
+            easy_ = parsed ? worker.get_easy(host_) : nullptr;
 
             response.user_data = options_.done_func_user_data;
 
@@ -303,11 +333,21 @@ public:
             return options_.url;
         }
 
+        [[nodiscard]] constexpr auto const& host() const
+        {
+            return host_;
+        }
+
         [[nodiscard]] constexpr auto const& range() const
         {
             return options_.range;
         }
 
+        [[nodiscard]] constexpr auto priority() const
+        {
+            return options_.priority;
+        }
+
         [[nodiscard]] constexpr auto const& cookies() const
         {
             return options_.cookies;
@@ -388,6 +428,7 @@ public:
         }
 
         tr_web::Impl& impl;
+        Worker& worker;
         tr_web::FetchResponse response;
 
     private:
@@ -398,12 +439,12 @@ public:
                 return;
             }
 
-            impl.paused_easy_handles.erase(easy_);
+            worker.paused_easy_handles.erase(easy_);
 
             if (auto const url = tr_urlParse(options_.url); url)
             {
                 curl_easy_reset(easy);
-                impl.easy_pool_[std::string{ url->host }].emplace(easy);
+                worker.easy_pool[std::string{ url->host }].emplace(easy);
             }
             else
             {
@@ -413,9 +454,302 @@ public:
 
         tr_web::FetchOptions options_;
 
+        std::string host_;
+
         CURL* easy_;
     };
 
+    // A thread with its own curl multi handle that runs a share of the transfers.
+    // Workers share the DNS, TLS session, and cookie caches through `curlsh_`.
+    class Worker
+    {
+    public:
+        explicit Worker(Impl& impl_in)
+            : impl{ impl_in }
+        {
+            auto const lock = std::unique_lock{ tasks_mutex_ };
+            thread_ = std::thread{ &Worker::thread_func, this };
+        }
+
+        Worker(Worker&&) = delete;
+        Worker(Worker const&) = delete;
+        Worker& operator=(Worker&&) = delete;
+        Worker& operator=(Worker const&) = delete;
+
+        ~Worker()
+        {
+            notify();
+            thread_.join();
+        }
+
+        void notify()
+        {
+            queued_tasks_cv_.notify_one();
+        }
+
+        void fetch(FetchOptions&& options)
+        {
+            auto const lock = std::unique_lock{ tasks_mutex_ };
+
+            // keep the queue sorted by priority, first-come first-served within each one
+            auto const pos = std::ranges::find_if(
+                queued_tasks_,
+                [priority = options.priority](Task const& task) { return task.priority() > priority; });
+            queued_tasks_.emplace(pos, *this, std::move(options));
+            ++n_tasks_;
+            queued_tasks_cv_.notify_one();
+        }
+
+        [[nodiscard]] bool is_idle() const noexcept
+        {
+            return std::empty(queued_tasks_) && std::empty(running_tasks_);
+        }
+
+        // number of queued and running tasks
+        [[nodiscard]] size_t n_tasks() const noexcept
+        {
+            return n_tasks_;
+        }
+
+        [[nodiscard]] bool is_current_thread() const noexcept
+        {
+            return std::this_thread::get_id() == thread_.get_id();
+        }
+
+        [[nodiscard]] CURL* get_easy(std::string_view host)
+        {
+            CURL* easy = nullptr;
+
+            if (auto iter = easy_pool.find(host); iter != std::end(easy_pool) && !std::empty(iter->second))
+            {
+                easy = iter->second.top().release();
+                iter->second.pop();
+            }
+
+            if (easy == nullptr)
+            {
+                easy = curl_easy_init();
+            }
+
+            return easy;
+        }
+
+        Impl& impl;
+
+        std::map<std::string /*host*/, std::stack<curl_helpers::easy_unique_ptr>, std::less<>> easy_pool;
+
+        std::map<CURL*, uint64_t /*tr_time_msec()*/> paused_easy_handles;
+
+    private:
+        void resume_paused_tasks()
+        {
+            TR_ASSERT(is_current_thread());
+
+            auto& paused = paused_easy_handles;
+            if (std::empty(paused))
+            {
+                return;
+            }
+
+            auto const now = tr_time_msec();
+
+            for (auto it = std::begin(paused); it != std::end(paused);)
+            {
+                if (it->second + BandwidthPauseMsec < now)
+                {
+                    curl_easy_pause(it->first, CURLPAUSE_CONT);
+                    it = paused.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        void remove_task(Task const& task)
+        {
+            auto const lock = std::unique_lock{ tasks_mutex_ };
+
+            auto const iter = std::ranges::find(running_tasks_, task);
+            TR_ASSERT(iter != std::ranges::end(running_tasks_));
+            if (iter == std::ranges::end(running_tasks_))
+            {
+                return;
+            }
+
+            if (auto const host = running_per_host_.find(iter->host());
+                host != std::end(running_per_host_) && --host->second == 0U)
+            {
+                running_per_host_.erase(host);
+            }
+
+            iter->done();
+            running_tasks_.erase(iter);
+            --n_tasks_;
+        }
+
+        void timeout_task(Task& task)
+        {
+            task.response.status = 408; // request timed out
+            task.response.did_timeout = true;
+            remove_task(task);
+        }
+
+        // the thread started by Worker.thread_ runs this function
+        void thread_func()
+        {
+            auto const multi = curl_helpers::multi_unique_ptr{ curl_multi_init() };
+#if LIBCURL_VERSION_NUM >= 0x071003 /* 7.16.3 */
+            (void)curl_multi_setopt(multi.get(), CURLMOPT_MAXCONNECTS, MaxCachedConnections);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x071E00 /* 7.30.0 */
+            (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, MaxTotalConnections);
+            (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, MaxHostConnections);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+            (void)curl_multi_setopt(
+                multi.get(),
+                CURLMOPT_PIPELINING,
+                impl.curl_avoid_http2 ? CURLPIPE_NOTHING : CURLPIPE_MULTIPLEX);
+#endif
+            auto const start_time = impl.mediator.now();
+
+            auto repeats = unsigned{};
+            for (;;)
+            {
+                if (impl.deadline_reached())
+                {
+                    while (!std::empty(running_tasks_))
+                    {
+                        auto& task = running_tasks_.front();
+                        curl_multi_remove_handle(multi.get(), task.easy());
+                        timeout_task(task);
+                    }
+
+                    // tasks still waiting for a free connection slot
+                    auto const lock = std::unique_lock{ tasks_mutex_ };
+                    for (auto& task : queued_tasks_)
+                    {
+                        task.response.status = 408; // request timed out
+                        task.response.did_timeout = true;
+                        task.done();
+                    }
+                    n_tasks_ -= std::size(queued_tasks_);
+                    queued_tasks_.clear();
+                }
+
+                if (impl.deadline_exists() && is_idle())
+                {
+                    break;
+                }
+
+                if (auto lock = std::unique_lock{ tasks_mutex_ }; lock.owns_lock())
+                {
+                    // sleep until there's something to do
+                    auto const stop_waiting = [this]()
+                    {
+                        return !is_idle() || !impl.deadline_exists();
+                    };
+                    if (!stop_waiting())
+                    {
+                        queued_tasks_cv_.wait(lock, stop_waiting);
+                    }
+
+                    // Add queued tasks, but don't give curl more tasks for a host than
+                    // it has connections for. Curl would park the extras in its pending
+                    // list with their timeouts already running, so a busy tracker would
+                    // see requests time out before they were even sent. Tasks to the
+                    // same host reuse its keep-alive or multiplexed connections.
+                    for (auto it = std::begin(queued_tasks_); it != std::end(queued_tasks_);)
+                    {
+                        auto& n_running = running_per_host_[it->host()];
+                        if (n_running >= static_cast<size_t>(MaxHostConnections))
+                        {
+                            ++it;
+                            continue;
+                        }
+
+                        ++n_running;
+                        impl.initEasy(*it);
+                        curl_multi_add_handle(multi.get(), it->easy());
+                        running_tasks_.splice(std::end(running_tasks_), queued_tasks_, it++);
+                    }
+                }
+
+                resume_paused_tasks();
+
+                // During steady state, wake up once per second.
+                // But during startup, wake up 10x more often. This is so tests
+                // that should take a few msec don't block for a full second
+                // while tr_session waits for this thread to finish.
+                static auto constexpr StartupSecs = std::chrono::seconds{ 15 };
+                auto const timeout_ms = impl.mediator.now() - start_time < StartupSecs ? 50 : 1000;
+
+                // Adapted from https://curl.se/libcurl/c/curl_multi_wait.html docs.
+                // 'numfds' being zero means either a timeout or no file descriptors to
+                // wait for. Try timeout on first occurrence, then assume no file
+                // descriptors and no file descriptors to wait for means wait for 100
+                // milliseconds.
+                auto numfds = int{};
+                curl_multi_wait(multi.get(), nullptr, 0, timeout_ms, &numfds);
+                if (numfds == 0)
+                {
+                    ++repeats;
+                    if (repeats > 1U)
+                    {
+                        std::this_thread::sleep_for(100ms);
+                    }
+                }
+                else
+                {
+                    repeats = 0;
+                }
+
+                // nonblocking update of the tasks
+                auto n_running = int{};
+                curl_multi_perform(multi.get(), &n_running);
+
+                // process any tasks that just finished
+                CURLMsg* msg = nullptr;
+                auto unused = int{};
+                while ((msg = curl_multi_info_read(multi.get(), &unused)) != nullptr)
+                {
+                    if (msg->msg == CURLMSG_DONE && msg->easy_handle != nullptr)
+                    {
+                        auto* const e = msg->easy_handle;
+
+                        Task* task = nullptr;
+                        curl_easy_getinfo(e, CURLINFO_PRIVATE, &task);
+
+                        auto req_bytes_sent = long{};
+                        auto total_time = double{};
+                        char* primary_ip = nullptr;
+                        curl_easy_getinfo(e, CURLINFO_REQUEST_SIZE, &req_bytes_sent);
+                        curl_easy_getinfo(e, CURLINFO_TOTAL_TIME, &total_time);
+                        curl_easy_getinfo(e, CURLINFO_RESPONSE_CODE, &task->response.status);
+                        curl_easy_getinfo(e, CURLINFO_PRIMARY_IP, &primary_ip);
+                        task->response.did_connect = task->response.status > 0 || req_bytes_sent > 0;
+                        task->response.did_timeout = task->response.status == 0 &&
+                            std::chrono::duration<double>(total_time) >= task->timeoutSecs();
+                        task->response.primary_ip = primary_ip;
+                        curl_multi_remove_handle(multi.get(), e);
+                        remove_task(*task);
+                    }
+                }
+            }
+        }
+
+        std::thread thread_;
+
+        std::mutex tasks_mutex_;
+        std::condition_variable queued_tasks_cv_;
+        std::list<Task> queued_tasks_;
+        std::list<Task> running_tasks_;
+        std::map<std::string /*host*/, size_t, std::less<>> running_per_host_;
+        std::atomic<size_t> n_tasks_ = {};
+    };
+
     [[nodiscard]] static unsigned int get_curl_version() noexcept
     {
         static auto const ver = curl_version_info(CURLVERSION_NOW)->version_num;
@@ -439,9 +773,11 @@ public:
     static auto constexpr BandwidthPauseMsec = long{ 500 };
     static auto constexpr DnsCacheTimeoutSecs = long{ 60 * 60 };
     static auto constexpr MaxRedirects = long{ 10 };
+    // These connection limits are per worker, since each has its own multi handle
     static auto constexpr MaxHostConnections = long{ 16 };
     static auto constexpr MaxTotalConnections = long{ 96 };
     static auto constexpr MaxCachedConnections = MaxTotalConnections;
+    static auto constexpr MaxWorkers = size_t{ 16 };
 
     bool const curl_verbose = tr_env_key_exists("TR_CURL_VERBOSE");
     bool const curl_ssl_verify = !tr_env_key_exists("TR_CURL_SSL_NO_VERIFY");
@@ -455,8 +791,6 @@ public:
     std::string cookie_file;
     std::string user_agent;
 
-    std::unique_ptr<std::thread> curl_thread;
-
     // if unset: steady-state, all is good
     // if set: do not accept new tasks
     // if set and deadline reached: kill all remaining tasks
@@ -485,29 +819,24 @@ public:
         return deadline_exists() && deadline_ns() <= to_ns(mediator.now());
     }
 
-    [[nodiscard]] CURL* get_easy(std::string_view host)
+    // Worker 0 handles everything but bulk transfers. Those are spread
+    // across the other workers so that they can't hold up tracker requests.
+    [[nodiscard]] Worker& worker_for(FetchOptions::Priority const priority)
     {
-        CURL* easy = nullptr;
-
-        if (auto iter = easy_pool_.find(host); iter != std::end(easy_pool_) && !std::empty(iter->second))
-        {
-            easy = iter->second.top().release();
-            iter->second.pop();
-        }
-
-        if (easy == nullptr)
+        if (priority != FetchOptions::Priority::Bulk || n_workers_ == 1U)
         {
-            easy = curl_easy_init();
+            return *workers_.front();
         }
 
-        return easy;
+        auto const bulk_workers = workers_ | std::views::take(n_workers_) | std::views::drop(1);
+        return **std::ranges::min_element(bulk_workers, std::less{}, [](auto const& worker) { return worker->n_tasks(); });
     }
 
     static size_t onDataReceived(void* data, size_t size, size_t nmemb, void* vtask)
     {
         size_t const bytes_used = size * nmemb;
         auto* task = static_cast<Task*>(vtask);
-        TR_ASSERT(std::this_thread::get_id() == task->impl.curl_thread->get_id());
+        TR_ASSERT(task->worker.is_current_thread());
 
         if (auto const range = task->range())
         {
@@ -543,7 +872,7 @@ public:
             // again when the transfer is unpaused.
             if (task->impl.mediator.clamp(*tag, bytes_used) < bytes_used)
             {
-                task->impl.paused_easy_handles.emplace(task->easy(), tr_time_msec());
+                task->worker.paused_easy_handles.emplace(task->easy(), tr_time_msec());
                 return CURL_WRITEFUNC_PAUSE;
             }
         }
@@ -555,7 +884,7 @@ public:
     static int onSocketCreated(void* vtask, curl_socket_t fd, curlsocktype /*purpose*/)
     {
         auto const* const task = static_cast<Task const*>(vtask);
-        TR_ASSERT(std::this_thread::get_id() == task->impl.curl_thread->get_id());
+        TR_ASSERT(task->worker.is_current_thread());
 
         // Ignore the sockopt() return values -- these are suggestions
         // rather than hard requirements & it's OK for them to fail
@@ -575,7 +904,7 @@ public:
 
     void initEasy(Task& task)
     {
-        TR_ASSERT(std::this_thread::get_id() == curl_thread->get_id());
+        TR_ASSERT(task.worker.is_current_thread());
         auto* const e = task.easy();
 
         (void)curl_easy_setopt(e, CURLOPT_SHARE, shared());
@@ -675,184 +1004,36 @@ public:
         {
             (void)curl_easy_setopt(e, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
         }
-    }
-
-    void resumePausedTasks()
-    {
-        TR_ASSERT(std::this_thread::get_id() == curl_thread->get_id());
-
-        auto& paused = paused_easy_handles;
-        if (std::empty(paused))
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+        else
         {
-            return;
+            // If the server speaks HTTP/2, wait to share its connection
+            // instead of opening a new one for every request
+            (void)curl_easy_setopt(e, CURLOPT_PIPEWAIT, 1L);
         }
+#endif
 
-        auto const now = tr_time_msec();
-
-        for (auto it = std::begin(paused); it != std::end(paused);)
-        {
-            if (it->second + BandwidthPauseMsec < now)
-            {
-                curl_easy_pause(it->first, CURLPAUSE_CONT);
-                it = paused.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
-        }
+#if LIBCURL_VERSION_NUM >= 0x071900 /* 7.25.0 */
+        // keep idle connections in the cache from being dropped by NATs
+        (void)curl_easy_setopt(e, CURLOPT_TCP_KEEPALIVE, 1L);
+#endif
     }
 
-    void remove_task(Task const& task)
-    {
-        auto const lock = std::unique_lock{ tasks_mutex_ };
+    // one per CURL_LOCK_DATA_* type, for the share handle's lock callbacks
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> share_mutexes_;
 
-        auto const iter = std::ranges::find(running_tasks_, task);
-        TR_ASSERT(iter != std::ranges::end(running_tasks_));
-        if (iter == std::ranges::end(running_tasks_))
-        {
-            return;
-        }
-
-        iter->done();
-        running_tasks_.erase(iter);
-    }
+    curl_helpers::shared_unique_ptr const curlsh_{ curl_share_init() };
 
-    void timeout_task(Task& task)
+    static void share_lock(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* vimpl)
     {
-        task.response.status = 408; // request timed out
-        task.response.did_timeout = true;
-        remove_task(task);
+        static_cast<Impl*>(vimpl)->share_mutexes_[data].lock();
     }
 
-    // the thread started by Impl.curl_thread runs this function
-    void curlThreadFunc()
+    static void share_unlock(CURL* /*handle*/, curl_lock_data data, void* vimpl)
     {
-        auto const multi = curl_helpers::multi_unique_ptr{ curl_multi_init() };
-#if LIBCURL_VERSION_NUM >= 0x071003 /* 7.16.3 */
-        (void)curl_multi_setopt(multi.get(), CURLMOPT_MAXCONNECTS, MaxCachedConnections);
-#endif
-#if LIBCURL_VERSION_NUM >= 0x071E00 /* 7.30.0 */
-        (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, MaxTotalConnections);
-        (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, MaxHostConnections);
-#endif
-        auto const start_time = mediator.now();
-
-        auto repeats = unsigned{};
-        for (;;)
-        {
-            if (deadline_reached())
-            {
-                while (!std::empty(running_tasks_))
-                {
-                    auto& task = running_tasks_.front();
-                    curl_multi_remove_handle(multi.get(), task.easy());
-                    timeout_task(task);
-                }
-            }
-
-            if (deadline_exists() && is_idle())
-            {
-                break;
-            }
-
-            if (auto lock = std::unique_lock{ tasks_mutex_ }; lock.owns_lock())
-            {
-                // sleep until there's something to do
-                auto const stop_waiting = [this]()
-                {
-                    return !is_idle() || !deadline_exists();
-                };
-                if (!stop_waiting())
-                {
-                    queued_tasks_cv_.wait(lock, stop_waiting);
-                }
-
-                // add queued tasks
-                if (!std::empty(queued_tasks_))
-                {
-                    for (auto& task : queued_tasks_)
-                    {
-                        initEasy(task);
-                        curl_multi_add_handle(multi.get(), task.easy());
-                    }
-
-                    running_tasks_.splice(std::end(running_tasks_), queued_tasks_);
-                }
-            }
-
-            resumePausedTasks();
-
-            // During steady state, wake up once per second.
-            // But during startup, wake up 10x more often. This is so tests
-            // that should take a few msec don't block for a full second
-            // while tr_session waits for this thread to finish.
-            static auto constexpr StartupSecs = std::chrono::seconds{ 15 };
-            auto const timeout_ms = mediator.now() - start_time < StartupSecs ? 50 : 1000;
-
-            // Adapted from https://curl.se/libcurl/c/curl_multi_wait.html docs.
-            // 'numfds' being zero means either a timeout or no file descriptors to
-            // wait for. Try timeout on first occurrence, then assume no file
-            // descriptors and no file descriptors to wait for means wait for 100
-            // milliseconds.
-            auto numfds = int{};
-            curl_multi_wait(multi.get(), nullptr, 0, timeout_ms, &numfds);
-            if (numfds == 0)
-            {
-                ++repeats;
-                if (repeats > 1U)
-                {
-                    std::this_thread::sleep_for(100ms);
-                }
-            }
-            else
-            {
-                repeats = 0;
-            }
-
-            // nonblocking update of the tasks
-            auto n_running = int{};
-            curl_multi_perform(multi.get(), &n_running);
-
-            // process any tasks that just finished
-            CURLMsg* msg = nullptr;
-            auto unused = int{};
-            while ((msg = curl_multi_info_read(multi.get(), &unused)) != nullptr)
-            {
-                if (msg->msg == CURLMSG_DONE && msg->easy_handle != nullptr)
-                {
-                    auto* const e = msg->easy_handle;
-
-                    Task* task = nullptr;
-                    curl_easy_getinfo(e, CURLINFO_PRIVATE, &task);
-
-                    auto req_bytes_sent = long{};
-                    auto total_time = double{};
-                    char* primary_ip = nullptr;
-                    curl_easy_getinfo(e, CURLINFO_REQUEST_SIZE, &req_bytes_sent);
-                    curl_easy_getinfo(e, CURLINFO_TOTAL_TIME, &total_time);
-                    curl_easy_getinfo(e, CURLINFO_RESPONSE_CODE, &task->response.status);
-                    curl_easy_getinfo(e, CURLINFO_PRIMARY_IP, &primary_ip);
-                    task->response.did_connect = task->response.status > 0 || req_bytes_sent > 0;
-                    task->response.did_timeout = task->response.status == 0 &&
-                        std::chrono::duration<double>(total_time) >= task->timeoutSecs();
-                    task->response.primary_ip = primary_ip;
-                    curl_multi_remove_handle(multi.get(), e);
-                    remove_task(*task);
-                }
-            }
-        }
+        static_cast<Impl*>(vimpl)->share_mutexes_[data].unlock();
     }
 
-    curl_helpers::shared_unique_ptr const curlsh_{ curl_share_init() };
-
-    std::map<std::string /*host*/, std::stack<curl_helpers::easy_unique_ptr>, std::less<>> easy_pool_;
-
-    std::mutex tasks_mutex_;
-    std::condition_variable queued_tasks_cv_;
-    std::list<Task> queued_tasks_;
-    std::list<Task> running_tasks_;
-
     CURLSH* shared()
     {
         return curlsh_.get();
@@ -864,20 +1045,29 @@ public:
         // https://github.com/transmission/transmission/issues/5199
 
         auto* const sh = shared();
+        curl_share_setopt(sh, CURLSHOPT_LOCKFUNC, share_lock);
+        curl_share_setopt(sh, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(sh, CURLSHOPT_USERDATA, this);
         curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
         curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
 #if LIBCURL_VERSION_NUM >= 0x071700 /* 7.23.0 */
         curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
 #endif
-#if LIBCURL_VERSION_NUM >= 0x073900 /* 7.57.0 */
-        curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
-#endif
+        // Don't share the connection cache either: curl doesn't support
+        // sharing it between threads, and the number of workers can change.
+        // Each worker keeps its own in its multi handle.
 #if LIBCURL_VERSION_NUM >= 0x073D00 /* 7.61.0 */
         curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_PSL);
 #endif
     }
 
-    std::map<CURL*, uint64_t /*tr_time_msec()*/> paused_easy_handles;
+    // depends-on: curlsh_
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // how many of `workers_` get new tasks
+    size_t n_workers_ = {};
+
+    mutable std::mutex workers_mutex_;
 };
 
 tr_web::tr_web(Mediator& mediator)
@@ -909,3 +1099,13 @@ bool tr_web::is_idle() const noexcept
 {
     return impl_->is_idle();
 }
+
+void tr_web::set_worker_count(size_t const n_workers)
+{
+    impl_->set_worker_count(n_workers);
+}
+
+size_t tr_web::worker_count() const
+{
+    return impl_->worker_count();
+}
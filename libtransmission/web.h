@@ -44,6 +44,15 @@ public:
             V6,
         };
 
+        // Higher-priority requests are started first. When tr_web has more
+        // than one worker thread, Bulk requests get workers of their own.
+        enum class Priority : uint8_t
+        {
+            High, // latency-sensitive, e.g. tracker announces and scrapes
+            Normal,
+            Bulk, // large transfers, e.g. webseed data and blocklists
+        };
+
         FetchOptions(
             std::string_view url_in,
             FetchDoneFunc&& done_func_in,
@@ -90,6 +99,8 @@ public:
         // IP protocol to use when making the request
         IPProtocol ip_proto = IPProtocol::ANY;
 
+        Priority priority = Priority::Normal;
+
         static auto constexpr DefaultTimeoutSecs = std::chrono::seconds{ 120 };
     };
 
@@ -102,6 +113,12 @@ public:
 
     [[nodiscard]] bool is_idle() const noexcept;
 
+    // Change how many threads run transfers, e.g. when the settings change.
+    // Threads that are no longer needed finish their transfers, but get no new ones.
+    void set_worker_count(size_t n_workers);
+
+    [[nodiscard]] size_t worker_count() const;
+
     // If you want to give running tasks a chance to finish,
     // call startShutdown() before destroying the tr_web object.
     // Deleting the object will cancel all of its tasks.
@@ -170,6 +187,13 @@ public:
         {
             return std::chrono::steady_clock::now();
         }
+
+        // Return how many threads to run transfers in.
+        // Each thread has its own connection limits.
+        [[nodiscard]] virtual size_t worker_count() const
+        {
+            return 1U;
+        }
     };
 
     // Note that tr_web does no management of the `mediator` reference.
@@ -0,0 +1,207 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef LIBTRANSMISSION_PEER_MODULE
+#error only the libtransmission peer module should #include this header.
+#endif
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <functional> // std::less
+#include <iterator>
+#include <vector>
+
+#include "libtransmission/tr-assert.h"
+#include "libtransmission/types.h"
+#include "libtransmission/utils.h" // tr_time()
+
+namespace tr::webseed
+{
+/**
+ * Manages how many web tasks should be running at a time.
+ *
+ * The limit adapts to the server, like TCP congestion control does:
+ * - When all is well, raise the limit by one each round (i.e. each time
+ *   `limit` tasks finish) as long as the extra task made us faster.
+ *   If it made us slower, back off by one.
+ * - If we get an error, halve the limit.
+ * - If we have too many errors in a row, put the peer in timeout
+ *   and don't allow _any_ connections for awhile.
+ */
+class ConnectionLimiter
+{
+public:
+    static auto constexpr TimeoutIntervalSecs = time_t{ 120 };
+    static auto constexpr MinConnections = size_t{ 1 };
+    static auto constexpr InitialConnections = size_t{ 4 };
+    static auto constexpr MaxConnections = size_t{ 32 };
+    static auto constexpr MaxConsecutiveFailures = InitialConnections;
+
+    // a speed change smaller than 1/N of the previous speed is just noise
+    static auto constexpr SpeedChangeDivisor = uint64_t{ 10 };
+
+    constexpr void task_started() noexcept
+    {
+        ++n_tasks_;
+    }
+
+    // `bytes_per_second` is how fast the webseed is downloading right now
+    void task_finished(bool success, uint64_t bytes_per_second)
+    {
+        TR_ASSERT(n_tasks_ > 0);
+        --n_tasks_;
+
+        if (!success)
+        {
+            task_failed();
+            return;
+        }
+
+        if (++n_finished_this_round_ < max_connections_)
+        {
+            return;
+        }
+
+        auto const prev = round_start_speed_;
+        if (bytes_per_second >= prev + prev / SpeedChangeDivisor)
+        {
+            max_connections_ = std::min(max_connections_ + 1U, MaxConnections);
+        }
+        else if (bytes_per_second + prev / SpeedChangeDivisor < prev)
+        {
+            max_connections_ = std::max(max_connections_ - 1U, MinConnections);
+        }
+
+        n_finished_this_round_ = 0;
+        round_start_speed_ = bytes_per_second;
+    }
+
+    constexpr void got_data() noexcept
+    {
+        TR_ASSERT(n_tasks_ > 0);
+        n_consecutive_failures_ = 0;
+        paused_until_ = 0;
+    }
+
+    [[nodiscard]] size_t slots_available() const noexcept
+    {
+        if (is_paused())
+        {
+            return 0;
+        }
+
+        auto const max = max_connections();
+        if (n_tasks_ >= max)
+        {
+            return 0;
+        }
+
+        return max - n_tasks_;
+    }
+
+    [[nodiscard]] constexpr size_t max_connections() const noexcept
+    {
+        return max_connections_;
+    }
+
+private:
+    [[nodiscard]] bool is_paused() const noexcept
+    {
+        return paused_until_ > tr_time();
+    }
+
+    void task_failed()
+    {
+        max_connections_ = std::max(max_connections_ / 2U, MinConnections);
+        n_finished_this_round_ = 0;
+        round_start_speed_ = 0;
+
+        if (++n_consecutive_failures_ >= MaxConsecutiveFailures)
+        {
+            paused_until_ = tr_time() + TimeoutIntervalSecs;
+        }
+    }
+
+    size_t max_connections_ = InitialConnections;
+    size_t n_tasks_ = 0;
+    size_t n_finished_this_round_ = 0;
+    size_t n_consecutive_failures_ = 0;
+    uint64_t round_start_speed_ = 0;
+    time_t paused_until_ = 0;
+};
+
+// the most unwanted blocks we'll download to join two spans into one request
+inline constexpr auto MaxGapBlocks = tr_block_index_t{ 4 };
+
+// Splits spans that are too big for one task.
+[[nodiscard]] inline std::vector<tr_block_span_t> split_spans(
+    tr_block_span_t const* const block_spans,
+    size_t const n_spans,
+    tr_block_index_t const max_task_blocks)
+{
+    auto spans = std::vector<tr_block_span_t>{};
+    spans.reserve(n_spans);
+    for (auto const *span = block_spans, *end = span + n_spans; span != end; ++span)
+    {
+        for (auto begin = span->begin; begin < span->end; begin += max_task_blocks)
+        {
+            spans.push_back({ .begin = begin, .end = std::min(span->end, begin + max_task_blocks) });
+        }
+    }
+
+    return spans;
+}
+
+// Finds the sorted spans, starting at `begin`, that can be fetched with a
+// single request: ones that are close enough to throw away the few blocks
+// in between instead of paying for another round trip.
+// Returns the end of that run of spans.
+template<typename Iter>
+[[nodiscard]] constexpr Iter coalesce_spans(Iter const begin, Iter const end, tr_block_index_t const max_task_blocks)
+{
+    TR_ASSERT(begin != end);
+
+    auto const task_begin = begin->begin;
+    auto task_end = begin->end;
+    auto next = std::next(begin);
+    for (; next != end && next->begin - task_end <= MaxGapBlocks && next->end - task_begin <= max_task_blocks; ++next)
+    {
+        task_end = next->end;
+    }
+
+    return next;
+}
+
+// True if `block` is in one of a task's sorted, disjoint `spans`.
+// A coalesced task also fetches the blocks between its spans, but those
+// aren't its requests; another task may be fetching them.
+[[nodiscard]] inline bool spans_contain(std::vector<tr_block_span_t> const& spans, tr_block_index_t const block)
+{
+    auto const it = std::ranges::upper_bound(spans, block, std::less{}, &tr_block_span_t::begin);
+    return it != std::begin(spans) && block < std::prev(it)->end;
+}
+
+// The parts of a task's sorted, disjoint `spans` at or after `begin`,
+// i.e. the requests it still hasn't filled
+[[nodiscard]] inline std::vector<tr_block_span_t> spans_from(
+    std::vector<tr_block_span_t> const& spans,
+    tr_block_index_t const begin)
+{
+    auto ret = std::vector<tr_block_span_t>{};
+    for (auto const& span : spans)
+    {
+        if (span.end > begin)
+        {
+            ret.push_back({ .begin = std::max(span.begin, begin), .end = span.end });
+        }
+    }
+
+    return ret;
+}
+} // namespace tr::webseed
@@ -14,13 +14,16 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
+#define LIBTRANSMISSION_PEER_MODULE
+
 #include "libtransmission/bandwidth.h"
 #include "libtransmission/bitfield.h"
 #include "libtransmission/block-info.h"
-#include "libtransmission/inout.h"
+#include "libtransmission/local-data.h"
 #include "libtransmission/peer-common.h"
 #include "libtransmission/peer-mgr.h"
 #include "libtransmission/session.h"
@@ -33,6 +36,7 @@
 #include "libtransmission/types.h"
 #include "libtransmission/web-utils.h"
 #include "libtransmission/web.h"
+#include "libtransmission/webseed-tasks.h"
 #include "libtransmission/webseed.h"
 
 using namespace std::literals;
@@ -45,8 +49,13 @@ class tr_webseed_impl;
 class tr_webseed_task
 {
 public:
-    tr_webseed_task(tr_torrent const& tor, tr_webseed_impl* webseed_in, tr_block_span_t blocks_in)
+    tr_webseed_task(
+        tr_torrent const& tor,
+        tr_webseed_impl* webseed_in,
+        tr_block_span_t blocks_in,
+        std::vector<tr_block_span_t> requested_in)
         : blocks{ blocks_in }
+        , requested{ std::move(requested_in) }
         , webseed_{ webseed_in }
         , session_{ tor.session }
         , end_byte_{ tor.block_loc(blocks.end - 1).byte + tor.block_size(blocks.end - 1) }
@@ -59,6 +68,10 @@ public:
     bool dead = false;
     tr_block_span_t const blocks;
 
+    // The spans in `blocks` that this task requested.
+    // The rest are gaps that it fetches only to save a round trip.
+    std::vector<tr_block_span_t> const requested;
+
 private:
     void use_fetched_blocks();
 
@@ -75,87 +88,6 @@ private:
     tr::StackBuffer<tr_block_info::BlockSize, std::byte, std::ratio<5, 1>> content_;
 };
 
-/**
- * Manages how many web tasks should be running at a time.
- *
- * - When all is well, allow multiple tasks running in parallel.
- * - If we get an error, throttle down to only one at a time
- *   until we get piece data.
- * - If we have too many errors in a row, put the peer in timeout
- *   and don't allow _any_ connections for awhile.
- */
-class ConnectionLimiter
-{
-public:
-    constexpr void task_started() noexcept
-    {
-        ++n_tasks_;
-    }
-
-    void task_finished(bool success)
-    {
-        if (!success)
-        {
-            task_failed();
-        }
-
-        TR_ASSERT(n_tasks_ > 0);
-        --n_tasks_;
-    }
-
-    constexpr void got_data() noexcept
-    {
-        TR_ASSERT(n_tasks_ > 0);
-        n_consecutive_failures_ = 0;
-        paused_until_ = 0;
-    }
-
-    [[nodiscard]] size_t slots_available() const noexcept
-    {
-        if (is_paused())
-        {
-            return 0;
-        }
-
-        auto const max = max_connections();
-        if (n_tasks_ >= max)
-        {
-            return 0;
-        }
-
-        return max - n_tasks_;
-    }
-
-private:
-    [[nodiscard]] bool is_paused() const noexcept
-    {
-        return paused_until_ > tr_time();
-    }
-
-    [[nodiscard]] constexpr size_t max_connections() const noexcept
-    {
-        return n_consecutive_failures_ > 0 ? 1 : MaxConnections;
-    }
-
-    void task_failed()
-    {
-        TR_ASSERT(n_tasks_ > 0);
-
-        if (++n_consecutive_failures_ >= MaxConsecutiveFailures)
-        {
-            paused_until_ = tr_time() + TimeoutIntervalSecs;
-        }
-    }
-
-    static auto constexpr TimeoutIntervalSecs = time_t{ 120 };
-    static auto constexpr MaxConnections = size_t{ 4 };
-    static auto constexpr MaxConsecutiveFailures = MaxConnections;
-
-    size_t n_tasks_ = 0;
-    size_t n_consecutive_failures_ = 0;
-    time_t paused_until_ = 0;
-};
-
 class tr_webseed_impl final : public tr_webseed
 {
 public:
@@ -250,6 +182,13 @@ public:
         stop();
     }
 
+    // There's no way to cancel part of an HTTP range request, but
+    // forgetting the block makes use_fetched_blocks() throw it away.
+    void maybe_cancel_block_request(tr_block_index_t block) override
+    {
+        active_requests.unset(block);
+    }
+
     void got_piece_data(uint32_t n_bytes)
     {
         auto const now = tr_time_msec();
@@ -259,16 +198,19 @@ public:
         connection_limiter.got_data();
     }
 
-    void on_rejection(tr_block_span_t block_span)
+    void on_rejection(std::vector<tr_block_span_t> const& block_spans)
     {
-        for (auto block = block_span.begin; block < block_span.end; ++block)
+        for (auto const& [begin, end] : block_spans)
         {
-            if (active_requests.test(block))
+            for (auto block = begin; block < end; ++block)
             {
-                publish(tr_peer_event::GotRejected(tor.block_info(), block));
+                if (active_requests.test(block))
+                {
+                    publish(tr_peer_event::GotRejected(tor.block_info(), block));
+                }
             }
+            active_requests.unset_span(begin, end);
         }
-        active_requests.unset_span(block_span.begin, block_span.end);
     }
 
     void request_blocks(tr_block_span_t const* block_spans, size_t n_spans) override
@@ -278,14 +220,23 @@ public:
             return;
         }
 
-        for (auto const *span = block_spans, *end = span + n_spans; span != end; ++span)
+        // Split spans that are too big for one task, and fetch nearby spans with a single request
+        auto const max_task_blocks = static_cast<tr_block_index_t>(blocks_per_task());
+        auto const spans = tr::webseed::split_spans(block_spans, n_spans, max_task_blocks);
+        for (auto it = std::begin(spans), end = std::end(spans); it != end && connection_limiter.slots_available() > 0U;)
         {
-            auto* const task = new tr_webseed_task{ tor, this, *span };
+            auto const next = tr::webseed::coalesce_spans(it, end, max_task_blocks);
+            auto const task_span = tr_block_span_t{ .begin = it->begin, .end = std::prev(next)->end };
+            auto requested = std::vector<tr_block_span_t>{ it, next };
+            for (; it != next; ++it)
+            {
+                active_requests.set_span(it->begin, it->end);
+                publish(tr_peer_event::SentRequest(tor.block_info(), *it));
+            }
+
+            auto* const task = new tr_webseed_task{ tor, this, task_span, std::move(requested) };
             tasks.insert(task);
             task->request_next_chunk();
-
-            active_requests.set_span(span->begin, span->end);
-            publish(tr_peer_event::SentRequest(tor.block_info(), *span));
         }
     }
 
@@ -302,14 +253,7 @@ public:
             return;
         }
 
-        // Prefer to request large, contiguous chunks from webseeds.
-        // The actual value of '64' is arbitrary here; we could probably
-        // be smarter about this.
         auto spans = tr_peerMgrGetNextRequests(&tor, this, max_blocks);
-        if (std::size(spans) > max_spans)
-        {
-            spans.resize(max_spans);
-        }
         request_blocks(std::data(spans), std::size(spans));
     }
 
@@ -326,11 +270,17 @@ public:
             return {};
         }
 
-        // Prefer to request large, contiguous chunks from webseeds.
-        // The actual value of '64' is arbitrary here;
-        // we could probably be smarter about this.
-        static auto constexpr PreferredBlocksPerTask = size_t{ 64 };
-        return { .max_spans = n_slots, .max_blocks = n_slots * PreferredBlocksPerTask };
+        return { .max_spans = n_slots, .max_blocks = n_slots * blocks_per_task() };
+    }
+
+    // Prefer to request large, contiguous chunks from webseeds:
+    // enough for each task to run for a few seconds at our current speed,
+    // so that fast servers aren't slowed down by per-request overhead.
+    [[nodiscard]] size_t blocks_per_task() const noexcept
+    {
+        auto const speed = get_piece_speed(tr_time_msec(), tr_direction::Down).base_quantity();
+        auto const per_task = speed * TargetTaskSecs / tr_block_info::BlockSize / connection_limiter.max_connections();
+        return std::clamp(static_cast<size_t>(per_task), MinBlocksPerTask, MaxBlocksPerTask);
     }
 
     void publish(tr_peer_event const& peer_event)
@@ -344,12 +294,16 @@ public:
     tr_torrent& tor;
     std::string const base_url;
 
-    ConnectionLimiter connection_limiter;
+    tr::webseed::ConnectionLimiter connection_limiter;
     std::set<tr_webseed_task*> tasks;
 
 private:
     static auto constexpr IdleTimerInterval = 2s;
 
+    static auto constexpr TargetTaskSecs = uint64_t{ 4 };
+    static auto constexpr MinBlocksPerTask = size_t{ 64 }; // 1 MiB
+    static auto constexpr MaxBlocksPerTask = size_t{ 1024 }; // 16 MiB
+
     std::unique_ptr<tr::Timer> const idle_timer_;
 
     tr_bitfield have_;
@@ -370,6 +324,9 @@ void tr_webseed_task::use_fetched_blocks()
 
     auto const& tor = webseed_->tor;
 
+    // shared so that the session-thread callback below is copyable
+    auto blocks = std::make_shared<std::vector<std::pair<tr_block_index_t, std::unique_ptr<tr::LocalData::BlockData>>>>();
+
     for (;;)
     {
         auto const block_size = tor.block_size(loc_.block);
@@ -378,29 +335,18 @@ void tr_webseed_task::use_fetched_blocks()
             break;
         }
 
-        if (tor.has_block(loc_.block))
+        // skip blocks we already have or that were cancelled, and the ones
+        // between requested spans that we only fetched to save a round trip
+        if (tor.has_block(loc_.block) || !tr::webseed::spans_contain(requested, loc_.block) ||
+            !webseed_->active_requests.test(loc_.block))
         {
             content_.drain(block_size);
         }
         else
         {
-            auto block_buf = std::vector<uint8_t>{};
-            block_buf.resize(block_size);
-            content_.to_buf(block_buf);
-
-            session_->run_in_session_thread(
-                [buf = std::move(block_buf), loc = loc_, session = session_, tor_id = tor.id(), webseed = webseed_]()
-                {
-                    if (auto* const torrent = session->torrents().get(tor_id))
-                    {
-                        webseed->active_requests.unset(loc.block);
-                        if (tr_ioWrite(*torrent, session->openFiles(), loc, buf) != 0)
-                        {
-                            return;
-                        }
-                        webseed->publish(tr_peer_event::GotBlock(torrent->block_info(), loc.block));
-                    }
-                });
+            auto block_buf = std::make_unique<tr::LocalData::BlockData>(block_size);
+            content_.to_buf(std::data(*block_buf), block_size);
+            blocks->emplace_back(loc_.block, std::move(block_buf));
         }
 
         loc_ = tor.byte_loc(loc_.byte + block_size);
@@ -408,6 +354,39 @@ void tr_webseed_task::use_fetched_blocks()
         TR_ASSERT(loc_.byte <= end_byte_);
         TR_ASSERT(loc_.byte == end_byte_ || loc_.block_offset == 0);
     }
+
+    if (std::empty(*blocks))
+    {
+        return;
+    }
+
+    // Hand the whole batch to the session thread at once
+    // rather than queueing up a job for each block.
+    session_->run_in_session_thread(
+        [blocks = std::move(blocks), session = session_, tor_id = tor.id(), webseed = webseed_]()
+        {
+            auto* const torrent = session->torrents().get(tor_id);
+            if (torrent == nullptr)
+            {
+                return;
+            }
+
+            for (auto& [block, data] : *blocks)
+            {
+                webseed->active_requests.unset(block);
+                session->local_data.write(
+                    tor_id,
+                    torrent->block_info().byte_span_for_block(block),
+                    std::move(data),
+                    [session, webseed, block](tr_torrent_id_t const id, tr_byte_span_t /*byte_span*/, tr_error const& error)
+                    {
+                        if (auto const* const tor = session->torrents().get(id); tor != nullptr && !error)
+                        {
+                            webseed->publish(tr_peer_event::GotBlock(tor->block_info(), block));
+                        }
+                    });
+            }
+        });
 }
 
 // ---
@@ -437,11 +416,13 @@ void tr_webseed_task::on_partial_data_fetched(tr_web::FetchResponse const& web_r
     }
 
     auto* const webseed = task->webseed_;
-    webseed->connection_limiter.task_finished(success);
+    webseed->connection_limiter.task_finished(
+        success,
+        webseed->get_piece_speed(tr_time_msec(), tr_direction::Down).base_quantity());
 
     if (!success)
     {
-        webseed->on_rejection({ .begin = task->loc_.block, .end = task->blocks.end });
+        webseed->on_rejection(tr::webseed::spans_from(task->requested, task->loc_.block));
         webseed->tasks.erase(task);
         delete task;
         return;
@@ -499,6 +480,7 @@ void tr_webseed_task::request_next_chunk()
     auto options = tr_web::FetchOptions{ url.sv(), on_partial_data_fetched, this };
     options.range.emplace(file_offset, file_offset + this_chunk - 1);
     options.speed_limit_tag = tor.id();
+    options.priority = tr_web::FetchOptions::Priority::Bulk;
     options.on_data_received = [this](size_t const n_bytes)
     {
         on_data_received(n_bytes);
@@ -3,6 +3,8 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <functional>
+#include <optional>
 #include <string_view>
 #include <utility>
 
@@ -34,6 +36,7 @@ namespace
 
 char constexpr const* const RequestBodyKey{ "requestBody" };
 char constexpr const* const RequestFutureinterfacePropertyKey{ "requestReplyFutureInterface" };
+char constexpr const* const RequestFilterPropertyKey{ "requestResponseFilter" };
 
 [[nodiscard]] int64_t nextId()
 {
@@ -63,6 +66,8 @@ RpcClient::RpcClient(QNetworkAccessManager& nam, QObject* parent)
     , nam_{ &nam }
 {
     qRegisterMetaType<TrVariantPtr>("TrVariantPtr");
+
+    decoder_.setMaxThreadCount(1);
 }
 
 void RpcClient::stop()
@@ -87,7 +92,7 @@ void RpcClient::start(QUrl const& url)
     url_is_loopback_ = QHostAddress{ url_.host() }.isLoopback();
 }
 
-RpcResponseFuture RpcClient::exec(tr_quark const method, tr_variant* args)
+RpcResponseFuture RpcClient::exec(tr_quark const method, tr_variant* args, RpcResponseFilter filter)
 {
     auto [req, id] = buildRequest(method, args);
 
@@ -97,22 +102,24 @@ RpcResponseFuture RpcClient::exec(tr_quark const method, tr_variant* args)
     promise.setProgressValue(0);
     promise.reportStarted();
 
+    auto request = PendingRequest{ promise, std::move(filter) };
+
     if (session_ != nullptr)
     {
-        sendLocalRequest(req, promise, id);
+        sendLocalRequest(req, std::move(request), id);
     }
     else if (!url_.isEmpty())
     {
         api_compat::convert(req, network_style_);
         auto const json = tr_variant_serde::json().compact().to_string(req);
         auto const body = QByteArray::fromStdString(json);
-        sendNetworkRequest(body, promise);
+        sendNetworkRequest(body, request);
     }
 
     return promise.future();
 }
 
-void RpcClient::sendNetworkRequest(QByteArray const& body, QFutureInterface<RpcResponse> const& promise)
+void RpcClient::sendNetworkRequest(QByteArray const& body, PendingRequest const& request)
 {
     auto req = QNetworkRequest{};
     req.setUrl(url_);
@@ -139,21 +146,22 @@ void RpcClient::sendNetworkRequest(QByteArray const& body, QFutureInterface<RpcR
     if (QNetworkReply* reply = nam_->post(req, body))
     {
         reply->setProperty(RequestBodyKey, body);
-        reply->setProperty(RequestFutureinterfacePropertyKey, QVariant::fromValue(promise));
+        reply->setProperty(RequestFutureinterfacePropertyKey, QVariant::fromValue(request.promise));
+        reply->setProperty(RequestFilterPropertyKey, QVariant::fromValue(request.filter));
 
         connect(reply, &QNetworkReply::downloadProgress, this, &RpcClient::dataReadProgress);
         connect(reply, &QNetworkReply::uploadProgress, this, &RpcClient::dataSendProgress);
     }
 }
 
-void RpcClient::sendLocalRequest(tr_variant& req, QFutureInterface<RpcResponse> const& promise, int64_t const id)
+void RpcClient::sendLocalRequest(tr_variant& req, PendingRequest request, int64_t const id)
 {
     if (verbose_)
     {
         fmt::print("{:s}:{:d} sending req:\n{:s}\n", __FILE__, __LINE__, tr_variant_serde::json().to_string(req));
     }
 
-    local_requests_.try_emplace(id, promise);
+    local_requests_.try_emplace(id, std::move(request));
     tr_rpc_request_exec(
         session_,
         req,
@@ -186,7 +194,10 @@ void RpcClient::networkRequestFinished(QNetworkReply* reply)
 {
     reply->deleteLater();
 
-    auto promise = reply->property(RequestFutureinterfacePropertyKey).value<QFutureInterface<RpcResponse>>();
+    auto request = PendingRequest{
+        reply->property(RequestFutureinterfacePropertyKey).value<QFutureInterface<RpcResponse>>(),
+        reply->property(RequestFilterPropertyKey).value<RpcResponseFilter>(),
+    };
 
     if (verbose_)
     {
@@ -235,7 +246,7 @@ void RpcClient::networkRequestFinished(QNetworkReply* reply)
         }
 
         session_id_ = reply->rawHeader(SessionIdHeaderName);
-        sendNetworkRequest(reply->property(RequestBodyKey).toByteArray(), promise);
+        sendNetworkRequest(reply->property(RequestBodyKey).toByteArray(), request);
         return;
     }
 
@@ -246,37 +257,62 @@ void RpcClient::networkRequestFinished(QNetworkReply* reply)
         RpcResponse result;
         result.networkError = reply->error();
 
-        promise.setProgressValueAndText(1, reply->errorString());
-        promise.reportFinished(&result);
+        request.promise.setProgressValueAndText(1, reply->errorString());
+        request.promise.reportFinished(&result);
     }
     else
     {
-        auto const json = reply->readAll().trimmed().toStdString();
+        finishInBackground(
+            std::move(request),
+            [json = reply->readAll().trimmed().toStdString(), verbose = verbose_]()
+            {
+                if (verbose)
+                {
+                    fmt::print("{:s}:{:d} got raw response:\n{:s}\n", __FILE__, __LINE__, json);
+                }
 
-        if (verbose_)
-        {
-            fmt::print("{:s}:{:d} got raw response:\n{:s}\n", __FILE__, __LINE__, json);
-        }
+                auto var = tr_variant_serde::json().parse(json);
+                if (var)
+                {
+                    api_compat::convert_incoming_data(*var);
+
+                    if (verbose)
+                    {
+                        auto serde = tr_variant_serde::json();
+                        serde.compact();
+                        fmt::print("{:s}:{:d} compat response:\n{:s}\n", __FILE__, __LINE__, serde.to_string(*var));
+                    }
+                }
 
-        auto response = RpcResponse{};
+                return var;
+            });
+    }
+}
 
-        if (auto var = tr_variant_serde::json().parse(json))
+// Parsing a large response, e.g. torrent_get for tens of thousands of torrents,
+// takes long enough to freeze the UI, so it happens on `decoder_`'s thread.
+// The promise is thread-safe and its watchers are notified on their own threads.
+void RpcClient::finishInBackground(PendingRequest request, std::function<std::optional<tr_variant>()> decode)
+{
+    decoder_.start(
+        [request = std::move(request), decode = std::move(decode)]() mutable
         {
-            api_compat::convert_incoming_data(*var);
+            auto response = RpcResponse{};
 
-            if (verbose_)
+            if (auto var = decode(); var)
             {
-                auto serde = tr_variant_serde::json();
-                serde.compact();
-                fmt::print("{:s}:{:d} compat response:\n{:s}\n", __FILE__, __LINE__, serde.to_string(*var));
-            }
+                response = parseResponseData(*var);
 
-            response = parseResponseData(*var);
-        }
+                if (response.success && request.filter)
+                {
+                    request.filter(response);
+                }
+            }
 
-        promise.setProgressValue(1);
-        promise.reportFinished(&response);
-    }
+            request.promise.setProgressRange(0, 1);
+            request.promise.setProgressValue(1);
+            request.promise.reportFinished(&response);
+        });
 }
 
 // NOLINTNEXTLINE(performance-unnecessary-value-param): DO NOT make the parameter a reference as this method is called from another thread
@@ -284,21 +320,18 @@ void RpcClient::localRequestFinished(TrVariantPtr response)
 {
     if (auto node = local_requests_.extract(parseResponseId(*response)))
     {
-        auto const result = parseResponseData(*response);
-
-        auto& promise = node.mapped();
-        promise.setProgressRange(0, 1);
-        promise.setProgressValue(1);
-        promise.reportFinished(&result);
+        finishInBackground(
+            std::move(node.mapped()),
+            [response = std::move(response)]() { return std::optional<tr_variant>{ std::move(*response) }; });
     }
 }
 
-int64_t RpcClient::parseResponseId(tr_variant& response) const
+int64_t RpcClient::parseResponseId(tr_variant& response)
 {
     return dictFind<int>(&response, TR_KEY_id).value_or(-1);
 }
 
-RpcResponse RpcClient::parseResponseData(tr_variant& response) const
+RpcResponse RpcClient::parseResponseData(tr_variant& response)
 {
     auto ret = RpcResponse{};
 
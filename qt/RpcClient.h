@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cstdint> // int64_t
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -17,6 +18,7 @@
 #include <QNetworkReply>
 #include <QObject>
 #include <QString>
+#include <QThreadPool>
 #include <QUrl>
 
 #include <libtransmission/transmission.h>
@@ -48,6 +50,11 @@ Q_DECLARE_METATYPE(QFutureInterface<RpcResponse>)
 // The response future -- the RPC engine returns one for each request made.
 using RpcResponseFuture = QFuture<RpcResponse>;
 
+// Optional post-processing for a successful response, e.g. to trim it down
+// before it reaches the GUI thread. Runs on RpcClient's decoding thread.
+using RpcResponseFilter = std::function<void(RpcResponse&)>;
+Q_DECLARE_METATYPE(RpcResponseFilter)
+
 class RpcClient : public QObject
 {
     Q_OBJECT
@@ -74,7 +81,7 @@ public:
     void start(tr_session* session);
     void start(QUrl const& url);
 
-    RpcResponseFuture exec(tr_quark method, tr_variant* args);
+    RpcResponseFuture exec(tr_quark method, tr_variant* args, RpcResponseFilter filter = {});
 
 signals:
     void httpAuthenticationRequired();
@@ -94,17 +101,28 @@ private:
 
     void connectNetworkAccessManager();
 
-    void sendNetworkRequest(QByteArray const& body, QFutureInterface<RpcResponse> const& promise);
-    void sendLocalRequest(tr_variant& req, QFutureInterface<RpcResponse> const& promise, int64_t id);
-    [[nodiscard]] int64_t parseResponseId(tr_variant& response) const;
-    [[nodiscard]] RpcResponse parseResponseData(tr_variant& response) const;
+    struct PendingRequest
+    {
+        QFutureInterface<RpcResponse> promise;
+        RpcResponseFilter filter;
+    };
+
+    void sendNetworkRequest(QByteArray const& body, PendingRequest const& request);
+    void sendLocalRequest(tr_variant& req, PendingRequest request, int64_t id);
+    void finishInBackground(PendingRequest request, std::function<std::optional<tr_variant>()> decode);
+    [[nodiscard]] static int64_t parseResponseId(tr_variant& response);
+    [[nodiscard]] static RpcResponse parseResponseData(tr_variant& response);
 
     tr::api_compat::Style network_style_ = tr::api_compat::default_style();
     tr_session* session_ = {};
     QByteArray session_id_;
     QUrl url_;
     QNetworkAccessManager* const nam_;
-    std::unordered_map<int64_t, QFutureInterface<RpcResponse>> local_requests_;
+    std::unordered_map<int64_t, PendingRequest> local_requests_;
     bool const verbose_ = qEnvironmentVariableIsSet("TR_RPC_VERBOSE");
     bool url_is_loopback_ = false;
+
+    // Decodes responses off the GUI thread. A single thread keeps
+    // responses finishing in the order that they arrived.
+    QThreadPool decoder_;
 };
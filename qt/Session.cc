@@ -305,6 +305,8 @@ void Session::restart()
 
 void Session::start()
 {
+    torrent_differ_ = std::make_shared<TorrentDiffer>();
+
     if (prefs_.get<bool>(TR_KEY_remote_session_enabled))
     {
         QUrl url;
@@ -661,10 +663,31 @@ void Session::refreshTorrents(torrent_ids_t const& torrent_ids, TorrentPropertie
     auto* q = new RpcQueue{};
 
     auto args = tr_variant{ std::move(map) };
-    q->add([this, &args]() { return exec(TR_KEY_torrent_get, &args); });
-
     bool const all_torrents = std::empty(torrent_ids);
 
+    // Trim the response down to the properties that changed before it reaches the GUI thread.
+    // Torrents that need their info get it all, since the model asked for it.
+    auto filter = [differ = torrent_differ_, all_torrents, keep_all = props == TorrentProperties::MainAll](RpcResponse& r)
+    {
+        auto* const args_map = r.args ? r.args->get_if<tr_variant::Map>() : nullptr;
+        if (args_map == nullptr)
+        {
+            return;
+        }
+
+        if (auto* const removed = args_map->find_if<tr_variant::Vector>(TR_KEY_removed); removed != nullptr)
+        {
+            differ->forget(*removed);
+        }
+
+        if (auto* const torrents = args_map->find_if<tr_variant::Vector>(TR_KEY_torrents); torrents != nullptr)
+        {
+            differ->reduce(*torrents, all_torrents, keep_all);
+        }
+    };
+
+    q->add([this, &args, &filter]() { return rpc_.exec(TR_KEY_torrent_get, &args, std::move(filter)); });
+
     q->add(
         [this, all_torrents](RpcResponse const& r)
         {
@@ -8,6 +8,7 @@
 #include <array>
 #include <cstdint> // int64_t
 #include <map>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <vector>
@@ -25,6 +26,7 @@
 #include "RpcClient.h"
 #include "RpcQueue.h"
 #include "Torrent.h"
+#include "TorrentDiffer.h"
 #include "Typedefs.h"
 
 class AddData;
@@ -195,6 +197,10 @@ private:
     bool is_definitely_local_session_ = true;
     RpcClient& rpc_;
 
+    // Shared with in-flight torrent_get responses, which are reduced off the GUI thread.
+    // Replaced on restart so that stale responses can't repopulate it.
+    std::shared_ptr<TorrentDiffer> torrent_differ_ = std::make_shared<TorrentDiffer>();
+
     static inline torrent_ids_t const RecentlyActiveIDs = { -1 };
 
     std::map<QString, QString> duplicates_;
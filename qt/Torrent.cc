@@ -54,19 +54,17 @@ bool Torrent::includesTracker(QString const& sitename) const
     return std::ranges::binary_search(sitenames_, sitename);
 }
 
-std::partial_ordering Torrent::compareSeedProgress(Torrent const& that) const
+std::partial_ordering Torrent::compareSeedProgress(
+    double const a_ratio,
+    std::optional<double> const a_ratio_limit,
+    double const b_ratio,
+    std::optional<double> const b_ratio_limit)
 {
-    auto const a_ratio_limit = getSeedRatioLimit();
-    auto const b_ratio_limit = that.getSeedRatioLimit();
-
     if (!a_ratio_limit && !b_ratio_limit)
     {
-        return compareRatio(that);
+        return compareRatio(a_ratio, b_ratio);
     }
 
-    auto const a_ratio = ratio();
-    auto const b_ratio = that.ratio();
-
     if (!a_ratio_limit)
     {
         return b_ratio < *b_ratio_limit ? std::partial_ordering::greater : std::partial_ordering::less;
@@ -79,7 +77,7 @@ std::partial_ordering Torrent::compareSeedProgress(Torrent const& that) const
 
     if (!(*a_ratio_limit > 0) && !(*b_ratio_limit > 0))
     {
-        return compareRatio(that);
+        return compareRatio(a_ratio, b_ratio);
     }
 
     if (!(*a_ratio_limit > 0))
@@ -97,11 +95,8 @@ std::partial_ordering Torrent::compareSeedProgress(Torrent const& that) const
     return a_progress <=> b_progress;
 }
 
-std::partial_ordering Torrent::compareRatio(Torrent const& that) const
+std::partial_ordering Torrent::compareRatio(double const a, double const b)
 {
-    double const a = ratio();
-    double const b = that.ratio();
-
     if (static_cast<int>(a) == TR_RATIO_INF && static_cast<int>(b) == TR_RATIO_INF)
     {
         return std::partial_ordering::equivalent;
@@ -120,14 +115,14 @@ std::partial_ordering Torrent::compareRatio(Torrent const& that) const
     return a <=> b;
 }
 
-std::strong_ordering Torrent::compareETA(Torrent const& that) const
+std::strong_ordering Torrent::compareETA(int const a, int const b)
 {
-    bool const have_a(hasETA());
-    bool const have_b(that.hasETA());
+    bool const have_a = a >= 0;
+    bool const have_b = b >= 0;
 
     if (have_a && have_b)
     {
-        return getETA() <=> that.getETA();
+        return a <=> b;
     }
 
     if (have_a)
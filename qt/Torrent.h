@@ -304,9 +304,14 @@ public:
         return failed_ever_;
     }
 
-    std::partial_ordering compareSeedProgress(Torrent const& that) const;
-    std::partial_ordering compareRatio(Torrent const& that) const;
-    std::strong_ordering compareETA(Torrent const& that) const;
+    // These take values rather than Torrents so that they can be used on cached sort keys
+    [[nodiscard]] static std::partial_ordering compareSeedProgress(
+        double a_ratio,
+        std::optional<double> a_ratio_limit,
+        double b_ratio,
+        std::optional<double> b_ratio_limit);
+    [[nodiscard]] static std::partial_ordering compareRatio(double a, double b);
+    [[nodiscard]] static std::strong_ordering compareETA(int a, int b);
 
     [[nodiscard]] constexpr auto getETA() const noexcept
     {
@@ -0,0 +1,202 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // int64_t, uint64_t
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "TorrentDiffer.h"
+
+namespace
+{
+// 64-bit FNV-1a
+auto constexpr FnvOffsetBasis = uint64_t{ 14695981039346656037ULL };
+auto constexpr FnvPrime = uint64_t{ 1099511628211ULL };
+
+void hashBytes(uint64_t& hash, void const* data, size_t len)
+{
+    for (auto const* it = static_cast<unsigned char const*>(data); len > 0U; --len, ++it)
+    {
+        hash ^= *it;
+        hash *= FnvPrime;
+    }
+}
+
+template<typename T>
+void hashValue(uint64_t& hash, T const& val)
+{
+    hashBytes(hash, &val, sizeof(val));
+}
+
+void hashVariant(uint64_t& hash, tr_variant const& var)
+{
+    // both kinds of string hash the same
+    auto const index = var.index() == tr_variant::StringViewIndex ? size_t{ tr_variant::StringIndex } : var.index();
+    hashValue(hash, index);
+
+    switch (index)
+    {
+    case tr_variant::BoolIndex:
+        hashValue(hash, *var.get_if<tr_variant::BoolIndex>());
+        break;
+
+    case tr_variant::IntIndex:
+        hashValue(hash, *var.get_if<tr_variant::IntIndex>());
+        break;
+
+    case tr_variant::DoubleIndex:
+        hashValue(hash, *var.get_if<tr_variant::DoubleIndex>());
+        break;
+
+    case tr_variant::StringIndex:
+        if (auto const sv = var.value_if<std::string_view>(); sv)
+        {
+            hashValue(hash, std::size(*sv));
+            hashBytes(hash, std::data(*sv), std::size(*sv));
+        }
+        break;
+
+    case tr_variant::VectorIndex:
+        {
+            auto const& vec = *var.get_if<tr_variant::VectorIndex>();
+            hashValue(hash, std::size(vec));
+            for (auto const& child : vec)
+            {
+                hashVariant(hash, child);
+            }
+        }
+        break;
+
+    case tr_variant::MapIndex:
+        {
+            auto const& map = *var.get_if<tr_variant::MapIndex>();
+            hashValue(hash, std::size(map));
+            for (auto const& [key, child] : map)
+            {
+                hashValue(hash, key);
+                hashVariant(hash, child);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+[[nodiscard]] uint64_t fingerprint(tr_variant const& var)
+{
+    auto hash = FnvOffsetBasis;
+    hashVariant(hash, var);
+    return hash;
+}
+} // namespace
+
+void TorrentDiffer::reduce(tr_variant::Vector& torrents, bool const is_complete_list, bool const keep_all)
+{
+    if (std::empty(torrents))
+    {
+        return;
+    }
+
+    // In 'table' format, the first entry in 'torrents' is an array of keys.
+    // All the other entries are an array of the values for one torrent.
+    auto keys = std::vector<tr_quark>{};
+    auto const* const key_list = torrents.front().get_if<tr_variant::Vector>();
+    if (key_list != nullptr)
+    {
+        keys.reserve(std::size(*key_list));
+        for (auto const& key : *key_list)
+        {
+            keys.push_back(tr_quark_new(key.value_if<std::string_view>().value_or(std::string_view{})));
+        }
+    }
+
+    auto const lock = std::scoped_lock{ mutex_ };
+
+    auto present = std::unordered_set<int64_t>{};
+    auto reduced = tr_variant::Vector{};
+    reduced.reserve(std::size(torrents));
+
+    auto properties = std::vector<std::pair<tr_quark, tr_variant*>>{};
+    for (auto it = std::begin(torrents) + (key_list != nullptr ? 1 : 0), end = std::end(torrents); it != end; ++it)
+    {
+        properties.clear();
+
+        if (auto* const values = it->get_if<tr_variant::Vector>(); values != nullptr && key_list != nullptr)
+        {
+            for (size_t i = 0, n = std::min(std::size(keys), std::size(*values)); i < n; ++i)
+            {
+                properties.emplace_back(keys[i], &(*values)[i]);
+            }
+        }
+        else if (auto* const map = it->get_if<tr_variant::Map>(); map != nullptr)
+        {
+            for (auto& [key, value] : *map)
+            {
+                properties.emplace_back(key, &value);
+            }
+        }
+
+        auto const id_it = std::ranges::find(properties, TR_KEY_id, &std::pair<tr_quark, tr_variant*>::first);
+        auto const id = id_it != std::ranges::end(properties) ? id_it->second->value_if<int64_t>() : std::nullopt;
+        if (!id)
+        {
+            continue;
+        }
+
+        if (is_complete_list)
+        {
+            present.insert(*id);
+        }
+
+        auto& seen = seen_[*id];
+        auto changed = tr_variant::Map{ std::size(properties) };
+        for (auto const& [key, value] : properties)
+        {
+            auto const print = fingerprint(*value);
+            auto const [seen_it, is_new] = seen.try_emplace(key, print);
+            auto const is_changed = is_new || seen_it->second != print;
+            seen_it->second = print;
+
+            if (keep_all || is_changed || key == TR_KEY_id)
+            {
+                changed.try_emplace(key, std::move(*value));
+            }
+        }
+
+        // A complete list needs every id so that missing torrents can be
+        // told apart from unchanged ones
+        if (is_complete_list || std::size(changed) > 1U)
+        {
+            reduced.emplace_back(std::move(changed));
+        }
+    }
+
+    if (is_complete_list)
+    {
+        std::erase_if(seen_, [&present](auto const& item) { return !present.contains(item.first); });
+    }
+
+    torrents = std::move(reduced);
+}
+
+void TorrentDiffer::forget(tr_variant::Vector const& removed_ids)
+{
+    auto const lock = std::scoped_lock{ mutex_ };
+
+    for (auto const& var : removed_ids)
+    {
+        if (auto const id = var.value_if<int64_t>(); id)
+        {
+            seen_.erase(*id);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#include <cstdint> // int64_t, uint64_t
+#include <mutex>
+#include <unordered_map>
+
+#include <libtransmission/quark.h>
+#include <libtransmission/variant.h>
+
+// Remembers the torrent properties that have already been handed to the GUI,
+// so that each torrent_get response can be trimmed down to what changed.
+// Responses are reduced on RpcClient's decoding thread, so this is thread-safe.
+class TorrentDiffer
+{
+public:
+    // Rewrite a torrent_get response's `torrents`, in either format, into one
+    // object per torrent that holds its id and the properties that changed.
+    // Unless `is_complete_list` is set, torrents with no changes are dropped.
+    // If `keep_all` is set, nothing is trimmed but the cache is still updated.
+    void reduce(tr_variant::Vector& torrents, bool is_complete_list, bool keep_all);
+
+    // Forget the torrents in a torrent_get response's `removed` list
+    void forget(tr_variant::Vector const& removed_ids);
+
+private:
+    std::mutex mutex_;
+
+    // torrent id -> property key -> fingerprint of the property's value
+    std::unordered_map<int64_t, std::unordered_map<tr_quark, uint64_t>> seen_;
+};
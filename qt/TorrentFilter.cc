@@ -3,9 +3,15 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <compare>
+#include <cstddef> // size_t
+#include <functional>
+#include <iterator>
 #include <optional>
+#include <vector>
 
 #include "libtransmission/utils.h"
 
@@ -22,8 +28,6 @@ TorrentFilter::TorrentFilter(Prefs const& prefs)
     connect(&prefs_, qOverload<tr_quark>(&Prefs::changed), this, &TorrentFilter::onPrefChanged);
     connect(&refilter_timer_, &QTimer::timeout, this, &TorrentFilter::refilter);
 
-    setDynamicSortFilter(true);
-
     refilter();
 }
 
@@ -68,26 +72,51 @@ void TorrentFilter::onPrefChanged(tr_quark key)
 
 void TorrentFilter::refilter()
 {
-    invalidate();
-    sort(0, prefs_.get<bool>(TR_KEY_sort_reversed) ? Qt::AscendingOrder : Qt::DescendingOrder);
+    sort_mode_ = prefs_.get<SortMode>(TR_KEY_sort_mode);
+    sort_reversed_ = prefs_.get<bool>(TR_KEY_sort_reversed);
+    show_mode_ = prefs_.get<ShowMode>(TR_KEY_filter_mode);
+    tracker_ = prefs_.get<QString>(TR_KEY_filter_trackers).toLower();
+    text_ = prefs_.get<QString>(TR_KEY_filter_text);
+
+    emit layoutAboutToBeChanged();
+
+    // remember which torrents the persistent indices point to, e.g. the selection
+    auto const old_indices = persistentIndexList();
+    auto source_indices = QModelIndexList{};
+    source_indices.reserve(old_indices.size());
+    for (auto const& idx : old_indices)
+    {
+        source_indices << mapToSource(idx);
+    }
+
+    rebuild();
+
+    auto new_indices = QModelIndexList{};
+    new_indices.reserve(source_indices.size());
+    for (auto const& idx : source_indices)
+    {
+        new_indices << mapFromSource(idx);
+    }
+
+    changePersistentIndexList(old_indices, new_indices);
+
+    emit layoutChanged();
 }
 
 /***
 ****
 ***/
 
-bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right) const
+bool TorrentFilter::lessThan(SortKey const& a, SortKey const& b, SortMode const mode)
 {
     auto val = std::partial_ordering::equivalent;
-    auto const* a = sourceModel()->data(left, TorrentModel::TorrentRole).value<Torrent const*>();
-    auto const* b = sourceModel()->data(right, TorrentModel::TorrentRole).value<Torrent const*>();
 
-    switch (prefs_.get<SortMode>(TR_KEY_sort_mode))
+    switch (mode)
     {
     case SortMode::SortByQueue:
         if (val == 0)
         {
-            val = b->queuePosition() <=> a->queuePosition();
+            val = b.queue_position <=> a.queue_position;
         }
 
         break;
@@ -95,7 +124,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortBySize:
         if (val == 0)
         {
-            val = a->sizeWhenDone() <=> b->sizeWhenDone();
+            val = a.size_when_done <=> b.size_when_done;
         }
 
         break;
@@ -103,7 +132,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByAge:
         if (val == 0)
         {
-            val = a->dateAdded() <=> b->dateAdded();
+            val = a.date_added <=> b.date_added;
         }
 
         break;
@@ -111,7 +140,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortById:
         if (val == 0)
         {
-            val = a->id() <=> b->id();
+            val = a.id <=> b.id;
         }
 
         break;
@@ -119,13 +148,12 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByActivity:
         if (val == 0)
         {
-            val = a->downloadSpeed() + a->uploadSpeed() <=> b->downloadSpeed() + b->uploadSpeed();
+            val = a.speed <=> b.speed;
         }
 
         if (val == 0)
         {
-            val = a->peersWeAreUploadingTo() + a->webseedsWeAreDownloadingFrom() <=>
-                b->peersWeAreUploadingTo() + b->webseedsWeAreDownloadingFrom();
+            val = a.peers_and_webseeds <=> b.peers_and_webseeds;
         }
 
         [[fallthrough]];
@@ -133,22 +161,22 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByState:
         if (val == 0)
         {
-            val = static_cast<int>(b->isPaused()) <=> static_cast<int>(a->isPaused());
+            val = static_cast<int>(b.is_paused) <=> static_cast<int>(a.is_paused);
         }
 
         if (val == 0)
         {
-            val = a->getActivity() <=> b->getActivity();
+            val = a.activity <=> b.activity;
         }
 
         if (val == 0)
         {
-            val = b->queuePosition() <=> a->queuePosition();
+            val = b.queue_position <=> a.queue_position;
         }
 
         if (val == 0)
         {
-            val = static_cast<int>(a->hasError()) <=> static_cast<int>(b->hasError());
+            val = static_cast<int>(a.has_error) <=> static_cast<int>(b.has_error);
         }
 
         [[fallthrough]];
@@ -156,22 +184,22 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByProgress:
         if (val == 0)
         {
-            val = a->metadataPercentDone() <=> b->metadataPercentDone();
+            val = a.metadata_percent_done <=> b.metadata_percent_done;
         }
 
         if (val == 0)
         {
-            val = a->percentComplete() <=> b->percentComplete();
+            val = a.percent_complete <=> b.percent_complete;
         }
 
         if (val == 0)
         {
-            val = a->compareSeedProgress(*b);
+            val = Torrent::compareSeedProgress(a.ratio, a.seed_ratio_limit, b.ratio, b.seed_ratio_limit);
         }
 
         if (val == 0)
         {
-            val = b->queuePosition() <=> a->queuePosition();
+            val = b.queue_position <=> a.queue_position;
         }
 
         [[fallthrough]];
@@ -179,7 +207,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByRatio:
         if (val == 0)
         {
-            val = a->compareRatio(*b);
+            val = Torrent::compareRatio(a.ratio, b.ratio);
         }
 
         break;
@@ -187,7 +215,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
     case SortMode::SortByEta:
         if (val == 0)
         {
-            val = a->compareETA(*b);
+            val = Torrent::compareETA(a.eta, b.eta);
         }
 
         break;
@@ -198,7 +226,7 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
 
     if (val == 0)
     {
-        if (auto const tmp = a->name().compare(b->name(), Qt::CaseInsensitive); tmp < 0)
+        if (auto const tmp = a.name.compare(b.name, Qt::CaseInsensitive); tmp < 0)
         {
             val = std::strong_ordering::greater;
         }
@@ -214,64 +242,444 @@ bool TorrentFilter::lessThan(QModelIndex const& left, QModelIndex const& right)
 
     if (val == 0)
     {
-        val = a->hash() <=> b->hash();
+        val = a.hash <=> b.hash;
+    }
+
+    if (val == 0)
+    {
+        val = a.id <=> b.id;
     }
 
     return val < 0;
 }
 
+TorrentFilter::Entry TorrentFilter::makeEntry(Torrent const& tor) const
+{
+    auto entry = Entry{};
+
+    auto& key = entry.key;
+    key.name = tor.name();
+    key.hash = tor.hash();
+    key.seed_ratio_limit = tor.getSeedRatioLimit();
+    key.metadata_percent_done = tor.metadataPercentDone();
+    key.percent_complete = tor.percentComplete();
+    key.ratio = tor.ratio();
+    key.size_when_done = tor.sizeWhenDone();
+    key.speed = (tor.downloadSpeed() + tor.uploadSpeed()).base_quantity();
+    key.date_added = tor.dateAdded();
+    key.id = tor.id();
+    key.queue_position = tor.queuePosition();
+    key.peers_and_webseeds = tor.peersWeAreUploadingTo() + tor.webseedsWeAreDownloadingFrom();
+    key.eta = tor.getETA();
+    key.activity = static_cast<int>(tor.getActivity());
+    key.is_paused = tor.isPaused();
+    key.has_error = tor.hasError();
+
+    for (size_t mode = 0; mode < ShowModeCount; ++mode)
+    {
+        entry.show_modes[mode] = should_show_torrent(tor, static_cast<ShowMode>(mode));
+    }
+
+    entry.accepted = entry.show_modes[static_cast<size_t>(show_mode_)] &&
+        (tracker_.isEmpty() || tor.includesTracker(tracker_)) &&
+        (text_.isEmpty() || tor.name().contains(text_, Qt::CaseInsensitive) ||
+         tor.hash().toString().contains(text_, Qt::CaseInsensitive));
+
+    return entry;
+}
+
+void TorrentFilter::countEntry(Entry const& entry, int const delta)
+{
+    for (size_t mode = 0; mode < ShowModeCount; ++mode)
+    {
+        if (entry.show_modes[mode])
+        {
+            counts_[mode] += delta;
+        }
+    }
+}
+
+bool TorrentFilter::isBefore(int const source_a, int const source_b) const
+{
+    auto const& a = entries_[source_a].key;
+    auto const& b = entries_[source_b].key;
+    return sort_reversed_ ? lessThan(a, b, sort_mode_) : lessThan(b, a, sort_mode_);
+}
+
+int TorrentFilter::proxyRowOf(int const source_row) const
+{
+    if (source_row < 0 || static_cast<size_t>(source_row) >= std::size(entries_) || !entries_[source_row].accepted)
+    {
+        return -1;
+    }
+
+    auto const is_before = [this](int const a, int const b)
+    {
+        return isBefore(a, b);
+    };
+
+    auto it = std::ranges::lower_bound(proxy_to_source_, source_row, is_before);
+    if (it == std::ranges::end(proxy_to_source_) || *it != source_row)
+    {
+        // The sort modes that compare ratios aren't a strict weak ordering
+        // for every input, e.g. NaNs, so the binary search can miss.
+        it = std::ranges::find(proxy_to_source_, source_row);
+    }
+
+    return it != std::ranges::end(proxy_to_source_) ? static_cast<int>(std::distance(std::begin(proxy_to_source_), it)) : -1;
+}
+
 /***
 ****
 ***/
 
-bool TorrentFilter::filterAcceptsRow(int source_row, QModelIndex const& source_parent) const
+void TorrentFilter::rebuild()
+{
+    entries_.clear();
+    proxy_to_source_.clear();
+    counts_ = {};
+
+    if (torrent_model_ == nullptr)
+    {
+        return;
+    }
+
+    auto const& torrents = torrent_model_->torrents();
+    entries_.reserve(std::size(torrents));
+    for (auto const* const tor : torrents)
+    {
+        auto const& entry = entries_.emplace_back(makeEntry(*tor));
+        countEntry(entry, 1);
+
+        if (entry.accepted)
+        {
+            proxy_to_source_.push_back(static_cast<int>(std::size(entries_) - 1U));
+        }
+    }
+
+    // stable_sort() copes with comparisons that aren't a strict weak ordering
+    std::ranges::stable_sort(proxy_to_source_, [this](int const a, int const b) { return isBefore(a, b); });
+}
+
+void TorrentFilter::addToProxy(int const source_row)
+{
+    auto const it = std::ranges::lower_bound(
+        proxy_to_source_,
+        source_row,
+        [this](int const a, int const b) { return isBefore(a, b); });
+    auto const row = static_cast<int>(std::distance(std::begin(proxy_to_source_), it));
+
+    beginInsertRows(QModelIndex{}, row, row);
+    proxy_to_source_.insert(it, source_row);
+    endInsertRows();
+}
+
+void TorrentFilter::updateRow(int const source_row)
 {
-    QModelIndex const child_index = sourceModel()->index(source_row, 0, source_parent);
-    auto const& tor = *child_index.model()->data(child_index, TorrentModel::TorrentRole).value<Torrent const*>();
-    bool accepts = true;
+    auto& entry = entries_[source_row];
+    auto const from = proxyRowOf(source_row); // must be found with the old sort key
+
+    countEntry(entry, -1);
+    entry = makeEntry(*torrent_model_->torrents()[source_row]);
+    countEntry(entry, 1);
+
+    if (from < 0)
+    {
+        if (entry.accepted)
+        {
+            addToProxy(source_row);
+        }
 
-    if (accepts)
+        return;
+    }
+
+    if (!entry.accepted)
     {
-        auto const show_mode = prefs_.get<ShowMode>(TR_KEY_filter_mode);
-        accepts = should_show_torrent(tor, show_mode);
+        beginRemoveRows(QModelIndex{}, from, from);
+        proxy_to_source_.erase(std::begin(proxy_to_source_) + from);
+        endRemoveRows();
+        return;
     }
 
-    if (accepts)
+    // It's still shown. Everything else is still in order, so it only
+    // needs to move if it's now out of order with its neighbors.
+    auto const is_before = [this](int const a, int const b)
+    {
+        return isBefore(a, b);
+    };
+    auto const begin = std::begin(proxy_to_source_);
+    auto const n_rows = static_cast<int>(std::size(proxy_to_source_));
+
+    auto dest = from; // the row to move in front of, numbered from before the move
+    auto to = from; // the row it ends up in
+    if (from > 0 && is_before(source_row, proxy_to_source_[from - 1]))
     {
-        auto const display_name = prefs_.get<QString>(TR_KEY_filter_trackers);
-        accepts = display_name.isEmpty() || tor.includesTracker(display_name.toLower());
+        dest = static_cast<int>(std::distance(begin, std::lower_bound(begin, begin + from, source_row, is_before)));
+        to = dest;
+    }
+    else if (from + 1 < n_rows && is_before(proxy_to_source_[from + 1], source_row))
+    {
+        auto const it = std::lower_bound(begin + from + 1, std::end(proxy_to_source_), source_row, is_before);
+        dest = static_cast<int>(std::distance(begin, it));
+        to = dest - 1;
     }
 
-    if (accepts)
+    if (to == from)
     {
-        auto const text = prefs_.get<QString>(TR_KEY_filter_text);
-        accepts = text.isEmpty() || tor.name().contains(text, Qt::CaseInsensitive) ||
-            tor.hash().toString().contains(text, Qt::CaseInsensitive);
+        return;
     }
 
-    return accepts;
+    [[maybe_unused]] auto const can_move = beginMoveRows(QModelIndex{}, from, from, QModelIndex{}, dest);
+    assert(can_move);
+
+    if (to < from)
+    {
+        std::rotate(begin + to, begin + from, begin + from + 1);
+    }
+    else
+    {
+        std::rotate(begin + from, begin + from + 1, begin + to + 1);
+    }
+
+    endMoveRows();
 }
 
-std::array<int, ShowModeCount> TorrentFilter::countTorrentsPerMode() const
+/***
+****
+***/
+
+void TorrentFilter::setSourceModel(QAbstractItemModel* source_model)
 {
-    auto* const torrent_model = dynamic_cast<TorrentModel*>(sourceModel());
-    if (torrent_model == nullptr)
+    if (auto* const old_model = sourceModel(); old_model != nullptr)
     {
-        return {};
+        disconnect(old_model, nullptr, this, nullptr);
+    }
+
+    beginResetModel();
+
+    QAbstractProxyModel::setSourceModel(source_model);
+    torrent_model_ = dynamic_cast<TorrentModel const*>(source_model);
+    rebuild();
+
+    if (source_model != nullptr)
+    {
+        connect(source_model, &QAbstractItemModel::dataChanged, this, &TorrentFilter::onSourceDataChanged);
+        connect(source_model, &QAbstractItemModel::rowsInserted, this, &TorrentFilter::onSourceRowsInserted);
+        connect(source_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &TorrentFilter::onSourceRowsAboutToBeRemoved);
+        connect(source_model, &QAbstractItemModel::rowsRemoved, this, &TorrentFilter::onSourceRowsRemoved);
+        connect(source_model, &QAbstractItemModel::modelAboutToBeReset, this, &TorrentFilter::beginResetModel);
+        connect(source_model, &QAbstractItemModel::modelReset, this, &TorrentFilter::onSourceModelReset);
+    }
+
+    endResetModel();
+}
+
+void TorrentFilter::onSourceDataChanged(QModelIndex const& top_left, QModelIndex const& bottom_right)
+{
+    if (torrent_model_ == nullptr || top_left.parent().isValid())
+    {
+        return;
+    }
+
+    auto const first = top_left.row();
+    auto const last = bottom_right.row();
+
+    for (int row = first; row <= last; ++row)
+    {
+        updateRow(row);
+    }
+
+    // now that they're in place, tell the view which rows to repaint
+    auto proxy_rows = std::vector<int>{};
+    proxy_rows.reserve(static_cast<size_t>(last - first + 1));
+    for (int row = first; row <= last; ++row)
+    {
+        if (auto const proxy_row = proxyRowOf(row); proxy_row >= 0)
+        {
+            proxy_rows.push_back(proxy_row);
+        }
+    }
+
+    std::ranges::sort(proxy_rows);
+
+    for (auto it = std::begin(proxy_rows), end = std::end(proxy_rows); it != end;)
+    {
+        auto const span_first = *it;
+        auto span_last = span_first;
+        while (++it != end && *it == span_last + 1)
+        {
+            ++span_last;
+        }
+
+        emit dataChanged(index(span_first, 0), index(span_last, 0));
+    }
+}
+
+void TorrentFilter::onSourceRowsInserted(QModelIndex const& parent, int const first, int const last)
+{
+    if (torrent_model_ == nullptr || parent.isValid())
+    {
+        return;
+    }
+
+    auto const n_added = last - first + 1;
+
+    // the rows after the insertion point moved down
+    for (auto& source_row : proxy_to_source_)
+    {
+        if (source_row >= first)
+        {
+            source_row += n_added;
+        }
+    }
+
+    auto const& torrents = torrent_model_->torrents();
+    auto added = std::vector<int>{};
+    entries_.insert(std::begin(entries_) + first, n_added, Entry{});
+    for (int row = first; row <= last; ++row)
+    {
+        auto& entry = entries_[row];
+        entry = makeEntry(*torrents[row]);
+        countEntry(entry, 1);
+
+        if (entry.accepted)
+        {
+            added.push_back(row);
+        }
+    }
+
+    // Insert each run of torrents that land next to each other in one go.
+    // On startup, this is every torrent at once.
+    auto const is_before = [this](int const a, int const b)
+    {
+        return isBefore(a, b);
+    };
+    std::ranges::stable_sort(added, is_before);
+    for (auto it = std::begin(added), end = std::end(added); it != end;)
+    {
+        auto const pos = std::ranges::lower_bound(proxy_to_source_, *it, is_before);
+        auto run_end = pos == std::end(proxy_to_source_) ? end : std::lower_bound(it, end, *pos, is_before);
+        run_end = std::max(run_end, std::next(it));
+
+        auto const row = static_cast<int>(std::distance(std::begin(proxy_to_source_), pos));
+        beginInsertRows(QModelIndex{}, row, row + static_cast<int>(std::distance(it, run_end)) - 1);
+        proxy_to_source_.insert(pos, it, run_end);
+        endInsertRows();
+
+        it = run_end;
+    }
+}
+
+void TorrentFilter::onSourceRowsAboutToBeRemoved(QModelIndex const& parent, int const first, int const last)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+
+    auto proxy_rows = std::vector<int>{};
+    for (int row = first; row <= last; ++row)
+    {
+        if (auto const proxy_row = proxyRowOf(row); proxy_row >= 0)
+        {
+            proxy_rows.push_back(proxy_row);
+        }
+    }
+
+    // remove from the bottom up so that the row numbers stay valid
+    std::ranges::sort(proxy_rows, std::greater{});
+    for (auto it = std::begin(proxy_rows), end = std::end(proxy_rows); it != end;)
+    {
+        auto const span_last = *it;
+        auto span_first = span_last;
+        while (++it != end && *it == span_first - 1)
+        {
+            --span_first;
+        }
+
+        beginRemoveRows(QModelIndex{}, span_first, span_last);
+        proxy_to_source_.erase(std::begin(proxy_to_source_) + span_first, std::begin(proxy_to_source_) + span_last + 1);
+        endRemoveRows();
+    }
+}
+
+void TorrentFilter::onSourceRowsRemoved(QModelIndex const& parent, int const first, int const last)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+
+    for (int row = first; row <= last; ++row)
+    {
+        countEntry(entries_[row], -1);
     }
 
-    auto torrent_counts = std::array<int, ShowModeCount>{};
+    entries_.erase(std::begin(entries_) + first, std::begin(entries_) + last + 1);
 
-    for (auto const& tor : torrent_model->torrents())
+    // the rows after the removed ones moved up
+    auto const n_removed = last - first + 1;
+    for (auto& source_row : proxy_to_source_)
     {
-        for (unsigned int mode = 0; mode < ShowModeCount; ++mode)
+        if (source_row > last)
         {
-            if (should_show_torrent(*tor, static_cast<ShowMode>(mode)))
-            {
-                ++torrent_counts[mode];
-            }
+            source_row -= n_removed;
         }
     }
+}
+
+void TorrentFilter::onSourceModelReset()
+{
+    rebuild();
+    endResetModel();
+}
+
+/***
+****
+***/
+
+QModelIndex TorrentFilter::index(int const row, int const column, QModelIndex const& parent) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount())
+    {
+        return {};
+    }
+
+    return createIndex(row, column);
+}
+
+QModelIndex TorrentFilter::parent(QModelIndex const& /*child*/) const
+{
+    return {};
+}
+
+int TorrentFilter::rowCount(QModelIndex const& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(std::size(proxy_to_source_));
+}
+
+int TorrentFilter::columnCount(QModelIndex const& parent) const
+{
+    return parent.isValid() || sourceModel() == nullptr ? 0 : sourceModel()->columnCount();
+}
+
+QModelIndex TorrentFilter::mapToSource(QModelIndex const& proxy_index) const
+{
+    if (!proxy_index.isValid() || sourceModel() == nullptr || proxy_index.row() >= rowCount())
+    {
+        return {};
+    }
+
+    return sourceModel()->index(proxy_to_source_[proxy_index.row()], proxy_index.column());
+}
+
+QModelIndex TorrentFilter::mapFromSource(QModelIndex const& source_index) const
+{
+    if (!source_index.isValid() || source_index.parent().isValid())
+    {
+        return {};
+    }
 
-    return torrent_counts;
+    auto const row = proxyRowOf(source_index.row());
+    return row >= 0 ? createIndex(row, source_index.column()) : QModelIndex{};
 }
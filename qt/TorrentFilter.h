@@ -6,18 +6,30 @@
 #pragma once
 
 #include <array>
+#include <bitset>
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <optional>
+#include <vector>
 
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QString>
 #include <QTimer>
 
 #include "Filters.h"
 #include "Prefs.h"
+#include "Torrent.h"
 
-class QString;
+class TorrentModel;
 
-class Torrent;
-
-class TorrentFilter : public QSortFilterProxyModel
+// A sorted, filtered view of a TorrentModel.
+//
+// Unlike QSortFilterProxyModel, this keeps its order up to date incrementally:
+// when torrents change, only those torrents get refiltered and moved. Their
+// sort keys and filter results are cached, so comparisons are cheap and stay
+// consistent with the current order even if a Torrent changes before the
+// model says so. Only a change to the sort or filter prefs re-sorts everything.
+class TorrentFilter : public QAbstractProxyModel
 {
     Q_OBJECT
 
@@ -29,18 +41,88 @@ public:
     TorrentFilter& operator=(TorrentFilter&&) = delete;
     TorrentFilter& operator=(TorrentFilter const&) = delete;
 
-    [[nodiscard]] std::array<int, ShowModeCount> countTorrentsPerMode() const;
+    [[nodiscard]] std::array<int, ShowModeCount> countTorrentsPerMode() const
+    {
+        return counts_;
+    }
+
+    // QAbstractItemModel
+    [[nodiscard]] QModelIndex index(int row, int column, QModelIndex const& parent = {}) const override;
+    [[nodiscard]] QModelIndex parent(QModelIndex const& child) const override;
+    [[nodiscard]] int rowCount(QModelIndex const& parent = {}) const override;
+    [[nodiscard]] int columnCount(QModelIndex const& parent = {}) const override;
 
-protected:
-    // QSortFilterProxyModel
-    [[nodiscard]] bool filterAcceptsRow(int source_row, QModelIndex const& source_parent) const override;
-    [[nodiscard]] bool lessThan(QModelIndex const& source_left, QModelIndex const& source_right) const override;
+    // QAbstractProxyModel
+    [[nodiscard]] QModelIndex mapToSource(QModelIndex const& proxy_index) const override;
+    [[nodiscard]] QModelIndex mapFromSource(QModelIndex const& source_index) const override;
+    void setSourceModel(QAbstractItemModel* source_model) override;
 
 private slots:
     void onPrefChanged(tr_quark key);
     void refilter();
 
+    void onSourceDataChanged(QModelIndex const& top_left, QModelIndex const& bottom_right);
+    void onSourceRowsInserted(QModelIndex const& parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(QModelIndex const& parent, int first, int last);
+    void onSourceRowsRemoved(QModelIndex const& parent, int first, int last);
+    void onSourceModelReset();
+
 private:
+    // A snapshot of the Torrent properties that the sort modes look at
+    struct SortKey
+    {
+        QString name;
+        TorrentHash hash;
+        std::optional<double> seed_ratio_limit;
+        double metadata_percent_done = {};
+        double percent_complete = {};
+        double ratio = {};
+        uint64_t size_when_done = {};
+        uint64_t speed = {}; // download + upload
+        time_t date_added = {};
+        int id = {};
+        int queue_position = {};
+        int peers_and_webseeds = {}; // peers we're uploading to + webseeds we're downloading from
+        int eta = {};
+        int activity = {};
+        bool is_paused = {};
+        bool has_error = {};
+    };
+
+    struct Entry
+    {
+        SortKey key;
+        std::bitset<ShowModeCount> show_modes; // the ShowModes that include this torrent
+        bool accepted = false;
+    };
+
+    [[nodiscard]] static bool lessThan(SortKey const& a, SortKey const& b, SortMode mode);
+
+    [[nodiscard]] Entry makeEntry(Torrent const& tor) const;
+    void countEntry(Entry const& entry, int delta);
+
+    // true if `source_a` is shown above `source_b`
+    [[nodiscard]] bool isBefore(int source_a, int source_b) const;
+
+    // the proxy row that `source_row` is shown in, or -1 if it's filtered out
+    [[nodiscard]] int proxyRowOf(int source_row) const;
+
+    void rebuild();
+    void updateRow(int source_row);
+    void addToProxy(int source_row);
+
+    std::vector<Entry> entries_; // by source row
+    std::vector<int> proxy_to_source_; // source rows of the shown torrents, in display order
+    std::array<int, ShowModeCount> counts_ = {};
+    TorrentModel const* torrent_model_ = nullptr;
+
+    // the sort and filter prefs, cached so that they aren't looked up per comparison
+    SortMode sort_mode_ = {};
+    ShowMode show_mode_ = {};
+    QString tracker_;
+    QString text_;
+    bool sort_reversed_ = false;
+
     QTimer refilter_timer_;
     Prefs const& prefs_;
 };
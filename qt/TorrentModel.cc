@@ -171,14 +171,15 @@ void TorrentModel::updateTorrents(tr_variant* torrent_list, bool is_complete_lis
         return (date != 0) && (difftime(now, date) < MaxAge);
     };
 
-    // build a list of the property keys
+    // In 'table' format, the first entry in 'torrents' is an array of keys.
+    // All the other entries are an array of the values for one torrent.
+    // In 'object' format, every entry is an object of property key/vals.
+    // Session trims those down to what changed, so the keys can differ per torrent.
     tr_variant* const first_child = tr_variantListChild(torrent_list, 0);
     bool const table = first_child != nullptr && first_child->holds_alternative<tr_variant::Vector>();
     std::vector<tr_quark> keys;
     if (table)
     {
-        // In 'table' format, the first entry in 'torrents' is an array of keys.
-        // All the other entries are an array of the values for one torrent.
         auto sv = std::string_view{};
         size_t i = 0;
         keys.reserve(tr_variantListSize(first_child));
@@ -186,27 +187,13 @@ void TorrentModel::updateTorrents(tr_variant* torrent_list, bool is_complete_lis
         {
             keys.push_back(tr_quark_new(sv));
         }
-    }
-    else if (first_child != nullptr)
-    {
-        // In 'object' format, every entry is an object with the same set of properties
-        auto key = tr_quark{};
-        tr_variant* value = nullptr;
-        for (size_t i = 0; tr_variantDictChild(first_child, i, &key, &value); ++i)
+
+        if (std::ranges::find(keys, TR_KEY_id) == std::ranges::end(keys)) // no ids provided; we can't proceed
         {
-            keys.push_back(key);
+            return;
         }
     }
 
-    // Find the position of TR_KEY_id so we can do torrent lookup
-    auto const id_it = std::ranges::find(keys, TR_KEY_id);
-    if (id_it == std::ranges::end(keys)) // no ids provided; we can't proceed
-    {
-        return;
-    }
-
-    auto const id_pos = std::distance(std::begin(keys), id_it);
-
     // Loop through the torrent records...
     std::vector<tr_variant*> values;
     values.reserve(keys.size());
@@ -230,16 +217,24 @@ void TorrentModel::updateTorrents(tr_variant* torrent_list, bool is_complete_lis
         else
         {
             // In object mode, v is an object of torrent property key/vals
+            keys.clear();
             size_t i = 0;
             auto key = tr_quark{};
             tr_variant* value = nullptr;
             while (tr_variantDictChild(v, i++, &key, &value))
             {
+                keys.push_back(key);
                 values.push_back(value);
             }
         }
 
         // Find the torrent id
+        auto const id_pos = static_cast<size_t>(std::distance(std::begin(keys), std::ranges::find(keys, TR_KEY_id)));
+        if (id_pos >= std::size(values))
+        {
+            continue;
+        }
+
         auto const id = getValue<int>(values[id_pos]);
         if (!id)
         {
@@ -256,7 +251,7 @@ void TorrentModel::updateTorrents(tr_variant* torrent_list, bool is_complete_lis
             is_new = true;
         }
 
-        auto const fields = tor->update(keys.data(), values.data(), keys.size());
+        auto const fields = tor->update(keys.data(), values.data(), values.size());
 
         if (fields.any())
         {
@@ -446,14 +441,22 @@ void TorrentModel::rowsAdd(torrents_t const& torrents)
     }
     else
     {
-        for (auto const& tor : torrents)
+        // insert each run of torrents that land next to each other in one go
+        auto sorted = torrents;
+        std::ranges::sort(sorted, TorrentIdLessThan);
+
+        for (auto it = sorted.begin(); it != sorted.end();)
         {
-            auto const it = std::ranges::lower_bound(torrents_, tor, TorrentIdLessThan);
-            auto const row = static_cast<int>(std::distance(torrents_.begin(), it));
+            auto const pos = std::ranges::lower_bound(torrents_, *it, TorrentIdLessThan);
+            auto const row = static_cast<int>(std::distance(torrents_.begin(), pos));
+            auto const run_end = pos == torrents_.end() ? sorted.end() :
+                                                          std::lower_bound(it, sorted.end(), *pos, TorrentIdLessThan);
 
-            beginInsertRows(QModelIndex{}, row, row);
-            torrents_.insert(it, tor);
+            beginInsertRows(QModelIndex{}, row, row + static_cast<int>(std::distance(it, run_end)) - 1);
+            torrents_.insert(pos, it, run_end);
             endInsertRows();
+
+            it = run_end;
         }
     }
 }
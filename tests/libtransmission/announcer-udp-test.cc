@@ -12,6 +12,7 @@
 #include <deque>
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
@@ -86,6 +87,11 @@ protected:
             return {};
         }
 
+        [[nodiscard]] std::string_view config_dir() const override
+        {
+            return config_dir_;
+        }
+
         // Mock DNS lookup that only resolves localhost
         [[nodiscard]] std::optional<tr_socket_address> dns_lookup(
             tr_address_type const ip_protocol,
@@ -154,6 +160,8 @@ protected:
 
         std::deque<Sent> sent_;
 
+        std::string config_dir_;
+
         std::unique_ptr<event_base, void (*)(event_base*)> const event_base_;
     };
 
@@ -474,6 +482,46 @@ TEST_F(AnnouncerUdpTest, canDestructCleanlyEvenWhenBusy)
     // the announcer and mediator will go out-of-scope & be destroyed.
 }
 
+TEST_F(AnnouncerUdpTest, reusesConnectionAfterRestart)
+{
+    auto const sandbox = tr::test::Sandbox{};
+    auto mediator = MockMediator{};
+    mediator.config_dir_ = sandbox.path();
+
+    auto [request, expected_response] = buildSimpleScrapeRequestAndResponse();
+    auto connection_id = tau_connection_t{};
+
+    // connect to the tracker and scrape it
+    {
+        auto announcer = tr_announcer_udp::create(mediator);
+        auto upkeep_timer = createUpkeepTimer(mediator, announcer);
+        announcer->scrape(request, {});
+
+        auto from = sockaddr_storage{};
+        auto* const from_ptr = reinterpret_cast<struct sockaddr*>(&from);
+        auto fromlen = socklen_t{};
+        auto const connect_transaction_id = parseConnectionRequest(
+            waitForAnnouncerToSendMessage(mediator, from_ptr, &fromlen));
+        connection_id = sendConnectionResponse(*announcer, connect_transaction_id, from_ptr, fromlen);
+
+        auto const [scrape_transaction_id, info_hashes] = parseScrapeRequest(
+            waitForAnnouncerToSendMessage(mediator),
+            connection_id);
+        expectEqual(request, info_hashes);
+    }
+
+    // A new announcer should pick up the saved address and connection ID
+    // and send the scrape right away, without a DNS lookup or `connect`
+    auto announcer = tr_announcer_udp::create(mediator);
+    auto upkeep_timer = createUpkeepTimer(mediator, announcer);
+    announcer->scrape(request, {});
+
+    auto const [scrape_transaction_id, info_hashes] = parseScrapeRequest(
+        waitForAnnouncerToSendMessage(mediator),
+        connection_id);
+    expectEqual(request, info_hashes);
+}
+
 TEST_F(AnnouncerUdpTest, canMultiScrape)
 {
     auto mediator = MockMediator{};
@@ -494,3 +494,38 @@ TEST(Bitfield, intersects)
     EXPECT_TRUE(a.intersects(b));
     EXPECT_TRUE(b.intersects(a));
 }
+
+TEST(Bitfield, countIntersection)
+{
+    // big enough to exercise both the word-at-a-time and leftover-byte paths
+    auto a = tr_bitfield{ 1000 };
+    auto b = tr_bitfield{ 1000 };
+
+    a.set_has_all();
+    b.set_has_none();
+    EXPECT_EQ(0U, a.count_intersection(b));
+    EXPECT_EQ(0U, b.count_intersection(a));
+
+    b.set_span(100U, 300U);
+    EXPECT_EQ(200U, a.count_intersection(b));
+    EXPECT_EQ(200U, b.count_intersection(a));
+
+    a.set_has_none();
+    for (size_t i = 0; i < std::size(a); i += 3U)
+    {
+        a.set(i);
+    }
+    auto expected = size_t{};
+    for (size_t i = 0; i < std::size(a); ++i)
+    {
+        if (a.test(i) && b.test(i))
+        {
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, a.count_intersection(b));
+    EXPECT_EQ(expected, b.count_intersection(a));
+
+    b.set(999U);
+    EXPECT_EQ(expected + 1U, a.count_intersection(b));
+}
@@ -98,3 +98,32 @@ TEST_F(BufferTest, Numbers)
         EXPECT_EQ(expected_u8, buf.to_uint8());
     }
 }
+
+TEST_F(BufferTest, spanWriterWritesInPlace)
+{
+    static auto constexpr NBytes = sizeof(uint32_t) + sizeof(uint8_t) + std::size("Hello"sv);
+
+    auto buf = Buffer{};
+    buf.add("x"sv);
+    auto const capacity = buf.capacity();
+
+    auto [space, space_len] = buf.reserve_space(NBytes);
+    auto writer = tr::SpanWriter<std::byte>{ space, NBytes };
+    writer.add_uint32(6U);
+    writer.add_uint8(20U);
+    writer.add("Hello"sv);
+    EXPECT_EQ(NBytes, std::size(writer));
+    buf.commit_space(std::size(writer));
+
+    EXPECT_EQ(capacity, buf.capacity());
+    EXPECT_TRUE(buf.starts_with("x"sv));
+    buf.drain(1U);
+    EXPECT_EQ(6U, buf.to_uint32());
+    EXPECT_EQ(20U, buf.to_uint8());
+    EXPECT_TRUE(buf.starts_with("Hello"sv));
+    EXPECT_EQ(5U, std::size(buf));
+
+    // reserving more than it can hold makes the buffer grow
+    buf.reserve_space(capacity + 1U);
+    EXPECT_LT(capacity, buf.capacity());
+}
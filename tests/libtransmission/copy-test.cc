@@ -19,6 +19,8 @@
 
 #include "test-fixtures.h"
 
+using namespace std::literals;
+
 namespace tr::test
 {
 
@@ -71,6 +73,7 @@ private:
         return bytes_remaining;
     }
 
+protected:
     static bool filesAreIdentical(std::string_view filename1, std::string_view filename2)
     {
         auto contents1 = std::vector<char>{};
@@ -88,4 +91,48 @@ TEST_F(CopyTest, copy)
     testImpl(filename1, filename2, random_file_length);
 }
 
+TEST_F(CopyTest, reportsProgress)
+{
+    auto const path1 = tr_pathbuf{ sandboxDir(), "/orig-blob.txt"sv };
+    auto const path2 = tr_pathbuf{ sandboxDir(), "/copy-blob.txt"sv };
+    auto const file_length = size_t{ 1024U * 1024U * 3U };
+
+    auto contents = std::vector<char>{};
+    contents.resize(file_length);
+    tr_rand_buffer(std::data(contents), std::size(contents));
+    createFileWithContents(path1, std::data(contents), std::size(contents));
+
+    auto reports = std::vector<uint64_t>{};
+    auto const on_progress = [&reports](uint64_t const bytes_copied)
+    {
+        reports.emplace_back(bytes_copied);
+        return true;
+    };
+
+    auto error = tr_error{};
+    EXPECT_TRUE(tr_sys_path_copy(path1, path2, &error, on_progress));
+    EXPECT_FALSE(error) << error;
+    EXPECT_TRUE(filesAreIdentical(path1, path2));
+
+    // progress only goes up, and ends with the whole file
+    ASSERT_FALSE(std::empty(reports));
+    EXPECT_TRUE(std::ranges::is_sorted(reports));
+    EXPECT_EQ(file_length, reports.back());
+}
+
+TEST_F(CopyTest, canBeCanceled)
+{
+    auto const path1 = tr_pathbuf{ sandboxDir(), "/orig-blob.txt"sv };
+    auto const path2 = tr_pathbuf{ sandboxDir(), "/copy-blob.txt"sv };
+
+    auto contents = std::vector<char>{};
+    contents.resize(1024U * 1024U * 3U);
+    tr_rand_buffer(std::data(contents), std::size(contents));
+    createFileWithContents(path1, std::data(contents), std::size(contents));
+
+    auto error = tr_error{};
+    EXPECT_FALSE(tr_sys_path_copy(path1, path2, &error, [](uint64_t /*bytes_copied*/) { return false; }));
+    EXPECT_TRUE(error);
+}
+
 } // namespace tr::test
@@ -38,6 +38,7 @@
 
 #include <libtransmission/crypto-utils.h> // tr_rand_obj
 #include <libtransmission/file.h>
+#include <libtransmission/metrics.h>
 #include <libtransmission/net.h>
 #include <libtransmission/quark.h>
 #include <libtransmission/session-thread.h> // for tr_evthread_init();
@@ -645,11 +646,14 @@ TEST_F(DhtTest, announcesTorrents)
     auto& mock_dht = mediator.mock_dht_;
     mock_dht.setHealthySwarm();
 
+    auto const n_announces_before = tr::metrics::snapshot()[tr::metrics::Counter::DhtAnnounces];
+
     auto dht = tr_dht::create(mediator, PeerPort, ArbitrarySock4, ArbitrarySock6);
 
     waitFor(event_base_, MockTimerInterval * 10);
 
     ASSERT_EQ(2U, std::size(mock_dht.searched_));
+    EXPECT_EQ(n_announces_before + 2U, tr::metrics::snapshot()[tr::metrics::Counter::DhtAnnounces]);
 
     EXPECT_EQ(info_hash, mock_dht.searched_[0].info_hash);
     EXPECT_EQ(PeerPort, mock_dht.searched_[0].port);
@@ -660,6 +664,36 @@ TEST_F(DhtTest, announcesTorrents)
     EXPECT_EQ(AF_INET6, mock_dht.searched_[1].af);
 }
 
+TEST_F(DhtTest, spreadsAnnouncesForLargeTorrentCounts)
+{
+    static auto constexpr NumTorrents = 500U;
+
+    tr_timeUpdate(time(nullptr));
+
+    auto mediator = MockMediator{ event_base_ };
+    for (auto id = tr_torrent_id_t{ 1 }; id <= tr_torrent_id_t{ NumTorrents }; ++id)
+    {
+        mediator.info_hashes_[id] = tr_rand_obj<tr_sha1_digest_t>();
+        mediator.torrents_allowing_dht_.push_back(id);
+    }
+    mediator.config_dir_ = sandboxDir();
+
+    auto& mock_dht = mediator.mock_dht_;
+    mock_dht.setHealthySwarm();
+
+    // The first tick should not search for every torrent at once...
+    auto dht = tr_dht::create(mediator, ArbitraryPeerPort, ArbitrarySock4, ArbitrarySock6);
+    EXPECT_FALSE(std::empty(mock_dht.searched_));
+    EXPECT_LT(std::size(mock_dht.searched_), NumTorrents * 2U);
+
+    // ...but every torrent should get announced on both families eventually
+    waitFor(
+        event_base_,
+        [&mock_dht]() { return std::size(mock_dht.searched_) == NumTorrents * 2U; },
+        MockTimerInterval * 40);
+    EXPECT_EQ(NumTorrents * 2U, std::size(mock_dht.searched_));
+}
+
 TEST_F(DhtTest, callsPeriodicPeriodically)
 {
     auto mediator = MockMediator{ event_base_ };
@@ -0,0 +1,157 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <array>
+#include <cstddef> // size_t
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/log.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+class LogTest : public ::tr::test::TransmissionTest
+{
+protected:
+    void SetUp() override
+    {
+        TransmissionTest::SetUp();
+
+        old_level_ = tr_logGetLevel();
+        tr_logSetLevel(TR_LOG_INFO);
+        tr_logClearQueue();
+        tr_logSetQueueEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        tr_logSetQueueEnabled(false);
+        tr_logClearQueue();
+        tr_logSetLevel(old_level_);
+
+        TransmissionTest::TearDown();
+    }
+
+private:
+    tr_log_level old_level_ = {};
+};
+
+TEST_F(LogTest, queuedMessagesAreAvailableRightAway)
+{
+    tr_logAddInfo("one");
+    tr_logAddInfo("two", "module");
+
+    auto const msgs = tr_logGetQueue();
+    ASSERT_EQ(2U, std::size(msgs));
+    EXPECT_EQ("one"sv, msgs[0].message);
+    EXPECT_EQ("log-test.cc"sv, msgs[0].file);
+    EXPECT_EQ(fmt::format("log-test.cc:{:d}", msgs[0].line), msgs[0].name);
+    EXPECT_EQ("two"sv, msgs[1].message);
+    EXPECT_EQ("module"sv, msgs[1].name);
+}
+
+TEST_F(LogTest, disabledLevelsAreNotBuilt)
+{
+    auto n_built = 0;
+    auto const build = [&n_built]()
+    {
+        ++n_built;
+        return std::string{ "built" };
+    };
+
+    tr_logAddDebug(build());
+    tr_logAddInfo(build());
+
+    EXPECT_EQ(1, n_built);
+    EXPECT_EQ(1U, std::size(tr_logGetQueue()));
+}
+
+TEST_F(LogTest, repeatedWarningsAreCapped)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        tr_logAddWarn("again");
+    }
+
+    // 30 of them, plus a note saying that the rest are skipped
+    EXPECT_EQ(31U, std::size(tr_logGetQueue()));
+}
+
+TEST_F(LogTest, mutedWarningsAreNotBuilt)
+{
+    auto n_built = size_t{};
+    auto const build = [&n_built]()
+    {
+        ++n_built;
+        return std::string{ "built" };
+    };
+
+    for (int i = 0; i < 100; ++i)
+    {
+        tr_logAddWarn(build());
+    }
+
+    EXPECT_EQ(tr::detail::log::MaxRepeat, n_built);
+    EXPECT_EQ(n_built + 1U, std::size(tr_logGetQueue()));
+
+    // other call sites are still heard
+    tr_logAddWarn("another");
+    EXPECT_EQ(1U, std::size(tr_logGetQueue()));
+}
+
+TEST_F(LogTest, messagesFromManyThreads)
+{
+    static auto constexpr NumThreads = size_t{ 4U };
+    static auto constexpr NumMessages = 1000;
+
+    auto const dropped_before = tr_logGetDroppedCount();
+
+    auto threads = std::array<std::thread, NumThreads>{};
+    for (size_t i = 0; i < NumThreads; ++i)
+    {
+        threads[i] = std::thread{ [i]()
+                                  {
+                                      for (int j = 0; j < NumMessages; ++j)
+                                      {
+                                          tr_logAddInfo(fmt::format("{:d} {:d}", j, i), fmt::format("{:d}", i));
+                                      }
+                                  } };
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Messages may be dropped if the queue fills up,
+    // but each thread's messages should stay in order.
+    auto next = std::array<int, NumThreads>{};
+    auto n_dropped_notes = size_t{};
+    for (auto const& msg : tr_logGetQueue())
+    {
+        if (msg.level == TR_LOG_WARN)
+        {
+            ++n_dropped_notes;
+            continue;
+        }
+
+        auto const thread_idx = std::stoul(msg.name);
+        ASSERT_LT(thread_idx, NumThreads);
+        auto const j = std::stoi(msg.message);
+        EXPECT_LE(next[thread_idx], j);
+        next[thread_idx] = j + 1;
+    }
+
+    auto const n_dropped = tr_logGetDroppedCount() - dropped_before;
+    EXPECT_EQ(n_dropped > 0U, n_dropped_notes > 0U);
+    EXPECT_LE(n_dropped, NumThreads * NumMessages);
+}
@@ -0,0 +1,124 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/metrics.h>
+
+using namespace std::literals;
+using namespace tr::metrics;
+
+TEST(Metrics, countsFromManyThreads)
+{
+    static auto constexpr NumThreads = 32U; // more than there are shards
+    static auto constexpr NumAdds = 1000U;
+
+    auto const before = snapshot()[Counter::VerifyPieces];
+
+    auto threads = std::array<std::thread, NumThreads>{};
+    for (auto& thread : threads)
+    {
+        thread = std::thread{ []()
+                              {
+                                  for (unsigned i = 0; i < NumAdds; ++i)
+                                  {
+                                      add(Counter::VerifyPieces);
+                                  }
+                              } };
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(before + (NumThreads * NumAdds), snapshot()[Counter::VerifyPieces]);
+}
+
+TEST(Metrics, histogramBuckets)
+{
+    auto const before = snapshot()[Histogram::BandwidthAllocationTime];
+
+    observe(Histogram::BandwidthAllocationTime, 0us); // first bucket
+    observe(Histogram::BandwidthAllocationTime, BucketBounds.front()); // bounds are inclusive
+    observe(Histogram::BandwidthAllocationTime, BucketBounds.front() + 1us); // second bucket
+    observe(Histogram::BandwidthAllocationTime, BucketBounds.back() + 1us); // unbounded last bucket
+    observe(Histogram::BandwidthAllocationTime, -1s); // clamped to zero
+
+    auto const after = snapshot()[Histogram::BandwidthAllocationTime];
+    EXPECT_EQ(before.count + 5U, after.count);
+    EXPECT_EQ(before.buckets[0] + 3U, after.buckets[0]);
+    EXPECT_EQ(before.buckets[1] + 1U, after.buckets[1]);
+    EXPECT_EQ(before.buckets[BucketCount - 1U] + 1U, after.buckets[BucketCount - 1U]);
+    EXPECT_EQ(before.sum + (BucketBounds.front() * 2) + 1us + BucketBounds.back() + 1us, after.sum);
+}
+
+TEST(Metrics, prometheusFormat)
+{
+    auto snap = Snapshot{};
+    snap.counters[static_cast<size_t>(Counter::RpcRequests)] = 42U;
+    auto& rpc_time = snap.histograms[static_cast<size_t>(Histogram::RpcRequestTime)];
+    rpc_time.buckets[0] = 2U;
+    rpc_time.buckets[2] = 1U;
+    rpc_time.buckets[BucketCount - 1U] = 1U;
+    rpc_time.count = 4U;
+    rpc_time.sum = 2500ms;
+
+    auto const text = to_prometheus(snap);
+
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_rpc_requests_total counter\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_requests_total 42\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_rpc_request_seconds histogram\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_bucket{le=\"1e-05\"} 2\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_bucket{le=\"5e-05\"} 2\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_bucket{le=\"0.0001\"} 3\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_bucket{le=\"1\"} 3\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_bucket{le=\"+Inf\"} 4\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_sum 2.5\n"));
+    EXPECT_NE(std::string::npos, text.find("\ntransmission_rpc_request_seconds_count 4\n"));
+    EXPECT_EQ('\n', text.back());
+}
+
+TEST(Metrics, endgameCounters)
+{
+    auto const before = snapshot();
+
+    add(Counter::EndgameRequests, 3U);
+    add(Counter::EndgameWastedBytes, 16384U);
+
+    auto const after = snapshot();
+    EXPECT_EQ(before[Counter::EndgameRequests] + 3U, after[Counter::EndgameRequests]);
+    EXPECT_EQ(before[Counter::EndgameWastedBytes] + 16384U, after[Counter::EndgameWastedBytes]);
+
+    auto const text = to_prometheus(after);
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_endgame_requests_total counter\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_endgame_wasted_bytes_total counter\n"));
+}
+
+TEST(Metrics, peerMessageCountersAreByType)
+{
+    auto const before = snapshot();
+
+    add(Counter::PeerMessagesSentPiece, 2U);
+    add(Counter::PeerMessageAllocationsLtep);
+
+    auto const after = snapshot();
+    EXPECT_EQ(before[Counter::PeerMessagesSentPiece] + 2U, after[Counter::PeerMessagesSentPiece]);
+    EXPECT_EQ(before[Counter::PeerMessagesSentRequest], after[Counter::PeerMessagesSentRequest]);
+    EXPECT_EQ(before[Counter::PeerMessageAllocationsLtep] + 1U, after[Counter::PeerMessageAllocationsLtep]);
+    EXPECT_EQ("peer_messages_sent_piece"sv, name(Counter::PeerMessagesSentPiece));
+    EXPECT_EQ("peer_messages_sent_unchoke"sv, name(Counter::PeerMessagesSentUnchoke));
+    EXPECT_EQ("peer_message_allocations_ltep"sv, name(Counter::PeerMessageAllocationsLtep));
+    EXPECT_EQ("peer_message_allocations_unchoke"sv, name(Counter::PeerMessageAllocationsUnchoke));
+
+    auto const text = to_prometheus(after);
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_peer_messages_sent_piece_total counter\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE transmission_peer_message_allocations_ltep_total counter\n"));
+}
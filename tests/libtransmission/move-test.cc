@@ -4,10 +4,20 @@
 // License text can be found in the licenses/ folder.
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib> // setenv(), unsetenv()
+#include <future>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#define setenv(key, value, unused) SetEnvironmentVariableA(key, value)
+#define unsetenv(key) SetEnvironmentVariableA(key, nullptr)
+#endif
 
 #include <gtest/gtest.h>
 
@@ -16,7 +26,9 @@
 #include <libtransmission/block-info.h>
 #include <libtransmission/file.h> // tr_sys_path_*()
 #include <libtransmission/inout.h>
+#include <libtransmission/file-utils.h>
 #include <libtransmission/quark.h>
+#include <libtransmission/relocate.h>
 #include <libtransmission/torrent-files.h>
 #include <libtransmission/torrent.h>
 #include <libtransmission/tr-strbuf.h>
@@ -196,4 +208,258 @@ TEST_F(MoveTest, setLocation)
     tr_torrentRemove(tor, true);
 }
 
+TEST_F(MoveTest, sameFilesystemRenamesInsteadOfCopying)
+{
+    struct Result
+    {
+        std::atomic<int> n_progress = 0;
+        std::atomic<bool> same_filesystem = false;
+        std::atomic<bool> failed = false;
+        std::atomic<bool> copied = false;
+    };
+
+    // the worker owns the mediator, so report to a `Result` that outlives it
+    class MediatorMock final : public tr_relocate_worker::Mediator
+    {
+    public:
+        explicit MediatorMock(Result& result)
+            : result_{ result }
+        {
+        }
+
+        [[nodiscard]] tr_sha1_digest_t const& info_hash() const override
+        {
+            return info_hash_;
+        }
+
+        void on_progress(uint64_t /*bytes_done*/, uint64_t /*bytes_total*/) override
+        {
+            ++result_.n_progress;
+        }
+
+        void on_copied(tr_relocate_worker::Job job, tr_error const& error) override
+        {
+            result_.same_filesystem = job.same_filesystem;
+            result_.failed = static_cast<bool>(error);
+            result_.copied = true;
+        }
+
+    private:
+        Result& result_;
+        tr_sha1_digest_t const info_hash_ = {};
+    };
+
+    auto const old_path = tr_pathbuf{ sandboxDir(), "/old/a/file" };
+    auto const new_path = tr_pathbuf{ sandboxDir(), "/new/a/file" };
+    createFileWithContents(old_path, "hello");
+
+    auto job = tr_relocate_worker::Job{};
+    job.old_parent = tr_pathbuf{ sandboxDir(), "/old" };
+    job.new_parent = tr_pathbuf{ sandboxDir(), "/new" };
+    job.files.push_back({ std::string{ old_path }, std::string{ new_path } });
+
+    auto result = Result{};
+    auto worker = tr_relocate_worker{};
+    worker.add(std::make_unique<MediatorMock>(result), std::move(job));
+    EXPECT_TRUE(waitFor([&result]() { return result.copied.load(); }, MaxWaitMsec));
+
+    // the sandbox is a single filesystem, so the cut-over can just rename
+    EXPECT_TRUE(result.same_filesystem);
+    EXPECT_FALSE(result.failed);
+    EXPECT_EQ(0, result.n_progress);
+    EXPECT_TRUE(tr_sys_path_exists(old_path));
+    EXPECT_FALSE(tr_sys_path_exists(new_path));
+    EXPECT_FALSE(tr_sys_path_exists(tr_pathbuf{ new_path, tr_relocate_worker::TempSuffix }));
+}
+
+// Copies the files even though the sandbox is on one filesystem,
+// so that the copying and cut-over can be tested
+class RelocateCopyTest : public SessionTest
+{
+protected:
+    void SetUp() override
+    {
+        setenv(EnvKey, "1", 1);
+        SessionTest::SetUp();
+    }
+
+    void TearDown() override
+    {
+        SessionTest::TearDown();
+        unsetenv(EnvKey);
+    }
+
+    [[nodiscard]] static std::vector<std::string> file_names(tr_torrent const* tor)
+    {
+        auto names = std::vector<std::string>{};
+        for (tr_file_index_t i = 0, n = tr_torrentFileCount(tor); i < n; ++i)
+        {
+            names.emplace_back(tr_torrentFile(tor, i).name);
+        }
+        return names;
+    }
+
+    // true if `dir` has all of `names` and none of their temp copies
+    [[nodiscard]] static bool has_files(std::string_view const dir, std::vector<std::string> const& names)
+    {
+        return std::ranges::all_of(
+            names,
+            [dir](auto const& name)
+            {
+                auto const path = tr_pathbuf{ dir, '/', name };
+                return tr_sys_path_exists(path) && !tr_sys_path_exists(tr_pathbuf{ path, tr_relocate_worker::TempSuffix });
+            });
+    }
+
+    // true if `dir` has none of `names` nor any of their temp copies
+    [[nodiscard]] static bool has_no_files(std::string_view const dir, std::vector<std::string> const& names)
+    {
+        return std::ranges::none_of(
+            names,
+            [dir](auto const& name)
+            {
+                auto const path = tr_pathbuf{ dir, '/', name };
+                return tr_sys_path_exists(path) || tr_sys_path_exists(tr_pathbuf{ path, tr_relocate_worker::TempSuffix });
+            });
+    }
+
+    static auto constexpr EnvKey = "TR_RELOCATE_ALWAYS_COPY";
+};
+
+TEST_F(RelocateCopyTest, newLocationReplacesMoveInProgress)
+{
+    auto const first_dir = tr_pathbuf{ sandboxDir(), "/first"sv };
+    auto const second_dir = tr_pathbuf{ sandboxDir(), "/second"sv };
+
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    auto const names = file_names(tor);
+    auto const old_dir = std::string{ tor->current_dir().sv() };
+
+    auto first_state = -1;
+    auto second_state = -1;
+    tr_torrentSetLocation(tor, first_dir, true, &first_state);
+    tr_torrentSetLocation(tor, second_dir, true, &second_state);
+    EXPECT_TRUE(waitFor([&second_state]() { return second_state == TR_LOC_DONE; }, MaxWaitMsec));
+
+    // the first move was cancelled and its copies cleaned up...
+    EXPECT_EQ(TR_LOC_ERROR, first_state);
+    EXPECT_TRUE(waitFor([&first_dir, &names]() { return has_no_files(first_dir, names); }, MaxWaitMsec));
+
+    // ...and the files ended up in the second location
+    EXPECT_EQ(TR_LOC_DONE, second_state);
+    EXPECT_TRUE(has_files(second_dir, names));
+    EXPECT_TRUE(waitFor([&old_dir, &names]() { return has_no_files(old_dir, names); }, MaxWaitMsec));
+    EXPECT_EQ(second_dir.sv(), tor->current_dir().sv());
+
+    // cleanup
+    tr_torrentRemove(tor, true);
+}
+
+TEST_F(RelocateCopyTest, removingTorrentCancelsMoveInProgress)
+{
+    auto const target_dir = tr_pathbuf{ sandboxDir(), "/target"sv };
+
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    auto const names = file_names(tor);
+
+    // remove the torrent before the move can finish
+    auto state = -1;
+    session_->run_in_session_thread(
+        [tor, &target_dir, &state]()
+        {
+            tr_torrentSetLocation(tor, target_dir, true, &state);
+            tr_torrentRemove(tor, false);
+        });
+
+    // whoever asked for the move is told that it failed...
+    EXPECT_TRUE(waitFor([&state]() { return state == TR_LOC_ERROR; }, MaxWaitMsec));
+
+    // ...and its copies are cleaned up
+    EXPECT_TRUE(waitFor([&target_dir, &names]() { return has_no_files(target_dir, names); }, MaxWaitMsec));
+}
+
+TEST_F(RelocateCopyTest, staleCopiesAreCopiedAgain)
+{
+    auto const target_dir = tr_pathbuf{ sandboxDir(), "/target"sv };
+
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    auto const names = file_names(tor);
+    auto const source = tr_pathbuf{ tor->current_dir().sv(), '/', names.front() };
+
+    // hold up the session thread, so that the cut-over waits
+    // until the source has been changed
+    auto release = std::promise<void>{};
+    auto state = -1;
+    tr_torrentSetLocation(tor, target_dir, true, &state);
+    session_->run_in_session_thread([released = release.get_future().share()]() { released.wait(); });
+
+    auto const copied = [tor]()
+    {
+        auto const st = tr_torrentStat(tor);
+        return st.relocation_bytes_total != 0U && st.relocation_bytes_done == st.relocation_bytes_total;
+    };
+    EXPECT_TRUE(waitFor(copied, MaxWaitMsec));
+
+    auto constexpr Changed = "changed"sv;
+    createFileWithContents(source, Changed);
+    release.set_value();
+
+    EXPECT_TRUE(waitFor([&state]() { return state == TR_LOC_DONE; }, MaxWaitMsec));
+    EXPECT_TRUE(has_files(target_dir, names));
+
+    auto const info = tr_sys_path_get_info(tr_pathbuf{ target_dir, '/', names.front() });
+    ASSERT_TRUE(info);
+    EXPECT_EQ(std::size(Changed), info->size);
+
+    // cleanup
+    tr_torrentRemove(tor, true);
+}
+
+TEST_F(RelocateCopyTest, interruptedMoveResumesOnRestart)
+{
+    auto const target_dir = tr_pathbuf{ sandboxDir(), "/target"sv };
+
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    auto const names = file_names(tor);
+    auto const old_dir = std::string{ tor->current_dir().sv() };
+    auto const torrent_file = std::string{ tor->torrent_file() };
+    auto const resume_file = std::string{ tor->resume_file() };
+
+    // take the torrent out of the session, keeping its data and its .torrent file
+    auto const saved_torrent_file = tr_pathbuf{ sandboxDir(), "/saved.torrent"sv };
+    ASSERT_TRUE(tr_sys_path_copy(torrent_file, saved_torrent_file));
+    tr_torrentRemove(tor, false);
+    auto removed = std::promise<void>{};
+    session_->run_in_session_thread([&removed]() { removed.set_value(); });
+    removed.get_future().wait();
+    ASSERT_FALSE(tr_sys_path_exists(torrent_file));
+    ASSERT_TRUE(tr_sys_path_rename(saved_torrent_file, torrent_file));
+
+    // pretend it was restarted in the middle of a move...
+    auto resume = tr_variant::Map{ 1U };
+    resume.try_emplace(TR_KEY_relocation_target, target_dir.sv());
+    ASSERT_TRUE(tr_variant_serde::benc().to_file(tr_variant{ std::move(resume) }, resume_file));
+
+    // ...that had finished copying the first file
+    auto const temp = tr_pathbuf{ target_dir, '/', names.front(), tr_relocate_worker::TempSuffix };
+    auto const info = tr_sys_path_get_info(tr_pathbuf{ old_dir, '/', names.front() });
+    ASSERT_TRUE(info);
+    auto const contents = std::vector<char>(info->size, '\1');
+    createFileWithContents(temp, std::data(contents), std::size(contents));
+
+    auto* const ctor = tr_ctorNew(session_);
+    ctor->set_paused(TR_FORCE, true);
+    EXPECT_EQ(1U, tr_sessionLoadTorrents(session_, ctor));
+    tr_ctorFree(ctor);
+
+    // the move picks up where it left off...
+    EXPECT_TRUE(waitFor([&target_dir, &names]() { return has_files(target_dir, names); }, MaxWaitMsec));
+    EXPECT_TRUE(waitFor([&old_dir, &names]() { return has_no_files(old_dir, names); }, MaxWaitMsec));
+
+    // ...reusing the copy that was already made
+    auto moved = std::vector<char>{};
+    EXPECT_TRUE(tr_file_read(tr_pathbuf{ target_dir, '/', names.front() }, moved));
+    EXPECT_EQ(contents, moved);
+}
+
 } // namespace tr::test
@@ -81,10 +81,12 @@ protected:
         }
     };
 
-    static auto constexpr PeerHasAllPieces = [](tr_piece_index_t)
+    static inline auto const PeerHasAllPieces = []
     {
-        return true;
-    };
+        auto have = tr_bitfield{ 0U };
+        have.set_has_all();
+        return have;
+    }();
 };
 
 TEST_F(PeerMgrWishlistTest, doesNotRequestPiecesThatAreNotWanted)
@@ -162,14 +164,12 @@ TEST_F(PeerMgrWishlistTest, onlyRequestBlocksThePeerHas)
 
     // but the peer only has the second piece, we don't want to
     // request blocks other than these
-    static auto constexpr IsPieceOne = [](tr_piece_index_t p)
-    {
-        return p == 1U;
-    };
+    auto peer_has = tr_bitfield{ 3U };
+    peer_has.set(1U);
 
     // even if we ask wishlist for more blocks than what the peer has,
     // it should only return blocks [100..200)
-    auto const spans = Wishlist{ mediator }.next(250, IsPieceOne);
+    auto const spans = Wishlist{ mediator }.next(250, peer_has);
     auto requested = tr_bitfield{ 250 };
     for (auto const& [begin, end] : spans)
     {
@@ -220,6 +220,125 @@ TEST_F(PeerMgrWishlistTest, doesNotRequestSameBlockTwice)
     EXPECT_EQ(240U, requested.count(10, 250));
 }
 
+TEST_F(PeerMgrWishlistTest, skipsPeersWithNothingLeftToRequest)
+{
+    auto mediator = MockMediator{};
+
+    // setup: three pieces, all missing
+    mediator.block_span_[0] = { .begin = 0, .end = 100 };
+    mediator.block_span_[1] = { .begin = 100, .end = 200 };
+    mediator.block_span_[2] = { .begin = 200, .end = 250 };
+
+    // all pieces are available
+    mediator.piece_replication_[0] = 2;
+    mediator.piece_replication_[1] = 2;
+    mediator.piece_replication_[2] = 2;
+
+    // and we want all three pieces
+    mediator.client_wants_piece_.insert(0);
+    mediator.client_wants_piece_.insert(1);
+    mediator.client_wants_piece_.insert(2);
+
+    auto wishlist = Wishlist{ mediator };
+
+    // a peer that only has piece 2
+    auto peer_has = tr_bitfield{ 3U };
+    peer_has.set(2U);
+
+    // once every block of piece 2 has been requested,
+    // that peer has nothing more to offer us
+    wishlist.on_sent_request(tr_block_span_t{ .begin = 200, .end = 250 });
+    EXPECT_TRUE(std::empty(wishlist.next(250, peer_has)));
+
+    // but a peer with all the pieces still does
+    auto requested = tr_bitfield{ 250 };
+    for (auto const& [begin, end] : wishlist.next(250, PeerHasAllPieces))
+    {
+        requested.set_span(begin, end);
+    }
+    EXPECT_EQ(200U, requested.count());
+    EXPECT_EQ(200U, requested.count(0, 200));
+
+    // if a request gets rejected, that block is available again
+    wishlist.on_got_reject(210U);
+    auto const spans = wishlist.next(250, peer_has);
+    ASSERT_EQ(1U, std::size(spans));
+    EXPECT_EQ(210U, spans.front().begin);
+    EXPECT_EQ(211U, spans.front().end);
+}
+
+TEST_F(PeerMgrWishlistTest, endgameDuplicatesInFlightBlocks)
+{
+    auto mediator = MockMediator{};
+
+    // setup: two pieces, all missing
+    mediator.block_span_[0] = { .begin = 0, .end = 10 };
+    mediator.block_span_[1] = { .begin = 10, .end = 20 };
+    mediator.piece_replication_[0] = 3;
+    mediator.piece_replication_[1] = 3;
+    mediator.client_wants_piece_.insert(0);
+    mediator.client_wants_piece_.insert(1);
+
+    auto wishlist = Wishlist{ mediator };
+    EXPECT_FALSE(wishlist.is_endgame());
+
+    // no duplicates until every block has been requested
+    auto no_requests = tr_bitfield{ 20U };
+    EXPECT_TRUE(std::empty(wishlist.next_endgame(20, PeerHasAllPieces, no_requests)));
+
+    // request everything from one peer
+    auto first_peer_requests = tr_bitfield{ 20U };
+    for (auto const& span : wishlist.next(20, PeerHasAllPieces))
+    {
+        wishlist.on_sent_request(span);
+        first_peer_requests.set_span(span.begin, span.end);
+    }
+    EXPECT_EQ(20U, first_peer_requests.count());
+    EXPECT_TRUE(wishlist.is_endgame());
+    EXPECT_TRUE(std::empty(wishlist.next(20, PeerHasAllPieces)));
+
+    // don't ask a peer for blocks that it already has requests for
+    EXPECT_TRUE(std::empty(wishlist.next_endgame(20, PeerHasAllPieces, first_peer_requests)));
+
+    // other peers can be asked for the same blocks, up to the limit
+    auto const count_blocks = [](std::vector<tr_block_span_t> const& spans)
+    {
+        auto n = size_t{};
+        for (auto const& [begin, end] : spans)
+        {
+            n += end - begin;
+        }
+        return n;
+    };
+
+    // duplicates that are picked but never sent don't count against the limit
+    for (size_t i = 0; i <= Wishlist::MaxEndgameDuplicates; ++i)
+    {
+        EXPECT_EQ(20U, count_blocks(wishlist.next_endgame(20, PeerHasAllPieces, no_requests)));
+    }
+
+    for (size_t i = 0; i < Wishlist::MaxEndgameDuplicates; ++i)
+    {
+        for (auto const& span : wishlist.next_endgame(20, PeerHasAllPieces, no_requests))
+        {
+            EXPECT_EQ(20U, span.end - span.begin);
+            wishlist.on_sent_request(span);
+        }
+    }
+    EXPECT_EQ(0U, count_blocks(wishlist.next_endgame(20, PeerHasAllPieces, no_requests)));
+
+    // cancelling a duplicate doesn't put the block back in the queue,
+    // since another copy of it is still in flight...
+    wishlist.on_sent_cancel(5U);
+    EXPECT_TRUE(std::empty(wishlist.next(20, PeerHasAllPieces)));
+    EXPECT_EQ(1U, count_blocks(wishlist.next_endgame(20, PeerHasAllPieces, no_requests)));
+
+    // ...but once the block arrives, it's no longer wanted from anyone
+    mediator.client_has_block_.insert(5U);
+    wishlist.on_got_block(5U);
+    EXPECT_EQ(0U, count_blocks(wishlist.next_endgame(20, PeerHasAllPieces, no_requests)));
+}
+
 TEST_F(PeerMgrWishlistTest, sequentialDownload)
 {
     auto const get_spans = [](size_t n_wanted)
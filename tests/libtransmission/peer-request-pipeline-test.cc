@@ -0,0 +1,266 @@
+// This file Copyright (C) 2026 Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <deque>
+#include <utility>
+
+#define LIBTRANSMISSION_PEER_MODULE
+
+#include <libtransmission/block-info.h>
+#include <libtransmission/peer-request-pipeline.h>
+
+#include <gtest/gtest.h>
+
+namespace tr::test
+{
+
+class PeerRequestPipelineTest : public ::testing::Test
+{
+protected:
+    struct Link
+    {
+        uint64_t bytes_per_sec;
+        uint64_t one_way_msec;
+        size_t reqq;
+    };
+
+    struct Result
+    {
+        uint64_t delivered_bytes = {};
+        size_t peak_outstanding = {};
+        double avg_outstanding = {};
+    };
+
+    // The request-queue sizing that peer-msgs used before RequestPipeline:
+    // ten seconds' worth of blocks at the recent download speed, at least 32.
+    struct LegacyPolicy
+    {
+        static void on_sent(tr_block_index_t /*block*/, uint64_t /*now_msec*/)
+        {
+        }
+
+        static void on_received(tr_block_index_t /*block*/, uint64_t /*now_msec*/)
+        {
+        }
+
+        [[nodiscard]] static size_t desired(uint64_t const recent_bytes_per_sec)
+        {
+            return std::max(size_t{ 32U }, static_cast<size_t>(recent_bytes_per_sec * 10U / tr_block_info::BlockSize));
+        }
+    };
+
+    struct PipelinePolicy
+    {
+        void on_sent(tr_block_index_t const block, uint64_t const now_msec)
+        {
+            pipeline.on_request_sent(block, now_msec);
+        }
+
+        void on_received(tr_block_index_t const block, uint64_t const now_msec)
+        {
+            pipeline.on_block_received(block, now_msec);
+        }
+
+        [[nodiscard]] size_t desired(uint64_t /*recent_bytes_per_sec*/) const
+        {
+            return pipeline.desired_requests();
+        }
+
+        RequestPipeline pipeline;
+    };
+
+    // Millisecond-step simulation of a peer that serves requests in order
+    // through a link with the given bandwidth and latency.
+    template<typename Policy>
+    static Result simulate(Link const& link, uint64_t const duration_msec, Policy&& policy)
+    {
+        static auto constexpr BlockSize = uint64_t{ tr_block_info::BlockSize };
+        static auto constexpr SpeedIntervalMsec = uint64_t{ 2000U };
+
+        auto to_peer = std::deque<std::pair<uint64_t, tr_block_index_t>>{};
+        auto peer_queue = std::deque<tr_block_index_t>{};
+        auto to_client = std::deque<std::pair<uint64_t, tr_block_index_t>>{};
+        auto recent = std::deque<uint64_t>{};
+        auto link_free_at = 0.0;
+        auto next_block = tr_block_index_t{};
+        auto outstanding = size_t{};
+        auto sum_outstanding = 0.0;
+        auto ret = Result{};
+
+        for (uint64_t now = 1U; now <= duration_msec; ++now)
+        {
+            while (!std::empty(to_peer) && to_peer.front().first <= now)
+            {
+                peer_queue.push_back(to_peer.front().second);
+                to_peer.pop_front();
+            }
+
+            while (!std::empty(peer_queue) && link_free_at <= static_cast<double>(now))
+            {
+                auto const start = std::max(link_free_at, static_cast<double>(now - 1U));
+                link_free_at = start + 1000.0 * BlockSize / link.bytes_per_sec;
+                to_client.emplace_back(static_cast<uint64_t>(link_free_at) + link.one_way_msec, peer_queue.front());
+                peer_queue.pop_front();
+            }
+
+            while (!std::empty(to_client) && to_client.front().first <= now)
+            {
+                policy.on_received(to_client.front().second, now);
+                to_client.pop_front();
+                --outstanding;
+                ret.delivered_bytes += BlockSize;
+                recent.push_back(now);
+            }
+
+            while (!std::empty(recent) && recent.front() + SpeedIntervalMsec <= now)
+            {
+                recent.pop_front();
+            }
+
+            auto const recent_speed = std::size(recent) * BlockSize * 1000U / SpeedIntervalMsec;
+            auto const desired = std::min(link.reqq, policy.desired(recent_speed));
+            while (outstanding < desired)
+            {
+                policy.on_sent(next_block, now);
+                to_peer.emplace_back(now + link.one_way_msec, next_block++);
+                ++outstanding;
+            }
+
+            ret.peak_outstanding = std::max(ret.peak_outstanding, outstanding);
+            sum_outstanding += outstanding;
+        }
+
+        ret.avg_outstanding = sum_outstanding / duration_msec;
+        return ret;
+    }
+};
+
+TEST_F(PeerRequestPipelineTest, fillsHighBdpLinksAtLeastAsFast)
+{
+    // 1 Gbit/s with a 200 ms round trip
+    static auto constexpr Fat = Link{ 125'000'000U, 100U, 2000U };
+
+    for (auto const duration_msec : { 1000U, 3000U })
+    {
+        auto const legacy = simulate(Fat, duration_msec, LegacyPolicy{});
+        auto const pipelined = simulate(Fat, duration_msec, PipelinePolicy{});
+        EXPECT_GE(pipelined.delivered_bytes, legacy.delivered_bytes) << duration_msec;
+    }
+}
+
+TEST_F(PeerRequestPipelineTest, doesNotOverRequestFromSlowPeers)
+{
+    // 200 KB/s with a 200 ms round trip
+    static auto constexpr Slow = Link{ 200'000U, 100U, 250U };
+    static auto constexpr DurationMsec = 30000U;
+
+    auto const legacy = simulate(Slow, DurationMsec, LegacyPolicy{});
+    auto const pipelined = simulate(Slow, DurationMsec, PipelinePolicy{});
+    EXPECT_GE(pipelined.delivered_bytes * 100U, legacy.delivered_bytes * 99U);
+    EXPECT_LE(pipelined.avg_outstanding * 4, legacy.avg_outstanding);
+
+    // 20 KB/s with a 100 ms round trip
+    static auto constexpr VerySlow = Link{ 20'000U, 50U, 500U };
+    EXPECT_LT(
+        simulate(VerySlow, DurationMsec, PipelinePolicy{}).avg_outstanding,
+        simulate(VerySlow, DurationMsec, LegacyPolicy{}).avg_outstanding);
+}
+
+TEST_F(PeerRequestPipelineTest, failedRequestsShrinkTheWindow)
+{
+    auto pipeline = RequestPipeline{};
+    EXPECT_TRUE(pipeline.is_ramping_up());
+    EXPECT_EQ(RequestPipeline::InitialWindow, pipeline.window());
+
+    pipeline.on_request_sent(0U, 1000U);
+    pipeline.on_request_sent(1U, 1000U);
+    pipeline.on_request_failed(0U);
+    EXPECT_FALSE(pipeline.is_ramping_up());
+    EXPECT_LT(pipeline.window(), RequestPipeline::InitialWindow);
+
+    // a reject for a request we're no longer tracking is not a signal
+    auto const window = pipeline.window();
+    pipeline.on_request_failed(0U);
+    EXPECT_EQ(window, pipeline.window());
+
+    for (int i = 0; i < 100; ++i)
+    {
+        pipeline.on_request_sent(2U, 1000U);
+        pipeline.on_request_failed(2U);
+    }
+    EXPECT_EQ(RequestPipeline::MinWindow, pipeline.window());
+}
+
+TEST_F(PeerRequestPipelineTest, failuresOutlastTheNextRateEstimate)
+{
+    auto pipeline = RequestPipeline{};
+    auto block = tr_block_index_t{};
+    auto now = uint64_t{ 1000U };
+
+    // a peer that sends a block every 10 ms, each 100 ms after we asked for it
+    auto const deliver = [&](uint64_t const msec)
+    {
+        for (auto const end = now + msec; now < end; now += 10U)
+        {
+            pipeline.on_request_sent(block, now - 100U);
+            pipeline.on_block_received(block++, now);
+        }
+    };
+
+    deliver(2000U);
+    ASSERT_FALSE(pipeline.is_ramping_up());
+    auto const steady = pipeline.window();
+
+    pipeline.on_request_sent(block, now);
+    pipeline.on_request_failed(block++);
+    EXPECT_LT(pipeline.window(), steady);
+
+    // the rate estimates of the next few rounds don't undo the shrink...
+    deliver(300U);
+    EXPECT_LT(pipeline.window(), steady);
+
+    // ...but once the peer keeps up for a while, the window grows back
+    deliver(5000U);
+    EXPECT_EQ(steady, pipeline.window());
+}
+
+TEST_F(PeerRequestPipelineTest, chokeDiscardsInFlightRequests)
+{
+    auto pipeline = RequestPipeline{};
+    pipeline.on_request_sent(0U, 1000U);
+    pipeline.on_choked();
+
+    // the peer rejecting a request that the choke discarded doesn't shrink the window
+    pipeline.on_request_failed(0U);
+    EXPECT_TRUE(pipeline.is_ramping_up());
+    EXPECT_EQ(RequestPipeline::InitialWindow, pipeline.window());
+
+    // and a late block for it doesn't produce an RTT sample
+    pipeline.on_block_received(0U, 5000U);
+    EXPECT_FALSE(pipeline.min_rtt_msec());
+}
+
+TEST_F(PeerRequestPipelineTest, honorsSpeedLimits)
+{
+    auto pipeline = RequestPipeline{};
+
+    // with no RTT sample yet, there's no BDP to cap to
+    EXPECT_EQ(RequestPipeline::InitialWindow, pipeline.desired_requests(0U));
+
+    pipeline.on_request_sent(0U, 1000U);
+    pipeline.on_block_received(0U, 1100U);
+    ASSERT_EQ(100U, pipeline.min_rtt_msec());
+    EXPECT_EQ(RequestPipeline::MinWindow, pipeline.desired_requests(0U));
+
+    // 1 MB/s * 100 ms is 100 KB, or 7 blocks, in flight; doubled for jitter
+    auto const window = pipeline.window();
+    EXPECT_EQ(std::min(window, size_t{ 7U * RequestPipeline::BdpGain + 1U }), pipeline.desired_requests(1'000'000U));
+    EXPECT_EQ(window, pipeline.desired_requests(1'000'000'000U));
+}
+
+} // namespace tr::test
@@ -5,19 +5,25 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef> // size_t
 #include <cstdint> // int64_t
 #include <future>
 #include <iterator> // std::inserter
+#include <limits>
 #include <set>
 #include <string_view>
 #include <vector>
 
 #include <gtest/gtest.h>
 
+#include <libtransmission/file.h>
+#include <libtransmission/metrics.h>
 #include <libtransmission/quark.h>
 #include <libtransmission/transmission.h>
 #include <libtransmission/rpcimpl.h>
+#include <libtransmission/tr-strbuf.h>
+#include <libtransmission/tracer.h>
 #include <libtransmission/variant.h>
 
 #include "test-fixtures.h"
@@ -686,6 +692,124 @@ TEST_F(RpcTest, sessionGet)
     tr_torrentRemove(tor, false);
 }
 
+TEST_F(RpcTest, sessionMetrics)
+{
+    tr::metrics::add(tr::metrics::Counter::DiskBytesRead, 100U);
+    tr::metrics::observe(tr::metrics::Histogram::DiskReadTime, 3ms);
+
+    auto request_map = tr_variant::Map{ 3U };
+    request_map.try_emplace(TR_KEY_jsonrpc, JsonRpc::Version);
+    request_map.try_emplace(TR_KEY_method, tr_variant::unmanaged_string(TR_KEY_session_metrics));
+    request_map.try_emplace(TR_KEY_id, 12345);
+    auto request = tr_variant{ std::move(request_map) };
+
+    auto response = tr_variant{};
+    tr_rpc_request_exec(session_, request, [&response](tr_variant&& resp) { response = std::move(resp); });
+
+    auto* response_map = response.get_if<tr_variant::Map>();
+    ASSERT_NE(response_map, nullptr);
+    auto* args_map = response_map->find_if<tr_variant::Map>(TR_KEY_result);
+    ASSERT_NE(args_map, nullptr);
+
+    auto* bounds = args_map->find_if<tr_variant::Vector>(TR_KEY_bucket_bounds);
+    ASSERT_NE(bounds, nullptr);
+    EXPECT_EQ(std::size(tr::metrics::BucketBounds), std::size(*bounds));
+
+    auto* counters = args_map->find_if<tr_variant::Map>(TR_KEY_counters);
+    ASSERT_NE(counters, nullptr);
+    EXPECT_EQ(tr::metrics::CounterCount, std::size(*counters));
+    EXPECT_LE(100, counters->value_if<int64_t>(tr_quark_new("disk_bytes_read"sv)).value_or(0));
+
+    auto* histograms = args_map->find_if<tr_variant::Map>(TR_KEY_histograms);
+    ASSERT_NE(histograms, nullptr);
+    EXPECT_EQ(tr::metrics::HistogramCount, std::size(*histograms));
+    auto* disk_read = histograms->find_if<tr_variant::Map>(tr_quark_new("disk_read_seconds"sv));
+    ASSERT_NE(disk_read, nullptr);
+    auto* buckets = disk_read->find_if<tr_variant::Vector>(TR_KEY_buckets);
+    ASSERT_NE(buckets, nullptr);
+    EXPECT_EQ(tr::metrics::BucketCount, std::size(*buckets));
+    EXPECT_LE(1, disk_read->value_if<int64_t>(TR_KEY_count).value_or(0));
+}
+
+TEST_F(RpcTest, sessionTrace)
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    auto params = tr_variant::Map{ 2U };
+    params.try_emplace(TR_KEY_enabled, true);
+    params.try_emplace(TR_KEY_threshold_ms, 5);
+
+    auto request_map = tr_variant::Map{ 4U };
+    request_map.try_emplace(TR_KEY_jsonrpc, JsonRpc::Version);
+    request_map.try_emplace(TR_KEY_method, tr_variant::unmanaged_string(TR_KEY_session_trace));
+    request_map.try_emplace(TR_KEY_params, std::move(params));
+    request_map.try_emplace(TR_KEY_id, 12345);
+    auto request = tr_variant{ std::move(request_map) };
+
+    auto response = tr_variant{};
+    tr_rpc_request_exec(session_, request, [&response](tr_variant&& resp) { response = std::move(resp); });
+    tr::tracer::record(tr::tracer::Kind::Task, "slow task"sv, now, now + 20ms);
+    tr_rpc_request_exec(session_, request, [&response](tr_variant&& resp) { response = std::move(resp); });
+
+    tr::tracer::set_enabled(false);
+    tr::tracer::set_threshold(10ms);
+    tr::tracer::clear();
+
+    auto* response_map = response.get_if<tr_variant::Map>();
+    ASSERT_NE(response_map, nullptr);
+    auto* args_map = response_map->find_if<tr_variant::Map>(TR_KEY_result);
+    ASSERT_NE(args_map, nullptr);
+    EXPECT_TRUE(args_map->value_if<bool>(TR_KEY_enabled).value_or(false));
+    EXPECT_EQ(5, args_map->value_if<int64_t>(TR_KEY_threshold_ms).value_or(0));
+
+    auto* events = args_map->find_if<tr_variant::Vector>(TR_KEY_events);
+    ASSERT_NE(events, nullptr);
+    auto const it = std::ranges::find_if(
+        *events,
+        [](tr_variant const& var)
+        {
+            auto const* const map = var.get_if<tr_variant::Map>();
+            return map != nullptr && map->value_if<std::string_view>(TR_KEY_name) == "slow task"sv;
+        });
+    ASSERT_NE(it, std::end(*events));
+    auto* event = it->get_if<tr_variant::Map>();
+    EXPECT_EQ("task"sv, event->value_if<std::string_view>(TR_KEY_kind).value_or(""sv));
+    EXPECT_EQ(20000, event->value_if<int64_t>(TR_KEY_duration_us).value_or(0));
+}
+
+TEST_F(RpcTest, sessionTraceSavesToConfigDir)
+{
+    auto params = tr_variant::Map{ 3U };
+    params.try_emplace(TR_KEY_threshold_ms, std::numeric_limits<int64_t>::max());
+    params.try_emplace(TR_KEY_filename, tr_pathbuf{ sandboxDir(), "/elsewhere.json"sv }.sv());
+    params.try_emplace(TR_KEY_save, true);
+
+    auto request_map = tr_variant::Map{ 4U };
+    request_map.try_emplace(TR_KEY_jsonrpc, JsonRpc::Version);
+    request_map.try_emplace(TR_KEY_method, tr_variant::unmanaged_string(TR_KEY_session_trace));
+    request_map.try_emplace(TR_KEY_params, std::move(params));
+    request_map.try_emplace(TR_KEY_id, 12345);
+    auto request = tr_variant{ std::move(request_map) };
+
+    auto response = tr_variant{};
+    tr_rpc_request_exec(session_, request, [&response](tr_variant&& resp) { response = std::move(resp); });
+    tr::tracer::set_threshold(10ms);
+
+    auto* response_map = response.get_if<tr_variant::Map>();
+    ASSERT_NE(response_map, nullptr);
+    auto* args_map = response_map->find_if<tr_variant::Map>(TR_KEY_result);
+    ASSERT_NE(args_map, nullptr);
+
+    // huge thresholds are clamped instead of overflowing
+    EXPECT_EQ(60000, args_map->value_if<int64_t>(TR_KEY_threshold_ms).value_or(0));
+
+    // the trace is always saved to the same file in the config dir
+    auto const expected = tr_pathbuf{ session_->configDir(), "/trace.json"sv };
+    EXPECT_EQ(expected.sv(), args_map->value_if<std::string_view>(TR_KEY_filename).value_or(""sv));
+    EXPECT_TRUE(tr_sys_path_exists(expected));
+    EXPECT_FALSE(tr_sys_path_exists(tr_pathbuf{ sandboxDir(), "/elsewhere.json"sv }));
+}
+
 TEST_F(RpcTest, torrentGet)
 {
     auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
@@ -11,6 +11,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -20,6 +21,7 @@
 #include <libtransmission/quark.h>
 #include <libtransmission/session-id.h>
 #include <libtransmission/session.h>
+#include <libtransmission/utils.h> // tr_time()
 #include <libtransmission/variant.h>
 #include <libtransmission/version.h>
 
@@ -328,6 +330,28 @@ TEST_F(SessionTest, savesSettings)
     }
 }
 
+TEST_F(SessionTest, honorsWebWorkerCount)
+{
+    EXPECT_EQ(2U, webWorkerCount(session_));
+
+    // from the settings the session starts with
+    auto settings = tr_sessionGetDefaultSettings();
+    auto* settings_map = settings.get_if<tr_variant::Map>();
+    ASSERT_NE(settings_map, nullptr);
+    settings_map->insert_or_assign(TR_KEY_web_worker_count, 4);
+    auto* session = tr_sessionInit(sandboxDir(), false, settings);
+    EXPECT_EQ(4U, webWorkerCount(session));
+    tr_sessionClose(session, 0.5);
+
+    // and from settings changed later
+    settings = tr_sessionGetSettings(session_);
+    settings_map = settings.get_if<tr_variant::Map>();
+    ASSERT_NE(settings_map, nullptr);
+    settings_map->insert_or_assign(TR_KEY_web_worker_count, 3);
+    tr_sessionSet(session_, settings);
+    EXPECT_EQ(3U, webWorkerCount(session_));
+}
+
 TEST_F(SessionTest, loadTorrentsThenMagnets)
 {
     static auto constexpr TorrentFile = LIBTRANSMISSION_TEST_ASSETS_DIR "/archlinux-2025.05.01-x86_64.iso.torrent";
@@ -357,4 +381,20 @@ TEST_F(SessionTest, loadTorrentsThenMagnets)
     EXPECT_TRUE(tor->has_metainfo());
 }
 
+TEST_F(SessionTest, getTorrentsChangedSince)
+{
+    auto const before = tr_time() - 1;
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    ASSERT_NE(tor, nullptr);
+
+    // the torrent was added and verified, so it's changed
+    auto const expected = std::vector<tr_torrent_id_t>{ tr_torrentId(tor) };
+    EXPECT_EQ(expected, tr_sessionGetTorrentsChangedSince(session_, before));
+
+    // but nothing can have changed after now
+    EXPECT_TRUE(std::empty(tr_sessionGetTorrentsChangedSince(session_, tr_time())));
+
+    tr_torrentRemove(tor, false);
+}
+
 } // namespace tr::test
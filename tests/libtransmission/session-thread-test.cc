@@ -0,0 +1,200 @@
+// This file Copyright (C) 2026 Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <functional>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/session-thread.h>
+#include <libtransmission/tracer.h>
+
+using namespace std::literals;
+
+namespace tr::test
+{
+
+class SessionThreadTest : public ::testing::Test
+{
+protected:
+    [[nodiscard]] static auto createWithSlotHook(std::function<void()> on_slot_claimed)
+    {
+        return tr_session_thread::create_with_slot_hook(std::move(on_slot_claimed));
+    }
+};
+
+TEST_F(SessionThreadTest, runsQueuedTasksInSessionThread)
+{
+    auto const session_thread = tr_session_thread::create();
+
+    auto promise = std::promise<bool>{};
+    auto future = promise.get_future();
+    session_thread->queue([&]() { promise.set_value(session_thread->am_in_session_thread()); });
+
+    ASSERT_EQ(std::future_status::ready, future.wait_for(5s));
+    EXPECT_TRUE(future.get());
+    EXPECT_FALSE(session_thread->am_in_session_thread());
+}
+
+TEST_F(SessionThreadTest, namesTracedTasksAfterTheirCaller)
+{
+    auto const session_thread = tr_session_thread::create();
+    tr::tracer::clear();
+    tr::tracer::set_threshold(0ms);
+    tr::tracer::set_enabled(true);
+
+    session_thread->queue([]() {});
+
+    // The first task's span is recorded once it returns,
+    // so it's there by the time that the second task runs
+    auto promise = std::promise<void>{};
+    auto future = promise.get_future();
+    session_thread->queue([&promise]() { promise.set_value(); });
+    ASSERT_EQ(std::future_status::ready, future.wait_for(5s));
+
+    auto const events = tr::tracer::events();
+    EXPECT_TRUE(std::ranges::any_of(
+        events,
+        [](auto const& event)
+        {
+            return event.kind == tr::tracer::Kind::Task &&
+                event.name.find("SessionThreadTest_namesTracedTasksAfterTheirCaller_Test"sv) != std::string::npos;
+        }));
+
+    tr::tracer::set_enabled(false);
+    tr::tracer::clear();
+}
+
+TEST_F(SessionThreadTest, keepsPerProducerOrderUnderLoad)
+{
+    // Enough tasks to overrun the ring and exercise the overflow path
+    static auto constexpr NumProducers = size_t{ 4U };
+    static auto constexpr TasksPerProducer = size_t{ 20000U };
+
+    auto const session_thread = tr_session_thread::create();
+
+    // only touched from the session thread
+    auto next_expected = std::vector<size_t>(NumProducers);
+    auto n_out_of_order = size_t{};
+    auto n_run = std::atomic<size_t>{};
+
+    auto producers = std::vector<std::thread>{};
+    for (size_t producer = 0; producer < NumProducers; ++producer)
+    {
+        producers.emplace_back(
+            [&, producer]()
+            {
+                for (size_t i = 0; i < TasksPerProducer; ++i)
+                {
+                    session_thread->queue(
+                        [&, producer, i]()
+                        {
+                            if (next_expected[producer]++ != i)
+                            {
+                                ++n_out_of_order;
+                            }
+
+                            ++n_run;
+                        });
+                }
+            });
+    }
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    auto promise = std::promise<void>{};
+    auto future = promise.get_future();
+    session_thread->queue([&promise]() { promise.set_value(); });
+    ASSERT_EQ(std::future_status::ready, future.wait_for(10s));
+
+    EXPECT_EQ(NumProducers * TasksPerProducer, n_run.load());
+    EXPECT_EQ(0U, n_out_of_order);
+
+    auto const stats = session_thread->queue_stats();
+    EXPECT_EQ(NumProducers * TasksPerProducer + 1U, stats.n_tasks);
+    EXPECT_GT(stats.max_depth, 0U);
+    EXPECT_LE(stats.max_latency, stats.total_latency);
+}
+
+TEST_F(SessionThreadTest, keepsOrderWhenAProducerStallsMidPush)
+{
+    // More tasks than the lock-free queue holds, so that some overflow
+    static auto constexpr NumTasks = size_t{ 10000U };
+
+    auto stall_next_push = std::atomic<bool>{ false };
+    auto claimed = std::promise<void>{};
+    auto resume = std::promise<void>{};
+    auto resume_future = resume.get_future().share();
+
+    auto const session_thread = createWithSlotHook(
+        [&]()
+        {
+            if (stall_next_push.exchange(false))
+            {
+                claimed.set_value();
+                resume_future.wait();
+            }
+        });
+
+    // Keep the session thread busy while the queue fills up
+    auto gate_entered = std::promise<void>{};
+    auto gate = std::promise<void>{};
+    auto gate_future = gate.get_future().share();
+    session_thread->queue(
+        [&]()
+        {
+            gate_entered.set_value();
+            gate_future.wait();
+        });
+    ASSERT_EQ(std::future_status::ready, gate_entered.get_future().wait_for(5s));
+
+    // This producer claims the first free slot, then stalls before publishing its task
+    stall_next_push = true;
+    auto stalled_producer = std::thread{ [&]() { session_thread->queue([]() {}); } };
+    ASSERT_EQ(std::future_status::ready, claimed.get_future().wait_for(5s));
+
+    // Another producer fills the rest of the queue, then spills into the overflow list
+    auto n_run = size_t{};
+    auto n_out_of_order = size_t{};
+    for (size_t i = 0; i < NumTasks; ++i)
+    {
+        session_thread->queue(
+            [&, i]()
+            {
+                if (n_run++ != i)
+                {
+                    ++n_out_of_order;
+                }
+            });
+    }
+
+    // Let the session thread run into the stalled slot before it's published
+    gate.set_value();
+    std::this_thread::sleep_for(100ms);
+    resume.set_value();
+    stalled_producer.join();
+
+    auto promise = std::promise<void>{};
+    auto future = promise.get_future();
+    session_thread->queue([&promise]() { promise.set_value(); });
+    ASSERT_EQ(std::future_status::ready, future.wait_for(10s));
+
+    EXPECT_EQ(NumTasks, n_run);
+    EXPECT_EQ(0U, n_out_of_order);
+}
+
+} // namespace tr::test
@@ -31,6 +31,7 @@
 #include <libtransmission/torrent.h>
 #include <libtransmission/utils.h>
 #include <libtransmission/variant.h>
+#include <libtransmission/web.h>
 
 using namespace std::literals;
 
@@ -507,6 +508,11 @@ protected:
         verified_cv_.wait_for(verified_lock, 20s, stop_waiting);
     }
 
+    [[nodiscard]] static size_t webWorkerCount(tr_session const* const session)
+    {
+        return session->web_->worker_count();
+    }
+
     tr_session* session_ = nullptr;
 
     tr_variant* settings()
@@ -0,0 +1,117 @@
+// This file Copyright (C) 2026 Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <ctime> // time_t
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/timer-wheel.h>
+
+namespace
+{
+auto constexpr Start = time_t{ 1'700'000'000 };
+
+[[nodiscard]] auto sorted(std::vector<int> vec)
+{
+    std::ranges::sort(vec);
+    return vec;
+}
+} // namespace
+
+TEST(TimerWheel, returnsKeysWhenDue)
+{
+    auto wheel = tr_timer_wheel<int>{ Start };
+    wheel.add(Start + 5, 5);
+    wheel.add(Start + 1, 1);
+    wheel.add(Start + 1, 11);
+    EXPECT_EQ(3U, wheel.size());
+
+    EXPECT_TRUE(std::empty(wheel.advance(Start)));
+    EXPECT_EQ((std::vector<int>{ 1, 11 }), sorted(wheel.advance(Start + 1)));
+    EXPECT_TRUE(std::empty(wheel.advance(Start + 4)));
+    EXPECT_EQ((std::vector<int>{ 5 }), wheel.advance(Start + 10));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, keysInThePastAreDueImmediately)
+{
+    auto wheel = tr_timer_wheel<int>{ Start };
+    wheel.add(Start - 100, 1);
+    wheel.add(Start, 2);
+    wheel.add(0, 3);
+
+    // even if time hasn't moved
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), sorted(wheel.advance(Start)));
+}
+
+TEST(TimerWheel, matchesANaiveScheduler)
+{
+    // due times that land in every level, across wraparounds, and past the end of the wheel
+    auto const offsets = std::vector<time_t>{ 0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 10'000, 262'143, 262'144,
+                                              300'000, 16'777'215, 16'777'216, 20'000'000 };
+
+    auto wheel = tr_timer_wheel<int>{ Start };
+    auto expected = std::map<time_t, std::vector<int>>{};
+    for (size_t i = 0; i < std::size(offsets); ++i)
+    {
+        auto const when = Start + offsets[i];
+        wheel.add(when, static_cast<int>(i));
+        expected[when].push_back(static_cast<int>(i));
+    }
+
+    // Walk forward in uneven strides, sometimes far enough to jump
+    auto now = Start - 1;
+    auto n_seen = size_t{};
+    auto stride = time_t{ 1 };
+    while (!wheel.empty())
+    {
+        auto const prev = now;
+        now += stride;
+        stride = stride * 3 + 1;
+
+        auto want = std::vector<int>{};
+        for (auto it = expected.upper_bound(prev); it != std::end(expected) && it->first <= now; ++it)
+        {
+            want.insert(std::end(want), std::begin(it->second), std::end(it->second));
+        }
+
+        auto const got = sorted(wheel.advance(now));
+        EXPECT_EQ(sorted(want), got) << "now - Start == " << (now - Start);
+        n_seen += std::size(got);
+    }
+
+    EXPECT_EQ(std::size(offsets), n_seen);
+}
+
+TEST(TimerWheel, stepsOneSecondAtATime)
+{
+    static auto constexpr Duration = time_t{ 10'000 };
+
+    auto wheel = tr_timer_wheel<time_t>{ Start };
+    for (time_t when = Start + 1; when <= Start + Duration; when += 7)
+    {
+        wheel.add(when, when);
+    }
+
+    for (time_t now = Start + 1; now <= Start + Duration; ++now)
+    {
+        auto const due = wheel.advance(now);
+        if ((now - Start - 1) % 7 == 0)
+        {
+            ASSERT_EQ(1U, std::size(due)) << now;
+            EXPECT_EQ(now, due.front());
+        }
+        else
+        {
+            ASSERT_TRUE(std::empty(due)) << now;
+        }
+    }
+
+    EXPECT_TRUE(wheel.empty());
+}
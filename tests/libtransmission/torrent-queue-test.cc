@@ -3,10 +3,16 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
+#include <cstddef> // std::ptrdiff_t
+#include <cstdint> // uint32_t
 #include <fstream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string_view>
+#include <tuple> // std::ignore
+#include <utility> // std::minmax()
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -180,3 +186,86 @@ TEST_F(TorrentQueueTest, toFromFile)
         EXPECT_EQ(filenames[i], owned[i]->store_filename());
     }
 }
+
+TEST_F(TorrentQueueTest, getQueuedInQueueOrder)
+{
+    auto queue = tr_torrent_queue{ mediator_ };
+    for (tr_torrent_id_t id = 1; id <= 6; ++id)
+    {
+        queue.add(id);
+    }
+
+    queue.set_queued(2, tr_direction::Down);
+    queue.set_queued(3, tr_direction::Up);
+    queue.set_queued(5, tr_direction::Down);
+    queue.set_queued(6, tr_direction::Down);
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 2, 5, 6 }), queue.get_queued(tr_direction::Down, 10U));
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 2, 5 }), queue.get_queued(tr_direction::Down, 2U));
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 3 }), queue.get_queued(tr_direction::Up, 10U));
+
+    // moving a torrent keeps its queued state
+    std::ignore = queue.set_pos(6, 0U);
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 6, 2, 5 }), queue.get_queued(tr_direction::Down, 10U));
+
+    // changing direction, e.g. when a download finishes
+    queue.set_queued(2, tr_direction::Up);
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 6, 5 }), queue.get_queued(tr_direction::Down, 10U));
+    EXPECT_EQ((std::vector<tr_torrent_id_t>{ 2, 3 }), queue.get_queued(tr_direction::Up, 10U));
+
+    queue.set_queued(5, std::nullopt);
+    queue.remove(6);
+    EXPECT_TRUE(std::empty(queue.get_queued(tr_direction::Down, 10U)));
+    EXPECT_EQ(0U, queue.get_queued(tr_direction::Up, 0U).size());
+}
+
+TEST_F(TorrentQueueTest, positionsMatchAVector)
+{
+    static auto constexpr NumTorrents = tr_torrent_id_t{ 500 };
+
+    auto queue = tr_torrent_queue{ mediator_ };
+    auto expected = std::vector<tr_torrent_id_t>{};
+    for (tr_torrent_id_t id = 1; id <= NumTorrents; ++id)
+    {
+        queue.add(id);
+        expected.push_back(id);
+    }
+
+    // move torrents around with a fixed pseudorandom sequence
+    auto seed = uint32_t{ 1 };
+    auto const next_rand = [&seed](size_t upper_bound)
+    {
+        seed = seed * 1103515245U + 12345U;
+        return static_cast<size_t>(seed >> 8U) % upper_bound;
+    };
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto const old_pos = next_rand(std::size(expected));
+        auto const new_pos = next_rand(std::size(expected));
+        auto const id = expected[old_pos];
+
+        auto changed = queue.set_pos(id, new_pos);
+        auto const [lo, hi] = std::minmax(old_pos, new_pos);
+        expected.erase(std::begin(expected) + static_cast<std::ptrdiff_t>(old_pos));
+        expected.insert(std::begin(expected) + static_cast<std::ptrdiff_t>(new_pos), id);
+        auto expected_changed = old_pos == new_pos ?
+            std::vector<tr_torrent_id_t>{} :
+            std::vector<tr_torrent_id_t>(
+                std::begin(expected) + static_cast<std::ptrdiff_t>(lo),
+                std::begin(expected) + static_cast<std::ptrdiff_t>(hi) + 1);
+        std::ranges::sort(changed);
+        std::ranges::sort(expected_changed);
+        ASSERT_EQ(expected_changed, changed);
+
+        if (i % 100 == 0)
+        {
+            queue.remove(expected.back());
+            expected.pop_back();
+        }
+    }
+
+    ASSERT_EQ(std::size(expected), queue.size());
+    for (size_t pos = 0; pos < std::size(expected); ++pos)
+    {
+        EXPECT_EQ(pos, queue.get_pos(expected[pos]));
+    }
+}
@@ -15,6 +15,7 @@
 
 #include <libtransmission/transmission.h>
 
+#include <libtransmission/crypto-utils.h>
 #include <libtransmission/torrent.h>
 #include <libtransmission/torrents.h>
 #include <libtransmission/torrent-metainfo.h>
@@ -254,6 +255,65 @@ TEST_F(TorrentsTest, rangedLoop)
     EXPECT_EQ(0U, std::size(torrents_set));
 }
 
+TEST_F(TorrentsTest, hashLookupsSurviveRemoval)
+{
+    auto constexpr Filenames = std::array<std::string_view, 4>{ "Android-x86 8.1 r6 iso.torrent"sv,
+                                                                "debian-11.2.0-amd64-DVD-1.iso.torrent"sv,
+                                                                "ubuntu-18.04.6-desktop-amd64.iso.torrent"sv,
+                                                                "ubuntu-20.04.4-desktop-amd64.iso.torrent"sv };
+
+    auto owned = std::vector<std::unique_ptr<tr_torrent>>{};
+    auto torrents = tr_torrents{};
+
+    for (auto const& name : Filenames)
+    {
+        auto const path = tr_pathbuf{ LIBTRANSMISSION_TEST_ASSETS_DIR, '/', name };
+        auto tm = tr_torrent_metainfo{};
+        EXPECT_TRUE(tm.parse_torrent_file(path));
+        owned.emplace_back(std::make_unique<tr_torrent>(std::move(tm)));
+
+        auto* const tor = owned.back().get();
+        tor->init_id(torrents.add(tor));
+    }
+
+    auto const obfuscated = [](tr_torrent const* const tor)
+    {
+        return tr_sha1::digest("req2"sv, tor->info_hash());
+    };
+
+    for (auto const& tor : owned)
+    {
+        EXPECT_EQ(tor.get(), torrents.get(tor->info_hash()));
+        EXPECT_EQ(tor.get(), torrents.find_from_obfuscated_hash(obfuscated(tor.get())));
+    }
+    EXPECT_EQ(nullptr, torrents.find_from_obfuscated_hash(owned.front()->info_hash()));
+
+    // remove one from the middle; the others should still be found
+    auto const* const removed = owned[1].get();
+    torrents.remove(removed, time(nullptr));
+    EXPECT_EQ(std::size(Filenames) - 1U, std::size(torrents));
+    EXPECT_EQ(nullptr, torrents.get(removed->info_hash()));
+    EXPECT_EQ(nullptr, torrents.find_from_obfuscated_hash(obfuscated(removed)));
+
+    for (auto const& tor : owned)
+    {
+        if (tor.get() != removed)
+        {
+            EXPECT_EQ(tor.get(), torrents.get(tor->info_hash()));
+            EXPECT_EQ(tor.get(), torrents.get(tor->id()));
+            EXPECT_EQ(tor.get(), torrents.find_from_obfuscated_hash(obfuscated(tor.get())));
+        }
+    }
+
+    auto n_iterated = size_t{};
+    for (auto const* const tor : torrents)
+    {
+        EXPECT_NE(removed, tor);
+        ++n_iterated;
+    }
+    EXPECT_EQ(std::size(torrents), n_iterated);
+}
+
 TEST_F(TorrentsTest, removedSince)
 {
     auto constexpr Filenames = std::array<std::string_view, 4>{ "Android-x86 8.1 r6 iso.torrent"sv,
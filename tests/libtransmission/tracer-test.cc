@@ -0,0 +1,151 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // int64_t
+#include <string_view>
+#include <typeinfo>
+
+#include <fmt/format.h>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/quark.h>
+#include <libtransmission/tracer.h>
+#include <libtransmission/variant.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+class TracerTest : public ::tr::test::TransmissionTest
+{
+protected:
+    void SetUp() override
+    {
+        TransmissionTest::SetUp();
+
+        old_threshold_ = tr::tracer::threshold();
+        tr::tracer::clear();
+        tr::tracer::set_threshold(10ms);
+        tr::tracer::set_enabled(true);
+    }
+
+    void TearDown() override
+    {
+        tr::tracer::set_enabled(false);
+        tr::tracer::set_threshold(old_threshold_);
+        tr::tracer::clear();
+
+        TransmissionTest::TearDown();
+    }
+
+    static void record(
+        std::string_view const name,
+        std::chrono::microseconds const duration,
+        std::chrono::microseconds const lag = {})
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        tr::tracer::record(tr::tracer::Kind::Timer, name, begin, begin + duration, lag);
+    }
+
+private:
+    std::chrono::microseconds old_threshold_ = {};
+};
+
+TEST_F(TracerTest, keepsOnlySlowOrLateEvents)
+{
+    record("fast"sv, 1ms);
+    record("slow"sv, 20ms);
+    record("late"sv, 1ms, 30ms);
+
+    auto const events = tr::tracer::events();
+    ASSERT_EQ(2U, std::size(events));
+    EXPECT_EQ("slow"sv, events[0].name);
+    EXPECT_EQ(20ms, events[0].duration);
+    EXPECT_EQ(tr::tracer::Kind::Timer, events[0].kind);
+    EXPECT_EQ("late"sv, events[1].name);
+    EXPECT_EQ(1ms, events[1].duration);
+    EXPECT_EQ(30ms, events[1].lag);
+}
+
+TEST_F(TracerTest, spanRecordsItsLifetime)
+{
+    tr::tracer::set_threshold(0ms);
+
+    {
+        auto const span = tr::tracer::Span{ tr::tracer::Kind::Rpc, "session_get"sv };
+    }
+
+    auto const events = tr::tracer::events();
+    ASSERT_EQ(1U, std::size(events));
+    EXPECT_EQ("session_get"sv, events[0].name);
+    EXPECT_EQ(tr::tracer::Kind::Rpc, events[0].kind);
+}
+
+TEST_F(TracerTest, disabledRecordsNothing)
+{
+    tr::tracer::set_enabled(false);
+    tr::tracer::set_threshold(0ms);
+
+    record("slow"sv, 20ms);
+    {
+        auto const span = tr::tracer::Span{ tr::tracer::Kind::Task, "task"sv };
+    }
+
+    EXPECT_TRUE(std::empty(tr::tracer::events()));
+}
+
+TEST_F(TracerTest, keepsTheMostRecentEvents)
+{
+    static auto constexpr N = tr::tracer::Capacity + 10U;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        record(fmt::format("{:d}", i), 20ms);
+    }
+
+    auto const events = tr::tracer::events();
+    ASSERT_EQ(tr::tracer::Capacity, std::size(events));
+    EXPECT_EQ("10"sv, events.front().name);
+    EXPECT_EQ(fmt::format("{:d}", N - 1U), events.back().name);
+}
+
+TEST_F(TracerTest, chromeTraceFormat)
+{
+    record("slow"sv, 20ms, 15ms);
+
+    auto const var = tr::tracer::to_chrome_trace(tr::tracer::events());
+    auto const* const map = var.get_if<tr_variant::Map>();
+    ASSERT_NE(map, nullptr);
+
+    auto const* const trace_events = map->find_if<tr_variant::Vector>(TR_KEY_trace_events_camel);
+    ASSERT_NE(trace_events, nullptr);
+    ASSERT_EQ(1U, std::size(*trace_events));
+
+    auto const* const event = (*trace_events)[0].get_if<tr_variant::Map>();
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ("slow"sv, event->value_if<std::string_view>(TR_KEY_name).value_or(""sv));
+    EXPECT_EQ("timer"sv, event->value_if<std::string_view>(TR_KEY_cat).value_or(""sv));
+    EXPECT_EQ("X"sv, event->value_if<std::string_view>(TR_KEY_ph).value_or(""sv));
+    EXPECT_EQ(20000, event->value_if<int64_t>(TR_KEY_dur).value_or(0));
+
+    auto const* const args = event->find_if<tr_variant::Map>(TR_KEY_args);
+    ASSERT_NE(args, nullptr);
+    EXPECT_EQ(15000, args->value_if<int64_t>(TR_KEY_lag_us).value_or(0));
+}
+
+TEST_F(TracerTest, typeNamesAreReadable)
+{
+    auto const lambda = []() {};
+    auto const name = tr::tracer::type_name(typeid(lambda));
+
+    // names the function that the lambda was written in
+    EXPECT_NE(std::string_view::npos, name.find("TracerTest_typeNamesAreReadable_Test"sv)) << name;
+
+    // and is looked up once
+    EXPECT_EQ(std::data(name), std::data(tr::tracer::type_name(typeid(lambda))));
+}
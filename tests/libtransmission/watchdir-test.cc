@@ -4,6 +4,7 @@
 // License text can be found in the licenses/ folder.
 
 #include <chrono>
+#include <cstddef> // size_t
 #include <cstdint>
 #include <memory>
 #include <set>
@@ -76,7 +77,8 @@ protected:
         SandboxedTest::TearDown();
     }
 
-    auto createWatchDir(std::string_view path, Watchdir::Callback callback)
+    template<typename CallbackT>
+    auto createWatchDir(std::string_view path, CallbackT callback)
     {
         auto const force_generic = GetParam() == WatchMode::GENERIC;
         auto watchdir = force_generic ?
@@ -218,6 +220,95 @@ TEST_P(WatchDirTest, watch)
     EXPECT_TRUE(std::empty(names));
 }
 
+TEST_P(WatchDirTest, batchesFiles)
+{
+    auto const path = sandboxDir();
+
+    // setup: lots of files that are there before the watchdir starts
+    static auto constexpr NumFiles = 20U;
+    for (size_t i = 0; i < NumFiles; ++i)
+    {
+        createFile(path, fmt::format("test{:d}", i));
+    }
+
+    auto batches = std::vector<std::vector<std::string>>{};
+    auto callback = [&batches](std::string_view /*dirname*/, std::vector<std::string> const& basenames)
+    {
+        batches.emplace_back(basenames);
+        return std::vector<Watchdir::Action>(std::size(basenames), Watchdir::Action::Done);
+    };
+    auto watchdir = createWatchDir(path, callback);
+    processEvents();
+
+    // the initial scan should find them all at once
+    ASSERT_EQ(1U, std::size(batches));
+    EXPECT_EQ(NumFiles, std::size(batches.front()));
+}
+
+TEST_P(WatchDirTest, forgetsRemovedFiles)
+{
+    auto const path = sandboxDir();
+
+    auto names = std::vector<std::string>{};
+    auto callback = [&names](std::string_view /*dirname*/, std::string_view basename)
+    {
+        names.emplace_back(basename);
+        return Watchdir::Action::Done;
+    };
+    auto watchdir = createWatchDir(path, callback);
+    auto const* const base_watchdir = dynamic_cast<impl::BaseWatchdir const*>(watchdir.get());
+    ASSERT_NE(nullptr, base_watchdir);
+    processEvents();
+
+    auto const test_file = "test.txt"sv;
+    createFile(path, test_file);
+    processEvents();
+    EXPECT_EQ(1U, std::size(names));
+    EXPECT_EQ(1U, base_watchdir->handledCount());
+
+    // removing the file should forget it...
+    tr_sys_path_remove(tr_pathbuf{ path, '/', test_file });
+    processEvents();
+    EXPECT_EQ(0U, base_watchdir->handledCount());
+
+    // ...so a new file with the same name is seen
+    createFile(path, test_file);
+    processEvents();
+    EXPECT_EQ(2U, std::size(names));
+}
+
+TEST_P(WatchDirTest, stopsRetryingFilesThatAreNoLongerFiles)
+{
+    auto const path = sandboxDir();
+
+    auto n_calls = size_t{};
+    auto callback = [&n_calls](std::string_view /*dirname*/, std::string_view /*basename*/)
+    {
+        ++n_calls;
+        return Watchdir::Action::Retry;
+    };
+    auto watchdir = createWatchDir(path, callback);
+    auto const* const base_watchdir = dynamic_cast<impl::BaseWatchdir const*>(watchdir.get());
+    ASSERT_NE(nullptr, base_watchdir);
+    processEvents();
+
+    auto const test_file = "test.txt"sv;
+    createFile(path, test_file);
+    processEvents();
+    EXPECT_LE(1U, n_calls);
+    EXPECT_EQ(1U, base_watchdir->pendingCount());
+
+    // once the name isn't a regular file anymore, its retry is dropped instead of rescheduled
+    tr_sys_path_remove(tr_pathbuf{ path, '/', test_file });
+    createDir(path, test_file);
+    processEvents();
+    EXPECT_EQ(0U, base_watchdir->pendingCount());
+
+    n_calls = 0U;
+    processEvents();
+    EXPECT_EQ(0U, n_calls);
+}
+
 // TODO(ckerr): flaky test should be fixed instead of disabled
 TEST_P(WatchDirTest, DISABLED_retry)
 {
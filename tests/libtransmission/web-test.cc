@@ -0,0 +1,232 @@
+// This file Copyright (C) 2026 Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <array>
+#include <chrono>
+#include <cstddef> // size_t
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/net.h>
+#include <libtransmission/web.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+namespace tr::test
+{
+
+class WebTest : public TransmissionTest
+{
+protected:
+    using Priority = tr_web::FetchOptions::Priority;
+
+    // Records which thread finished each fetch
+    class MediatorMock final : public tr_web::Mediator
+    {
+    public:
+        explicit MediatorMock(size_t const worker_count)
+            : worker_count_{ worker_count }
+        {
+        }
+
+        [[nodiscard]] size_t worker_count() const override
+        {
+            return worker_count_;
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-rvalue-reference-param-not-moved)
+        void run(tr_web::FetchDoneFunc&& func, tr_web::FetchResponse&& response) const override
+        {
+            {
+                auto const lock = std::scoped_lock{ mutex_ };
+                threads_.try_emplace(response.user_data, std::this_thread::get_id());
+            }
+
+            func(response);
+        }
+
+        [[nodiscard]] size_t n_done() const
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+            return std::size(threads_);
+        }
+
+        [[nodiscard]] std::thread::id thread_for(void const* const user_data) const
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+            auto const iter = threads_.find(user_data);
+            return iter != std::end(threads_) ? iter->second : std::thread::id{};
+        }
+
+    private:
+        size_t const worker_count_;
+        mutable std::mutex mutex_;
+        mutable std::map<void const*, std::thread::id> threads_;
+    };
+
+    // Accepts connections but never answers them,
+    // so that fetches from it stay in flight until they time out
+    class SilentServer
+    {
+    public:
+        SilentServer()
+            : sock_{ tr_netBindTCP(*tr_address::from_string("127.0.0.1"sv), tr_port{}, true) }
+        {
+            auto ss = sockaddr_storage{};
+            auto sslen = socklen_t{ sizeof(ss) };
+            if (is_valid_socket(sock_) && getsockname(sock_, reinterpret_cast<sockaddr*>(&ss), &sslen) == 0)
+            {
+                if (auto const addr = tr_socket_address::from_sockaddr(reinterpret_cast<sockaddr const*>(&ss)); addr)
+                {
+                    url_ = fmt::format("http://{:s}/", addr->display_name());
+                }
+            }
+        }
+
+        ~SilentServer()
+        {
+            if (is_valid_socket(sock_))
+            {
+                tr_net_close_socket(sock_);
+            }
+        }
+
+        SilentServer(SilentServer const&) = delete;
+        SilentServer(SilentServer&&) = delete;
+        SilentServer& operator=(SilentServer const&) = delete;
+        SilentServer& operator=(SilentServer&&) = delete;
+
+        [[nodiscard]] constexpr auto const& url() const noexcept
+        {
+            return url_;
+        }
+
+    private:
+        tr_socket_t const sock_;
+        std::string url_;
+    };
+
+    static void fetch(tr_web& web, std::string_view url, Priority const priority, void* const user_data)
+    {
+        auto options = tr_web::FetchOptions{ url, [](tr_web::FetchResponse const& /*response*/) {}, user_data, 1s };
+        options.priority = priority;
+        web.fetch(std::move(options));
+    }
+};
+
+TEST_F(WebTest, bulkRequestsGetWorkersOfTheirOwn)
+{
+    auto const server = SilentServer{};
+    ASSERT_FALSE(std::empty(server.url()));
+
+    auto mediator = MediatorMock{ 3U };
+    auto const web = tr_web::create(mediator);
+
+    // the addresses are only used as keys
+    auto tags = std::array<int, 5U>{};
+    auto* const high = &tags[0];
+    auto* const normal = &tags[1];
+    auto* const bulk_a = &tags[2];
+    auto* const bulk_b = &tags[3];
+    auto* const bulk_c = &tags[4];
+
+    fetch(*web, server.url(), Priority::High, high);
+    fetch(*web, server.url(), Priority::Normal, normal);
+    fetch(*web, server.url(), Priority::Bulk, bulk_a);
+    fetch(*web, server.url(), Priority::Bulk, bulk_b);
+    fetch(*web, server.url(), Priority::Bulk, bulk_c);
+    EXPECT_TRUE(waitFor([&mediator, &tags]() { return mediator.n_done() == std::size(tags); }, 10s));
+
+    // High and Normal requests share the first worker...
+    auto const first_worker = mediator.thread_for(high);
+    EXPECT_NE(std::thread::id{}, first_worker);
+    EXPECT_EQ(first_worker, mediator.thread_for(normal));
+
+    // ...and Bulk requests never go there
+    EXPECT_NE(first_worker, mediator.thread_for(bulk_a));
+    EXPECT_NE(first_worker, mediator.thread_for(bulk_b));
+    EXPECT_NE(first_worker, mediator.thread_for(bulk_c));
+
+    // While `bulk_a` is in flight, its worker is busier than the third one
+    EXPECT_NE(mediator.thread_for(bulk_a), mediator.thread_for(bulk_b));
+
+    // and once both have one task, it's a tie again
+    auto const bulk_c_worker = mediator.thread_for(bulk_c);
+    EXPECT_TRUE(bulk_c_worker == mediator.thread_for(bulk_a) || bulk_c_worker == mediator.thread_for(bulk_b));
+}
+
+TEST_F(WebTest, oneWorkerRunsEverything)
+{
+    auto const server = SilentServer{};
+    ASSERT_FALSE(std::empty(server.url()));
+
+    auto mediator = MediatorMock{ 1U };
+    auto const web = tr_web::create(mediator);
+
+    auto tags = std::array<int, 2U>{};
+    fetch(*web, server.url(), Priority::High, &tags[0]);
+    fetch(*web, server.url(), Priority::Bulk, &tags[1]);
+    EXPECT_TRUE(waitFor([&mediator, &tags]() { return mediator.n_done() == std::size(tags); }, 10s));
+
+    EXPECT_NE(std::thread::id{}, mediator.thread_for(&tags[0]));
+    EXPECT_EQ(mediator.thread_for(&tags[0]), mediator.thread_for(&tags[1]));
+}
+
+TEST_F(WebTest, workerCountCanChange)
+{
+    auto const server = SilentServer{};
+    ASSERT_FALSE(std::empty(server.url()));
+
+    auto mediator = MediatorMock{ 1U };
+    auto const web = tr_web::create(mediator);
+    EXPECT_EQ(1U, web->worker_count());
+
+    web->set_worker_count(3U);
+    EXPECT_EQ(3U, web->worker_count());
+
+    auto tags = std::array<int, 2U>{};
+    fetch(*web, server.url(), Priority::High, &tags[0]);
+    fetch(*web, server.url(), Priority::Bulk, &tags[1]);
+    EXPECT_TRUE(waitFor([&mediator, &tags]() { return mediator.n_done() == std::size(tags); }, 10s));
+
+    // now that there are more workers, Bulk requests get one of their own
+    EXPECT_NE(std::thread::id{}, mediator.thread_for(&tags[0]));
+    EXPECT_NE(mediator.thread_for(&tags[0]), mediator.thread_for(&tags[1]));
+
+    // and going back to one worker routes everything to the first one again
+    web->set_worker_count(1U);
+    EXPECT_EQ(1U, web->worker_count());
+
+    auto more_tags = std::array<int, 2U>{};
+    fetch(*web, server.url(), Priority::High, &more_tags[0]);
+    fetch(*web, server.url(), Priority::Bulk, &more_tags[1]);
+    EXPECT_TRUE(waitFor([&mediator]() { return mediator.n_done() == 4U; }, 10s));
+    EXPECT_EQ(mediator.thread_for(&tags[0]), mediator.thread_for(&more_tags[0]));
+    EXPECT_EQ(mediator.thread_for(&tags[0]), mediator.thread_for(&more_tags[1]));
+
+    // out-of-range counts are clamped
+    web->set_worker_count(0U);
+    EXPECT_EQ(1U, web->worker_count());
+}
+
+} // namespace tr::test
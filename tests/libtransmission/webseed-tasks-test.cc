@@ -0,0 +1,258 @@
+// This file Copyright (C) 2026 Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#define LIBTRANSMISSION_PEER_MODULE
+
+#include <libtransmission/types.h>
+#include <libtransmission/utils.h>
+#include <libtransmission/webseed-tasks.h>
+
+#include <gtest/gtest.h>
+
+namespace tr::test
+{
+
+class WebseedTasksTest : public ::testing::Test
+{
+protected:
+    using ConnectionLimiter = tr::webseed::ConnectionLimiter;
+
+    void SetUp() override
+    {
+        tr_timeUpdate(Now);
+    }
+
+    // Starts and finishes a full round of tasks at `bytes_per_second`
+    static void run_round(ConnectionLimiter& limiter, uint64_t const bytes_per_second)
+    {
+        auto const n_tasks = limiter.max_connections();
+        for (size_t i = 0; i < n_tasks; ++i)
+        {
+            limiter.task_started();
+        }
+        for (size_t i = 0; i < n_tasks; ++i)
+        {
+            limiter.got_data();
+            limiter.task_finished(true, bytes_per_second);
+        }
+    }
+
+    using Spans = std::vector<std::pair<tr_block_index_t, tr_block_index_t>>;
+
+    [[nodiscard]] static Spans to_pairs(std::vector<tr_block_span_t> const& spans)
+    {
+        auto pairs = Spans{};
+        for (auto const& [begin, end] : spans)
+        {
+            pairs.emplace_back(begin, end);
+        }
+        return pairs;
+    }
+
+    [[nodiscard]] static Spans coalesce(std::vector<tr_block_span_t> const& spans, tr_block_index_t const max_task_blocks)
+    {
+        auto tasks = std::vector<tr_block_span_t>{};
+        for (auto it = std::begin(spans), end = std::end(spans); it != end;)
+        {
+            auto const next = tr::webseed::coalesce_spans(it, end, max_task_blocks);
+            tasks.push_back({ .begin = it->begin, .end = std::prev(next)->end });
+            it = next;
+        }
+        return to_pairs(tasks);
+    }
+
+    static auto constexpr Now = time_t{ 1000000 };
+};
+
+TEST_F(WebseedTasksTest, limiterCountsRunningTasks)
+{
+    auto limiter = ConnectionLimiter{};
+    EXPECT_EQ(ConnectionLimiter::InitialConnections, limiter.max_connections());
+    EXPECT_EQ(ConnectionLimiter::InitialConnections, limiter.slots_available());
+
+    limiter.task_started();
+    limiter.task_started();
+    EXPECT_EQ(ConnectionLimiter::InitialConnections - 2U, limiter.slots_available());
+
+    // finishing part of a round doesn't change the limit
+    limiter.task_finished(true, 1000U);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections, limiter.max_connections());
+    EXPECT_EQ(ConnectionLimiter::InitialConnections - 1U, limiter.slots_available());
+}
+
+TEST_F(WebseedTasksTest, limiterGrowsWhileMoreTasksAreFaster)
+{
+    auto limiter = ConnectionLimiter{};
+    auto speed = uint64_t{ 1000U };
+
+    // the first round has nothing to compare to, so it counts as faster
+    run_round(limiter, speed);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections + 1U, limiter.max_connections());
+
+    // one more each round, as long as the speed keeps climbing...
+    speed += speed / ConnectionLimiter::SpeedChangeDivisor;
+    run_round(limiter, speed);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections + 2U, limiter.max_connections());
+
+    // ...but not when the gain is just noise
+    run_round(limiter, speed + speed / ConnectionLimiter::SpeedChangeDivisor - 1U);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections + 2U, limiter.max_connections());
+
+    // and never past the cap
+    for (size_t i = 0; i < ConnectionLimiter::MaxConnections; ++i)
+    {
+        speed *= 2U;
+        run_round(limiter, speed);
+    }
+    EXPECT_EQ(ConnectionLimiter::MaxConnections, limiter.max_connections());
+}
+
+TEST_F(WebseedTasksTest, limiterBacksOffWhenSlower)
+{
+    auto limiter = ConnectionLimiter{};
+    auto speed = uint64_t{ 1000U };
+    run_round(limiter, speed);
+    ASSERT_EQ(ConnectionLimiter::InitialConnections + 1U, limiter.max_connections());
+
+    // a small slowdown is noise
+    run_round(limiter, speed - speed / ConnectionLimiter::SpeedChangeDivisor);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections + 1U, limiter.max_connections());
+
+    // a real one takes back a connection
+    speed = speed - speed / ConnectionLimiter::SpeedChangeDivisor;
+    run_round(limiter, speed - speed / ConnectionLimiter::SpeedChangeDivisor - 1U);
+    EXPECT_EQ(ConnectionLimiter::InitialConnections, limiter.max_connections());
+
+    // and never below the minimum
+    for (size_t i = 0; i < ConnectionLimiter::InitialConnections; ++i)
+    {
+        speed /= 2U;
+        run_round(limiter, speed);
+    }
+    EXPECT_EQ(ConnectionLimiter::MinConnections, limiter.max_connections());
+}
+
+TEST_F(WebseedTasksTest, limiterHalvesOnFailure)
+{
+    auto limiter = ConnectionLimiter{};
+    run_round(limiter, 1000U);
+    run_round(limiter, 2000U);
+    ASSERT_EQ(6U, limiter.max_connections());
+
+    limiter.task_started();
+    limiter.task_finished(false, 2000U);
+    EXPECT_EQ(3U, limiter.max_connections());
+
+    limiter.task_started();
+    limiter.task_finished(false, 2000U);
+    EXPECT_EQ(ConnectionLimiter::MinConnections, limiter.max_connections());
+
+    limiter.task_started();
+    limiter.task_finished(false, 2000U);
+    EXPECT_EQ(ConnectionLimiter::MinConnections, limiter.max_connections());
+
+    // a failure starts a new round, so the next success
+    // has nothing to compare to and counts as faster
+    run_round(limiter, 1U);
+    EXPECT_EQ(ConnectionLimiter::MinConnections + 1U, limiter.max_connections());
+}
+
+TEST_F(WebseedTasksTest, limiterPausesAfterConsecutiveFailures)
+{
+    auto limiter = ConnectionLimiter{};
+
+    for (size_t i = 0; i < ConnectionLimiter::MaxConsecutiveFailures - 1U; ++i)
+    {
+        limiter.task_started();
+        limiter.task_finished(false, 0U);
+    }
+    EXPECT_NE(0U, limiter.slots_available());
+
+    limiter.task_started();
+    limiter.task_finished(false, 0U);
+    EXPECT_EQ(0U, limiter.slots_available());
+
+    tr_timeUpdate(Now + ConnectionLimiter::TimeoutIntervalSecs - 1);
+    EXPECT_EQ(0U, limiter.slots_available());
+
+    tr_timeUpdate(Now + ConnectionLimiter::TimeoutIntervalSecs);
+    EXPECT_EQ(ConnectionLimiter::MinConnections, limiter.slots_available());
+
+    // getting data resets the failure count
+    limiter.task_started();
+    limiter.got_data();
+    limiter.task_finished(false, 0U);
+    EXPECT_NE(0U, limiter.slots_available());
+}
+
+TEST_F(WebseedTasksTest, splitsSpansByBlocksPerTask)
+{
+    auto const spans = std::vector<tr_block_span_t>{ { .begin = 0, .end = 10 }, { .begin = 20, .end = 24 } };
+    auto const expected = Spans{ { 0, 4 }, { 4, 8 }, { 8, 10 }, { 20, 24 } };
+    EXPECT_EQ(expected, to_pairs(tr::webseed::split_spans(std::data(spans), std::size(spans), 4U)));
+
+    // spans that already fit are left alone
+    EXPECT_EQ(to_pairs(spans), to_pairs(tr::webseed::split_spans(std::data(spans), std::size(spans), 64U)));
+}
+
+TEST_F(WebseedTasksTest, coalescesNearbySpans)
+{
+    auto constexpr Gap = tr::webseed::MaxGapBlocks;
+
+    // spans that are close enough get fetched together...
+    auto spans = std::vector<tr_block_span_t>{ { .begin = 0, .end = 2 }, { .begin = 2 + Gap, .end = 4 + Gap } };
+    EXPECT_EQ((Spans{ { 0, 4 + Gap } }), coalesce(spans, 64U));
+
+    // ...but not ones that are too far apart
+    spans.back() = { .begin = 3 + Gap, .end = 5 + Gap };
+    EXPECT_EQ(to_pairs(spans), coalesce(spans, 64U));
+
+    // and a request never grows past the task size
+    spans = { { .begin = 0, .end = 4 }, { .begin = 5, .end = 9 }, { .begin = 10, .end = 12 } };
+    EXPECT_EQ((Spans{ { 0, 9 }, { 10, 12 } }), coalesce(spans, 9U));
+    EXPECT_EQ((Spans{ { 0, 4 }, { 5, 12 } }), coalesce(spans, 8U));
+}
+
+TEST_F(WebseedTasksTest, splitSpansAreCoalescedBackUpToTheTaskSize)
+{
+    auto const spans = std::vector<tr_block_span_t>{ { .begin = 0, .end = 10 }, { .begin = 11, .end = 13 } };
+    auto const split = tr::webseed::split_spans(std::data(spans), std::size(spans), 8U);
+    EXPECT_EQ((Spans{ { 0, 8 }, { 8, 13 } }), coalesce(split, 8U));
+}
+
+TEST_F(WebseedTasksTest, tasksOnlyOwnTheirRequestedSpans)
+{
+    // Task A coalesced two spans around a gap that task B requested,
+    // so both tasks are fetching blocks 2 and 3
+    auto constexpr MaxTaskBlocks = tr_block_index_t{ 64 };
+    auto const spans = std::vector<tr_block_span_t>{ { .begin = 0, .end = 2 }, { .begin = 4, .end = 6 } };
+    ASSERT_EQ(std::end(spans), tr::webseed::coalesce_spans(std::begin(spans), std::end(spans), MaxTaskBlocks));
+    auto const task_b = std::vector<tr_block_span_t>{ { .begin = 2, .end = 4 } };
+
+    // A doesn't keep B's blocks...
+    for (tr_block_index_t block = 0; block < 6; ++block)
+    {
+        auto const in_gap = block == 2 || block == 3;
+        EXPECT_EQ(!in_gap, tr::webseed::spans_contain(spans, block)) << block;
+        EXPECT_EQ(in_gap, tr::webseed::spans_contain(task_b, block)) << block;
+    }
+    EXPECT_FALSE(tr::webseed::spans_contain(spans, 6));
+
+    // ...and if A fails, only its own unfilled requests are rejected
+    EXPECT_EQ((Spans{ { 0, 2 }, { 4, 6 } }), to_pairs(tr::webseed::spans_from(spans, 0)));
+    EXPECT_EQ((Spans{ { 1, 2 }, { 4, 6 } }), to_pairs(tr::webseed::spans_from(spans, 1)));
+    EXPECT_EQ((Spans{ { 4, 6 } }), to_pairs(tr::webseed::spans_from(spans, 3)));
+    EXPECT_EQ((Spans{ { 5, 6 } }), to_pairs(tr::webseed::spans_from(spans, 5)));
+    EXPECT_TRUE(std::empty(tr::webseed::spans_from(spans, 6)));
+}
+
+} // namespace tr::test
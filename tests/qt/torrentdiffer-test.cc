@@ -0,0 +1,206 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cstdint> // int64_t
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <QApplication>
+#include <QTest>
+
+#include <libtransmission/quark.h>
+#include <libtransmission/variant.h>
+
+#include "TorrentDiffer.h"
+#include "TrQtInit.h"
+#include "qt-test-fixtures.h"
+
+using namespace std::literals;
+
+namespace
+{
+struct Row
+{
+    int64_t id = {};
+    std::string name;
+    int64_t rate_download = {};
+};
+
+// A torrent_get response's `torrents` in 'table' format
+[[nodiscard]] tr_variant::Vector makeTable(std::vector<Row> const& rows)
+{
+    auto keys = tr_variant::Vector{};
+    keys.emplace_back(tr_variant::unmanaged_string(TR_KEY_id));
+    keys.emplace_back(tr_variant::unmanaged_string(TR_KEY_name));
+    keys.emplace_back(tr_variant::unmanaged_string(TR_KEY_rate_download));
+
+    auto torrents = tr_variant::Vector{};
+    torrents.emplace_back(std::move(keys));
+    for (auto const& [id, name, rate_download] : rows)
+    {
+        auto row = tr_variant::Vector{};
+        row.emplace_back(id);
+        row.emplace_back(name);
+        row.emplace_back(rate_download);
+        torrents.emplace_back(std::move(row));
+    }
+
+    return torrents;
+}
+
+// A torrent_get response's `torrents` in 'objects' format
+[[nodiscard]] tr_variant::Vector makeObjects(std::vector<Row> const& rows)
+{
+    auto torrents = tr_variant::Vector{};
+    for (auto const& [id, name, rate_download] : rows)
+    {
+        auto map = tr_variant::Map{ 3U };
+        map.try_emplace(TR_KEY_id, id);
+        map.try_emplace(TR_KEY_name, name);
+        map.try_emplace(TR_KEY_rate_download, rate_download);
+        torrents.emplace_back(std::move(map));
+    }
+
+    return torrents;
+}
+
+using Entry = std::pair<int64_t, std::vector<std::string_view>>;
+
+// The id and sorted property names of each torrent in a reduced list
+[[nodiscard]] std::vector<Entry> describe(tr_variant::Vector const& torrents)
+{
+    auto entries = std::vector<Entry>{};
+    for (auto const& var : torrents)
+    {
+        auto const* const map = var.get_if<tr_variant::Map>();
+        if (map == nullptr)
+        {
+            entries.emplace_back(-1, std::vector<std::string_view>{});
+            continue;
+        }
+
+        auto keys = std::vector<std::string_view>{};
+        for (auto const& [key, value] : *map)
+        {
+            keys.push_back(tr_quark_get_string_view(key));
+        }
+        std::ranges::sort(keys);
+        entries.emplace_back(map->value_if<int64_t>(TR_KEY_id).value_or(-1), std::move(keys));
+    }
+
+    return entries;
+}
+
+auto const AllKeys = std::vector{ "id"sv, "name"sv, "rate_download"sv };
+auto const IdOnly = std::vector{ "id"sv };
+} // namespace
+
+class TorrentDifferTest
+    : public QObject
+    , BasicTest
+{
+    Q_OBJECT
+
+private slots:
+    static void drops_unchanged_torrents()
+    {
+        auto differ = TorrentDiffer{};
+
+        // everything is new the first time
+        auto torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, AllKeys }, { 2, AllKeys } }));
+
+        // nothing changed, so nothing is left
+        torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(std::empty(torrents));
+
+        // only the property that changed is kept, plus the id
+        torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 1000 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 2, { "id"sv, "rate_download"sv } } }));
+        auto const* const changed = torrents.front().get_if<tr_variant::Map>();
+        QCOMPARE(changed->value_if<int64_t>(TR_KEY_rate_download).value_or(0), int64_t{ 1000 });
+
+        // both formats share the same cache
+        torrents = makeObjects({ { 1, "uno", 0 }, { 2, "two", 1000 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, { "id"sv, "name"sv } } }));
+    }
+
+    static void keeps_everything_when_asked()
+    {
+        auto differ = TorrentDiffer{};
+
+        auto torrents = makeTable({ { 1, "one", 0 } });
+        differ.reduce(torrents, false, false);
+
+        torrents = makeTable({ { 1, "one", 0 } });
+        differ.reduce(torrents, false, true);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, AllKeys } }));
+
+        // but the cache is still updated
+        torrents = makeTable({ { 1, "one", 500 } });
+        differ.reduce(torrents, false, true);
+        torrents = makeTable({ { 1, "one", 500 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(std::empty(torrents));
+    }
+
+    static void complete_lists_keep_every_id()
+    {
+        auto differ = TorrentDiffer{};
+
+        auto torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, true, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, AllKeys }, { 2, AllKeys } }));
+
+        // unchanged torrents are still listed, so they aren't mistaken for removed ones
+        torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, true, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, IdOnly }, { 2, IdOnly } }));
+
+        // torrents missing from a complete list are forgotten...
+        torrents = makeTable({ { 2, "two", 0 } });
+        differ.reduce(torrents, true, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 2, IdOnly } }));
+
+        // ...so if they come back, they're sent in full
+        torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, AllKeys } }));
+    }
+
+    static void forgets_removed_torrents()
+    {
+        auto differ = TorrentDiffer{};
+
+        auto torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, false, false);
+
+        auto removed = tr_variant::Vector{};
+        removed.emplace_back(int64_t{ 1 });
+        differ.forget(removed);
+
+        // a torrent that reuses a forgotten id is sent in full
+        torrents = makeTable({ { 1, "one", 0 }, { 2, "two", 0 } });
+        differ.reduce(torrents, false, false);
+        QVERIFY(describe(torrents) == (std::vector<Entry>{ { 1, AllKeys } }));
+    }
+};
+
+int main(int argc, char** argv)
+{
+    trqt::trqt_init();
+    auto const app = QApplication{ argc, argv };
+    auto test = TorrentDifferTest{};
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "torrentdiffer-test.moc"
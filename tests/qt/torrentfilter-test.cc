@@ -0,0 +1,240 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <QApplication>
+#include <QTest>
+
+#include <libtransmission/quark.h>
+#include <libtransmission/transmission.h>
+#include <libtransmission/variant.h>
+
+#include "Filters.h"
+#include "Prefs.h"
+#include "TorrentFilter.h"
+#include "TorrentModel.h"
+#include "TrQtInit.h"
+#include "qt-test-fixtures.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
+#define QCOMPARE_EQ(actual, expected) QCOMPARE(actual, expected)
+#endif
+
+namespace
+{
+// A torrent_get response in 'table' format with random activity
+[[nodiscard]] tr_variant makeTorrentList(std::vector<int> const& ids, std::mt19937& rng)
+{
+    static auto constexpr Keys = std::array<tr_quark, 8U>{
+        TR_KEY_id,
+        TR_KEY_name,
+        TR_KEY_hash_string,
+        TR_KEY_status,
+        TR_KEY_rate_download,
+        TR_KEY_rate_upload,
+        TR_KEY_peers_getting_from_us,
+        TR_KEY_percent_complete,
+    };
+    static auto constexpr Statuses = std::array<int, 4U>{
+        TR_STATUS_STOPPED,
+        TR_STATUS_DOWNLOAD,
+        TR_STATUS_SEED,
+        TR_STATUS_CHECK,
+    };
+
+    auto keys = tr_variant::Vector{};
+    for (auto const key : Keys)
+    {
+        keys.emplace_back(tr_variant::unmanaged_string(key));
+    }
+
+    auto list = tr_variant::Vector{};
+    list.reserve(std::size(ids) + 1U);
+    list.emplace_back(std::move(keys));
+
+    auto rate = std::uniform_int_distribution<int64_t>{ 0, 8 };
+    auto peers = std::uniform_int_distribution<int64_t>{ 0, 3 };
+    auto status = std::uniform_int_distribution<size_t>{ 0, std::size(Statuses) - 1U };
+    auto percent = std::uniform_int_distribution<int>{ 0, 4 };
+    for (auto const id : ids)
+    {
+        auto hash = std::string(40U, '0');
+        auto const id_str = std::to_string(id);
+        hash.replace(std::size(hash) - std::size(id_str), std::size(id_str), id_str);
+
+        auto row = tr_variant::Vector{};
+        row.reserve(std::size(Keys));
+        row.emplace_back(int64_t{ id });
+        row.emplace_back("torrent " + id_str);
+        row.emplace_back(hash);
+        row.emplace_back(int64_t{ Statuses[status(rng)] });
+        row.emplace_back(rate(rng) * 1000);
+        row.emplace_back(rate(rng) * 1000);
+        row.emplace_back(peers(rng));
+        row.emplace_back(percent(rng) / 4.0);
+        list.emplace_back(std::move(row));
+    }
+
+    return tr_variant{ std::move(list) };
+}
+
+[[nodiscard]] std::vector<int> pickIds(std::vector<int> ids, size_t const n, std::mt19937& rng)
+{
+    std::ranges::shuffle(ids, rng);
+    ids.resize(std::min(n, std::size(ids)));
+    return ids;
+}
+
+[[nodiscard]] std::vector<int> shownIds(TorrentFilter const& filter)
+{
+    auto ids = std::vector<int>{};
+    for (int row = 0, n = filter.rowCount(); row < n; ++row)
+    {
+        auto const* const tor = filter.index(row, 0).data(TorrentModel::TorrentRole).value<Torrent const*>();
+        ids.push_back(tor->id());
+    }
+    return ids;
+}
+} // namespace
+
+class TorrentFilterTest
+    : public QObject
+    , BasicTest
+{
+    Q_OBJECT
+
+private slots:
+    static void keeps_order_as_torrents_change_data()
+    {
+        QTest::addColumn<SortMode>("sort_mode");
+        QTest::addColumn<ShowMode>("show_mode");
+        QTest::newRow("activity/all") << SortMode::SortByActivity << ShowMode::ShowAll;
+        QTest::newRow("activity/active") << SortMode::SortByActivity << ShowMode::ShowActive;
+        QTest::newRow("state/downloading") << SortMode::SortByState << ShowMode::ShowDownloading;
+        QTest::newRow("progress/all") << SortMode::SortByProgress << ShowMode::ShowAll;
+        QTest::newRow("name/paused") << SortMode::SortByName << ShowMode::ShowPaused;
+    }
+    static void keeps_order_as_torrents_change()
+    {
+        QFETCH(SortMode const, sort_mode);
+        QFETCH(ShowMode const, show_mode);
+
+        // setup: a model with some torrents, and a filter on it
+        auto prefs = Prefs{};
+        prefs.set(TR_KEY_sort_mode, sort_mode);
+        prefs.set(TR_KEY_filter_mode, show_mode);
+        auto model = TorrentModel{ prefs };
+        auto filter = TorrentFilter{ prefs };
+        filter.setSourceModel(&model);
+
+        auto rng = std::mt19937{ 1234 }; // NOLINT(cert-msc32-c, cert-msc51-cpp): reproducible
+        auto ids = std::vector<int>(2000U);
+        std::iota(std::begin(ids), std::end(ids), 1);
+        auto list = makeTorrentList(ids, rng);
+        model.updateTorrents(&list, true);
+
+        for (int round = 0; round < 20; ++round)
+        {
+            // action: change some of them, sometimes removing or adding others
+            if (round % 5 == 4)
+            {
+                ids = pickIds(ids, std::size(ids) - 50U, rng);
+                for (int i = 0; i < 20; ++i)
+                {
+                    ids.push_back(10000 + (round * 100) + i);
+                }
+                list = makeTorrentList(ids, rng);
+                model.updateTorrents(&list, true);
+            }
+            else
+            {
+                list = makeTorrentList(pickIds(ids, 100U, rng), rng);
+                model.updateTorrents(&list, false);
+            }
+
+            // verify: same as a filter that sorted everything from scratch
+            auto fresh = TorrentFilter{ prefs };
+            fresh.setSourceModel(&model);
+            QVERIFY(shownIds(filter) == shownIds(fresh));
+        }
+    }
+
+    static void counts_torrents_per_mode()
+    {
+        auto prefs = Prefs{};
+        auto model = TorrentModel{ prefs };
+        auto filter = TorrentFilter{ prefs };
+        filter.setSourceModel(&model);
+
+        auto rng = std::mt19937{ 5678 }; // NOLINT(cert-msc32-c, cert-msc51-cpp): reproducible
+        auto ids = std::vector<int>(500U);
+        std::iota(std::begin(ids), std::end(ids), 1);
+        auto list = makeTorrentList(ids, rng);
+        model.updateTorrents(&list, true);
+        list = makeTorrentList(pickIds(ids, 100U, rng), rng);
+        model.updateTorrents(&list, false);
+
+        auto expected = std::array<int, ShowModeCount>{};
+        for (auto const* const tor : model.torrents())
+        {
+            for (size_t mode = 0; mode < ShowModeCount; ++mode)
+            {
+                expected[mode] += should_show_torrent(*tor, static_cast<ShowMode>(mode)) ? 1 : 0;
+            }
+        }
+
+        QVERIFY(filter.countTorrentsPerMode() == expected);
+    }
+
+    static void benchmark_updates_to_100k_torrents()
+    {
+        static auto constexpr NumTorrents = 100000;
+        static auto constexpr NumChanged = 1000U;
+
+        auto prefs = Prefs{};
+        prefs.set(TR_KEY_sort_mode, SortMode::SortByActivity);
+        auto model = TorrentModel{ prefs };
+        auto filter = TorrentFilter{ prefs };
+        filter.setSourceModel(&model);
+
+        auto rng = std::mt19937{ 4321 }; // NOLINT(cert-msc32-c, cert-msc51-cpp): reproducible
+        auto ids = std::vector<int>(NumTorrents);
+        std::iota(std::begin(ids), std::end(ids), 1);
+        auto list = makeTorrentList(ids, rng);
+        model.updateTorrents(&list, true);
+
+        // a refresh where 1% of the torrents changed
+        auto updates = std::vector<tr_variant>{};
+        for (int i = 0; i < 8; ++i)
+        {
+            updates.emplace_back(makeTorrentList(pickIds(ids, NumChanged, rng), rng));
+        }
+
+        auto i = size_t{};
+        QBENCHMARK
+        {
+            model.updateTorrents(&updates[i++ % std::size(updates)], false);
+        }
+
+        QCOMPARE_EQ(filter.rowCount(), NumTorrents);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    trqt::trqt_init();
+    auto const app = QApplication{ argc, argv };
+    auto test = TorrentFilterTest{};
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "torrentfilter-test.moc"